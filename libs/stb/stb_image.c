@@ -1,3 +1,19 @@
+// NEON needs to be enabled explicitly, SSE2 is detected by stb_image.h itself
+#if defined(STBI_ENABLE_SIMD) && !defined(STBI_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define STBI_NEON
+#endif
+
+// route allocations through hooks so that the output image can be
+// decoded directly into caller-provided memory (see stb_image_ext.h)
+#include <stdlib.h>
+#include <string.h>
+static void* _stbi_ext_malloc(size_t size);
+static void* _stbi_ext_realloc(void* ptr, size_t size);
+static void _stbi_ext_free(void* ptr);
+#define STBI_MALLOC(sz) _stbi_ext_malloc(sz)
+#define STBI_REALLOC(p,newsz) _stbi_ext_realloc(p,newsz)
+#define STBI_FREE(p) _stbi_ext_free(p)
+
 #define STB_IMAGE_IMPLEMENTATION
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -7,3 +23,92 @@
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
+#undef STB_IMAGE_IMPLEMENTATION
+#include "stb_image_ext.h"
+
+#if defined(_MSC_VER)
+#define _STBI_EXT_THREAD_LOCAL __declspec(thread)
+#else
+#define _STBI_EXT_THREAD_LOCAL _Thread_local
+#endif
+
+// the caller-provided destination for the current thread's decode operation
+typedef struct {
+    void* ptr;
+    size_t size;        // exact size of the decoded image
+    size_t capacity;    // size of the caller-provided buffer
+    int in_use;
+} _stbi_ext_target_t;
+static _STBI_EXT_THREAD_LOCAL _stbi_ext_target_t _stbi_ext_target;
+
+// hand out the caller's buffer for the first allocation which matches
+// the output image size (the JPEG decoder asks for one extra byte), this
+// is the output image in the common case, otherwise
+// stbi_load_from_memory_into() falls back to a copy
+static void* _stbi_ext_malloc(size_t size) {
+    _stbi_ext_target_t* t = &_stbi_ext_target;
+    if (t->ptr && !t->in_use && ((size == t->size) || (size == t->size + 1)) && (size <= t->capacity)) {
+        t->in_use = 1;
+        return t->ptr;
+    }
+    return malloc(size);
+}
+
+static void* _stbi_ext_realloc(void* ptr, size_t size) {
+    _stbi_ext_target_t* t = &_stbi_ext_target;
+    if (ptr && (ptr == t->ptr)) {
+        // the caller's buffer can't grow, move the data into a heap allocation
+        void* new_ptr = malloc(size);
+        if (new_ptr) {
+            memcpy(new_ptr, ptr, (size < t->capacity) ? size : t->capacity);
+            t->in_use = 0;
+        }
+        return new_ptr;
+    }
+    return realloc(ptr, size);
+}
+
+static void _stbi_ext_free(void* ptr) {
+    _stbi_ext_target_t* t = &_stbi_ext_target;
+    if (ptr && (ptr == t->ptr)) {
+        t->in_use = 0;
+        return;
+    }
+    free(ptr);
+}
+
+int stbi_load_from_memory_into(stbi_uc const* buffer, int len, int* x, int* y, int* channels_in_file, int desired_channels, stbi_uc* dst, size_t dst_size) {
+    if (!dst || (desired_channels < 1) || (desired_channels > 4)) {
+        return 0;
+    }
+    int w, h, comp;
+    if (!stbi_info_from_memory(buffer, len, &w, &h, &comp)) {
+        return 0;
+    }
+    const size_t num_bytes = (size_t)w * (size_t)h * (size_t)desired_channels;
+    if (num_bytes > dst_size) {
+        return 0;
+    }
+    _stbi_ext_target = (_stbi_ext_target_t){ .ptr = dst, .size = num_bytes, .capacity = dst_size, .in_use = 0 };
+    stbi_uc* pixels = stbi_load_from_memory(buffer, len, x, y, channels_in_file, desired_channels);
+    _stbi_ext_target = (_stbi_ext_target_t){ 0 };
+    if (!pixels) {
+        return 0;
+    }
+    if (pixels != dst) {
+        // output ended up in a separate allocation, copy it over
+        memcpy(dst, pixels, num_bytes);
+        free(pixels);
+    }
+    return 1;
+}
+
+const char* stbi_simd_path(void) {
+    #if defined(STBI_SSE2)
+    return "SSE2";
+    #elif defined(STBI_NEON)
+    return "NEON";
+    #else
+    return "none";
+    #endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+/*
+    Additions to stb_image.h for the samples, implemented in stb_image.c
+
+    stbi_load_from_memory_into() decodes an image directly into
+    caller-provided memory instead of a buffer allocated by stb_image.h,
+    so that no stbi_image_free() round trip (and usually no extra copy)
+    is needed. The destination must be big enough for
+    width * height * desired_channels bytes, use stbi_info_from_memory()
+    to query the image size upfront. The JPEG decoder needs one extra byte
+    of room to decode in place, otherwise the image is decoded into a
+    temporary buffer and copied. Returns 1 on success and 0 on failure.
+    This is safe to call from multiple threads at the same time.
+
+    stbi_simd_path() returns the name of the SIMD code path compiled into
+    stb_image.c ("SSE2", "NEON" or "none"), this depends on the
+    STB_IMAGE_SIMD cmake option and the target CPU.
+
+    stbi_ref_load_from_memory() and stbi_ref_image_free() use a second
+    copy of the decoder in stb_image_ref.c which is always compiled
+    without SIMD code paths, this is the reference to validate the
+    SIMD results against. The JPEG IDCT and color conversion of the
+    SIMD paths may differ from the scalar code by a few units per channel.
+*/
+#include <stddef.h>
+#include "stb_image.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int stbi_load_from_memory_into(stbi_uc const* buffer, int len, int* x, int* y, int* channels_in_file, int desired_channels, stbi_uc* dst, size_t dst_size);
+const char* stbi_simd_path(void);
+stbi_uc* stbi_ref_load_from_memory(stbi_uc const* buffer, int len, int* x, int* y, int* channels_in_file, int desired_channels);
+void stbi_ref_image_free(void* retval_from_stbi_ref_load);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,26 @@
+// a second, scalar-only copy of the stb_image.h decoder, used as reference
+// to validate the results of the SIMD code paths compiled into stb_image.c
+// (see stbi_ref_load_from_memory() in stb_image_ext.h), all stb_image.h
+// functions in this file are static so they don't clash with stb_image.c
+#define STBI_NO_SIMD
+#define STBI_NO_STDIO
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+#endif
+#include "stb_image.h"
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+#undef STB_IMAGE_IMPLEMENTATION
+#include "stb_image_ext.h"
+
+stbi_uc* stbi_ref_load_from_memory(stbi_uc const* buffer, int len, int* x, int* y, int* channels_in_file, int desired_channels) {
+    return stbi_load_from_memory(buffer, len, x, y, channels_in_file, desired_channels);
+}
+
+void stbi_ref_image_free(void* retval_from_stbi_ref_load) {
+    stbi_image_free(retval_from_stbi_ref_load);
+}
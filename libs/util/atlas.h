@@ -0,0 +1,162 @@
+#pragma once
+/*
+    Quick'n'dirty texture atlas packer for small RGBA8 images (e.g. UI icons).
+
+    Images are packed with a simple shelf packer into a CPU-side pixel
+    buffer, each image is surrounded by a border which replicates the
+    image's edge pixels so that linear filtering doesn't bleed in
+    neighbouring images. After all images have been added, create
+    a single sokol-gfx texture from atlas.pixels and use atlas_uv()
+    to get the texture coordinates of each packed image (or use the
+    pixel rectangles from atlas_add() directly where a UI library
+    expects sub-image regions in pixels, like Nuklear).
+
+    atlas_make_icon_pixels() generates simple procedural test icons
+    (ATLAS_ICON_SIZE x ATLAS_ICON_SIZE RGBA8 pixels) to fill an atlas with.
+
+    Include after sokol_gfx.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define ATLAS_ICON_SIZE (16)
+
+typedef struct {
+    int width;
+    int height;
+    int padding;        // default: 1
+} atlas_desc_t;
+
+typedef struct {
+    int x, y, w, h;
+} atlas_rect_t;
+
+typedef struct {
+    float u0, v0, u1, v1;
+} atlas_uv_t;
+
+typedef struct {
+    int width;
+    int height;
+    int padding;
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
+    int num_images;
+    uint32_t* pixels;
+} atlas_t;
+
+static void atlas_init(atlas_t* atlas, const atlas_desc_t* desc) {
+    assert(atlas && desc);
+    assert((desc->width > 0) && (desc->height > 0));
+    memset(atlas, 0, sizeof(atlas_t));
+    atlas->width = desc->width;
+    atlas->height = desc->height;
+    atlas->padding = (desc->padding == 0) ? 1 : desc->padding;
+    atlas->pixels = (uint32_t*) calloc((size_t)(atlas->width * atlas->height), sizeof(uint32_t));
+    assert(atlas->pixels);
+}
+
+static void atlas_discard(atlas_t* atlas) {
+    assert(atlas);
+    free(atlas->pixels);
+    memset(atlas, 0, sizeof(atlas_t));
+}
+
+static int _atlas_clamp(int val, int max_val) {
+    return (val < 0) ? 0 : ((val > max_val) ? max_val : val);
+}
+
+/* add an image with tightly packed RGBA8 pixels, returns false if the atlas is full */
+static bool atlas_add(atlas_t* atlas, int w, int h, const uint32_t* pixels, atlas_rect_t* out_rect) {
+    assert(atlas && atlas->pixels && pixels && out_rect);
+    const int pad = atlas->padding;
+    const int pw = w + 2 * pad;
+    const int ph = h + 2 * pad;
+    if ((atlas->shelf_x + pw) > atlas->width) {
+        // start a new shelf
+        atlas->shelf_x = 0;
+        atlas->shelf_y += atlas->shelf_height;
+        atlas->shelf_height = 0;
+    }
+    if (((atlas->shelf_x + pw) > atlas->width) || ((atlas->shelf_y + ph) > atlas->height)) {
+        return false;
+    }
+    // copy pixels including the replicated border
+    for (int y = 0; y < ph; y++) {
+        const int src_y = _atlas_clamp(y - pad, h - 1);
+        uint32_t* dst = atlas->pixels + (atlas->shelf_y + y) * atlas->width + atlas->shelf_x;
+        for (int x = 0; x < pw; x++) {
+            dst[x] = pixels[src_y * w + _atlas_clamp(x - pad, w - 1)];
+        }
+    }
+    *out_rect = (atlas_rect_t){ atlas->shelf_x + pad, atlas->shelf_y + pad, w, h };
+    atlas->shelf_x += pw;
+    if (ph > atlas->shelf_height) {
+        atlas->shelf_height = ph;
+    }
+    atlas->num_images++;
+    return true;
+}
+
+/* get the normalized texture coordinates of a packed image */
+static inline atlas_uv_t atlas_uv(const atlas_t* atlas, atlas_rect_t rect) {
+    assert(atlas);
+    const float w = (float) atlas->width;
+    const float h = (float) atlas->height;
+    return (atlas_uv_t) {
+        .u0 = (float)rect.x / w,
+        .v0 = (float)rect.y / h,
+        .u1 = (float)(rect.x + rect.w) / w,
+        .v1 = (float)(rect.y + rect.h) / h,
+    };
+}
+
+/* create a sokol-gfx texture from the atlas pixels */
+static sg_image atlas_make_image(const atlas_t* atlas, const char* label) {
+    assert(atlas && atlas->pixels);
+    return sg_make_image(&(sg_image_desc){
+        .width = atlas->width,
+        .height = atlas->height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .data.subimage[0][0] = {
+            .ptr = atlas->pixels,
+            .size = (size_t)(atlas->width * atlas->height) * sizeof(uint32_t),
+        },
+        .label = label,
+    });
+}
+
+/* generate a simple procedural test icon (colored rings and dots), 64 different icons */
+static void atlas_make_icon_pixels(int index, uint32_t* pixels) {
+    const uint32_t colors[8] = {
+        0xFF3643F4, 0xFF631EE9, 0xFFB0279C, 0xFFF39621,
+        0xFFD4BC00, 0xFF50AF4C, 0xFF3BEBFF, 0xFF0098FF,
+    };
+    const uint32_t color = colors[index % 8];
+    const int shape = (index / 8) % 8;
+    const float c = (ATLAS_ICON_SIZE - 1) * 0.5f;
+    for (int y = 0; y < ATLAS_ICON_SIZE; y++) {
+        for (int x = 0; x < ATLAS_ICON_SIZE; x++) {
+            const float dx = (float)x - c;
+            const float dy = (float)y - c;
+            const float d = sqrtf(dx * dx + dy * dy);
+            bool set;
+            switch (shape) {
+                case 0: set = d < 7.0f; break;
+                case 1: set = (d < 7.0f) && (d > 4.0f); break;
+                case 2: set = (fabsf(dx) < 6.0f) && (fabsf(dy) < 6.0f); break;
+                case 3: set = (fabsf(dx) < 2.0f) || (fabsf(dy) < 2.0f); break;
+                case 4: set = (fabsf(dx) + fabsf(dy)) < 7.0f; break;
+                case 5: set = ((x ^ y) & 4) != 0; break;
+                case 6: set = fabsf(dx - dy) < 2.0f || fabsf(dx + dy) < 2.0f; break;
+                default: set = (y > 2) && (fabsf(dx) < (float)(y - 2) * 0.5f); break;
+            }
+            pixels[y * ATLAS_ICON_SIZE + x] = set ? color : 0xFF202020;
+        }
+    }
+}
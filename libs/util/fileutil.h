@@ -1,9 +1,74 @@
+#pragma once
+/*
+    Minimal file helpers for the samples.
+
+    fileutil_get_path() builds a platform-specific path to an asset file
+    (on macOS and iOS this is inside the application bundle).
+
+    fileutil_mmap() maps an entire asset file read-only into memory, so
+    that its content can be consumed in place without first copying it
+    into a separate buffer (as sokol_fetch.h does). The advice hint is
+    forwarded to madvise() / PrefetchVirtualMemory() where supported.
+    Memory mapping is not available on all platforms (most notably
+    not on the web), so check FILEUTIL_HAS_MMAP or the return value
+    and fall back to sokol_fetch.h:
+
+        fileutil_mmap_t map;
+        if (fileutil_mmap(path, FILEUTIL_ADVICE_SEQUENTIAL, &map)) {
+            ... use map.ptr and map.size ...
+            fileutil_munmap(&map);
+        }
+
+    If sokol_gfx.h or sokol_fetch.h are included before this header,
+    the helper functions fileutil_mmap_as_sg_range() and
+    fileutil_mmap_as_sfetch_range() are available to convert a mapping
+    into a range struct which points directly into the mapped memory.
+*/
 #include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__EMSCRIPTEN__)
+#define FILEUTIL_HAS_MMAP (0)
+#else
+#define FILEUTIL_HAS_MMAP (1)
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
+
+typedef enum {
+    FILEUTIL_ADVICE_NORMAL,
+    FILEUTIL_ADVICE_SEQUENTIAL,     // data will be read front to back once
+    FILEUTIL_ADVICE_RANDOM,         // data will be accessed in random order
+    FILEUTIL_ADVICE_WILLNEED,       // prefetch the whole file right away
+} fileutil_advice_t;
+
+typedef struct {
+    const void* ptr;
+    size_t size;
+    // private
+    void* _handle;
+} fileutil_mmap_t;
+
 const char* fileutil_get_path(const char* filename, char* buf, size_t buf_size);
+bool fileutil_mmap(const char* path, fileutil_advice_t advice, fileutil_mmap_t* out_map);
+void fileutil_munmap(fileutil_mmap_t* map);
+
 #if defined(__cplusplus)
 }
 #endif
 
+#if defined(SOKOL_GFX_INCLUDED)
+static inline sg_range fileutil_mmap_as_sg_range(const fileutil_mmap_t* map) {
+    sg_range range = { map->ptr, map->size };
+    return range;
+}
+#endif
+
+#if defined(SOKOL_FETCH_INCLUDED)
+static inline sfetch_range_t fileutil_mmap_as_sfetch_range(const fileutil_mmap_t* map) {
+    sfetch_range_t range = { map->ptr, map->size };
+    return range;
+}
+#endif
@@ -0,0 +1,120 @@
+// memory-mapped file loading, shared by all platforms
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+#include "fileutil.h"
+#include <string.h>
+#include <stdint.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+bool fileutil_mmap(const char* path, fileutil_advice_t advice, fileutil_mmap_t* out_map) {
+    memset(out_map, 0, sizeof(fileutil_mmap_t));
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (advice == FILEUTIL_ADVICE_SEQUENTIAL) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (advice == FILEUTIL_ADVICE_RANDOM) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || (file_size.QuadPart <= 0) || ((uint64_t)file_size.QuadPart > SIZE_MAX)) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    // the mapping object keeps its own reference to the file
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return false;
+    }
+    void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (ptr == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+    out_map->ptr = ptr;
+    out_map->size = (size_t)file_size.QuadPart;
+    out_map->_handle = mapping;
+    #if (_WIN32_WINNT >= 0x0602)
+    if (advice == FILEUTIL_ADVICE_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY entry = { ptr, out_map->size };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+    }
+    #endif
+    return true;
+}
+
+void fileutil_munmap(fileutil_mmap_t* map) {
+    if (map->ptr) {
+        UnmapViewOfFile(map->ptr);
+    }
+    if (map->_handle) {
+        CloseHandle((HANDLE)map->_handle);
+    }
+    memset(map, 0, sizeof(fileutil_mmap_t));
+}
+
+#elif !defined(__EMSCRIPTEN__)
+bool fileutil_mmap(const char* path, fileutil_advice_t advice, fileutil_mmap_t* out_map) {
+    memset(out_map, 0, sizeof(fileutil_mmap_t));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    void* ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the file descriptor is closed
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+    int madv;
+    switch (advice) {
+        case FILEUTIL_ADVICE_SEQUENTIAL: madv = MADV_SEQUENTIAL; break;
+        case FILEUTIL_ADVICE_RANDOM:     madv = MADV_RANDOM; break;
+        case FILEUTIL_ADVICE_WILLNEED:   madv = MADV_WILLNEED; break;
+        default:                         madv = MADV_NORMAL; break;
+    }
+    // advice is only a hint, so ignore errors
+    madvise(ptr, size, madv);
+    out_map->ptr = ptr;
+    out_map->size = size;
+    return true;
+}
+
+void fileutil_munmap(fileutil_mmap_t* map) {
+    if (map->ptr) {
+        munmap((void*)map->ptr, map->size);
+    }
+    memset(map, 0, sizeof(fileutil_mmap_t));
+}
+
+#else
+// no memory mapped files on the web, use sokol_fetch.h instead
+bool fileutil_mmap(const char* path, fileutil_advice_t advice, fileutil_mmap_t* out_map) {
+    (void)path; (void)advice;
+    memset(out_map, 0, sizeof(fileutil_mmap_t));
+    return false;
+}
+
+void fileutil_munmap(fileutil_mmap_t* map) {
+    memset(map, 0, sizeof(fileutil_mmap_t));
+}
+#endif
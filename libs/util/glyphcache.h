@@ -0,0 +1,394 @@
+#pragma once
+/*
+    Quick'n'dirty fontstash renderer backend on top of sokol_gl.h which
+    only uploads the changed regions of the glyph atlas.
+
+    sokol_fontstash.h re-uploads the whole atlas texture whenever a new
+    glyph has been rasterized, since sokol-gfx can only update complete
+    images. The glyph cache keeps the atlas in a render target instead,
+    copies the dirty rectangle reported by fontstash into the smallest
+    fitting 'staging' stream texture and then renders that staging
+    texture into the atlas with sokol-gl, so the upload size only
+    depends on the height of the dirty area.
+
+    For comparison, GCACHE_UPLOAD_FULL mode updates a stream texture
+    with the entire atlas (same as sokol_fontstash.h).
+
+    Include after sokol_gfx.h, sokol_gl.h and the fontstash.h
+    implementation, then use like sokol_fontstash.h:
+
+        FONScontext* fs = gcache_create(&(gcache_desc_t){ .width=512, .height=512 });
+        // optional: rasterize all glyphs that will be needed upfront
+        gcache_prewarm(fs, font, 16.0f, 0.0f, "0123456789");
+        ...
+        fonsDrawText(fs, ...);
+        // once per frame, outside a sokol-gfx render pass
+        gcache_flush(fs);
+        ...
+        gcache_destroy(fs);
+
+    Atlas colors are white with the glyph coverage in the alpha channel,
+    so that text can be rendered with the default sokol-gl shader.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define GCACHE_MAX_STAGING (12)
+#define GCACHE_MIN_STAGING_HEIGHT (16)
+
+typedef enum {
+    GCACHE_UPLOAD_DIRTY,    // only upload the dirty rectangle (default)
+    GCACHE_UPLOAD_FULL,     // upload the whole atlas on each change
+} gcache_upload_mode_t;
+
+typedef struct {
+    int width;              // atlas width
+    int height;             // atlas height
+    gcache_upload_mode_t mode;
+} gcache_desc_t;
+
+typedef struct {
+    int num_uploads;            // number of atlas updates in the last gcache_flush() (0 or 1)
+    int dirty_width;            // size of the dirty rectangle in the last gcache_flush()
+    int dirty_height;
+    size_t upload_bytes;        // bytes passed to sg_update_image() in the last gcache_flush()
+    int total_uploads;          // accumulated since gcache_create()
+    size_t total_upload_bytes;
+} gcache_stats_t;
+
+typedef struct {
+    gcache_upload_mode_t mode;
+    int width;
+    int height;
+    bool images_valid;
+    bool needs_clear;
+    sg_image atlas_img;             // render target for GCACHE_UPLOAD_DIRTY
+    sg_attachments atlas_atts;
+    sg_image full_img;              // stream texture for GCACHE_UPLOAD_FULL
+    int num_staging;
+    int staging_height[GCACHE_MAX_STAGING];
+    sg_image staging_img[GCACHE_MAX_STAGING];
+    sg_sampler smp_linear;
+    sg_sampler smp_nearest;
+    sgl_context atlas_ctx;
+    sgl_pipeline pip;
+    uint32_t* full_pixels;          // RGBA8 copy of the entire atlas
+    uint32_t* staging_pixels;       // RGBA8 copy of the dirty rows
+    const uint8_t* tex_data;        // fontstash's alpha-only atlas data
+    int dirty[4];                   // x0, y0, x1, y1
+    gcache_stats_t stats;
+} _gcache_t;
+
+static void _gcache_mark_dirty(_gcache_t* gc, int x0, int y0, int x1, int y1) {
+    if (x0 < gc->dirty[0]) gc->dirty[0] = x0;
+    if (y0 < gc->dirty[1]) gc->dirty[1] = y0;
+    if (x1 > gc->dirty[2]) gc->dirty[2] = x1;
+    if (y1 > gc->dirty[3]) gc->dirty[3] = y1;
+}
+
+static void _gcache_clear_dirty(_gcache_t* gc) {
+    gc->dirty[0] = gc->width;
+    gc->dirty[1] = gc->height;
+    gc->dirty[2] = 0;
+    gc->dirty[3] = 0;
+}
+
+static void _gcache_destroy_images(_gcache_t* gc) {
+    if (gc->images_valid) {
+        sg_destroy_attachments(gc->atlas_atts);
+        sg_destroy_image(gc->atlas_img);
+        sg_destroy_image(gc->full_img);
+        for (int i = 0; i < gc->num_staging; i++) {
+            sg_destroy_image(gc->staging_img[i]);
+        }
+        gc->num_staging = 0;
+        gc->images_valid = false;
+    }
+    free(gc->full_pixels); gc->full_pixels = 0;
+    free(gc->staging_pixels); gc->staging_pixels = 0;
+}
+
+static int _gcache_render_create(void* uptr, int width, int height) {
+    _gcache_t* gc = (_gcache_t*) uptr;
+    _gcache_destroy_images(gc);
+    gc->width = width;
+    gc->height = height;
+    gc->atlas_img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = 1,
+        .label = "gcache-atlas",
+    });
+    gc->atlas_atts = sg_make_attachments(&(sg_attachments_desc){
+        .colors[0].image = gc->atlas_img,
+        .label = "gcache-atlas-attachments",
+    });
+    gc->full_img = sg_make_image(&(sg_image_desc){
+        .usage = SG_USAGE_STREAM,
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .label = "gcache-full-atlas",
+    });
+    // staging textures with power-of-2 heights up to the atlas height
+    int staging_height = GCACHE_MIN_STAGING_HEIGHT;
+    while (gc->num_staging < GCACHE_MAX_STAGING) {
+        if ((staging_height >= height) || (gc->num_staging == (GCACHE_MAX_STAGING - 1))) {
+            staging_height = height;
+        }
+        gc->staging_height[gc->num_staging] = staging_height;
+        gc->staging_img[gc->num_staging] = sg_make_image(&(sg_image_desc){
+            .usage = SG_USAGE_STREAM,
+            .width = width,
+            .height = staging_height,
+            .pixel_format = SG_PIXELFORMAT_RGBA8,
+            .label = "gcache-staging",
+        });
+        gc->num_staging++;
+        if (staging_height == height) {
+            break;
+        }
+        staging_height *= 2;
+    }
+    const size_t num_pixels = (size_t)(width * height);
+    gc->full_pixels = (uint32_t*) calloc(num_pixels, sizeof(uint32_t));
+    gc->staging_pixels = (uint32_t*) calloc(num_pixels, sizeof(uint32_t));
+    assert(gc->full_pixels && gc->staging_pixels);
+    gc->images_valid = true;
+    gc->needs_clear = true;
+    _gcache_clear_dirty(gc);
+    return 1;
+}
+
+static int _gcache_render_resize(void* uptr, int width, int height) {
+    return _gcache_render_create(uptr, width, height);
+}
+
+// called by fontstash when new glyphs have been rasterized, may happen
+// several times per frame, the actual upload happens in gcache_flush()
+static void _gcache_render_update(void* uptr, int* rect, const unsigned char* data) {
+    _gcache_t* gc = (_gcache_t*) uptr;
+    gc->tex_data = data;
+    _gcache_mark_dirty(gc, rect[0], rect[1], rect[2], rect[3]);
+}
+
+static sg_image _gcache_current_image(const _gcache_t* gc) {
+    return (gc->mode == GCACHE_UPLOAD_FULL) ? gc->full_img : gc->atlas_img;
+}
+
+static void _gcache_render_draw(void* uptr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts) {
+    _gcache_t* gc = (_gcache_t*) uptr;
+    sgl_enable_texture();
+    sgl_texture(_gcache_current_image(gc), gc->smp_linear);
+    sgl_push_pipeline();
+    sgl_load_pipeline(gc->pip);
+    sgl_begin_triangles();
+    for (int i = 0; i < nverts; i++) {
+        sgl_v2f_t2f_c1i(verts[2*i+0], verts[2*i+1], tcoords[2*i+0], tcoords[2*i+1], colors[i]);
+    }
+    sgl_end();
+    sgl_pop_pipeline();
+    sgl_disable_texture();
+}
+
+static void _gcache_render_delete(void* uptr) {
+    _gcache_t* gc = (_gcache_t*) uptr;
+    _gcache_destroy_images(gc);
+    sgl_destroy_pipeline(gc->pip);
+    sgl_destroy_context(gc->atlas_ctx);
+    sg_destroy_sampler(gc->smp_nearest);
+    sg_destroy_sampler(gc->smp_linear);
+    free(gc);
+}
+
+// expand alpha-only fontstash pixels to white RGBA8 pixels
+static void _gcache_expand(uint32_t* dst, const uint8_t* src, int num_pixels) {
+    for (int i = 0; i < num_pixels; i++) {
+        dst[i] = 0x00FFFFFF | ((uint32_t)src[i] << 24);
+    }
+}
+
+static inline FONScontext* gcache_create(const gcache_desc_t* desc) {
+    assert(desc && (desc->width > 0) && (desc->height > 0));
+    _gcache_t* gc = (_gcache_t*) calloc(1, sizeof(_gcache_t));
+    assert(gc);
+    gc->mode = desc->mode;
+    gc->smp_linear = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "gcache-sampler",
+    });
+    gc->smp_nearest = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "gcache-staging-sampler",
+    });
+    // a sokol-gl context which copies staging texture content into the atlas
+    gc->atlas_ctx = sgl_make_context(&(sgl_context_desc_t){
+        .max_vertices = 16,
+        .max_commands = 4,
+        .color_format = SG_PIXELFORMAT_RGBA8,
+        .depth_format = SG_PIXELFORMAT_NONE,
+        .sample_count = 1,
+    });
+    // an alpha-blended pipeline for rendering text in the current context
+    gc->pip = sgl_make_pipeline(&(sg_pipeline_desc){
+        .colors[0].blend = {
+            .enabled = true,
+            .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
+            .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            .src_factor_alpha = SG_BLENDFACTOR_ONE,
+            .dst_factor_alpha = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        },
+        .label = "gcache-text-pipeline",
+    });
+    FONSparams params = {
+        .width = desc->width,
+        .height = desc->height,
+        .flags = FONS_ZERO_TOPLEFT,
+        .userPtr = gc,
+        .renderCreate = _gcache_render_create,
+        .renderResize = _gcache_render_resize,
+        .renderUpdate = _gcache_render_update,
+        .renderDraw = _gcache_render_draw,
+        .renderDelete = _gcache_render_delete,
+    };
+    return fonsCreateInternal(&params);
+}
+
+static inline void gcache_destroy(FONScontext* fs) {
+    assert(fs);
+    fonsDeleteInternal(fs);
+}
+
+static inline void gcache_set_mode(FONScontext* fs, gcache_upload_mode_t mode) {
+    assert(fs);
+    _gcache_t* gc = (_gcache_t*) fs->params.userPtr;
+    if (gc->mode != mode) {
+        gc->mode = mode;
+        // the other texture is out of date
+        gc->needs_clear = true;
+        _gcache_mark_dirty(gc, 0, 0, gc->width, gc->height);
+    }
+}
+
+static inline gcache_stats_t gcache_query_stats(FONScontext* fs) {
+    assert(fs);
+    return ((_gcache_t*) fs->params.userPtr)->stats;
+}
+
+/* rasterize a set of glyphs into the atlas without rendering them (works with any fontstash renderer) */
+static inline void gcache_prewarm(FONScontext* fs, int font, float size, float blur, const char* glyphs) {
+    assert(fs && glyphs);
+    fonsPushState(fs);
+    fonsSetFont(fs, font);
+    fonsSetSize(fs, size);
+    fonsSetBlur(fs, blur);
+    fonsTextBounds(fs, 0.0f, 0.0f, glyphs, 0, 0);
+    fonsPopState(fs);
+}
+
+static void _gcache_upload_full(_gcache_t* gc, int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        const int offset = y * gc->width + x0;
+        _gcache_expand(gc->full_pixels + offset, gc->tex_data + offset, x1 - x0);
+    }
+    const size_t num_bytes = (size_t)(gc->width * gc->height) * sizeof(uint32_t);
+    sg_update_image(gc->full_img, &(sg_image_data){
+        .subimage[0][0] = { .ptr = gc->full_pixels, .size = num_bytes }
+    });
+    gc->stats.upload_bytes = num_bytes;
+}
+
+static void _gcache_upload_dirty(_gcache_t* gc, int x0, int y0, int x1, int y1) {
+    // find the smallest staging texture which fits the dirty rows
+    const int h = y1 - y0;
+    int si = 0;
+    while ((si < (gc->num_staging - 1)) && (gc->staging_height[si] < h)) {
+        si++;
+    }
+    const int sh = gc->staging_height[si];
+    for (int y = 0; y < h; y++) {
+        _gcache_expand(gc->staging_pixels + y * gc->width + x0, gc->tex_data + (y0 + y) * gc->width + x0, x1 - x0);
+    }
+    const size_t num_bytes = (size_t)(gc->width * sh) * sizeof(uint32_t);
+    sg_update_image(gc->staging_img[si], &(sg_image_data){
+        .subimage[0][0] = { .ptr = gc->staging_pixels, .size = num_bytes }
+    });
+    gc->stats.upload_bytes = num_bytes;
+
+    // copy the staging rows into the atlas render target, atlas texel
+    // rows must end up at the same v coordinate on all backends
+    const float w = (float) gc->width;
+    const float fh = (float) gc->height;
+    const float fx0 = (float)x0; const float fx1 = (float)x1;
+    const float fy0 = (float)y0; const float fy1 = (float)y1;
+    const float u0 = fx0 / w; const float u1 = fx1 / w;
+    const float v0 = 0.0f; const float v1 = (float)h / (float)sh;
+    const sgl_context prev_ctx = sgl_get_context();
+    sgl_set_context(gc->atlas_ctx);
+    sgl_defaults();
+    sgl_matrix_mode_projection();
+    if (sg_query_features().origin_top_left) {
+        sgl_ortho(0.0f, w, fh, 0.0f, -1.0f, +1.0f);
+    } else {
+        sgl_ortho(0.0f, w, 0.0f, fh, -1.0f, +1.0f);
+    }
+    sgl_enable_texture();
+    sgl_texture(gc->staging_img[si], gc->smp_nearest);
+    sgl_begin_quads();
+    sgl_v2f_t2f(fx0, fy0, u0, v0);
+    sgl_v2f_t2f(fx1, fy0, u1, v0);
+    sgl_v2f_t2f(fx1, fy1, u1, v1);
+    sgl_v2f_t2f(fx0, fy1, u0, v1);
+    sgl_end();
+    sgl_set_context(prev_ctx);
+
+    sg_begin_pass(&(sg_pass){
+        .action.colors[0] = {
+            .load_action = gc->needs_clear ? SG_LOADACTION_CLEAR : SG_LOADACTION_LOAD,
+            .clear_value = { 1.0f, 1.0f, 1.0f, 0.0f },
+        },
+        .attachments = gc->atlas_atts,
+    });
+    sgl_context_draw(gc->atlas_ctx);
+    sg_end_pass();
+    gc->needs_clear = false;
+}
+
+/* upload the dirty atlas area, call once per frame outside a render pass */
+static inline void gcache_flush(FONScontext* fs) {
+    assert(fs);
+    _gcache_t* gc = (_gcache_t*) fs->params.userPtr;
+    gc->stats.num_uploads = 0;
+    gc->stats.dirty_width = 0;
+    gc->stats.dirty_height = 0;
+    gc->stats.upload_bytes = 0;
+    const int x0 = gc->dirty[0];
+    const int y0 = gc->dirty[1];
+    const int x1 = gc->dirty[2];
+    const int y1 = gc->dirty[3];
+    if ((x0 >= x1) || (y0 >= y1) || !gc->tex_data) {
+        return;
+    }
+    if (gc->mode == GCACHE_UPLOAD_FULL) {
+        _gcache_upload_full(gc, x0, y0, x1, y1);
+    } else {
+        _gcache_upload_dirty(gc, x0, y0, x1, y1);
+    }
+    _gcache_clear_dirty(gc);
+    gc->stats.num_uploads = 1;
+    gc->stats.dirty_width = x1 - x0;
+    gc->stats.dirty_height = y1 - y0;
+    gc->stats.total_uploads++;
+    gc->stats.total_upload_bytes += gc->stats.upload_bytes;
+}
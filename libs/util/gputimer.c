@@ -0,0 +1,390 @@
+// GPU timers for sokol-gfx passes, see gputimer.h
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "gputimer.h"
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(SOKOL_GLCORE)
+#define _GPUTIMER_GL (1)
+#if defined(_WIN32)
+// opengl32.dll only exports the GL 1.1 functions, the query functions are loaded at runtime
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+#define _GPUTIMER_GLAPIENTRY APIENTRY
+#elif defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#define _GPUTIMER_GLAPIENTRY
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#define _GPUTIMER_GLAPIENTRY
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+typedef void (_GPUTIMER_GLAPIENTRY *_gputimer_glGenQueries_t)(GLsizei n, GLuint* ids);
+typedef void (_GPUTIMER_GLAPIENTRY *_gputimer_glDeleteQueries_t)(GLsizei n, const GLuint* ids);
+typedef void (_GPUTIMER_GLAPIENTRY *_gputimer_glQueryCounter_t)(GLuint id, GLenum target);
+typedef void (_GPUTIMER_GLAPIENTRY *_gputimer_glGetQueryObjectiv_t)(GLuint id, GLenum pname, GLint* params);
+typedef void (_GPUTIMER_GLAPIENTRY *_gputimer_glGetQueryObjectui64v_t)(GLuint id, GLenum pname, uint64_t* params);
+#elif defined(SOKOL_D3D11)
+#define _GPUTIMER_D3D11 (1)
+#ifndef D3D11_NO_HELPERS
+#define D3D11_NO_HELPERS
+#endif
+#include <d3d11.h>
+#endif
+// Metal: sokol-gfx has no public accessor for the frame's command buffer, so
+// there's no GPU frame time, WebGPU and GLES3 have no timestamp queries
+
+// the last query pair measures the whole frame
+#define _GPUTIMER_FRAME_TIMER (GPUTIMER_MAX_TIMERS)
+#define _GPUTIMER_NUM_QUERIES (GPUTIMER_MAX_TIMERS + 1)
+
+typedef struct {
+    bool pending;                           // queries issued but not read back yet
+    bool begun[_GPUTIMER_NUM_QUERIES];
+    bool ended[_GPUTIMER_NUM_QUERIES];
+    #if defined(_GPUTIMER_GL)
+    GLuint begin_query[_GPUTIMER_NUM_QUERIES];
+    GLuint end_query[_GPUTIMER_NUM_QUERIES];
+    #elif defined(_GPUTIMER_D3D11)
+    ID3D11Query* disjoint_query;
+    ID3D11Query* begin_query[_GPUTIMER_NUM_QUERIES];
+    ID3D11Query* end_query[_GPUTIMER_NUM_QUERIES];
+    #endif
+} _gputimer_frame_t;
+
+static struct {
+    bool valid;
+    bool supported;             // per-timer measurements
+    bool frame_on_gpu;          // frame time is measured on the GPU
+    bool in_frame;
+    bool disjoint;              // the latest measured frame had no valid timestamps
+    int cur_frame;
+    uint64_t last_frame_start;  // for the CPU frame time fallback
+    _gputimer_frame_t frames[GPUTIMER_NUM_FRAMES];
+    double ms[_GPUTIMER_NUM_QUERIES];
+    #if defined(_GPUTIMER_GL)
+    struct {
+        _gputimer_glGenQueries_t GenQueries;
+        _gputimer_glDeleteQueries_t DeleteQueries;
+        _gputimer_glQueryCounter_t QueryCounter;
+        _gputimer_glGetQueryObjectiv_t GetQueryObjectiv;
+        _gputimer_glGetQueryObjectui64v_t GetQueryObjectui64v;
+    } gl;
+    #elif defined(_GPUTIMER_D3D11)
+    struct {
+        ID3D11Device* dev;
+        ID3D11DeviceContext* ctx;
+    } d3d11;
+    #endif
+} _gputimer;
+
+#if defined(_GPUTIMER_D3D11)
+static inline HRESULT _gputimer_d3d11_CreateQuery(ID3D11Device* self, const D3D11_QUERY_DESC* desc, ID3D11Query** query) {
+    #if defined(__cplusplus)
+        return self->CreateQuery(desc, query);
+    #else
+        return self->lpVtbl->CreateQuery(self, desc, query);
+    #endif
+}
+
+static inline void _gputimer_d3d11_Release(ID3D11Query* self) {
+    #if defined(__cplusplus)
+        self->Release();
+    #else
+        self->lpVtbl->Release(self);
+    #endif
+}
+
+static inline void _gputimer_d3d11_Begin(ID3D11DeviceContext* self, ID3D11Query* query) {
+    #if defined(__cplusplus)
+        self->Begin(query);
+    #else
+        self->lpVtbl->Begin(self, (ID3D11Asynchronous*)query);
+    #endif
+}
+
+static inline void _gputimer_d3d11_End(ID3D11DeviceContext* self, ID3D11Query* query) {
+    #if defined(__cplusplus)
+        self->End(query);
+    #else
+        self->lpVtbl->End(self, (ID3D11Asynchronous*)query);
+    #endif
+}
+
+static inline HRESULT _gputimer_d3d11_GetData(ID3D11DeviceContext* self, ID3D11Query* query, void* data, UINT size) {
+    #if defined(__cplusplus)
+        return self->GetData(query, data, size, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+    #else
+        return self->lpVtbl->GetData(self, (ID3D11Asynchronous*)query, data, size, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+    #endif
+}
+#endif
+
+// try to read back the results of a frame, returns false if they are not available yet
+static bool _gputimer_resolve(_gputimer_frame_t* frame) {
+    #if defined(_GPUTIMER_GL)
+        for (int i = 0; i < _GPUTIMER_NUM_QUERIES; i++) {
+            if (frame->begun[i] && frame->ended[i]) {
+                GLint available = 0;
+                _gputimer.gl.GetQueryObjectiv(frame->end_query[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) {
+                    return false;
+                }
+            }
+        }
+        for (int i = 0; i < _GPUTIMER_NUM_QUERIES; i++) {
+            if (frame->begun[i] && frame->ended[i]) {
+                uint64_t t0 = 0, t1 = 0;
+                _gputimer.gl.GetQueryObjectui64v(frame->begin_query[i], GL_QUERY_RESULT, &t0);
+                _gputimer.gl.GetQueryObjectui64v(frame->end_query[i], GL_QUERY_RESULT, &t1);
+                _gputimer.ms[i] = (double)(t1 - t0) / 1000000.0;
+            } else {
+                _gputimer.ms[i] = 0.0;
+            }
+        }
+        return true;
+    #elif defined(_GPUTIMER_D3D11)
+        ID3D11DeviceContext* ctx = _gputimer.d3d11.ctx;
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+        if (S_OK != _gputimer_d3d11_GetData(ctx, frame->disjoint_query, &disjoint, sizeof(disjoint))) {
+            return false;
+        }
+        uint64_t t0[_GPUTIMER_NUM_QUERIES], t1[_GPUTIMER_NUM_QUERIES];
+        for (int i = 0; i < _GPUTIMER_NUM_QUERIES; i++) {
+            if (frame->begun[i] && frame->ended[i]) {
+                if ((S_OK != _gputimer_d3d11_GetData(ctx, frame->begin_query[i], &t0[i], sizeof(uint64_t))) ||
+                    (S_OK != _gputimer_d3d11_GetData(ctx, frame->end_query[i], &t1[i], sizeof(uint64_t))))
+                {
+                    return false;
+                }
+            }
+        }
+        // timestamps are useless if the GPU clock changed during the frame
+        _gputimer.disjoint = disjoint.Disjoint;
+        for (int i = 0; i < _GPUTIMER_NUM_QUERIES; i++) {
+            if (!disjoint.Disjoint && frame->begun[i] && frame->ended[i]) {
+                _gputimer.ms[i] = (double)(t1[i] - t0[i]) * 1000.0 / (double)disjoint.Frequency;
+            } else {
+                _gputimer.ms[i] = 0.0;
+            }
+        }
+        return true;
+    #else
+        (void)frame;
+        return true;
+    #endif
+}
+
+static void _gputimer_begin_query(int timer) {
+    #if defined(_GPUTIMER_GL) || defined(_GPUTIMER_D3D11)
+    _gputimer_frame_t* frame = &_gputimer.frames[_gputimer.cur_frame];
+    assert(!frame->begun[timer]);
+    frame->begun[timer] = true;
+    #if defined(_GPUTIMER_GL)
+        _gputimer.gl.QueryCounter(frame->begin_query[timer], GL_TIMESTAMP);
+    #elif defined(_GPUTIMER_D3D11)
+        _gputimer_d3d11_End(_gputimer.d3d11.ctx, frame->begin_query[timer]);
+    #endif
+    #else
+    (void)timer;
+    #endif
+}
+
+static void _gputimer_end_query(int timer) {
+    #if defined(_GPUTIMER_GL) || defined(_GPUTIMER_D3D11)
+    _gputimer_frame_t* frame = &_gputimer.frames[_gputimer.cur_frame];
+    assert(frame->begun[timer] && !frame->ended[timer]);
+    frame->ended[timer] = true;
+    #if defined(_GPUTIMER_GL)
+        _gputimer.gl.QueryCounter(frame->end_query[timer], GL_TIMESTAMP);
+    #elif defined(_GPUTIMER_D3D11)
+        _gputimer_d3d11_End(_gputimer.d3d11.ctx, frame->end_query[timer]);
+    #endif
+    #else
+    (void)timer;
+    #endif
+}
+
+void gputimer_setup(void) {
+    assert(!_gputimer.valid);
+    memset(&_gputimer, 0, sizeof(_gputimer));
+    _gputimer.valid = true;
+    #if defined(_GPUTIMER_GL)
+        #if defined(_WIN32)
+            _gputimer.gl.GenQueries = (_gputimer_glGenQueries_t)(void*) wglGetProcAddress("glGenQueries");
+            _gputimer.gl.DeleteQueries = (_gputimer_glDeleteQueries_t)(void*) wglGetProcAddress("glDeleteQueries");
+            _gputimer.gl.QueryCounter = (_gputimer_glQueryCounter_t)(void*) wglGetProcAddress("glQueryCounter");
+            _gputimer.gl.GetQueryObjectiv = (_gputimer_glGetQueryObjectiv_t)(void*) wglGetProcAddress("glGetQueryObjectiv");
+            _gputimer.gl.GetQueryObjectui64v = (_gputimer_glGetQueryObjectui64v_t)(void*) wglGetProcAddress("glGetQueryObjectui64v");
+        #else
+            _gputimer.gl.GenQueries = glGenQueries;
+            _gputimer.gl.DeleteQueries = glDeleteQueries;
+            _gputimer.gl.QueryCounter = glQueryCounter;
+            _gputimer.gl.GetQueryObjectiv = glGetQueryObjectiv;
+            _gputimer.gl.GetQueryObjectui64v = (_gputimer_glGetQueryObjectui64v_t) glGetQueryObjectui64v;
+        #endif
+        _gputimer.supported = _gputimer.gl.GenQueries && _gputimer.gl.DeleteQueries && _gputimer.gl.QueryCounter &&
+                              _gputimer.gl.GetQueryObjectiv && _gputimer.gl.GetQueryObjectui64v;
+        if (_gputimer.supported) {
+            for (int i = 0; i < GPUTIMER_NUM_FRAMES; i++) {
+                _gputimer.gl.GenQueries(_GPUTIMER_NUM_QUERIES, _gputimer.frames[i].begin_query);
+                _gputimer.gl.GenQueries(_GPUTIMER_NUM_QUERIES, _gputimer.frames[i].end_query);
+            }
+        }
+    #elif defined(_GPUTIMER_D3D11)
+        _gputimer.d3d11.dev = (ID3D11Device*) sg_d3d11_device();
+        _gputimer.d3d11.ctx = (ID3D11DeviceContext*) sg_d3d11_device_context();
+        _gputimer.supported = (0 != _gputimer.d3d11.dev) && (0 != _gputimer.d3d11.ctx);
+        D3D11_QUERY_DESC disjoint_desc;
+        memset(&disjoint_desc, 0, sizeof(disjoint_desc));
+        disjoint_desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+        D3D11_QUERY_DESC ts_desc;
+        memset(&ts_desc, 0, sizeof(ts_desc));
+        ts_desc.Query = D3D11_QUERY_TIMESTAMP;
+        for (int i = 0; _gputimer.supported && (i < GPUTIMER_NUM_FRAMES); i++) {
+            _gputimer_frame_t* frame = &_gputimer.frames[i];
+            if (!SUCCEEDED(_gputimer_d3d11_CreateQuery(_gputimer.d3d11.dev, &disjoint_desc, &frame->disjoint_query))) {
+                _gputimer.supported = false;
+            }
+            for (int t = 0; t < _GPUTIMER_NUM_QUERIES; t++) {
+                if (!SUCCEEDED(_gputimer_d3d11_CreateQuery(_gputimer.d3d11.dev, &ts_desc, &frame->begin_query[t])) ||
+                    !SUCCEEDED(_gputimer_d3d11_CreateQuery(_gputimer.d3d11.dev, &ts_desc, &frame->end_query[t])))
+                {
+                    _gputimer.supported = false;
+                }
+            }
+        }
+    #endif
+    _gputimer.frame_on_gpu = _gputimer.supported;
+}
+
+void gputimer_shutdown(void) {
+    assert(_gputimer.valid);
+    #if defined(_GPUTIMER_GL)
+        if (_gputimer.supported) {
+            for (int i = 0; i < GPUTIMER_NUM_FRAMES; i++) {
+                _gputimer.gl.DeleteQueries(_GPUTIMER_NUM_QUERIES, _gputimer.frames[i].begin_query);
+                _gputimer.gl.DeleteQueries(_GPUTIMER_NUM_QUERIES, _gputimer.frames[i].end_query);
+            }
+        }
+    #elif defined(_GPUTIMER_D3D11)
+        for (int i = 0; i < GPUTIMER_NUM_FRAMES; i++) {
+            _gputimer_frame_t* frame = &_gputimer.frames[i];
+            if (frame->disjoint_query) {
+                _gputimer_d3d11_Release(frame->disjoint_query);
+            }
+            for (int t = 0; t < _GPUTIMER_NUM_QUERIES; t++) {
+                if (frame->begin_query[t]) {
+                    _gputimer_d3d11_Release(frame->begin_query[t]);
+                }
+                if (frame->end_query[t]) {
+                    _gputimer_d3d11_Release(frame->end_query[t]);
+                }
+            }
+        }
+    #endif
+    _gputimer.valid = false;
+}
+
+bool gputimer_supported(void) {
+    return _gputimer.valid && _gputimer.supported;
+}
+
+void gputimer_begin_frame(void) {
+    assert(_gputimer.valid && !_gputimer.in_frame);
+    _gputimer.in_frame = true;
+    if (!_gputimer.frame_on_gpu) {
+        // CPU frame time fallback, from the start of the previous frame to the start of this frame
+        const uint64_t now = stm_now();
+        if (0 != _gputimer.last_frame_start) {
+            _gputimer.ms[_GPUTIMER_FRAME_TIMER] = stm_ms(stm_diff(now, _gputimer.last_frame_start));
+        }
+        _gputimer.last_frame_start = now;
+        return;
+    }
+    // read back finished frames from oldest to newest, a frame which
+    // is still not finished when its queries are needed again is dropped
+    const int next = (_gputimer.cur_frame + 1) % GPUTIMER_NUM_FRAMES;
+    for (int i = 0; i < GPUTIMER_NUM_FRAMES; i++) {
+        _gputimer_frame_t* frame = &_gputimer.frames[(next + i) % GPUTIMER_NUM_FRAMES];
+        if (frame->pending) {
+            if (!_gputimer_resolve(frame)) {
+                break;
+            }
+            frame->pending = false;
+        }
+    }
+    _gputimer.cur_frame = next;
+    _gputimer_frame_t* frame = &_gputimer.frames[next];
+    frame->pending = false;
+    for (int i = 0; i < _GPUTIMER_NUM_QUERIES; i++) {
+        frame->begun[i] = frame->ended[i] = false;
+    }
+    #if defined(_GPUTIMER_D3D11)
+        _gputimer_d3d11_Begin(_gputimer.d3d11.ctx, frame->disjoint_query);
+    #endif
+    _gputimer_begin_query(_GPUTIMER_FRAME_TIMER);
+}
+
+void gputimer_end_frame(void) {
+    assert(_gputimer.valid && _gputimer.in_frame);
+    _gputimer.in_frame = false;
+    if (!_gputimer.frame_on_gpu) {
+        return;
+    }
+    _gputimer_end_query(_GPUTIMER_FRAME_TIMER);
+    _gputimer_frame_t* frame = &_gputimer.frames[_gputimer.cur_frame];
+    #if defined(_GPUTIMER_D3D11)
+        _gputimer_d3d11_End(_gputimer.d3d11.ctx, frame->disjoint_query);
+    #endif
+    frame->pending = true;
+}
+
+void gputimer_begin(int timer) {
+    assert(_gputimer.valid && _gputimer.in_frame);
+    assert((timer >= 0) && (timer < GPUTIMER_MAX_TIMERS));
+    if (_gputimer.supported) {
+        _gputimer_begin_query(timer);
+    }
+}
+
+void gputimer_end(int timer) {
+    assert(_gputimer.valid && _gputimer.in_frame);
+    assert((timer >= 0) && (timer < GPUTIMER_MAX_TIMERS));
+    if (_gputimer.supported) {
+        _gputimer_end_query(timer);
+    }
+}
+
+double gputimer_ms(int timer) {
+    assert((timer >= 0) && (timer < GPUTIMER_MAX_TIMERS));
+    return _gputimer.ms[timer];
+}
+
+double gputimer_frame_ms(void) {
+    return _gputimer.ms[_GPUTIMER_FRAME_TIMER];
+}
+
+bool gputimer_frame_on_gpu(void) {
+    return _gputimer.valid && _gputimer.frame_on_gpu;
+}
+
+bool gputimer_disjoint(void) {
+    return _gputimer.valid && _gputimer.disjoint;
+}
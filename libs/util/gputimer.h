@@ -0,0 +1,231 @@
+#pragma once
+/*
+    GPU timers for sokol-gfx passes.
+
+    Measures the GPU time between two points in the sokol-gfx command
+    stream with backend timestamp queries. Results are read back without
+    stalling, so they arrive a few frames late:
+
+        // after sg_setup() and stm_setup()
+        gputimer_setup();
+        ...
+        // each frame
+        gputimer_begin_frame();
+        gputimer_begin(0);
+        sg_begin_pass(...); ... sg_end_pass();
+        gputimer_end(0);
+        gputimer_begin(1);
+        sg_begin_pass(...); ... sg_end_pass();
+        gputimer_end(1);
+        gputimer_end_frame();
+        sg_commit();
+        ...
+        // latest measured time of timer 0 in milliseconds
+        double ms = gputimer_ms(0);
+        ...
+        // before sg_shutdown()
+        gputimer_shutdown();
+
+    Timers may overlap and nest (e.g. one timer around the whole frame
+    and one per pass), put begin and end outside of render passes.
+
+    Per-timer measurements are supported on desktop GL (GL_TIMESTAMP
+    queries, GL 3.3) and D3D11 (timestamp and disjoint queries). On Metal,
+    WebGPU and GLES3/WebGL2 gputimer_supported() returns false and all
+    timer results stay 0.
+
+    Independent of the per-timer support, gputimer_frame_ms() returns the
+    time of the whole frame between gputimer_begin_frame() and
+    gputimer_end_frame(), so that samples have a frame time to show on
+    all backends:
+
+    - GL and D3D11: GPU time measured with the same timestamp queries
+    - Metal, WebGPU and GLES3/WebGL2: CPU time between two
+      gputimer_begin_frame() calls, gputimer_frame_on_gpu() returns false
+
+    On D3D11 the timestamps of a frame are useless if the GPU clock
+    changed during the frame. All results of such a frame are 0 and
+    gputimer_disjoint() returns true until the next frame is read back.
+
+    Because results arrive late, they are usually averaged over a number
+    of frames, and after the measured configuration changes the first
+    frames must be skipped. gputimer_avg_t does both:
+
+        gputimer_avg_t avg;
+        gputimer_avg_init(&avg, 60);        // average over 60 frames
+        ...
+        // once per frame, optionally with CPU times of the same frame
+        gputimer_avg_add_cpu(&avg, cpu_ms);
+        if (gputimer_avg_update(&avg)) {
+            // a new average is available
+            double ms = gputimer_avg_ms(&avg, 0);
+            double frame_ms = gputimer_avg_frame_ms(&avg);
+            double cpu_ms = gputimer_avg_cpu_ms(&avg);
+        }
+        ...
+        // after changing what is measured, skips GPUTIMER_WARMUP_FRAMES
+        gputimer_avg_reset(&avg);
+
+    Disjoint frames are not added to the average.
+
+    gputimer_bench_t steps a benchmark through a number of configurations
+    and averages each one:
+
+        gputimer_bench_start(&bench, num_configs, 120);
+        apply_config(0);
+        ...
+        // once per frame
+        if (gputimer_bench_update(&bench)) {
+            // the current configuration is done, bench.avg has the results
+            results[bench.config] = gputimer_avg_ms(&bench.avg, 0);
+            if (gputimer_bench_next(&bench)) {
+                apply_config(bench.config);
+            } else {
+                // bench.done is true
+            }
+        }
+
+    The implementation is in gputimer.c (the 'gputimer' library), it
+    only uses the public sokol-gfx and sokol-time API. The CPU frame time
+    fallback uses sokol_time.h, so stm_setup() must be called before
+    gputimer_setup().
+*/
+#include <stdbool.h>
+#include <string.h> // memset
+
+#define GPUTIMER_MAX_TIMERS (16)
+#define GPUTIMER_NUM_FRAMES (4)     // max number of frames in flight before a result is dropped
+#define GPUTIMER_WARMUP_FRAMES (2 * GPUTIMER_NUM_FRAMES)    // frames skipped after gputimer_avg_reset()
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void gputimer_setup(void);
+void gputimer_shutdown(void);
+bool gputimer_supported(void);
+void gputimer_begin_frame(void);
+void gputimer_end_frame(void);
+void gputimer_begin(int timer);
+void gputimer_end(int timer);
+// time in milliseconds in the latest measured frame, 0 if not supported or the timer wasn't used in that frame
+double gputimer_ms(int timer);
+// latest measured frame time in milliseconds, GPU time if gputimer_frame_on_gpu() is true, otherwise CPU time
+double gputimer_frame_ms(void);
+bool gputimer_frame_on_gpu(void);
+// true if the latest measured frame was disjoint (D3D11 only), all results are 0 then
+bool gputimer_disjoint(void);
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif
+
+typedef struct {
+    double timer[GPUTIMER_MAX_TIMERS];
+    double frame;
+    double cpu;
+} gputimer_times_t;
+
+typedef struct {
+    int num_frames;         // number of frames to average
+    int warmup_frames;      // frames to skip before accumulating
+    int frame;              // frames since the last reset or average
+    bool valid;             // true once an average is available
+    double cpu_ms;          // CPU time added in the current frame
+    gputimer_times_t accum;
+    gputimer_times_t ms;    // the latest average
+} gputimer_avg_t;
+
+typedef struct {
+    bool active;
+    bool done;
+    int config;
+    int num_configs;
+    gputimer_avg_t avg;
+} gputimer_bench_t;
+
+// start over, the next GPUTIMER_WARMUP_FRAMES frames are skipped
+static inline void gputimer_avg_reset(gputimer_avg_t* avg) {
+    const int num_frames = avg->num_frames;
+    memset(avg, 0, sizeof(gputimer_avg_t));
+    avg->num_frames = num_frames;
+    avg->warmup_frames = GPUTIMER_WARMUP_FRAMES;
+}
+
+static inline void gputimer_avg_init(gputimer_avg_t* avg, int num_frames) {
+    avg->num_frames = num_frames > 0 ? num_frames : 1;
+    gputimer_avg_reset(avg);
+}
+
+// add CPU time measured in the current frame
+static inline void gputimer_avg_add_cpu(gputimer_avg_t* avg, double ms) {
+    avg->cpu_ms += ms;
+}
+
+// call once per frame, returns true when a new average is available
+static inline bool gputimer_avg_update(gputimer_avg_t* avg) {
+    const double cpu_ms = avg->cpu_ms;
+    avg->cpu_ms = 0.0;
+    if (avg->frame++ < avg->warmup_frames) {
+        return false;
+    }
+    if (gputimer_disjoint()) {
+        // no valid results in this frame, don't count it
+        avg->frame--;
+        return false;
+    }
+    for (int i = 0; i < GPUTIMER_MAX_TIMERS; i++) {
+        avg->accum.timer[i] += gputimer_ms(i);
+    }
+    avg->accum.frame += gputimer_frame_ms();
+    avg->accum.cpu += cpu_ms;
+    if (avg->frame < (avg->warmup_frames + avg->num_frames)) {
+        return false;
+    }
+    for (int i = 0; i < GPUTIMER_MAX_TIMERS; i++) {
+        avg->ms.timer[i] = avg->accum.timer[i] / avg->num_frames;
+    }
+    avg->ms.frame = avg->accum.frame / avg->num_frames;
+    avg->ms.cpu = avg->accum.cpu / avg->num_frames;
+    memset(&avg->accum, 0, sizeof(avg->accum));
+    avg->frame = 0;
+    // the following frames measure the same configuration, no warmup needed
+    avg->warmup_frames = 0;
+    avg->valid = true;
+    return true;
+}
+
+static inline double gputimer_avg_ms(const gputimer_avg_t* avg, int timer) {
+    return avg->ms.timer[timer];
+}
+
+static inline double gputimer_avg_frame_ms(const gputimer_avg_t* avg) {
+    return avg->ms.frame;
+}
+
+static inline double gputimer_avg_cpu_ms(const gputimer_avg_t* avg) {
+    return avg->ms.cpu;
+}
+
+static inline void gputimer_bench_start(gputimer_bench_t* bench, int num_configs, int num_frames) {
+    bench->active = num_configs > 0;
+    bench->done = !bench->active;
+    bench->config = 0;
+    bench->num_configs = num_configs;
+    gputimer_avg_init(&bench->avg, num_frames);
+}
+
+// call once per frame, returns true when the current configuration is done
+static inline bool gputimer_bench_update(gputimer_bench_t* bench) {
+    return bench->active && gputimer_avg_update(&bench->avg);
+}
+
+// advance to the next configuration, returns false when the benchmark is done
+static inline bool gputimer_bench_next(gputimer_bench_t* bench) {
+    gputimer_avg_reset(&bench->avg);
+    if (++bench->config >= bench->num_configs) {
+        bench->active = false;
+        bench->done = true;
+    }
+    return bench->active;
+}
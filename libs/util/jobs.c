@@ -0,0 +1,290 @@
+// a minimal worker thread pool, see jobs.h
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+#include "jobs.h"
+#include <string.h>
+#include <assert.h>
+#if JOBS_HAS_THREADS
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/threading.h>
+#endif
+#endif
+#endif
+
+#define JOBS_QUEUE_SIZE (4096)
+#define JOBS_MAX_BATCHES (256)
+
+typedef struct {
+    jobs_func_t func;
+    void* user_data;
+    int job_index;
+    int slot;
+} _jobs_item_t;
+
+typedef struct {
+    uint32_t gen;
+    int pending;
+} _jobs_slot_t;
+
+#if JOBS_HAS_THREADS
+#if defined(_WIN32)
+typedef CRITICAL_SECTION _jobs_mutex_t;
+typedef CONDITION_VARIABLE _jobs_cond_t;
+typedef HANDLE _jobs_thread_t;
+#define _jobs_mutex_init(m) InitializeCriticalSection(m)
+#define _jobs_mutex_destroy(m) DeleteCriticalSection(m)
+#define _jobs_lock(m) EnterCriticalSection(m)
+#define _jobs_unlock(m) LeaveCriticalSection(m)
+#define _jobs_cond_init(c) InitializeConditionVariable(c)
+#define _jobs_cond_destroy(c) ((void)c)
+#define _jobs_cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define _jobs_cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_mutex_t _jobs_mutex_t;
+typedef pthread_cond_t _jobs_cond_t;
+typedef pthread_t _jobs_thread_t;
+#define _jobs_mutex_init(m) pthread_mutex_init(m, 0)
+#define _jobs_mutex_destroy(m) pthread_mutex_destroy(m)
+#define _jobs_lock(m) pthread_mutex_lock(m)
+#define _jobs_unlock(m) pthread_mutex_unlock(m)
+#define _jobs_cond_init(c) pthread_cond_init(c, 0)
+#define _jobs_cond_destroy(c) pthread_cond_destroy(c)
+#define _jobs_cond_wait(c, m) pthread_cond_wait(c, m)
+#define _jobs_cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+#endif
+
+static struct {
+    bool valid;
+    int num_threads;
+    #if JOBS_HAS_THREADS
+    bool quit;
+    _jobs_thread_t threads[JOBS_MAX_THREADS];
+    _jobs_mutex_t mutex;
+    _jobs_cond_t work_cond;
+    _jobs_cond_t done_cond;
+    _jobs_item_t queue[JOBS_QUEUE_SIZE];
+    int queue_head;
+    int queue_count;
+    _jobs_slot_t slots[JOBS_MAX_BATCHES];
+    int next_slot;
+    #endif
+} _jobs;
+
+int jobs_num_cores(void) {
+    #if !JOBS_HAS_THREADS
+    return 1;
+    #elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+    #elif defined(__EMSCRIPTEN__)
+    return emscripten_num_logical_cores();
+    #else
+    const long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_cores > 0) ? (int)num_cores : 1;
+    #endif
+}
+
+#if JOBS_HAS_THREADS
+// pop a job from the queue, must be called with the mutex locked
+static _jobs_item_t _jobs_pop(void) {
+    assert(_jobs.queue_count > 0);
+    _jobs_item_t item = _jobs.queue[_jobs.queue_head];
+    _jobs.queue_head = (_jobs.queue_head + 1) % JOBS_QUEUE_SIZE;
+    _jobs.queue_count--;
+    return item;
+}
+
+// run a popped job, must be called with the mutex locked
+static void _jobs_run(const _jobs_item_t* item) {
+    _jobs_unlock(&_jobs.mutex);
+    item->func(item->job_index, item->user_data);
+    _jobs_lock(&_jobs.mutex);
+    if (--_jobs.slots[item->slot].pending == 0) {
+        _jobs_cond_broadcast(&_jobs.done_cond);
+    }
+}
+
+// must be called with the mutex locked
+static bool _jobs_done_locked(jobs_batch_t batch) {
+    const _jobs_slot_t* slot = &_jobs.slots[batch.id % JOBS_MAX_BATCHES];
+    return (slot->gen != (batch.id / JOBS_MAX_BATCHES)) || (slot->pending == 0);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _jobs_thread_func(LPVOID arg) {
+#else
+static void* _jobs_thread_func(void* arg) {
+#endif
+    (void)arg;
+    _jobs_lock(&_jobs.mutex);
+    while (true) {
+        while (!_jobs.quit && (_jobs.queue_count == 0)) {
+            _jobs_cond_wait(&_jobs.work_cond, &_jobs.mutex);
+        }
+        if (_jobs.queue_count == 0) {
+            // quit requested and no more work
+            break;
+        }
+        const _jobs_item_t item = _jobs_pop();
+        _jobs_run(&item);
+    }
+    _jobs_unlock(&_jobs.mutex);
+    return 0;
+}
+#endif
+
+void jobs_setup(const jobs_desc_t* desc) {
+    assert(desc && !_jobs.valid);
+    memset(&_jobs, 0, sizeof(_jobs));
+    _jobs.valid = true;
+    #if JOBS_HAS_THREADS
+    int num_threads = desc->num_threads;
+    if (num_threads <= 0) {
+        num_threads = jobs_num_cores() - 1;
+    }
+    if (num_threads > JOBS_MAX_THREADS) {
+        num_threads = JOBS_MAX_THREADS;
+    }
+    _jobs_mutex_init(&_jobs.mutex);
+    _jobs_cond_init(&_jobs.work_cond);
+    _jobs_cond_init(&_jobs.done_cond);
+    for (int i = 0; i < num_threads; i++) {
+        #if defined(_WIN32)
+        _jobs.threads[i] = CreateThread(NULL, 0, _jobs_thread_func, NULL, 0, NULL);
+        const bool ok = (_jobs.threads[i] != NULL);
+        #else
+        const bool ok = (0 == pthread_create(&_jobs.threads[i], 0, _jobs_thread_func, 0));
+        #endif
+        if (!ok) {
+            break;
+        }
+        _jobs.num_threads++;
+    }
+    #else
+    (void)desc;
+    #endif
+}
+
+void jobs_shutdown(void) {
+    assert(_jobs.valid);
+    #if JOBS_HAS_THREADS
+    _jobs_lock(&_jobs.mutex);
+    _jobs.quit = true;
+    _jobs_cond_broadcast(&_jobs.work_cond);
+    _jobs_unlock(&_jobs.mutex);
+    for (int i = 0; i < _jobs.num_threads; i++) {
+        #if defined(_WIN32)
+        WaitForSingleObject(_jobs.threads[i], INFINITE);
+        CloseHandle(_jobs.threads[i]);
+        #else
+        pthread_join(_jobs.threads[i], 0);
+        #endif
+    }
+    _jobs_cond_destroy(&_jobs.done_cond);
+    _jobs_cond_destroy(&_jobs.work_cond);
+    _jobs_mutex_destroy(&_jobs.mutex);
+    #endif
+    _jobs.valid = false;
+}
+
+int jobs_num_threads(void) {
+    assert(_jobs.valid);
+    return _jobs.num_threads;
+}
+
+jobs_batch_t jobs_dispatch(jobs_func_t func, void* user_data, int num_jobs) {
+    assert(_jobs.valid && func);
+    jobs_batch_t batch = { 0 };
+    int num_queued = 0;
+    #if JOBS_HAS_THREADS
+    if ((num_jobs > 0) && (_jobs.num_threads > 0)) {
+        _jobs_lock(&_jobs.mutex);
+        // find a free batch slot
+        int slot_index = -1;
+        for (int i = 0; i < JOBS_MAX_BATCHES; i++) {
+            const int idx = (_jobs.next_slot + i) % JOBS_MAX_BATCHES;
+            if (_jobs.slots[idx].pending == 0) {
+                slot_index = idx;
+                break;
+            }
+        }
+        if (slot_index >= 0) {
+            _jobs_slot_t* slot = &_jobs.slots[slot_index];
+            _jobs.next_slot = (slot_index + 1) % JOBS_MAX_BATCHES;
+            slot->gen = (slot->gen + 1) % (UINT32_MAX / JOBS_MAX_BATCHES);
+            if (slot->gen == 0) {
+                slot->gen = 1;
+            }
+            slot->pending = num_jobs;
+            batch.id = slot->gen * JOBS_MAX_BATCHES + (uint32_t)slot_index;
+            // jobs that don't fit into the queue are run below on this thread
+            while ((num_queued < num_jobs) && (_jobs.queue_count < JOBS_QUEUE_SIZE)) {
+                const int tail = (_jobs.queue_head + _jobs.queue_count) % JOBS_QUEUE_SIZE;
+                _jobs.queue[tail] = (_jobs_item_t){
+                    .func = func,
+                    .user_data = user_data,
+                    .job_index = num_queued++,
+                    .slot = slot_index,
+                };
+                _jobs.queue_count++;
+            }
+            _jobs_cond_broadcast(&_jobs.work_cond);
+            for (int i = num_queued; i < num_jobs; i++) {
+                const _jobs_item_t item = { func, user_data, i, slot_index };
+                _jobs_run(&item);
+            }
+            num_queued = num_jobs;
+        }
+        _jobs_unlock(&_jobs.mutex);
+    }
+    #endif
+    // no threads or out of batch slots, run synchronously
+    for (int i = num_queued; i < num_jobs; i++) {
+        func(i, user_data);
+    }
+    return batch;
+}
+
+bool jobs_done(jobs_batch_t batch) {
+    assert(_jobs.valid);
+    if (batch.id == 0) {
+        return true;
+    }
+    #if JOBS_HAS_THREADS
+    _jobs_lock(&_jobs.mutex);
+    const bool done = _jobs_done_locked(batch);
+    _jobs_unlock(&_jobs.mutex);
+    return done;
+    #else
+    return true;
+    #endif
+}
+
+void jobs_wait(jobs_batch_t batch) {
+    assert(_jobs.valid);
+    if (batch.id == 0) {
+        return;
+    }
+    #if JOBS_HAS_THREADS
+    _jobs_lock(&_jobs.mutex);
+    while (!_jobs_done_locked(batch)) {
+        // help out with queued jobs instead of idling
+        if (_jobs.queue_count > 0) {
+            const _jobs_item_t item = _jobs_pop();
+            _jobs_run(&item);
+        } else {
+            _jobs_cond_wait(&_jobs.done_cond, &_jobs.mutex);
+        }
+    }
+    _jobs_unlock(&_jobs.mutex);
+    #endif
+}
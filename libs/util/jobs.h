@@ -0,0 +1,60 @@
+#pragma once
+/*
+    Quick'n'dirty worker thread pool for the samples.
+
+    Jobs are dispatched in batches, a batch is N invocations of the same
+    job function with a job index from 0 to N-1:
+
+        jobs_setup(&(jobs_desc_t){ 0 });
+        ...
+        jobs_batch_t batch = jobs_dispatch(my_func, my_data, num_jobs);
+        ...
+        // either poll for completion (e.g. once per frame)...
+        if (jobs_done(batch)) { ... }
+        // ...or block until done, the calling thread helps running jobs
+        jobs_wait(batch);
+        ...
+        jobs_shutdown();
+
+    Job functions must not call any sokol-gfx functions.
+
+    On platforms without thread support (e.g. the web without pthreads
+    enabled) jobs_dispatch() runs all jobs synchronously on the calling
+    thread and the returned batch is already done.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define JOBS_HAS_THREADS (0)
+#else
+#define JOBS_HAS_THREADS (1)
+#endif
+
+#define JOBS_MAX_THREADS (64)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef void (*jobs_func_t)(int job_index, void* user_data);
+
+typedef struct {
+    int num_threads;    // default: number of logical cores minus one
+} jobs_desc_t;
+
+typedef struct {
+    uint32_t id;
+} jobs_batch_t;
+
+void jobs_setup(const jobs_desc_t* desc);
+void jobs_shutdown(void);
+int jobs_num_threads(void);
+int jobs_num_cores(void);
+jobs_batch_t jobs_dispatch(jobs_func_t func, void* user_data, int num_jobs);
+bool jobs_done(jobs_batch_t batch);
+void jobs_wait(jobs_batch_t batch);
+
+#if defined(__cplusplus)
+}
+#endif
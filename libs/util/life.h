@@ -0,0 +1,287 @@
+#pragma once
+/*
+    Bit-packed Game of Life simulation.
+
+    Each cell is one bit, 64 cells are packed into a uint64_t. All cells of
+    a word are updated at once by adding up the 8 neighbour bit masks with a
+    bitwise adder network, with SSE2 two words are updated per instruction
+    (define LIFE_NO_SIMD to disable). The grid wraps around at the borders,
+    the width must be a multiple of 64. Each generation is split into row
+    bands which are updated in parallel on the util/jobs.h thread pool.
+
+    The cells are only expanded to RGBA8 pixels for uploading into a texture:
+
+        jobs_setup(&(jobs_desc_t){ 0 });
+        ...
+        life_t life;
+        life_init(&life, 1024, 1024);
+        life_randomize(&life, 12345);
+        ...
+        // each frame, 0 jobs means one job per thread
+        life_step(&life, 0);
+        life_to_rgba(&life, pixels, 0xFFFFFFFF, 0xFF000000, 0);
+        sg_update_image(img, ...);
+        ...
+        life_discard(&life);
+
+    Include after util/jobs.h, jobs_setup() must have been called.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if !defined(LIFE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>
+#define LIFE_SSE2 (1)
+#else
+#define LIFE_SSE2 (0)
+#endif
+
+#define LIFE_MAX_SIZE (4096)
+
+typedef struct {
+    int width;          // number of cells, multiple of 64
+    int height;
+    int num_words;      // words per row (without padding)
+    int stride;         // words per row including a padding word on each side
+    uint64_t* cur;
+    uint64_t* next;
+    uint64_t generation;
+} life_t;
+
+typedef struct {
+    life_t* life;
+    uint32_t* pixels;
+    uint32_t living;
+    uint32_t dead;
+    int num_jobs;
+} _life_job_t;
+
+static void life_init(life_t* life, int width, int height) {
+    assert(life);
+    assert((width >= 64) && (width <= LIFE_MAX_SIZE) && ((width & 63) == 0));
+    assert((height >= 1) && (height <= LIFE_MAX_SIZE));
+    memset(life, 0, sizeof(life_t));
+    life->width = width;
+    life->height = height;
+    life->num_words = width / 64;
+    life->stride = life->num_words + 2;
+    const size_t size = (size_t)(life->stride * height) * sizeof(uint64_t);
+    life->cur = (uint64_t*) calloc(1, size);
+    life->next = (uint64_t*) calloc(1, size);
+}
+
+static void life_discard(life_t* life) {
+    assert(life);
+    free(life->cur);
+    free(life->next);
+    memset(life, 0, sizeof(life_t));
+}
+
+// about one in 8 cells will be alive
+static void life_randomize(life_t* life, uint64_t seed) {
+    assert(life && life->cur);
+    uint64_t x = seed ? seed : 0x9E3779B97F4A7C15;
+    for (int y = 0; y < life->height; y++) {
+        uint64_t* row = life->cur + y * life->stride + 1;
+        for (int i = 0; i < life->num_words; i++) {
+            uint64_t r[3];
+            for (int k = 0; k < 3; k++) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                r[k] = x;
+            }
+            row[i] = r[0] & r[1] & r[2];
+        }
+    }
+    life->generation = 0;
+}
+
+static inline bool life_get(const life_t* life, int x, int y) {
+    const uint64_t w = life->cur[y * life->stride + 1 + (x >> 6)];
+    return (w >> (x & 63)) & 1;
+}
+
+static inline void life_set(life_t* life, int x, int y, bool alive) {
+    uint64_t* w = &life->cur[y * life->stride + 1 + (x >> 6)];
+    const uint64_t bit = (uint64_t)1 << (x & 63);
+    *w = alive ? (*w | bit) : (*w & ~bit);
+}
+
+// new state of 64 cells from the rows above, at and below (bit i is cell i)
+static inline uint64_t _life_rule(const uint64_t* up, const uint64_t* mid, const uint64_t* dn) {
+    const uint64_t nw = (up[0] << 1) | (up[-1] >> 63);
+    const uint64_t n  = up[0];
+    const uint64_t ne = (up[0] >> 1) | (up[1] << 63);
+    const uint64_t w  = (mid[0] << 1) | (mid[-1] >> 63);
+    const uint64_t e  = (mid[0] >> 1) | (mid[1] << 63);
+    const uint64_t sw = (dn[0] << 1) | (dn[-1] >> 63);
+    const uint64_t s  = dn[0];
+    const uint64_t se = (dn[0] >> 1) | (dn[1] << 63);
+    // add up the neighbour counts per row...
+    const uint64_t ua = nw ^ n ^ ne;
+    const uint64_t ub = (nw & n) | (ne & (nw ^ n));
+    const uint64_t la = sw ^ s ^ se;
+    const uint64_t lb = (sw & s) | (se & (sw ^ s));
+    const uint64_t ma = w ^ e;
+    const uint64_t mb = w & e;
+    // ...and then all rows: count = s0 + 2*s1 + 4*(fours)
+    const uint64_t s0 = ua ^ la ^ ma;
+    const uint64_t c0 = (ua & la) | (ma & (ua ^ la));
+    const uint64_t t1 = ub ^ lb ^ mb;
+    const uint64_t tc = (ub & lb) | (mb & (ub ^ lb));
+    const uint64_t s1 = t1 ^ c0;
+    const uint64_t c1 = t1 & c0;
+    // alive if count is 3, or count is 2 and alive
+    return s1 & (s0 | mid[0]) & ~(tc | c1);
+}
+
+#if LIFE_SSE2
+static inline __m128i _life_west(const uint64_t* p) {
+    return _mm_or_si128(_mm_slli_epi64(_mm_loadu_si128((const __m128i*)p), 1), _mm_srli_epi64(_mm_loadu_si128((const __m128i*)(p - 1)), 63));
+}
+
+static inline __m128i _life_east(const uint64_t* p) {
+    return _mm_or_si128(_mm_srli_epi64(_mm_loadu_si128((const __m128i*)p), 1), _mm_slli_epi64(_mm_loadu_si128((const __m128i*)(p + 1)), 63));
+}
+
+static inline __m128i _life_maj(__m128i a, __m128i b, __m128i c) {
+    return _mm_or_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_xor_si128(a, b)));
+}
+
+// same as _life_rule() for 2 words
+static inline __m128i _life_rule2(const uint64_t* up, const uint64_t* mid, const uint64_t* dn) {
+    const __m128i nw = _life_west(up);
+    const __m128i n  = _mm_loadu_si128((const __m128i*)up);
+    const __m128i ne = _life_east(up);
+    const __m128i w  = _life_west(mid);
+    const __m128i c  = _mm_loadu_si128((const __m128i*)mid);
+    const __m128i e  = _life_east(mid);
+    const __m128i sw = _life_west(dn);
+    const __m128i s  = _mm_loadu_si128((const __m128i*)dn);
+    const __m128i se = _life_east(dn);
+    const __m128i ua = _mm_xor_si128(_mm_xor_si128(nw, n), ne);
+    const __m128i ub = _life_maj(nw, n, ne);
+    const __m128i la = _mm_xor_si128(_mm_xor_si128(sw, s), se);
+    const __m128i lb = _life_maj(sw, s, se);
+    const __m128i ma = _mm_xor_si128(w, e);
+    const __m128i mb = _mm_and_si128(w, e);
+    const __m128i s0 = _mm_xor_si128(_mm_xor_si128(ua, la), ma);
+    const __m128i c0 = _life_maj(ua, la, ma);
+    const __m128i t1 = _mm_xor_si128(_mm_xor_si128(ub, lb), mb);
+    const __m128i tc = _life_maj(ub, lb, mb);
+    const __m128i s1 = _mm_xor_si128(t1, c0);
+    const __m128i c1 = _mm_and_si128(t1, c0);
+    return _mm_andnot_si128(_mm_or_si128(tc, c1), _mm_and_si128(s1, _mm_or_si128(s0, c)));
+}
+#endif
+
+static void _life_step_rows(const life_t* life, int y0, int y1) {
+    const int h = life->height;
+    const int nw = life->num_words;
+    for (int y = y0; y < y1; y++) {
+        const uint64_t* up = life->cur + ((y + h - 1) % h) * life->stride + 1;
+        const uint64_t* mid = life->cur + y * life->stride + 1;
+        const uint64_t* dn = life->cur + ((y + 1) % h) * life->stride + 1;
+        uint64_t* dst = life->next + y * life->stride + 1;
+        int i = 0;
+        #if LIFE_SSE2
+        for (; (i + 2) <= nw; i += 2) {
+            _mm_storeu_si128((__m128i*)(dst + i), _life_rule2(up + i, mid + i, dn + i));
+        }
+        #endif
+        for (; i < nw; i++) {
+            dst[i] = _life_rule(up + i, mid + i, dn + i);
+        }
+    }
+}
+
+static void _life_step_task(int job_index, void* user_data) {
+    const _life_job_t* job = (const _life_job_t*) user_data;
+    const int h = job->life->height;
+    _life_step_rows(job->life, (job_index * h) / job->num_jobs, ((job_index + 1) * h) / job->num_jobs);
+}
+
+static int _life_num_jobs(const life_t* life, int num_jobs) {
+    if (num_jobs <= 0) {
+        num_jobs = jobs_num_threads() + 1;
+    }
+    return (num_jobs > life->height) ? life->height : num_jobs;
+}
+
+// advance one generation, split into num_jobs row bands (0: one per thread)
+static void life_step(life_t* life, int num_jobs) {
+    assert(life && life->cur && life->next);
+    // the padding words hold the wrapped-around neighbour words of each row
+    for (int y = 0; y < life->height; y++) {
+        uint64_t* row = life->cur + y * life->stride;
+        row[0] = row[life->num_words];
+        row[life->num_words + 1] = row[1];
+    }
+    num_jobs = _life_num_jobs(life, num_jobs);
+    if (num_jobs <= 1) {
+        _life_step_rows(life, 0, life->height);
+    } else {
+        _life_job_t job = { .life = life, .num_jobs = num_jobs };
+        jobs_wait(jobs_dispatch(_life_step_task, &job, num_jobs));
+    }
+    uint64_t* tmp = life->cur;
+    life->cur = life->next;
+    life->next = tmp;
+    life->generation++;
+}
+
+static void _life_rgba_rows(const _life_job_t* job, int y0, int y1) {
+    const life_t* life = job->life;
+    const uint32_t diff = job->living ^ job->dead;
+    #if LIFE_SSE2
+    const __m128i vdead = _mm_set1_epi32((int)job->dead);
+    const __m128i vdiff = _mm_set1_epi32((int)diff);
+    const __m128i bits_lo = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i bits_hi = _mm_setr_epi32(16, 32, 64, 128);
+    #endif
+    for (int y = y0; y < y1; y++) {
+        const uint64_t* src = life->cur + y * life->stride + 1;
+        uint32_t* dst = job->pixels + y * life->width;
+        for (int i = 0; i < life->num_words; i++, dst += 64) {
+            const uint64_t w = src[i];
+            #if LIFE_SSE2
+            // 8 pixels per byte, each lane tests one bit
+            for (int b = 0; b < 8; b++) {
+                const __m128i v = _mm_set1_epi32((int)((w >> (b * 8)) & 0xFF));
+                const __m128i lo = _mm_cmpeq_epi32(_mm_and_si128(v, bits_lo), bits_lo);
+                const __m128i hi = _mm_cmpeq_epi32(_mm_and_si128(v, bits_hi), bits_hi);
+                _mm_storeu_si128((__m128i*)(dst + b * 8), _mm_xor_si128(vdead, _mm_and_si128(vdiff, lo)));
+                _mm_storeu_si128((__m128i*)(dst + b * 8 + 4), _mm_xor_si128(vdead, _mm_and_si128(vdiff, hi)));
+            }
+            #else
+            for (int b = 0; b < 64; b++) {
+                dst[b] = job->dead ^ (diff & (0u - (uint32_t)((w >> b) & 1)));
+            }
+            #endif
+        }
+    }
+}
+
+static void _life_rgba_task(int job_index, void* user_data) {
+    const _life_job_t* job = (const _life_job_t*) user_data;
+    const int h = job->life->height;
+    _life_rgba_rows(job, (job_index * h) / job->num_jobs, ((job_index + 1) * h) / job->num_jobs);
+}
+
+// expand the cells into width * height RGBA8 pixels
+static void life_to_rgba(const life_t* life, uint32_t* pixels, uint32_t living, uint32_t dead, int num_jobs) {
+    assert(life && life->cur && pixels);
+    _life_job_t job = {
+        .life = (life_t*)life,
+        .pixels = pixels,
+        .living = living,
+        .dead = dead,
+        .num_jobs = _life_num_jobs(life, num_jobs),
+    };
+    if (job.num_jobs <= 1) {
+        _life_rgba_rows(&job, 0, life->height);
+    } else {
+        jobs_wait(jobs_dispatch(_life_rgba_task, &job, job.num_jobs));
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+/*
+    GPU mipmap generation for sokol-gfx render target images.
+
+    Fills mip levels 1..n-1 of an image from its mip level 0 with a chain
+    of downsample render passes, either with a 2x2 box filter or with a
+    6x6 Kaiser-windowed sinc filter (sharper, with less aliasing):
+
+        mipgen_setup(&(mipgen_desc_t){ .shader = sg_make_shader(mipgen_shader_desc(sg_query_backend())) });
+        ...
+        // img must have been created with .render_target = true and .num_mipmaps > 1
+        mipgen_chain_t chain = mipgen_make_chain(img, "my-image");
+        ...
+        // after updating mip level 0, outside of a render pass:
+        mipgen_generate(&chain, MIPGEN_FILTER_BOX);
+        ...
+        mipgen_destroy_chain(&chain);
+        mipgen_shutdown();
+
+    A mip level can't be sampled while another mip level of the same image
+    is a render pass attachment on all backends (D3D11 and WebGL2 treat
+    this as a feedback loop), so each level is downsampled into a scratch
+    image (with the size of mip level 1 and one mip level less than the
+    image), and then copied back into the image. The scratch image adds
+    1/3 to the image's memory, the copy passes are single-tap and cost
+    much less than the downsample passes.
+
+    The filters assume power-of-two sizes, for other sizes the last
+    odd row and column of a level are ignored by the box filter.
+
+    The shader is provided by the application (see sapp/mipgen.glsl), it
+    must have a fragment shader uniform block at slot 0 with two ints
+    (source mip level and filter mode), and a texture and a non-filtering
+    sampler at slot 0.
+
+    Include after sokol_gfx.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define MIPGEN_MAX_MIPMAPS (SG_MAX_MIPMAPS)
+
+typedef enum {
+    MIPGEN_FILTER_BOX,
+    MIPGEN_FILTER_KAISER,
+    MIPGEN_NUM_FILTERS,
+} mipgen_filter_t;
+
+typedef struct {
+    sg_shader shader;
+} mipgen_desc_t;
+
+typedef struct {
+    sg_image img;
+    sg_image scratch;
+    int num_mipmaps;
+    sg_pipeline pip;
+    sg_attachments atts[MIPGEN_MAX_MIPMAPS];            // image mip levels 1..n-1
+    sg_attachments scratch_atts[MIPGEN_MAX_MIPMAPS];    // scratch mip levels 0..n-2
+} mipgen_chain_t;
+
+// must match the mipgen_params uniform block in mipgen.glsl
+typedef struct {
+    int32_t src_level;
+    int32_t mode;
+    int32_t _pad[2];
+} _mipgen_params_t;
+
+enum {
+    _MIPGEN_MODE_COPY,
+    _MIPGEN_MODE_BOX,
+    _MIPGEN_MODE_KAISER,
+};
+
+static struct {
+    bool valid;
+    sg_shader shader;
+    sg_sampler smp;
+} _mipgen;
+
+static void mipgen_setup(const mipgen_desc_t* desc) {
+    assert(desc && (desc->shader.id != SG_INVALID_ID));
+    _mipgen.shader = desc->shader;
+    // all reads are texelFetch() so the sampler only needs to be compatible with unfilterable formats
+    _mipgen.smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "mipgen-sampler",
+    });
+    _mipgen.valid = true;
+}
+
+static void mipgen_shutdown(void) {
+    assert(_mipgen.valid);
+    sg_destroy_sampler(_mipgen.smp);
+    _mipgen.valid = false;
+}
+
+static mipgen_chain_t mipgen_make_chain(sg_image img, const char* label) {
+    assert(_mipgen.valid);
+    const sg_image_desc img_desc = sg_query_image_desc(img);
+    assert(img_desc.render_target && (img_desc.type == SG_IMAGETYPE_2D) && (img_desc.sample_count == 1));
+    assert((img_desc.num_mipmaps > 1) && (img_desc.num_mipmaps <= MIPGEN_MAX_MIPMAPS));
+    mipgen_chain_t chain = {
+        .img = img,
+        .num_mipmaps = img_desc.num_mipmaps,
+    };
+    chain.scratch = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = (img_desc.width > 1) ? (img_desc.width / 2) : 1,
+        .height = (img_desc.height > 1) ? (img_desc.height / 2) : 1,
+        .num_mipmaps = img_desc.num_mipmaps - 1,
+        .pixel_format = img_desc.pixel_format,
+        .sample_count = 1,
+        .label = label,
+    });
+    for (int level = 1; level < chain.num_mipmaps; level++) {
+        chain.atts[level] = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0] = { .image = img, .mip_level = level },
+            .label = label,
+        });
+        chain.scratch_atts[level - 1] = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0] = { .image = chain.scratch, .mip_level = level - 1 },
+            .label = label,
+        });
+    }
+    chain.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .shader = _mipgen.shader,
+        .colors[0].pixel_format = img_desc.pixel_format,
+        .depth.pixel_format = SG_PIXELFORMAT_NONE,
+        .sample_count = 1,
+        .label = label,
+    });
+    return chain;
+}
+
+static void mipgen_destroy_chain(mipgen_chain_t* chain) {
+    assert(chain);
+    for (int level = 1; level < chain->num_mipmaps; level++) {
+        sg_destroy_attachments(chain->atts[level]);
+        sg_destroy_attachments(chain->scratch_atts[level - 1]);
+    }
+    sg_destroy_pipeline(chain->pip);
+    sg_destroy_image(chain->scratch);
+    *chain = (mipgen_chain_t){0};
+}
+
+static void _mipgen_pass(const mipgen_chain_t* chain, sg_attachments atts, sg_image src, int src_level, int mode) {
+    // every destination pixel is overwritten, so there's no need to load or clear
+    sg_begin_pass(&(sg_pass){
+        .action.colors[0].load_action = SG_LOADACTION_DONTCARE,
+        .attachments = atts,
+    });
+    sg_apply_pipeline(chain->pip);
+    sg_apply_bindings(&(sg_bindings){ .images[0] = src, .samplers[0] = _mipgen.smp });
+    const _mipgen_params_t params = { .src_level = src_level, .mode = mode };
+    sg_apply_uniforms(0, &SG_RANGE(params));
+    sg_draw(0, 3, 1);
+    sg_end_pass();
+}
+
+// generate mip levels 1..n-1 from mip level 0, must be called outside of a render pass
+static void mipgen_generate(const mipgen_chain_t* chain, mipgen_filter_t filter) {
+    assert(_mipgen.valid && chain);
+    const int mode = (filter == MIPGEN_FILTER_KAISER) ? _MIPGEN_MODE_KAISER : _MIPGEN_MODE_BOX;
+    for (int level = 1; level < chain->num_mipmaps; level++) {
+        // downsample the previous image level into the scratch image...
+        _mipgen_pass(chain, chain->scratch_atts[level - 1], chain->img, level - 1, mode);
+        // ...and copy it back into the image
+        _mipgen_pass(chain, chain->atts[level], chain->scratch, level - 1, _MIPGEN_MODE_COPY);
+    }
+}
@@ -0,0 +1,502 @@
+#pragma once
+/*
+    Parallel generation of high-tessellation sokol_shape.h geometry.
+
+    The pshape_build_*() functions take the same sshape_buffer_t and
+    parameter structs as their sshape_build_*() counterparts in
+    sokol_shape.h, but split each shape into chunks of rows which are
+    generated on the jobs.h thread pool, with the vertex transforms and
+    normal packing done 4 vertices at a time (SSE2 where available,
+    define PSHAPE_NO_SIMD to disable). Vertices and indices are written
+    directly into the caller-provided buffers:
+
+        jobs_setup(&(jobs_desc_t){ 0 });
+        ...
+        sshape_buffer_t buf = {
+            .vertices.buffer = { .ptr = vertices, .size = vertices_size },
+            .indices.buffer  = { .ptr = indices,  .size = indices_size },
+        };
+        const pshape_options_t opts = { .index32 = true };
+        buf = pshape_build_sphere(&buf, &(sshape_sphere_t){ .slices = 1000, .stacks = 1000 }, &opts);
+        buf = pshape_build_torus(&buf, &(sshape_torus_t){ .merge = true, ... }, &opts);
+        ...
+        const sshape_element_range_t elms = pshape_element_range(&buf, &opts);
+
+    sokol_shape.h uses 16-bit indices, which limits a buffer to 64k
+    vertices. With pshape_options_t.index32 the index buffer is filled
+    with uint32_t indices instead, so the pipeline must use
+    SG_INDEXTYPE_UINT32 and the element range must be computed with
+    pshape_element_range().
+
+    Differences to sokol_shape.h: the triangle layout is a plain grid per
+    shape part (the sphere poles and cylinder caps contain degenerate
+    triangles), and random colors are hashed from the vertex index so
+    they don't depend on how the shape was split into chunks.
+
+    Include after sokol_shape.h and util/jobs.h, jobs_setup() must have
+    been called unless pshape_options_t.no_jobs is set.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#if !defined(PSHAPE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>
+#define PSHAPE_SSE2 (1)
+#else
+#define PSHAPE_SSE2 (0)
+#endif
+
+typedef struct {
+    bool index32;   // write uint32_t instead of uint16_t indices
+    bool no_jobs;   // generate all chunks on the calling thread
+} pshape_options_t;
+
+// columns are processed in blocks of this size
+#define _PSHAPE_BLOCK (128)
+// approximate number of vertices per job
+#define _PSHAPE_VERTICES_PER_JOB (8192)
+#define _PSHAPE_MAX_GRIDS (6)
+
+typedef enum {
+    _PSHAPE_GRID_SPHERE,
+    _PSHAPE_GRID_TORUS,
+    _PSHAPE_GRID_CYLINDER,
+    _PSHAPE_GRID_CAP,
+    _PSHAPE_GRID_PLANE,
+} _pshape_grid_type_t;
+
+typedef struct {
+    _pshape_grid_type_t type;
+    int rows, cols;             // number of vertices in each direction
+    uint32_t base_vertex;       // vertex index of the grid's first vertex
+    size_t first_index;         // position of the grid's first index
+    float* row_sin; float* row_cos;
+    float* col_sin; float* col_cos;
+    float radius, ring_radius, y0, height;
+    float origin[3], du[3], dv[3], normal[3];
+} _pshape_grid_t;
+
+typedef struct {
+    int grid;
+    int row0, row1;
+} _pshape_task_t;
+
+typedef struct {
+    sshape_mat4_t transform;
+    bool random_colors;
+    uint32_t color;
+    bool index32;
+    sshape_vertex_t* vertices;
+    void* indices;
+    int num_grids;
+    _pshape_grid_t grids[_PSHAPE_MAX_GRIDS];
+    int num_tasks;
+    _pshape_task_t* tasks;
+} _pshape_job_t;
+
+static inline uint32_t _pshape_hash_color(uint32_t i) {
+    i ^= i >> 16; i *= 0x7FEB352D;
+    i ^= i >> 15; i *= 0x846CA68B;
+    i ^= i >> 16;
+    return 0xFF000000 | (i & 0x00FFFFFF);
+}
+
+static inline uint32_t _pshape_pack_normal(float x, float y, float z) {
+    const uint8_t bx = (uint8_t)(int8_t)(x * 127.0f);
+    const uint8_t by = (uint8_t)(int8_t)(y * 127.0f);
+    const uint8_t bz = (uint8_t)(int8_t)(z * 127.0f);
+    return (uint32_t)bx | ((uint32_t)by << 8) | ((uint32_t)bz << 16);
+}
+
+// compute untransformed positions, normals and uvs for a block of columns in a row
+static void _pshape_eval_block(const _pshape_grid_t* g, int row, int col0, int num, float* p, float* n, float* uv) {
+    const float fr = (float)row / (float)(g->rows - 1);
+    for (int i = 0; i < num; i++) {
+        const int col = col0 + i;
+        const float fc = (float)col / (float)(g->cols - 1);
+        float* pp = &p[i * 3];
+        float* nn = &n[i * 3];
+        switch (g->type) {
+            case _PSHAPE_GRID_SPHERE:
+                nn[0] = -g->col_sin[col] * g->row_sin[row];
+                nn[1] = g->row_cos[row];
+                nn[2] = g->col_cos[col] * g->row_sin[row];
+                pp[0] = nn[0] * g->radius; pp[1] = nn[1] * g->radius; pp[2] = nn[2] * g->radius;
+                uv[i * 2 + 0] = 1.0f - fc;
+                uv[i * 2 + 1] = 1.0f - fr;
+                break;
+            case _PSHAPE_GRID_TORUS:
+                // rows go around the ring, columns around the torus
+                nn[0] = g->row_cos[row] * g->col_cos[col];
+                nn[1] = g->row_sin[row];
+                nn[2] = g->row_cos[row] * g->col_sin[col];
+                pp[0] = g->radius * g->col_cos[col] + g->ring_radius * nn[0];
+                pp[1] = g->ring_radius * nn[1];
+                pp[2] = g->radius * g->col_sin[col] + g->ring_radius * nn[2];
+                uv[i * 2 + 0] = fc;
+                uv[i * 2 + 1] = fr;
+                break;
+            case _PSHAPE_GRID_CYLINDER:
+                nn[0] = g->col_sin[col]; nn[1] = 0.0f; nn[2] = g->col_cos[col];
+                pp[0] = g->radius * nn[0]; pp[1] = g->y0 + g->height * fr; pp[2] = g->radius * nn[2];
+                uv[i * 2 + 0] = fc;
+                uv[i * 2 + 1] = 1.0f - fr;
+                break;
+            case _PSHAPE_GRID_CAP:
+                // row 0 is the center, row 1 the rim
+                nn[0] = 0.0f; nn[1] = g->normal[1]; nn[2] = 0.0f;
+                pp[0] = g->radius * g->col_sin[col] * fr; pp[1] = g->y0; pp[2] = g->radius * g->col_cos[col] * fr;
+                uv[i * 2 + 0] = 0.5f + 0.5f * g->col_sin[col] * fr;
+                uv[i * 2 + 1] = 0.5f + 0.5f * g->col_cos[col] * fr;
+                break;
+            default:
+                for (int k = 0; k < 3; k++) {
+                    pp[k] = g->origin[k] + g->du[k] * fc + g->dv[k] * fr;
+                    nn[k] = g->normal[k];
+                }
+                uv[i * 2 + 0] = fc;
+                uv[i * 2 + 1] = fr;
+                break;
+        }
+    }
+}
+
+// transform, normalize and pack a block of vertices
+static void _pshape_emit_block(const _pshape_job_t* job, uint32_t first_vertex, int num, const float* p, const float* n, const float* uv) {
+    const float (*m)[4] = job->transform.m;
+    sshape_vertex_t* dst = &job->vertices[first_vertex];
+    int i = 0;
+    #if PSHAPE_SSE2
+    {
+        const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+        const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+        const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+        const __m128 m30 = _mm_set1_ps(m[3][0]), m31 = _mm_set1_ps(m[3][1]), m32 = _mm_set1_ps(m[3][2]);
+        const __m128 s127 = _mm_set1_ps(127.0f);
+        const __m128 s65535 = _mm_set1_ps(65535.0f);
+        const __m128 tiny = _mm_set1_ps(1e-12f);
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        for (; (i + 4) <= num; i += 4) {
+            // gather 4 vertices into SoA form
+            const __m128 px = _mm_setr_ps(p[i*3+0], p[i*3+3], p[i*3+6], p[i*3+9]);
+            const __m128 py = _mm_setr_ps(p[i*3+1], p[i*3+4], p[i*3+7], p[i*3+10]);
+            const __m128 pz = _mm_setr_ps(p[i*3+2], p[i*3+5], p[i*3+8], p[i*3+11]);
+            const __m128 nx = _mm_setr_ps(n[i*3+0], n[i*3+3], n[i*3+6], n[i*3+9]);
+            const __m128 ny = _mm_setr_ps(n[i*3+1], n[i*3+4], n[i*3+7], n[i*3+10]);
+            const __m128 nz = _mm_setr_ps(n[i*3+2], n[i*3+5], n[i*3+8], n[i*3+11]);
+            const __m128 u = _mm_setr_ps(uv[i*2+0], uv[i*2+2], uv[i*2+4], uv[i*2+6]);
+            const __m128 v = _mm_setr_ps(uv[i*2+1], uv[i*2+3], uv[i*2+5], uv[i*2+7]);
+
+            // positions (w=1) and normals (w=0)
+            float tx[4], ty[4], tz[4];
+            _mm_storeu_ps(tx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, px), _mm_mul_ps(m10, py)), _mm_add_ps(_mm_mul_ps(m20, pz), m30)));
+            _mm_storeu_ps(ty, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, px), _mm_mul_ps(m11, py)), _mm_add_ps(_mm_mul_ps(m21, pz), m31)));
+            _mm_storeu_ps(tz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, px), _mm_mul_ps(m12, py)), _mm_add_ps(_mm_mul_ps(m22, pz), m32)));
+            __m128 tnx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, nx), _mm_mul_ps(m10, ny)), _mm_mul_ps(m20, nz));
+            __m128 tny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, nx), _mm_mul_ps(m11, ny)), _mm_mul_ps(m21, nz));
+            __m128 tnz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, nx), _mm_mul_ps(m12, ny)), _mm_mul_ps(m22, nz));
+            const __m128 len = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tnx, tnx), _mm_mul_ps(tny, tny)), _mm_mul_ps(tnz, tnz)), tiny));
+            const __m128 scale = _mm_div_ps(s127, len);
+            tnx = _mm_mul_ps(tnx, scale);
+            tny = _mm_mul_ps(tny, scale);
+            tnz = _mm_mul_ps(tnz, scale);
+
+            // pack normals to byte4n and texcoords to ushort2n
+            const __m128i bx = _mm_and_si128(_mm_cvttps_epi32(tnx), byte_mask);
+            const __m128i by = _mm_and_si128(_mm_cvttps_epi32(tny), byte_mask);
+            const __m128i bz = _mm_and_si128(_mm_cvttps_epi32(tnz), byte_mask);
+            uint32_t packed_n[4], packed_uv[4];
+            _mm_storeu_si128((__m128i*)packed_n, _mm_or_si128(bx, _mm_or_si128(_mm_slli_epi32(by, 8), _mm_slli_epi32(bz, 16))));
+            const __m128i iu = _mm_cvttps_epi32(_mm_mul_ps(u, s65535));
+            const __m128i iv = _mm_cvttps_epi32(_mm_mul_ps(v, s65535));
+            _mm_storeu_si128((__m128i*)packed_uv, _mm_or_si128(iu, _mm_slli_epi32(iv, 16)));
+
+            for (int k = 0; k < 4; k++) {
+                sshape_vertex_t* vtx = &dst[i + k];
+                vtx->x = tx[k]; vtx->y = ty[k]; vtx->z = tz[k];
+                vtx->normal = packed_n[k];
+                vtx->u = (uint16_t)(packed_uv[k] & 0xFFFF);
+                vtx->v = (uint16_t)(packed_uv[k] >> 16);
+                vtx->color = job->random_colors ? _pshape_hash_color(first_vertex + (uint32_t)(i + k)) : job->color;
+            }
+        }
+    }
+    #endif
+    for (; i < num; i++) {
+        const float* pp = &p[i * 3];
+        const float* nn = &n[i * 3];
+        sshape_vertex_t* vtx = &dst[i];
+        vtx->x = m[0][0] * pp[0] + m[1][0] * pp[1] + m[2][0] * pp[2] + m[3][0];
+        vtx->y = m[0][1] * pp[0] + m[1][1] * pp[1] + m[2][1] * pp[2] + m[3][1];
+        vtx->z = m[0][2] * pp[0] + m[1][2] * pp[1] + m[2][2] * pp[2] + m[3][2];
+        float tnx = m[0][0] * nn[0] + m[1][0] * nn[1] + m[2][0] * nn[2];
+        float tny = m[0][1] * nn[0] + m[1][1] * nn[1] + m[2][1] * nn[2];
+        float tnz = m[0][2] * nn[0] + m[1][2] * nn[1] + m[2][2] * nn[2];
+        const float len = sqrtf(fmaxf(tnx * tnx + tny * tny + tnz * tnz, 1e-12f));
+        vtx->normal = _pshape_pack_normal(tnx / len, tny / len, tnz / len);
+        vtx->u = (uint16_t)(uv[i * 2 + 0] * 65535.0f);
+        vtx->v = (uint16_t)(uv[i * 2 + 1] * 65535.0f);
+        vtx->color = job->random_colors ? _pshape_hash_color(first_vertex + (uint32_t)i) : job->color;
+    }
+}
+
+static void _pshape_task(int task_index, void* user_data) {
+    const _pshape_job_t* job = (const _pshape_job_t*)user_data;
+    const _pshape_task_t* task = &job->tasks[task_index];
+    const _pshape_grid_t* g = &job->grids[task->grid];
+    float p[_PSHAPE_BLOCK * 3], n[_PSHAPE_BLOCK * 3], uv[_PSHAPE_BLOCK * 2];
+    for (int row = task->row0; row < task->row1; row++) {
+        // vertices
+        for (int col0 = 0; col0 < g->cols; col0 += _PSHAPE_BLOCK) {
+            const int num = ((g->cols - col0) < _PSHAPE_BLOCK) ? (g->cols - col0) : _PSHAPE_BLOCK;
+            _pshape_eval_block(g, row, col0, num, p, n, uv);
+            _pshape_emit_block(job, g->base_vertex + (uint32_t)(row * g->cols + col0), num, p, n, uv);
+        }
+        // two triangles per quad between this and the next row
+        if (row < (g->rows - 1)) {
+            size_t idx = g->first_index + (size_t)row * (size_t)(g->cols - 1) * 6;
+            for (int col = 0; col < (g->cols - 1); col++) {
+                const uint32_t i0 = g->base_vertex + (uint32_t)(row * g->cols + col);
+                const uint32_t i1 = i0 + 1;
+                const uint32_t i2 = i0 + (uint32_t)g->cols;
+                const uint32_t i3 = i2 + 1;
+                const uint32_t tri[6] = { i0, i2, i1, i1, i2, i3 };
+                if (job->index32) {
+                    memcpy(&((uint32_t*)job->indices)[idx], tri, sizeof(tri));
+                } else {
+                    uint16_t* dst = &((uint16_t*)job->indices)[idx];
+                    for (int k = 0; k < 6; k++) {
+                        dst[k] = (uint16_t)tri[k];
+                    }
+                }
+                idx += 6;
+            }
+        }
+    }
+}
+
+static void _pshape_sincos_table(float* s, float* c, int num, float angle_scale, float angle_offset) {
+    for (int i = 0; i < num; i++) {
+        const float a = angle_offset + angle_scale * (float)i;
+        s[i] = sinf(a);
+        c[i] = cosf(a);
+    }
+}
+
+// add a grid to the job, returns a pointer to it for further setup
+static _pshape_grid_t* _pshape_add_grid(_pshape_job_t* job, _pshape_grid_type_t type, int rows, int cols) {
+    assert(job->num_grids < _PSHAPE_MAX_GRIDS);
+    _pshape_grid_t* g = &job->grids[job->num_grids++];
+    memset(g, 0, sizeof(_pshape_grid_t));
+    g->type = type;
+    g->rows = rows;
+    g->cols = cols;
+    return g;
+}
+
+// allocate the sin/cos tables shared by grids with the same row/column angles
+static float* _pshape_alloc_table(int num) {
+    return (float*) malloc((size_t)num * 2 * sizeof(float));
+}
+
+static bool _pshape_transform_is_null(const sshape_mat4_t* m) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (m->m[i][j] != 0.0f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// run all grids of a job, update and return the sshape buffer
+static sshape_buffer_t _pshape_run(_pshape_job_t* job, const sshape_buffer_t* in_buf, bool merge, const pshape_options_t* opts) {
+    sshape_buffer_t buf = *in_buf;
+    const size_t index_size = opts->index32 ? sizeof(uint32_t) : sizeof(uint16_t);
+    uint32_t num_vertices = 0;
+    size_t num_indices = 0;
+    for (int i = 0; i < job->num_grids; i++) {
+        num_vertices += (uint32_t)(job->grids[i].rows * job->grids[i].cols);
+        num_indices += (size_t)(job->grids[i].rows - 1) * (size_t)(job->grids[i].cols - 1) * 6;
+    }
+    const uint32_t base_vertex = (uint32_t)(buf.vertices.data_size / sizeof(sshape_vertex_t));
+    const bool fits =
+        ((buf.vertices.data_size + num_vertices * sizeof(sshape_vertex_t)) <= buf.vertices.buffer.size) &&
+        ((buf.indices.data_size + num_indices * index_size) <= buf.indices.buffer.size) &&
+        (opts->index32 || ((base_vertex + num_vertices) <= 0x10000));
+    if (!buf.valid || !fits) {
+        buf.valid = false;
+        return buf;
+    }
+    if (!merge) {
+        buf.vertices.shape_offset = buf.vertices.data_size;
+        buf.indices.shape_offset = buf.indices.data_size;
+    }
+    job->vertices = (sshape_vertex_t*)buf.vertices.buffer.ptr;
+    job->indices = (void*)buf.indices.buffer.ptr;
+    job->index32 = opts->index32;
+    if (_pshape_transform_is_null(&job->transform)) {
+        job->transform = sshape_mat4((const float[16]){ 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 });
+    }
+
+    // split the grids into chunks of rows
+    int max_tasks = 0;
+    uint32_t vertex = base_vertex;
+    size_t index = buf.indices.data_size / index_size;
+    for (int i = 0; i < job->num_grids; i++) {
+        _pshape_grid_t* g = &job->grids[i];
+        g->base_vertex = vertex;
+        g->first_index = index;
+        vertex += (uint32_t)(g->rows * g->cols);
+        index += (size_t)(g->rows - 1) * (size_t)(g->cols - 1) * 6;
+        max_tasks += g->rows;
+    }
+    job->tasks = (_pshape_task_t*) malloc((size_t)max_tasks * sizeof(_pshape_task_t));
+    job->num_tasks = 0;
+    for (int i = 0; i < job->num_grids; i++) {
+        const _pshape_grid_t* g = &job->grids[i];
+        int rows_per_task = _PSHAPE_VERTICES_PER_JOB / g->cols;
+        if (rows_per_task < 1) {
+            rows_per_task = 1;
+        }
+        for (int row = 0; row < g->rows; row += rows_per_task) {
+            _pshape_task_t* task = &job->tasks[job->num_tasks++];
+            task->grid = i;
+            task->row0 = row;
+            task->row1 = ((row + rows_per_task) < g->rows) ? (row + rows_per_task) : g->rows;
+        }
+    }
+    if (opts->no_jobs) {
+        for (int i = 0; i < job->num_tasks; i++) {
+            _pshape_task(i, job);
+        }
+    } else {
+        jobs_wait(jobs_dispatch(_pshape_task, job, job->num_tasks));
+    }
+    free(job->tasks);
+
+    buf.vertices.data_size += num_vertices * sizeof(sshape_vertex_t);
+    buf.indices.data_size += num_indices * index_size;
+    return buf;
+}
+
+static void _pshape_init_job(_pshape_job_t* job, sshape_mat4_t transform, bool random_colors, uint32_t color) {
+    memset(job, 0, sizeof(_pshape_job_t));
+    job->transform = transform;
+    job->random_colors = random_colors;
+    job->color = color ? color : 0xFFFFFFFF;
+}
+
+static sshape_buffer_t pshape_build_sphere(const sshape_buffer_t* buf, const sshape_sphere_t* params, const pshape_options_t* opts) {
+    const pshape_options_t def_opts = { 0 };
+    const float pi = 3.14159265358979323846f;
+    const int slices = (params->slices < 3) ? 5 : (int)params->slices;
+    const int stacks = (params->stacks < 2) ? 4 : (int)params->stacks;
+    _pshape_job_t job;
+    _pshape_init_job(&job, params->transform, params->random_colors, params->color);
+    _pshape_grid_t* g = _pshape_add_grid(&job, _PSHAPE_GRID_SPHERE, stacks + 1, slices + 1);
+    g->radius = (params->radius == 0.0f) ? 0.5f : params->radius;
+    float* row_tab = _pshape_alloc_table(g->rows);
+    float* col_tab = _pshape_alloc_table(g->cols);
+    g->row_sin = row_tab; g->row_cos = row_tab + g->rows;
+    g->col_sin = col_tab; g->col_cos = col_tab + g->cols;
+    _pshape_sincos_table(g->row_sin, g->row_cos, g->rows, pi / (float)stacks, 0.0f);
+    _pshape_sincos_table(g->col_sin, g->col_cos, g->cols, (2.0f * pi) / (float)slices, 0.0f);
+    const sshape_buffer_t res = _pshape_run(&job, buf, params->merge, opts ? opts : &def_opts);
+    free(row_tab);
+    free(col_tab);
+    return res;
+}
+
+static sshape_buffer_t pshape_build_torus(const sshape_buffer_t* buf, const sshape_torus_t* params, const pshape_options_t* opts) {
+    const pshape_options_t def_opts = { 0 };
+    const float pi = 3.14159265358979323846f;
+    const int sides = (params->sides < 3) ? 5 : (int)params->sides;
+    const int rings = (params->rings < 3) ? 5 : (int)params->rings;
+    _pshape_job_t job;
+    _pshape_init_job(&job, params->transform, params->random_colors, params->color);
+    _pshape_grid_t* g = _pshape_add_grid(&job, _PSHAPE_GRID_TORUS, sides + 1, rings + 1);
+    g->radius = (params->radius == 0.0f) ? 0.5f : params->radius;
+    g->ring_radius = (params->ring_radius == 0.0f) ? 0.2f : params->ring_radius;
+    float* row_tab = _pshape_alloc_table(g->rows);
+    float* col_tab = _pshape_alloc_table(g->cols);
+    g->row_sin = row_tab; g->row_cos = row_tab + g->rows;
+    g->col_sin = col_tab; g->col_cos = col_tab + g->cols;
+    _pshape_sincos_table(g->row_sin, g->row_cos, g->rows, (2.0f * pi) / (float)sides, 0.0f);
+    _pshape_sincos_table(g->col_sin, g->col_cos, g->cols, (2.0f * pi) / (float)rings, 0.0f);
+    const sshape_buffer_t res = _pshape_run(&job, buf, params->merge, opts ? opts : &def_opts);
+    free(row_tab);
+    free(col_tab);
+    return res;
+}
+
+static sshape_buffer_t pshape_build_cylinder(const sshape_buffer_t* buf, const sshape_cylinder_t* params, const pshape_options_t* opts) {
+    const pshape_options_t def_opts = { 0 };
+    const float pi = 3.14159265358979323846f;
+    const int slices = (params->slices < 3) ? 5 : (int)params->slices;
+    const int stacks = (params->stacks < 1) ? 1 : (int)params->stacks;
+    const float radius = (params->radius == 0.0f) ? 0.5f : params->radius;
+    const float height = (params->height == 0.0f) ? 1.0f : params->height;
+    _pshape_job_t job;
+    _pshape_init_job(&job, params->transform, params->random_colors, params->color);
+    float* col_tab = _pshape_alloc_table(slices + 1);
+    float* col_sin = col_tab;
+    float* col_cos = col_tab + slices + 1;
+    _pshape_sincos_table(col_sin, col_cos, slices + 1, (2.0f * pi) / (float)slices, 0.0f);
+
+    _pshape_grid_t* side = _pshape_add_grid(&job, _PSHAPE_GRID_CYLINDER, stacks + 1, slices + 1);
+    side->radius = radius;
+    side->y0 = -0.5f * height;
+    side->height = height;
+    side->col_sin = col_sin; side->col_cos = col_cos;
+    for (int i = 0; i < 2; i++) {
+        _pshape_grid_t* cap = _pshape_add_grid(&job, _PSHAPE_GRID_CAP, 2, slices + 1);
+        cap->radius = radius;
+        cap->y0 = (i == 0) ? (-0.5f * height) : (0.5f * height);
+        cap->normal[1] = (i == 0) ? -1.0f : 1.0f;
+        cap->col_sin = col_sin; cap->col_cos = col_cos;
+    }
+    const sshape_buffer_t res = _pshape_run(&job, buf, params->merge, opts ? opts : &def_opts);
+    free(col_tab);
+    return res;
+}
+
+static sshape_buffer_t pshape_build_box(const sshape_buffer_t* buf, const sshape_box_t* params, const pshape_options_t* opts) {
+    const pshape_options_t def_opts = { 0 };
+    const int tiles = (params->tiles < 1) ? 1 : (int)params->tiles;
+    const float w = 0.5f * ((params->width == 0.0f) ? 1.0f : params->width);
+    const float h = 0.5f * ((params->height == 0.0f) ? 1.0f : params->height);
+    const float d = 0.5f * ((params->depth == 0.0f) ? 1.0f : params->depth);
+    // origin, u- and v-direction and normal of each face
+    const float faces[6][4][3] = {
+        { { -w, -h, +d }, { 2*w, 0, 0 }, { 0, 2*h, 0 }, { 0, 0, +1 } },
+        { { +w, -h, -d }, { -2*w, 0, 0 }, { 0, 2*h, 0 }, { 0, 0, -1 } },
+        { { +w, -h, +d }, { 0, 0, -2*d }, { 0, 2*h, 0 }, { +1, 0, 0 } },
+        { { -w, -h, -d }, { 0, 0, 2*d }, { 0, 2*h, 0 }, { -1, 0, 0 } },
+        { { -w, +h, +d }, { 2*w, 0, 0 }, { 0, 0, -2*d }, { 0, +1, 0 } },
+        { { -w, -h, -d }, { 2*w, 0, 0 }, { 0, 0, 2*d }, { 0, -1, 0 } },
+    };
+    _pshape_job_t job;
+    _pshape_init_job(&job, params->transform, params->random_colors, params->color);
+    for (int i = 0; i < 6; i++) {
+        _pshape_grid_t* g = _pshape_add_grid(&job, _PSHAPE_GRID_PLANE, tiles + 1, tiles + 1);
+        memcpy(g->origin, faces[i][0], sizeof(g->origin));
+        memcpy(g->du, faces[i][1], sizeof(g->du));
+        memcpy(g->dv, faces[i][2], sizeof(g->dv));
+        memcpy(g->normal, faces[i][3], sizeof(g->normal));
+    }
+    return _pshape_run(&job, buf, params->merge, opts ? opts : &def_opts);
+}
+
+// like sshape_element_range(), but aware of 32-bit indices
+static sshape_element_range_t pshape_element_range(const sshape_buffer_t* buf, const pshape_options_t* opts) {
+    const size_t index_size = (opts && opts->index32) ? sizeof(uint32_t) : sizeof(uint16_t);
+    return (sshape_element_range_t){
+        .base_element = (int)(buf->indices.shape_offset / index_size),
+        .num_elements = (int)((buf->indices.data_size - buf->indices.shape_offset) / index_size),
+    };
+}
@@ -0,0 +1,199 @@
+#pragma once
+/*
+    Bulk text emission for sokol_debugtext.h.
+
+    sdtx_puts() and sdtx_putr() emit the glyph quads of a string one
+    character at a time. sdtxbulk_puts() and sdtxbulk_putr() have the
+    same behaviour, but gather each line segment between control
+    characters into a chunk, reserve the vertices for the whole chunk
+    at once, and write the glyph vertices in blocks of 4 glyphs (with
+    SSE2 where available, define SDTXBULK_NO_SIMD to disable):
+
+        sdtx_canvas(...);
+        sdtx_color3b(...);
+        sdtxbulk_puts(log_text);
+        ...
+        sdtx_draw();
+
+    This is meant for large text buffers like consoles and log viewers,
+    for short strings sdtx_puts() is just as fast.
+
+    Control characters are forwarded to sdtx_putc(). Chunks are cut to
+    the remaining vertex buffer space, once the buffer is full the rest
+    of the text goes through sdtx_putc() as well, so that an overflow
+    is handled exactly like sokol_debugtext.h handles it.
+
+    Include after the sokol_debugtext.h implementation (SOKOL_DEBUGTEXT_IMPL),
+    the glyph vertices are written directly into the current context, so
+    this depends on sokol_debugtext.h's private vertex layout (x, y as
+    floats, u, v as 16-bit normalized, color as RGBA8), which is checked
+    at compile time.
+*/
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h> // offsetof
+#if !defined(SDTXBULK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>
+#define SDTXBULK_SSE2 (1)
+#else
+#define SDTXBULK_SSE2 (0)
+#endif
+
+#define SDTXBULK_CHUNK_SIZE (256)
+
+// the glyph's uv rectangle, this must match _sdtx_draw_char()
+#define _SDTXBULK_UVW (0x10000 / 0x100)
+#define _SDTXBULK_UVH (0x10000 / SOKOL_DEBUGTEXT_MAX_FONTS)
+
+// the vertex layout written below, the SSE2 path stores whole 16-byte vertices
+#if defined(__cplusplus)
+#define _SDTXBULK_STATIC_ASSERT(c, msg) static_assert(c, msg)
+#else
+#define _SDTXBULK_STATIC_ASSERT(c, msg) _Static_assert(c, msg)
+#endif
+_SDTXBULK_STATIC_ASSERT(sizeof(_sdtx_vertex_t) == 16, "sdtxbulk.h: unexpected _sdtx_vertex_t size");
+_SDTXBULK_STATIC_ASSERT((offsetof(_sdtx_vertex_t, x) == 0) && (offsetof(_sdtx_vertex_t, y) == 4), "sdtxbulk.h: unexpected _sdtx_vertex_t position");
+_SDTXBULK_STATIC_ASSERT((offsetof(_sdtx_vertex_t, u) == 8) && (offsetof(_sdtx_vertex_t, v) == 10), "sdtxbulk.h: unexpected _sdtx_vertex_t uv");
+_SDTXBULK_STATIC_ASSERT(offsetof(_sdtx_vertex_t, color) == 12, "sdtxbulk.h: unexpected _sdtx_vertex_t color");
+
+static void _sdtxbulk_store_glyph(_sdtx_vertex_t* vx, float x0, float x1, float y0, float y1, uint16_t u0, uint16_t u1, uint16_t v0, uint16_t v1, uint32_t color) {
+    vx[0].x = x0; vx[0].y = y0; vx[0].u = u0; vx[0].v = v0; vx[0].color = color;
+    vx[1].x = x1; vx[1].y = y0; vx[1].u = u1; vx[1].v = v0; vx[1].color = color;
+    vx[2].x = x1; vx[2].y = y1; vx[2].u = u1; vx[2].v = v1; vx[2].color = color;
+    vx[3] = vx[0];
+    vx[4] = vx[2];
+    vx[5].x = x0; vx[5].y = y1; vx[5].u = u0; vx[5].v = v1; vx[5].color = color;
+}
+
+// number of glyphs which still fit into the vertex buffer, 0 if there's no draw command to append to
+static int _sdtxbulk_capacity(_sdtx_context_t* ctx) {
+    if (!_sdtx_cur_command(ctx)) {
+        return 0;
+    }
+    return (ctx->vertices.cap - ctx->vertices.next) / 6;
+}
+
+// write 6 vertices for each glyph, cols[] is the glyph's column relative to the origin,
+// the caller made sure that all glyphs fit
+static void _sdtxbulk_emit(_sdtx_context_t* ctx, const uint8_t* chars, const float* cols, int num) {
+    if (0 == num) {
+        return;
+    }
+    _sdtx_command_t* cmd = _sdtx_cur_command(ctx);
+    SOKOL_ASSERT(cmd && ((ctx->vertices.next + num * 6) <= ctx->vertices.cap));
+    _sdtx_vertex_t* vx = &ctx->vertices.ptr[ctx->vertices.next];
+    ctx->vertices.next += num * 6;
+    cmd->num_vertices += num * 6;
+
+    const float gw = ctx->glyph_size.x;
+    const float y0 = (ctx->origin.y + ctx->pos.y) * ctx->glyph_size.y;
+    const float y1 = y0 + ctx->glyph_size.y;
+    const uint32_t v0 = (uint32_t)(ctx->cur_font * _SDTXBULK_UVH) + 1;
+    const uint32_t v1 = v0 + _SDTXBULK_UVH - 2;
+    const uint32_t color = ctx->color;
+    int i = 0;
+    #if SDTXBULK_SSE2
+    {
+        // each vertex is exactly 16 bytes: x, y, u|v<<16, color
+        const __m128 ox = _mm_set1_ps(ctx->origin.x);
+        const __m128 vgw = _mm_set1_ps(gw);
+        const __m128i vy0 = _mm_castps_si128(_mm_set1_ps(y0));
+        const __m128i vy1 = _mm_castps_si128(_mm_set1_ps(y1));
+        const __m128i vv0 = _mm_set1_epi32((int)(v0 << 16));
+        const __m128i vv1 = _mm_set1_epi32((int)(v1 << 16));
+        const __m128i vuw = _mm_set1_epi32(_SDTXBULK_UVW - 2);
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i vcol = _mm_set1_epi32((int)color);
+        const __m128i zero = _mm_setzero_si128();
+        for (; (i + 4) <= num; i += 4, vx += 24) {
+            // 4 glyphs' x coordinates and u coordinates
+            const __m128 fx0 = _mm_mul_ps(_mm_add_ps(ox, _mm_loadu_ps(&cols[i])), vgw);
+            const __m128i x0 = _mm_castps_si128(fx0);
+            const __m128i x1 = _mm_castps_si128(_mm_add_ps(fx0, vgw));
+            int c4;
+            memcpy(&c4, &chars[i], 4);
+            const __m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(c4), zero), zero);
+            const __m128i u0 = _mm_add_epi32(_mm_slli_epi32(c, 8), one);
+            const __m128i u1 = _mm_add_epi32(u0, vuw);
+            const __m128i corner_x[4] = { x0, x1, x1, x0 };
+            const __m128i corner_y[4] = { vy0, vy0, vy1, vy1 };
+            const __m128i corner_uv[4] = {
+                _mm_or_si128(u0, vv0), _mm_or_si128(u1, vv0),
+                _mm_or_si128(u1, vv1), _mm_or_si128(u0, vv1),
+            };
+            // transpose into one vertex per glyph and corner
+            __m128i v[4][4];    // [glyph][corner]
+            for (int k = 0; k < 4; k++) {
+                const __m128i xy_lo = _mm_unpacklo_epi32(corner_x[k], corner_y[k]);
+                const __m128i xy_hi = _mm_unpackhi_epi32(corner_x[k], corner_y[k]);
+                const __m128i uc_lo = _mm_unpacklo_epi32(corner_uv[k], vcol);
+                const __m128i uc_hi = _mm_unpackhi_epi32(corner_uv[k], vcol);
+                v[0][k] = _mm_unpacklo_epi64(xy_lo, uc_lo);
+                v[1][k] = _mm_unpackhi_epi64(xy_lo, uc_lo);
+                v[2][k] = _mm_unpacklo_epi64(xy_hi, uc_hi);
+                v[3][k] = _mm_unpackhi_epi64(xy_hi, uc_hi);
+            }
+            __m128i* dst = (__m128i*)vx;
+            for (int g = 0; g < 4; g++, dst += 6) {
+                _mm_storeu_si128(dst + 0, v[g][0]);
+                _mm_storeu_si128(dst + 1, v[g][1]);
+                _mm_storeu_si128(dst + 2, v[g][2]);
+                _mm_storeu_si128(dst + 3, v[g][0]);
+                _mm_storeu_si128(dst + 4, v[g][2]);
+                _mm_storeu_si128(dst + 5, v[g][3]);
+            }
+        }
+    }
+    #endif
+    for (; i < num; i++, vx += 6) {
+        const float x0 = (ctx->origin.x + cols[i]) * gw;
+        const uint32_t u0 = ((uint32_t)chars[i] * _SDTXBULK_UVW) + 1;
+        const uint32_t u1 = u0 + _SDTXBULK_UVW - 2;
+        _sdtxbulk_store_glyph(vx, x0, x0 + gw, y0, y1, (uint16_t)u0, (uint16_t)u1, (uint16_t)v0, (uint16_t)v1, color);
+    }
+}
+
+static void sdtxbulk_putr(const char* str, int len) {
+    _sdtx_context_t* ctx = _sdtx.cur_ctx;
+    if (!ctx) {
+        return;
+    }
+    uint8_t chars[SDTXBULK_CHUNK_SIZE];
+    float cols[SDTXBULK_CHUNK_SIZE];
+    int i = 0;
+    while ((i < len) && str[i]) {
+        const int capacity = _sdtxbulk_capacity(ctx);
+        if (0 == capacity) {
+            // the vertex buffer is full, let sokol_debugtext.h deal with the rest
+            sdtx_putc(str[i++]);
+            continue;
+        }
+        // gather the visible glyphs up to the next control character,
+        // spaces only advance the cursor like in sokol_debugtext.h
+        const int max_num = (capacity < SDTXBULK_CHUNK_SIZE) ? capacity : SDTXBULK_CHUNK_SIZE;
+        float col = ctx->pos.x;
+        int num = 0;
+        while ((i < len) && (num < max_num)) {
+            const uint8_t c = (uint8_t)str[i];
+            if (c < 32) {
+                break;
+            }
+            if (c != 32) {
+                chars[num] = c;
+                cols[num] = col;
+                num++;
+            }
+            col += 1.0f;
+            i++;
+        }
+        _sdtxbulk_emit(ctx, chars, cols, num);
+        ctx->pos.x = col;
+        if ((i < len) && str[i] && ((uint8_t)str[i] < 32)) {
+            sdtx_putc(str[i++]);
+        }
+    }
+}
+
+static void sdtxbulk_puts(const char* str) {
+    sdtxbulk_putr(str, (int)strlen(str));
+}
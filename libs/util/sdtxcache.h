@@ -0,0 +1,334 @@
+#pragma once
+/*
+    Content-hash caching for sokol_debugtext.h text.
+
+    sokol-debugtext rebuilds and uploads all glyph vertices of a context
+    each frame, even if the text didn't change. An sdtxcache_t owns its
+    own debugtext context and a render target image per layer, and keeps
+    a hash of the text's inputs (strings, numbers, canvas size, ...). Only
+    when the hash changes, the text is defined again and rendered into the
+    cache's images, otherwise the images of the last rebuild are drawn
+    with a single fullscreen triangle:
+
+        sdtxcache_t cache;
+        sdtxcache_init(&cache, &(sdtxcache_desc_t){
+            .char_buf_size = 1024,
+            // the pass the cache is drawn into, zero for the swapchain defaults
+            .color_format = ...,
+            .depth_format = ...,
+            .sample_count = ...,
+        });
+        ...
+        // width and height are the pixel size of the pass the cache is drawn into
+        uint64_t hash = sdtxcache_hash(0, &score, sizeof(score));
+        if (sdtxcache_begin(&cache, width, height, hash)) {
+            // content changed, define the text as usual
+            sdtx_canvas(...);
+            sdtx_printf("Score: %d", score);
+        }
+        // outside a render pass, renders the text into the cache if it was rebuilt
+        sdtxcache_end(&cache);
+        ...
+        // inside a sokol-gfx render pass, instead of sdtx_draw():
+        sdtxcache_draw(&cache);
+
+    sdtxcache_begin() makes the cache's context current, it stays current
+    after sdtxcache_end(). A change of the size always causes a rebuild.
+
+    Only the public sokol_debugtext.h and sokol_gfx.h API is used, the
+    cached text is rendered with premultiplied alpha blending. Include
+    after sokol_debugtext.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define SDTXCACHE_MAX_LAYERS (4)
+
+typedef struct {
+    int char_buf_size;          // passed on to the cache's debugtext context
+    float canvas_width;         // initial canvas size of the context
+    float canvas_height;
+    int num_layers;             // default: 1, max SDTXCACHE_MAX_LAYERS
+    // attributes of the pass the cache is drawn into, default: the swapchain
+    sg_pixel_format color_format;
+    sg_pixel_format depth_format;
+    int sample_count;
+} sdtxcache_desc_t;
+
+typedef struct {
+    sdtx_context ctx;
+    bool valid;
+    bool rebuilt;           // true if the text was rebuilt this frame
+    uint64_t hash;
+    int num_layers;
+    int width, height;
+    sg_image img[SDTXCACHE_MAX_LAYERS];
+    sg_attachments atts[SDTXCACHE_MAX_LAYERS];
+    sg_sampler smp;
+    sg_shader shd;
+    sg_pipeline pip;
+    uint64_t num_rebuilt;   // number of frames the text was rebuilt...
+    uint64_t num_reused;    // ...or reused
+} sdtxcache_t;
+
+// FNV-1a, chain calls by passing the previous result as seed
+static uint64_t sdtxcache_hash(uint64_t seed, const void* data, size_t size) {
+    uint64_t h = seed ? seed : 0xCBF29CE484222325;
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001B3;
+    }
+    return h;
+}
+
+static uint64_t sdtxcache_hash_str(uint64_t seed, const char* str) {
+    return sdtxcache_hash(seed, str, strlen(str));
+}
+
+// draws a cached image with a fullscreen triangle, render targets are upside down on GL
+static sg_shader _sdtxcache_make_shader(void) {
+    sg_shader_desc desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.images[0].stage = SG_SHADERSTAGE_FRAGMENT;
+    desc.samplers[0].stage = SG_SHADERSTAGE_FRAGMENT;
+    desc.image_sampler_pairs[0].stage = SG_SHADERSTAGE_FRAGMENT;
+    desc.image_sampler_pairs[0].image_slot = 0;
+    desc.image_sampler_pairs[0].sampler_slot = 0;
+    desc.label = "sdtxcache-shader";
+    #if defined(SOKOL_GLCORE) || defined(SOKOL_GLES3)
+        #if defined(SOKOL_GLCORE)
+            #define _SDTXCACHE_GLSL_VERSION "#version 410\n"
+        #else
+            #define _SDTXCACHE_GLSL_VERSION "#version 300 es\nprecision mediump float;\n"
+        #endif
+        desc.vertex_func.source =
+            _SDTXCACHE_GLSL_VERSION
+            "out vec2 uv;\n"
+            "void main() {\n"
+            "  uv = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));\n"
+            "  gl_Position = vec4(uv * 2.0 - 1.0, 0.5, 1.0);\n"
+            "}\n";
+        desc.fragment_func.source =
+            _SDTXCACHE_GLSL_VERSION
+            "uniform sampler2D tex;\n"
+            "in vec2 uv;\n"
+            "out vec4 frag_color;\n"
+            "void main() {\n"
+            "  frag_color = texture(tex, uv);\n"
+            "}\n";
+        desc.image_sampler_pairs[0].glsl_name = "tex";
+        #undef _SDTXCACHE_GLSL_VERSION
+    #elif defined(SOKOL_D3D11)
+        desc.vertex_func.source =
+            "struct vs_out {\n"
+            "  float2 uv: TEXCOORD0;\n"
+            "  float4 pos: SV_Position;\n"
+            "};\n"
+            "vs_out main(uint vid: SV_VertexID) {\n"
+            "  vs_out outp;\n"
+            "  float2 p = float2((vid << 1) & 2, vid & 2);\n"
+            "  outp.pos = float4(p * 2.0 - 1.0, 0.5, 1.0);\n"
+            "  outp.uv = float2(p.x, 1.0 - p.y);\n"
+            "  return outp;\n"
+            "}\n";
+        desc.fragment_func.source =
+            "Texture2D<float4> tex: register(t0);\n"
+            "sampler smp: register(s0);\n"
+            "float4 main(float2 uv: TEXCOORD0): SV_Target0 {\n"
+            "  return tex.Sample(smp, uv);\n"
+            "}\n";
+        desc.images[0].hlsl_register_t_n = 0;
+        desc.samplers[0].hlsl_register_s_n = 0;
+    #elif defined(SOKOL_METAL)
+        desc.vertex_func.entry = "vs_main";
+        desc.vertex_func.source =
+            "#include <metal_stdlib>\n"
+            "using namespace metal;\n"
+            "struct vs_out {\n"
+            "  float4 pos [[position]];\n"
+            "  float2 uv;\n"
+            "};\n"
+            "vertex vs_out vs_main(uint vid [[vertex_id]]) {\n"
+            "  vs_out out;\n"
+            "  float2 p = float2((vid << 1) & 2, vid & 2);\n"
+            "  out.pos = float4(p * 2.0 - 1.0, 0.5, 1.0);\n"
+            "  out.uv = float2(p.x, 1.0 - p.y);\n"
+            "  return out;\n"
+            "}\n";
+        desc.fragment_func.entry = "fs_main";
+        desc.fragment_func.source =
+            "#include <metal_stdlib>\n"
+            "using namespace metal;\n"
+            "struct fs_in {\n"
+            "  float2 uv;\n"
+            "};\n"
+            "fragment float4 fs_main(fs_in in [[stage_in]], texture2d<float> tex [[texture(0)]], sampler smp [[sampler(0)]]) {\n"
+            "  return tex.sample(smp, in.uv);\n"
+            "}\n";
+        desc.images[0].msl_texture_n = 0;
+        desc.samplers[0].msl_sampler_n = 0;
+    #elif defined(SOKOL_WGPU)
+        desc.vertex_func.source =
+            "struct vs_out {\n"
+            "  @builtin(position) pos: vec4f,\n"
+            "  @location(0) uv: vec2f,\n"
+            "}\n"
+            "@vertex fn main(@builtin(vertex_index) vid: u32) -> vs_out {\n"
+            "  var out: vs_out;\n"
+            "  let p = vec2f(f32((vid << 1u) & 2u), f32(vid & 2u));\n"
+            "  out.pos = vec4f(p * 2.0 - 1.0, 0.5, 1.0);\n"
+            "  out.uv = vec2f(p.x, 1.0 - p.y);\n"
+            "  return out;\n"
+            "}\n";
+        desc.fragment_func.source =
+            "@group(1) @binding(0) var tex: texture_2d<f32>;\n"
+            "@group(1) @binding(1) var smp: sampler;\n"
+            "@fragment fn main(@location(0) uv: vec2f) -> @location(0) vec4f {\n"
+            "  return textureSample(tex, smp, uv);\n"
+            "}\n";
+        desc.images[0].wgsl_group1_binding_n = 0;
+        desc.samplers[0].wgsl_group1_binding_n = 1;
+    #endif
+    return sg_make_shader(&desc);
+}
+
+static void _sdtxcache_destroy_targets(sdtxcache_t* cache) {
+    for (int i = 0; i < SDTXCACHE_MAX_LAYERS; i++) {
+        sg_destroy_attachments(cache->atts[i]);
+        sg_destroy_image(cache->img[i]);
+        cache->atts[i] = (sg_attachments){0};
+        cache->img[i] = (sg_image){0};
+    }
+}
+
+static void _sdtxcache_create_targets(sdtxcache_t* cache, int width, int height) {
+    _sdtxcache_destroy_targets(cache);
+    cache->width = width;
+    cache->height = height;
+    for (int i = 0; i < cache->num_layers; i++) {
+        cache->img[i] = sg_make_image(&(sg_image_desc){
+            .render_target = true,
+            .width = width,
+            .height = height,
+            .pixel_format = SG_PIXELFORMAT_RGBA8,
+            .sample_count = 1,
+            .label = "sdtxcache-image",
+        });
+        cache->atts[i] = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = cache->img[i],
+            .label = "sdtxcache-attachments",
+        });
+    }
+}
+
+static void sdtxcache_init(sdtxcache_t* cache, const sdtxcache_desc_t* desc) {
+    assert(cache && desc);
+    assert((desc->num_layers >= 0) && (desc->num_layers <= SDTXCACHE_MAX_LAYERS));
+    memset(cache, 0, sizeof(sdtxcache_t));
+    cache->num_layers = (desc->num_layers > 0) ? desc->num_layers : 1;
+    // the text is always rendered into the cache's own RGBA8 images
+    cache->ctx = sdtx_make_context(&(sdtx_context_desc_t){
+        .char_buf_size = desc->char_buf_size,
+        .canvas_width = desc->canvas_width,
+        .canvas_height = desc->canvas_height,
+        .color_format = SG_PIXELFORMAT_RGBA8,
+        .depth_format = SG_PIXELFORMAT_NONE,
+        .sample_count = 1,
+    });
+    cache->smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "sdtxcache-sampler",
+    });
+    cache->shd = _sdtxcache_make_shader();
+    cache->pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .shader = cache->shd,
+        .depth.pixel_format = desc->depth_format,
+        .sample_count = desc->sample_count,
+        .colors[0] = {
+            .pixel_format = desc->color_format,
+            .blend = {
+                .enabled = true,
+                .src_factor_rgb = SG_BLENDFACTOR_ONE,
+                .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                .src_factor_alpha = SG_BLENDFACTOR_ONE,
+                .dst_factor_alpha = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            },
+        },
+        .label = "sdtxcache-pipeline",
+    });
+}
+
+static void sdtxcache_discard(sdtxcache_t* cache) {
+    assert(cache);
+    _sdtxcache_destroy_targets(cache);
+    sg_destroy_pipeline(cache->pip);
+    sg_destroy_shader(cache->shd);
+    sg_destroy_sampler(cache->smp);
+    sdtx_destroy_context(cache->ctx);
+    memset(cache, 0, sizeof(sdtxcache_t));
+}
+
+// returns true if the text must be rebuilt
+static bool sdtxcache_begin(sdtxcache_t* cache, int width, int height, uint64_t hash) {
+    assert(cache && (cache->num_layers > 0));
+    assert((width > 0) && (height > 0));
+    sdtx_set_context(cache->ctx);
+    const bool resized = (width != cache->width) || (height != cache->height);
+    if (resized) {
+        _sdtxcache_create_targets(cache, width, height);
+    }
+    cache->rebuilt = !cache->valid || resized || (cache->hash != hash);
+    cache->hash = hash;
+    cache->valid = true;
+    if (cache->rebuilt) {
+        cache->num_rebuilt++;
+    } else {
+        cache->num_reused++;
+    }
+    return cache->rebuilt;
+}
+
+static void sdtxcache_end(sdtxcache_t* cache) {
+    assert(cache && (cache->num_layers > 0));
+    if (!cache->rebuilt) {
+        return;
+    }
+    for (int i = 0; i < cache->num_layers; i++) {
+        sg_begin_pass(&(sg_pass){
+            .action.colors[0] = {
+                .load_action = SG_LOADACTION_CLEAR,
+                .clear_value = { 0.0f, 0.0f, 0.0f, 0.0f },
+            },
+            .attachments = cache->atts[i],
+            .label = "sdtxcache-pass",
+        });
+        sdtx_context_draw_layer(cache->ctx, i);
+        sg_end_pass();
+    }
+}
+
+// like sdtx_draw_layer(), but renders from the cache
+static void sdtxcache_draw_layer(const sdtxcache_t* cache, int layer_id) {
+    assert(cache);
+    if (!cache->valid || (layer_id < 0) || (layer_id >= cache->num_layers)) {
+        return;
+    }
+    sg_push_debug_group("sdtxcache");
+    sg_apply_pipeline(cache->pip);
+    sg_apply_bindings(&(sg_bindings){
+        .images[0] = cache->img[layer_id],
+        .samplers[0] = cache->smp,
+    });
+    sg_draw(0, 3, 1);
+    sg_pop_debug_group();
+}
+
+static void sdtxcache_draw(const sdtxcache_t* cache) {
+    sdtxcache_draw_layer(cache, 0);
+}
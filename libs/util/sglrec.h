@@ -0,0 +1,506 @@
+#pragma once
+/*
+    Quick'n'dirty 'record once, replay many' helper for static geometry
+    which would otherwise be re-submitted through sokol_gl.h every frame.
+
+    Vertices are recorded with a subset of the sokol_gl.h API, and
+    sglrec_end_recording() copies them into an immutable vertex buffer
+    together with a small draw list. Replaying a recorded mesh only
+    needs a model-view-projection matrix:
+
+        sglrec_setup(&(sglrec_desc_t){
+            .shader = sg_make_shader(sglrec_shader_desc(sg_query_backend())),
+            // optional, same as in sg_pipeline_desc
+            .cull_mode = SG_CULLMODE_BACK,
+            .depth = { .write_enabled = true, .compare = SG_COMPAREFUNC_LESS_EQUAL },
+        });
+        ...
+        sglrec_begin_recording();
+        sglrec_begin_lines();
+        sglrec_c3f(1.0f, 0.0f, 1.0f);
+        sglrec_v3f(...);
+        ...
+        sglrec_end();
+        sglrec_mesh_t mesh = sglrec_end_recording("my-mesh");
+        ...
+        // inside a sokol-gfx render pass:
+        sglrec_draw(&mesh, mvp);
+
+    Line strips and quads are converted into lines and triangles during
+    recording, consecutive primitives of the same type and texture are
+    merged into a single draw.
+
+    For dynamic point clouds, sglrec_stream_points() appends points from
+    separate position, color and size arrays in one call (with an SSE2
+    interleave loop where available) into a per-frame stream buffer,
+    which is rendered with sglrec_stream_draw():
+
+        sglrec_setup(&(sglrec_desc_t){ ..., .max_stream_vertices = 1000000 });
+        ...
+        sglrec_stream_points(num_points, xy, rgba, sizes);
+        ...
+        // once per frame inside a sokol-gfx render pass:
+        sglrec_stream_draw(mvp);
+
+    The shader is provided by the application and must have the same
+    interface as the sokol-gl shader:
+
+        - vertex attributes at location 0, 1, 2 and 3: position (float3),
+          texcoord (float2), color (ubyte4n) and point size (float)
+        - a vertex shader uniform block at slot 0 with a mat4 mvp
+        - a texture and sampler at slot 0
+
+    sglrec takes ownership of the shader, it is destroyed in
+    sglrec_shutdown().
+
+    Include after sokol_gfx.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if !defined(SGLREC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>
+#define SGLREC_SSE2 (1)
+#else
+#define SGLREC_SSE2 (0)
+#endif
+
+typedef enum {
+    SGLREC_PRIMITIVE_POINTS,
+    SGLREC_PRIMITIVE_LINES,
+    SGLREC_PRIMITIVE_TRIANGLES,
+    SGLREC_NUM_PRIMITIVES,
+} sglrec_primitive_t;
+
+typedef struct {
+    sg_shader shader;               // owned by sglrec, destroyed in sglrec_shutdown()
+    int max_vertices;               // default: 64k
+    int max_commands;               // default: 1024
+    int max_stream_vertices;        // default: 0 (no stream buffer)
+    sg_cull_mode cull_mode;         // cull mode and face winding of triangles
+    sg_face_winding face_winding;
+    sg_depth_state depth;           // depth pixel format, test and writes
+    sg_pixel_format color_format;   // default: swapchain default
+    int sample_count;
+} sglrec_desc_t;
+
+typedef struct {
+    float x, y, z;
+    float u, v;
+    uint32_t rgba;
+    float psize;
+} sglrec_vertex_t;
+
+typedef struct {
+    sglrec_primitive_t primitive;
+    sg_image img;
+    sg_sampler smp;
+    int base_vertex;
+    int num_vertices;
+} sglrec_command_t;
+
+typedef struct {
+    sg_buffer vbuf;
+    int num_vertices;
+    int num_commands;
+    sglrec_command_t* commands;
+} sglrec_mesh_t;
+
+typedef enum {
+    _SGLREC_MODE_POINTS,
+    _SGLREC_MODE_LINES,
+    _SGLREC_MODE_LINE_STRIP,
+    _SGLREC_MODE_TRIANGLES,
+    _SGLREC_MODE_QUADS,
+} _sglrec_mode_t;
+
+static struct {
+    bool valid;
+    bool recording;
+    bool in_begin;
+    sglrec_desc_t desc;
+    sg_pipeline pip[SGLREC_NUM_PRIMITIVES];
+    sg_image white_img;
+    sg_sampler smp;
+    // recording state
+    _sglrec_mode_t mode;
+    int begin_vertex;               // first vertex of the current begin/end pair
+    int num_begin_vertices;         // vertices submitted since begin
+    sglrec_vertex_t strip_prev;     // previous line strip vertex
+    sglrec_vertex_t quad[3];        // pending quad vertices
+    float u, v;
+    uint32_t rgba;
+    float psize;
+    sg_image img;
+    sg_sampler cur_smp;
+    bool overflow;
+    int num_vertices;
+    int num_commands;
+    sglrec_vertex_t* vertices;
+    sglrec_command_t* commands;
+    // per-frame stream buffer
+    sg_buffer stream_vbuf;
+    int num_stream_vertices;
+    sglrec_vertex_t* stream_vertices;
+} _sglrec;
+
+static void sglrec_setup(const sglrec_desc_t* desc) {
+    assert(desc && !_sglrec.valid);
+    memset(&_sglrec, 0, sizeof(_sglrec));
+    _sglrec.valid = true;
+    _sglrec.desc = *desc;
+    if (_sglrec.desc.max_vertices == 0) {
+        _sglrec.desc.max_vertices = 64 * 1024;
+    }
+    if (_sglrec.desc.max_commands == 0) {
+        _sglrec.desc.max_commands = 1024;
+    }
+    _sglrec.vertices = (sglrec_vertex_t*) malloc((size_t)_sglrec.desc.max_vertices * sizeof(sglrec_vertex_t));
+    _sglrec.commands = (sglrec_command_t*) malloc((size_t)_sglrec.desc.max_commands * sizeof(sglrec_command_t));
+    assert(_sglrec.vertices && _sglrec.commands);
+
+    // a white default texture for untextured geometry, same as sokol-gl
+    const uint32_t white_pixels[4] = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
+    _sglrec.white_img = sg_make_image(&(sg_image_desc){
+        .width = 2,
+        .height = 2,
+        .data.subimage[0][0] = SG_RANGE(white_pixels),
+        .label = "sglrec-white-texture",
+    });
+    _sglrec.smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .label = "sglrec-sampler",
+    });
+    const sg_primitive_type prim_types[SGLREC_NUM_PRIMITIVES] = {
+        SG_PRIMITIVETYPE_POINTS, SG_PRIMITIVETYPE_LINES, SG_PRIMITIVETYPE_TRIANGLES,
+    };
+    for (int i = 0; i < SGLREC_NUM_PRIMITIVES; i++) {
+        sg_pipeline_desc pip_desc = {
+            .shader = desc->shader,
+            .layout = {
+                .attrs = {
+                    [0].format = SG_VERTEXFORMAT_FLOAT3,
+                    [1].format = SG_VERTEXFORMAT_FLOAT2,
+                    [2].format = SG_VERTEXFORMAT_UBYTE4N,
+                    [3].format = SG_VERTEXFORMAT_FLOAT,
+                },
+            },
+            .primitive_type = prim_types[i],
+            .depth = desc->depth,
+            .colors[0].pixel_format = desc->color_format,
+            .sample_count = desc->sample_count,
+            .label = "sglrec-pipeline",
+        };
+        // culling only applies to triangles, same as in sokol-gl
+        if (prim_types[i] == SG_PRIMITIVETYPE_TRIANGLES) {
+            pip_desc.cull_mode = desc->cull_mode;
+            pip_desc.face_winding = desc->face_winding;
+        }
+        _sglrec.pip[i] = sg_make_pipeline(&pip_desc);
+    }
+    if (_sglrec.desc.max_stream_vertices > 0) {
+        const size_t size = (size_t)_sglrec.desc.max_stream_vertices * sizeof(sglrec_vertex_t);
+        _sglrec.stream_vertices = (sglrec_vertex_t*) malloc(size);
+        assert(_sglrec.stream_vertices);
+        _sglrec.stream_vbuf = sg_make_buffer(&(sg_buffer_desc){
+            .size = size,
+            .usage = SG_USAGE_STREAM,
+            .label = "sglrec-stream-vertices",
+        });
+    }
+}
+
+static void sglrec_shutdown(void) {
+    assert(_sglrec.valid);
+    for (int i = 0; i < SGLREC_NUM_PRIMITIVES; i++) {
+        sg_destroy_pipeline(_sglrec.pip[i]);
+    }
+    sg_destroy_sampler(_sglrec.smp);
+    sg_destroy_image(_sglrec.white_img);
+    sg_destroy_buffer(_sglrec.stream_vbuf);
+    sg_destroy_shader(_sglrec.desc.shader);
+    free(_sglrec.stream_vertices);
+    free(_sglrec.vertices);
+    free(_sglrec.commands);
+    memset(&_sglrec, 0, sizeof(_sglrec));
+}
+
+static void sglrec_begin_recording(void) {
+    assert(_sglrec.valid && !_sglrec.recording);
+    _sglrec.recording = true;
+    _sglrec.overflow = false;
+    _sglrec.num_vertices = 0;
+    _sglrec.num_commands = 0;
+    _sglrec.u = _sglrec.v = 0.0f;
+    _sglrec.rgba = 0xFFFFFFFF;
+    _sglrec.psize = 1.0f;
+    _sglrec.img = _sglrec.white_img;
+    _sglrec.cur_smp = _sglrec.smp;
+}
+
+/* returns a mesh with an invalid vertex buffer if the vertex or command capacity overflowed */
+static sglrec_mesh_t sglrec_end_recording(const char* label) {
+    assert(_sglrec.valid && _sglrec.recording && !_sglrec.in_begin);
+    _sglrec.recording = false;
+    sglrec_mesh_t mesh = { 0 };
+    if (_sglrec.overflow || (_sglrec.num_vertices == 0)) {
+        return mesh;
+    }
+    mesh.vbuf = sg_make_buffer(&(sg_buffer_desc){
+        .data = {
+            .ptr = _sglrec.vertices,
+            .size = (size_t)_sglrec.num_vertices * sizeof(sglrec_vertex_t),
+        },
+        .label = label,
+    });
+    mesh.num_vertices = _sglrec.num_vertices;
+    mesh.num_commands = _sglrec.num_commands;
+    const size_t cmd_size = (size_t)_sglrec.num_commands * sizeof(sglrec_command_t);
+    mesh.commands = (sglrec_command_t*) malloc(cmd_size);
+    assert(mesh.commands);
+    memcpy(mesh.commands, _sglrec.commands, cmd_size);
+    return mesh;
+}
+
+static void sglrec_destroy_mesh(sglrec_mesh_t* mesh) {
+    assert(mesh);
+    sg_destroy_buffer(mesh->vbuf);
+    free(mesh->commands);
+    memset(mesh, 0, sizeof(sglrec_mesh_t));
+}
+
+static void _sglrec_begin(_sglrec_mode_t mode) {
+    assert(_sglrec.recording && !_sglrec.in_begin);
+    _sglrec.in_begin = true;
+    _sglrec.mode = mode;
+    _sglrec.begin_vertex = _sglrec.num_vertices;
+    _sglrec.num_begin_vertices = 0;
+}
+
+static void sglrec_begin_points(void) { _sglrec_begin(_SGLREC_MODE_POINTS); }
+static void sglrec_begin_lines(void) { _sglrec_begin(_SGLREC_MODE_LINES); }
+static void sglrec_begin_line_strip(void) { _sglrec_begin(_SGLREC_MODE_LINE_STRIP); }
+static void sglrec_begin_triangles(void) { _sglrec_begin(_SGLREC_MODE_TRIANGLES); }
+static void sglrec_begin_quads(void) { _sglrec_begin(_SGLREC_MODE_QUADS); }
+
+static void sglrec_end(void) {
+    assert(_sglrec.in_begin);
+    _sglrec.in_begin = false;
+    const int num = _sglrec.num_vertices - _sglrec.begin_vertex;
+    if (num == 0) {
+        return;
+    }
+    sglrec_primitive_t prim;
+    switch (_sglrec.mode) {
+        case _SGLREC_MODE_POINTS: prim = SGLREC_PRIMITIVE_POINTS; break;
+        case _SGLREC_MODE_LINES:
+        case _SGLREC_MODE_LINE_STRIP: prim = SGLREC_PRIMITIVE_LINES; break;
+        default: prim = SGLREC_PRIMITIVE_TRIANGLES; break;
+    }
+    // merge with the previous command if possible
+    if (_sglrec.num_commands > 0) {
+        sglrec_command_t* prev = &_sglrec.commands[_sglrec.num_commands - 1];
+        if ((prev->primitive == prim) &&
+            (prev->img.id == _sglrec.img.id) &&
+            (prev->smp.id == _sglrec.cur_smp.id) &&
+            ((prev->base_vertex + prev->num_vertices) == _sglrec.begin_vertex))
+        {
+            prev->num_vertices += num;
+            return;
+        }
+    }
+    if (_sglrec.num_commands >= _sglrec.desc.max_commands) {
+        _sglrec.overflow = true;
+        return;
+    }
+    _sglrec.commands[_sglrec.num_commands++] = (sglrec_command_t){
+        .primitive = prim,
+        .img = _sglrec.img,
+        .smp = _sglrec.cur_smp,
+        .base_vertex = _sglrec.begin_vertex,
+        .num_vertices = num,
+    };
+}
+
+static void sglrec_texture(sg_image img, sg_sampler smp) {
+    assert(_sglrec.recording && !_sglrec.in_begin);
+    _sglrec.img = (img.id != SG_INVALID_ID) ? img : _sglrec.white_img;
+    _sglrec.cur_smp = (smp.id != SG_INVALID_ID) ? smp : _sglrec.smp;
+}
+
+static void sglrec_c4b(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    _sglrec.rgba = (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+}
+
+static void sglrec_c3b(uint8_t r, uint8_t g, uint8_t b) {
+    sglrec_c4b(r, g, b, 255);
+}
+
+static uint8_t _sglrec_unorm8(float f) {
+    return (uint8_t)((f <= 0.0f) ? 0 : ((f >= 1.0f) ? 255 : (int)(f * 255.0f + 0.5f)));
+}
+
+static void sglrec_c3f(float r, float g, float b) {
+    sglrec_c4b(_sglrec_unorm8(r), _sglrec_unorm8(g), _sglrec_unorm8(b), 255);
+}
+
+static void sglrec_point_size(float s) {
+    _sglrec.psize = s;
+}
+
+static void sglrec_t2f(float u, float v) {
+    _sglrec.u = u;
+    _sglrec.v = v;
+}
+
+static void _sglrec_push(const sglrec_vertex_t* vtx) {
+    if (_sglrec.num_vertices >= _sglrec.desc.max_vertices) {
+        _sglrec.overflow = true;
+        return;
+    }
+    _sglrec.vertices[_sglrec.num_vertices++] = *vtx;
+}
+
+static void sglrec_v3f(float x, float y, float z) {
+    assert(_sglrec.in_begin);
+    const sglrec_vertex_t vtx = { x, y, z, _sglrec.u, _sglrec.v, _sglrec.rgba, _sglrec.psize };
+    const int n = _sglrec.num_begin_vertices++;
+    switch (_sglrec.mode) {
+        case _SGLREC_MODE_LINE_STRIP:
+            // each strip vertex after the first one ends a line segment
+            if (n > 0) {
+                _sglrec_push(&_sglrec.strip_prev);
+                _sglrec_push(&vtx);
+            }
+            _sglrec.strip_prev = vtx;
+            break;
+        case _SGLREC_MODE_QUADS:
+            if ((n & 3) == 3) {
+                _sglrec_push(&_sglrec.quad[0]);
+                _sglrec_push(&_sglrec.quad[1]);
+                _sglrec_push(&_sglrec.quad[2]);
+                _sglrec_push(&_sglrec.quad[0]);
+                _sglrec_push(&_sglrec.quad[2]);
+                _sglrec_push(&vtx);
+            } else {
+                _sglrec.quad[n & 3] = vtx;
+            }
+            break;
+        default:
+            _sglrec_push(&vtx);
+            break;
+    }
+}
+
+static void sglrec_v2f(float x, float y) {
+    sglrec_v3f(x, y, 0.0f);
+}
+
+static void sglrec_v3f_t2f(float x, float y, float z, float u, float v) {
+    sglrec_t2f(u, v);
+    sglrec_v3f(x, y, z);
+}
+
+static void sglrec_v3f_c3f(float x, float y, float z, float r, float g, float b) {
+    sglrec_c3f(r, g, b);
+    sglrec_v3f(x, y, z);
+}
+
+/* replay a recorded mesh, must be called inside a sokol-gfx render pass */
+static void sglrec_draw(const sglrec_mesh_t* mesh, const float* mvp) {
+    assert(_sglrec.valid && mesh && mvp);
+    if (mesh->vbuf.id == SG_INVALID_ID) {
+        return;
+    }
+    int cur_prim = -1;
+    for (int i = 0; i < mesh->num_commands; i++) {
+        const sglrec_command_t* cmd = &mesh->commands[i];
+        if ((int)cmd->primitive != cur_prim) {
+            cur_prim = (int)cmd->primitive;
+            sg_apply_pipeline(_sglrec.pip[cur_prim]);
+            sg_apply_uniforms(0, &(sg_range){ mvp, 16 * sizeof(float) });
+        }
+        sg_apply_bindings(&(sg_bindings){
+            .vertex_buffers[0] = mesh->vbuf,
+            .images[0] = cmd->img,
+            .samplers[0] = cmd->smp,
+        });
+        sg_draw(cmd->base_vertex, cmd->num_vertices, 1);
+    }
+}
+
+// interleave separate point arrays into vertices, 'rgba' and 'sizes' may be null
+static void _sglrec_interleave_points(sglrec_vertex_t* dst, int num, const float* xy, const uint32_t* rgba, const float* sizes) {
+    int i = 0;
+    #if SGLREC_SSE2
+    // four points per iteration, each vertex is written with two overlapping
+    // 16-byte stores: (x, y, z, u) at offset 0 and (u, v, rgba, psize) at offset 12
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 white = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; (i + 4) <= num; i += 4) {
+        const __m128 xy01 = _mm_loadu_ps(xy + 2 * i);
+        const __m128 xy23 = _mm_loadu_ps(xy + 2 * i + 4);
+        const __m128 c = rgba ? _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(rgba + i))) : white;
+        const __m128 s = sizes ? _mm_loadu_ps(sizes + i) : one;
+        const __m128 cs01 = _mm_unpacklo_ps(c, s);     // c0 s0 c1 s1
+        const __m128 cs23 = _mm_unpackhi_ps(c, s);     // c2 s2 c3 s3
+        float* d = &dst[i].x;
+        const int stride = (int)(sizeof(sglrec_vertex_t) / sizeof(float));
+        _mm_storeu_ps(d + 0 * stride, _mm_movelh_ps(xy01, zero));
+        _mm_storeu_ps(d + 0 * stride + 3, _mm_movelh_ps(zero, cs01));
+        _mm_storeu_ps(d + 1 * stride, _mm_movehl_ps(zero, xy01));
+        _mm_storeu_ps(d + 1 * stride + 3, _mm_movelh_ps(zero, _mm_movehl_ps(cs01, cs01)));
+        _mm_storeu_ps(d + 2 * stride, _mm_movelh_ps(xy23, zero));
+        _mm_storeu_ps(d + 2 * stride + 3, _mm_movelh_ps(zero, cs23));
+        _mm_storeu_ps(d + 3 * stride, _mm_movehl_ps(zero, xy23));
+        _mm_storeu_ps(d + 3 * stride + 3, _mm_movelh_ps(zero, _mm_movehl_ps(cs23, cs23)));
+    }
+    #endif
+    for (; i < num; i++) {
+        dst[i] = (sglrec_vertex_t){
+            .x = xy[2 * i + 0],
+            .y = xy[2 * i + 1],
+            .rgba = rgba ? rgba[i] : 0xFFFFFFFF,
+            .psize = sizes ? sizes[i] : 1.0f,
+        };
+    }
+}
+
+/* append points to the per-frame stream buffer, returns false if the buffer is full */
+static bool sglrec_stream_points(int num_points, const float* xy, const uint32_t* rgba, const float* sizes) {
+    assert(_sglrec.valid && _sglrec.stream_vertices && xy && (num_points >= 0));
+    bool fits = true;
+    if ((_sglrec.num_stream_vertices + num_points) > _sglrec.desc.max_stream_vertices) {
+        num_points = _sglrec.desc.max_stream_vertices - _sglrec.num_stream_vertices;
+        fits = false;
+    }
+    _sglrec_interleave_points(_sglrec.stream_vertices + _sglrec.num_stream_vertices, num_points, xy, rgba, sizes);
+    _sglrec.num_stream_vertices += num_points;
+    return fits;
+}
+
+/* upload and render all streamed points, call once per frame inside a sokol-gfx render pass */
+static void sglrec_stream_draw(const float* mvp) {
+    assert(_sglrec.valid && mvp);
+    const int num = _sglrec.num_stream_vertices;
+    _sglrec.num_stream_vertices = 0;
+    if (num == 0) {
+        return;
+    }
+    sg_update_buffer(_sglrec.stream_vbuf, &(sg_range){
+        .ptr = _sglrec.stream_vertices,
+        .size = (size_t)num * sizeof(sglrec_vertex_t),
+    });
+    sg_apply_pipeline(_sglrec.pip[SGLREC_PRIMITIVE_POINTS]);
+    sg_apply_uniforms(0, &(sg_range){ mvp, 16 * sizeof(float) });
+    sg_apply_bindings(&(sg_bindings){
+        .vertex_buffers[0] = _sglrec.stream_vbuf,
+        .images[0] = _sglrec.white_img,
+        .samplers[0] = _sglrec.smp,
+    });
+    sg_draw(0, num, 1);
+}
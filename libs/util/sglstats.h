@@ -0,0 +1,245 @@
+#pragma once
+/*
+    Per-context sokol_gl.h counters: how many vertices and commands a
+    context recorded in a frame, how many primitives were merged into
+    a previous draw command, how many sokol-gfx draws and pipeline
+    switches sgl_context_draw() turned that into, and how often a context
+    was dropped because its vertex- or command-buffer overflowed
+    (sokol_gl.h skips rendering a context completely in that case).
+
+    Usage:
+
+        sglstats_setup();
+        // optional, the capacities from sgl_desc_t or sgl_context_desc_t
+        // (the counters can't query them)
+        sglstats_track(ctx, max_vertices, max_commands);
+        ...
+        // inside a sokol-gfx render pass, instead of sgl_context_draw():
+        sglstats_context_draw(ctx);
+        ...
+        // the counters of the last sglstats_context_draw() call:
+        const sglstats_t stats = sglstats_query(ctx);
+
+    Merging happens inside sgl_end(), so the batch and merge counters are
+    only gathered where sglstats_end() is used instead of sgl_end(), all
+    other counters work with plain sgl_end():
+
+        sgl_begin_quads();
+        ...
+        sglstats_end();
+
+    The draw and pipeline counters are gathered with sokol-gfx trace hooks,
+    so sokol_gfx.h must be compiled with SOKOL_TRACE_HOOKS (which is the
+    case for the sokol lib in this project). Previously installed trace
+    hooks (e.g. from the sokol-gfx debug UI) are still called.
+
+    Only the public sokol_gl.h and sokol_gfx.h API is used, the vertex-
+    and command-counts come from sgl_num_vertices() and sgl_num_commands().
+    Include after sokol_gl.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#define SGLSTATS_MAX_CONTEXTS (8)
+
+typedef struct {
+    int num_vertices;           // vertices recorded this frame
+    int max_vertices;           // 0 unless set with sglstats_track()
+    int num_commands;           // commands recorded this frame (draw, viewport, scissor)
+    int max_commands;           // 0 unless set with sglstats_track()
+    int num_batches;            // sglstats_end() calls
+    int num_merged;             // ...of those which were merged into the previous draw command
+    int num_draws;              // sg_draw() calls in sgl_context_draw()
+    int num_pipeline_switches;  // sg_apply_pipeline() calls in sgl_context_draw()
+    int upload_bytes;           // vertex and uniform data updated in sgl_context_draw()
+    sgl_error_t error;          // SGL_NO_ERROR unless the context overflowed this frame
+    uint64_t num_frames;        // number of sglstats_context_draw() calls
+    uint64_t num_dropped;       // ...of those skipped because of an error
+} sglstats_t;
+
+typedef struct {
+    uint32_t ctx_id;
+    int max_vertices;
+    int max_commands;
+    int last_vertices;      // vertex count after the previous sglstats_end()
+    int batches;
+    int merged;
+    sglstats_t stats;
+} _sglstats_slot_t;
+
+static struct {
+    bool valid;
+    sg_trace_hooks prev_hooks;
+    _sglstats_slot_t* active;
+    _sglstats_slot_t slots[SGLSTATS_MAX_CONTEXTS];
+} _sglstats;
+
+static _sglstats_slot_t* _sglstats_slot(sgl_context ctx) {
+    for (int i = 0; i < SGLSTATS_MAX_CONTEXTS; i++) {
+        if (_sglstats.slots[i].ctx_id == ctx.id) {
+            return &_sglstats.slots[i];
+        }
+    }
+    for (int i = 0; i < SGLSTATS_MAX_CONTEXTS; i++) {
+        if (_sglstats.slots[i].ctx_id == SG_INVALID_ID) {
+            _sglstats.slots[i].ctx_id = ctx.id;
+            return &_sglstats.slots[i];
+        }
+    }
+    return 0;
+}
+
+static void _sglstats_update_buffer(sg_buffer buf, const sg_range* data, void* user_data) {
+    (void)user_data;
+    if (_sglstats.active) {
+        _sglstats.active->stats.upload_bytes += (int)data->size;
+    }
+    if (_sglstats.prev_hooks.update_buffer) {
+        _sglstats.prev_hooks.update_buffer(buf, data, _sglstats.prev_hooks.user_data);
+    }
+}
+
+static void _sglstats_apply_pipeline(sg_pipeline pip, void* user_data) {
+    (void)user_data;
+    if (_sglstats.active) {
+        _sglstats.active->stats.num_pipeline_switches++;
+    }
+    if (_sglstats.prev_hooks.apply_pipeline) {
+        _sglstats.prev_hooks.apply_pipeline(pip, _sglstats.prev_hooks.user_data);
+    }
+}
+
+static void _sglstats_apply_uniforms(int ub_slot, const sg_range* data, void* user_data) {
+    (void)user_data;
+    if (_sglstats.active) {
+        _sglstats.active->stats.upload_bytes += (int)data->size;
+    }
+    if (_sglstats.prev_hooks.apply_uniforms) {
+        _sglstats.prev_hooks.apply_uniforms(ub_slot, data, _sglstats.prev_hooks.user_data);
+    }
+}
+
+static void _sglstats_draw(int base_element, int num_elements, int num_instances, void* user_data) {
+    (void)user_data;
+    if (_sglstats.active) {
+        _sglstats.active->stats.num_draws++;
+    }
+    if (_sglstats.prev_hooks.draw) {
+        _sglstats.prev_hooks.draw(base_element, num_elements, num_instances, _sglstats.prev_hooks.user_data);
+    }
+}
+
+static void sglstats_setup(void) {
+    assert(!_sglstats.valid);
+    memset(&_sglstats, 0, sizeof(_sglstats));
+    _sglstats.valid = true;
+    _sglstats.prev_hooks = sg_install_trace_hooks(&(sg_trace_hooks){
+        .update_buffer = _sglstats_update_buffer,
+        .apply_pipeline = _sglstats_apply_pipeline,
+        .apply_uniforms = _sglstats_apply_uniforms,
+        .draw = _sglstats_draw,
+    });
+}
+
+static void sglstats_shutdown(void) {
+    assert(_sglstats.valid);
+    sg_install_trace_hooks(&_sglstats.prev_hooks);
+    _sglstats.valid = false;
+}
+
+// set the vertex- and command-capacity a context was created with
+static void sglstats_track(sgl_context ctx, int max_vertices, int max_commands) {
+    assert(_sglstats.valid);
+    _sglstats_slot_t* slot = _sglstats_slot(ctx);
+    if (slot) {
+        slot->max_vertices = max_vertices;
+        slot->max_commands = max_commands;
+    }
+}
+
+// optional replacement for sgl_end() which counts batches merged by sokol-gl
+static void sglstats_end(void) {
+    if (!_sglstats.valid) {
+        sgl_end();
+        return;
+    }
+    // the vertex count includes the primitive which is ended here
+    const int num_vertices = sgl_num_vertices();
+    const int num_commands = sgl_num_commands();
+    sgl_end();
+    _sglstats_slot_t* slot = _sglstats_slot(sgl_get_context());
+    if (!slot) {
+        return;
+    }
+    const bool has_vertices = num_vertices > slot->last_vertices;
+    slot->last_vertices = num_vertices;
+    if (has_vertices && (sgl_error() == SGL_NO_ERROR)) {
+        slot->batches++;
+        if (sgl_num_commands() == num_commands) {
+            slot->merged++;
+        }
+    }
+}
+
+// replacement for sgl_context_draw(), must be called inside a sokol-gfx pass
+static void sglstats_context_draw(sgl_context ctx) {
+    assert(_sglstats.valid);
+    _sglstats_slot_t* slot = _sglstats_slot(ctx);
+    if (!slot) {
+        sgl_context_draw(ctx);
+        return;
+    }
+    // the counters are only available for the current context
+    const sgl_context cur_ctx = sgl_get_context();
+    sgl_set_context(ctx);
+    const int num_vertices = sgl_num_vertices();
+    const int num_commands = sgl_num_commands();
+    sgl_set_context(cur_ctx);
+    sglstats_t* stats = &slot->stats;
+    stats->num_vertices = num_vertices;
+    stats->max_vertices = slot->max_vertices;
+    stats->num_commands = num_commands;
+    stats->max_commands = slot->max_commands;
+    stats->num_batches = slot->batches;
+    stats->num_merged = slot->merged;
+    stats->num_draws = 0;
+    stats->num_pipeline_switches = 0;
+    stats->upload_bytes = 0;
+    stats->error = sgl_context_error(ctx);
+    stats->num_frames++;
+    if (stats->error != SGL_NO_ERROR) {
+        stats->num_dropped++;
+    }
+    slot->batches = 0;
+    slot->merged = 0;
+    // the context is rewound before the next frame is recorded
+    slot->last_vertices = 0;
+
+    _sglstats.active = slot;
+    sgl_context_draw(ctx);
+    _sglstats.active = 0;
+}
+
+static void sglstats_draw(void) {
+    sglstats_context_draw(sgl_default_context());
+}
+
+static sglstats_t sglstats_query(sgl_context ctx) {
+    assert(_sglstats.valid);
+    const _sglstats_slot_t* slot = _sglstats_slot(ctx);
+    return slot ? slot->stats : (sglstats_t){0};
+}
+
+static const char* sglstats_error_string(sgl_error_t err) {
+    switch (err) {
+        case SGL_NO_ERROR:              return "none";
+        case SGL_ERROR_VERTICES_FULL:   return "vertices full";
+        case SGL_ERROR_UNIFORMS_FULL:   return "uniforms full";
+        case SGL_ERROR_COMMANDS_FULL:   return "commands full";
+        case SGL_ERROR_STACK_OVERFLOW:  return "stack overflow";
+        case SGL_ERROR_STACK_UNDERFLOW: return "stack underflow";
+        default:                        return "other";
+    }
+}
@@ -0,0 +1,907 @@
+#pragma once
+/*
+    Preparsed Spine atlas and skeleton data as a flat binary blob.
+
+    Parsing the atlas text and the skeleton .skel/.json file creates a
+    large graph of small spine-c objects. spineblob_parse() routes all
+    spine-c allocations during parsing into a single memory arena, so the
+    parsed atlas and skeleton data end up in one contiguous block.
+    spineblob_save() turns the arena into a blob: it walks the spine-c
+    object graph and records the location of each pointer field, and of
+    each attachment and timeline vtable together with the object type.
+    spineblob_load() copies the blob into a new arena, rebases the pointer
+    fields and fills in the vtables of the running executable, without any
+    parsing:
+
+        // first run: parse and save
+        spineblob_data_t data;
+        if (spineblob_parse(&(spineblob_parse_desc_t){
+            .atlas_data = atlas_text, .atlas_size = atlas_size,
+            .skeleton_data = skel_bytes, .skeleton_size = skel_size,
+        }, &data)) {
+            void* blob;
+            size_t blob_size = spineblob_save(&data, &blob);
+            ... write blob to a cache file, free(blob)
+        }
+        ...
+        // later runs: load the cache file
+        if (spineblob_load(blob, blob_size, &data)) {
+            spSkeleton* skel = spSkeleton_create(data.skeleton_data);
+            ...
+        }
+        ...
+        spineblob_free(&data);
+
+    The parsed data lives in the arena, never call spAtlas_dispose() or
+    spSkeletonData_dispose() on it, only spineblob_free(). The renderer
+    objects of the atlas pages are not part of the blob (they are zero after
+    loading), they must be set up again.
+
+    The object graph walk knows the spine-c 4.1 data structures. If it finds
+    a pointer it can't account for (a pointer out of the arena, an unknown
+    attachment or timeline type), spineblob_save() fails instead of guessing,
+    and the data must be parsed each time. Code addresses are never stored
+    in the blob, but the blob depends on the spine-c struct layouts, a
+    fingerprint of them is checked by spineblob_load().
+
+    spine-c has no way to query its allocator functions, so the ones that
+    are active when calling spineblob_parse() must be passed in the desc
+    (default: malloc(), realloc(), free() and no debug malloc).
+    spineblob_parse() temporarily replaces them with the arena allocator and
+    restores them when done, so it must not run in parallel to other
+    spine-c code.
+
+    Include after spine/spine.h and spine/extension.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define SPINEBLOB_DEFAULT_ARENA_SIZE (32 * 1024 * 1024)
+#define _SPINEBLOB_MAGIC (0x4C425053)   // 'SPBL'
+#define _SPINEBLOB_VERSION (2)
+#define _SPINEBLOB_ALIGN (16)
+
+// relocation kinds, the low 16 bits hold the attachment or timeline type
+#define _SPINEBLOB_RELOC_POINTER (0 << 16)      // pointer into the arena
+#define _SPINEBLOB_RELOC_CLEAR (1 << 16)        // renderer object, zero after loading
+#define _SPINEBLOB_RELOC_ATTACHMENT (2 << 16)   // attachment vtable
+#define _SPINEBLOB_RELOC_TIMELINE (3 << 16)     // timeline vtable
+#define _SPINEBLOB_RELOC_KIND_MASK (0xFFFF0000)
+
+typedef struct {
+    const void* atlas_data;
+    size_t atlas_size;
+    const void* skeleton_data;      // .skel or .json data
+    size_t skeleton_size;
+    bool json;                      // skeleton_data is JSON text (must be zero-terminated)
+    size_t max_arena_size;          // default: SPINEBLOB_DEFAULT_ARENA_SIZE
+    // the current spine-c allocator functions, restored after parsing
+    void* (*malloc_fn)(size_t size);                                // default: malloc
+    void* (*realloc_fn)(void* ptr, size_t size);                    // default: realloc
+    void (*free_fn)(void* ptr);                                     // default: free
+    void* (*debug_malloc_fn)(size_t size, const char* file, int line);  // default: none
+} spineblob_parse_desc_t;
+
+typedef struct {
+    spAtlas* atlas;
+    spSkeletonData* skeleton_data;
+    void* arena;
+    size_t arena_size;              // used bytes
+} spineblob_data_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    uint64_t base;                  // arena address when saved
+    uint32_t arena_size;
+    uint32_t num_relocs;
+    uint32_t atlas_offset;
+    uint32_t skeleton_data_offset;
+} _spineblob_header_t;
+
+typedef struct {
+    uint32_t offset;                // into the arena
+    uint32_t kind;                  // _SPINEBLOB_RELOC_*
+} _spineblob_reloc_t;
+
+// allocations are preceded by their size
+typedef struct {
+    size_t size;
+    size_t pad;
+} _spineblob_block_t;
+
+// same layout as the private _spAttachmentVtable in spine-c's Attachment.c
+typedef struct {
+    void (*dispose)(spAttachment* self);
+    spAttachment* (*copy)(spAttachment* self);
+} _spineblob_attachment_vtable_t;
+
+// same layout as all spine-c _SP_ARRAY_DECLARE_TYPE() arrays
+typedef struct {
+    int size;
+    int capacity;
+    void* items;
+} _spineblob_array_t;
+
+static struct {
+    uint8_t* base;
+    size_t cap;
+    size_t pos;
+    size_t last;    // offset of the last block, for in-place realloc and free
+    bool overflow;
+    // the allocator functions which were active before parsing
+    void* (*malloc_fn)(size_t size);
+    void* (*realloc_fn)(void* ptr, size_t size);
+    void (*free_fn)(void* ptr);
+} _spineblob_arena;
+
+// vtables of the running executable, taken from template objects
+static struct {
+    bool valid;
+    _spineblob_attachment_vtable_t attachments[SP_ATTACHMENT_CLIPPING + 1];
+    _spTimelineVtable timelines[SP_TIMELINE_EVENT + 1];
+} _spineblob_vtables;
+
+static size_t _spineblob_round(size_t size) {
+    return (size + (_SPINEBLOB_ALIGN - 1)) & ~(size_t)(_SPINEBLOB_ALIGN - 1);
+}
+
+static bool _spineblob_in_arena(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return (p >= _spineblob_arena.base) && (p < (_spineblob_arena.base + _spineblob_arena.cap));
+}
+
+static void* _spineblob_malloc(size_t size) {
+    const size_t need = sizeof(_spineblob_block_t) + _spineblob_round(size);
+    if ((_spineblob_arena.pos + need) > _spineblob_arena.cap) {
+        // keep parsing with the regular allocator, the result can't be saved
+        _spineblob_arena.overflow = true;
+        return _spineblob_arena.malloc_fn(size);
+    }
+    _spineblob_block_t* block = (_spineblob_block_t*)(_spineblob_arena.base + _spineblob_arena.pos);
+    block->size = size;
+    _spineblob_arena.last = _spineblob_arena.pos;
+    _spineblob_arena.pos += need;
+    return block + 1;
+}
+
+static void _spineblob_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (!_spineblob_in_arena(ptr)) {
+        _spineblob_arena.free_fn(ptr);
+        return;
+    }
+    // only the last block can be given back
+    const _spineblob_block_t* block = ((const _spineblob_block_t*)ptr) - 1;
+    if ((const uint8_t*)block == (_spineblob_arena.base + _spineblob_arena.last)) {
+        _spineblob_arena.pos = _spineblob_arena.last;
+    }
+}
+
+static void* _spineblob_realloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return _spineblob_malloc(size);
+    }
+    if (!_spineblob_in_arena(ptr)) {
+        return _spineblob_arena.realloc_fn(ptr, size);
+    }
+    _spineblob_block_t* block = ((_spineblob_block_t*)ptr) - 1;
+    const size_t offset = (size_t)((uint8_t*)block - _spineblob_arena.base);
+    if (offset == _spineblob_arena.last) {
+        // grow or shrink the last block in place
+        const size_t end = offset + sizeof(_spineblob_block_t) + _spineblob_round(size);
+        if (end <= _spineblob_arena.cap) {
+            block->size = size;
+            _spineblob_arena.pos = end;
+            return ptr;
+        }
+    }
+    void* new_ptr = _spineblob_malloc(size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, (block->size < size) ? block->size : size);
+    }
+    return new_ptr;
+}
+
+static uint64_t _spineblob_fingerprint(void) {
+    const uint64_t vals[] = {
+        sizeof(uintptr_t),
+        sizeof(spAtlas), sizeof(spAtlasPage), sizeof(spAtlasRegion),
+        sizeof(spSkeletonData), sizeof(spBoneData), sizeof(spSlotData),
+        sizeof(spAnimation), sizeof(spTimeline), sizeof(_spSkin),
+        sizeof(spRegionAttachment), sizeof(spMeshAttachment),
+        sizeof(_spTimelineVtable), sizeof(_spineblob_attachment_vtable_t),
+    };
+    uint64_t h = 0xCBF29CE484222325;
+    for (size_t i = 0; i < (sizeof(vals) / sizeof(vals[0])); i++) {
+        h ^= vals[i];
+        h *= 0x100000001B3;
+    }
+    return h;
+}
+
+// the object graph walk which finds the relocation sites
+typedef struct {
+    uintptr_t base;
+    uintptr_t end;
+    _spineblob_reloc_t* relocs;
+    uint32_t num_relocs;
+    uint32_t max_relocs;
+    bool failed;
+} _spineblob_walk_t;
+
+static bool _spineblob_walk_contains(const _spineblob_walk_t* w, const void* ptr, size_t size) {
+    const uintptr_t p = (uintptr_t)ptr;
+    return (p >= w->base) && (p < w->end) && (size <= (w->end - p));
+}
+
+static void _spineblob_add_reloc(_spineblob_walk_t* w, const void* site, uint32_t kind, size_t size) {
+    if (w->failed) {
+        return;
+    }
+    if (!_spineblob_walk_contains(w, site, size) || (((uintptr_t)site & (sizeof(void*) - 1)) != 0)) {
+        w->failed = true;
+        return;
+    }
+    if (w->num_relocs == w->max_relocs) {
+        const uint32_t max_relocs = w->max_relocs ? (w->max_relocs * 2) : 1024;
+        _spineblob_reloc_t* relocs = (_spineblob_reloc_t*) realloc(w->relocs, max_relocs * sizeof(_spineblob_reloc_t));
+        if (!relocs) {
+            w->failed = true;
+            return;
+        }
+        w->relocs = relocs;
+        w->max_relocs = max_relocs;
+    }
+    w->relocs[w->num_relocs].offset = (uint32_t)((uintptr_t)site - w->base);
+    w->relocs[w->num_relocs].kind = kind;
+    w->num_relocs++;
+}
+
+// record a pointer field, returns the pointer or 0 if it is zero or the walk failed
+static const void* _spineblob_ptr(_spineblob_walk_t* w, const void* field) {
+    if (w->failed || !_spineblob_walk_contains(w, field, sizeof(void*))) {
+        w->failed = true;
+        return 0;
+    }
+    const void* ptr;
+    memcpy(&ptr, field, sizeof(ptr));
+    if (!ptr) {
+        return 0;
+    }
+    if (!_spineblob_walk_contains(w, ptr, 1)) {
+        // a pointer out of the arena can't be relocated
+        w->failed = true;
+        return 0;
+    }
+    _spineblob_add_reloc(w, field, _SPINEBLOB_RELOC_POINTER, sizeof(void*));
+    return w->failed ? 0 : ptr;
+}
+
+// record a renderer object field, these may point out of the arena
+static void _spineblob_renderer(_spineblob_walk_t* w, const void* field) {
+    if (w->failed || !_spineblob_walk_contains(w, field, sizeof(void*))) {
+        w->failed = true;
+        return;
+    }
+    const void* ptr;
+    memcpy(&ptr, field, sizeof(ptr));
+    if (ptr && !_spineblob_walk_contains(w, ptr, 1)) {
+        _spineblob_add_reloc(w, field, _SPINEBLOB_RELOC_CLEAR, sizeof(void*));
+    } else {
+        _spineblob_ptr(w, field);
+    }
+}
+
+// record a spine-c array and its items pointer, returns the array
+static const _spineblob_array_t* _spineblob_array(_spineblob_walk_t* w, const void* field) {
+    const _spineblob_array_t* array = (const _spineblob_array_t*)_spineblob_ptr(w, field);
+    if (array) {
+        _spineblob_ptr(w, &array->items);
+    }
+    return w->failed ? 0 : array;
+}
+
+// record a spine-c array whose items are pointers
+static void _spineblob_ptr_array(_spineblob_walk_t* w, const void* field) {
+    const _spineblob_array_t* array = _spineblob_array(w, field);
+    for (int i = 0; array && (i < array->size); i++) {
+        _spineblob_ptr(w, &((void* const*)array->items)[i]);
+    }
+}
+
+static void _spineblob_walk_atlas(_spineblob_walk_t* w, const spAtlas* atlas) {
+    _spineblob_renderer(w, &atlas->rendererObject);
+    const spAtlasPage* page = (const spAtlasPage*)_spineblob_ptr(w, &atlas->pages);
+    while (page) {
+        _spineblob_ptr(w, &page->atlas);
+        _spineblob_ptr(w, &page->name);
+        _spineblob_renderer(w, &page->rendererObject);
+        page = (const spAtlasPage*)_spineblob_ptr(w, &page->next);
+    }
+    const spAtlasRegion* region = (const spAtlasRegion*)_spineblob_ptr(w, &atlas->regions);
+    while (region) {
+        _spineblob_renderer(w, &region->super.rendererObject);
+        _spineblob_ptr(w, &region->name);
+        _spineblob_ptr(w, &region->splits);
+        _spineblob_ptr(w, &region->pads);
+        const _spineblob_array_t* key_values = _spineblob_array(w, &region->keyValues);
+        for (int i = 0; key_values && (i < key_values->size); i++) {
+            _spineblob_ptr(w, &((const spKeyValue*)key_values->items)[i].name);
+        }
+        _spineblob_ptr(w, &region->page);
+        region = (const spAtlasRegion*)_spineblob_ptr(w, &region->next);
+    }
+}
+
+static void _spineblob_walk_sequence(_spineblob_walk_t* w, const void* field) {
+    const spSequence* sequence = (const spSequence*)_spineblob_ptr(w, field);
+    if (sequence) {
+        _spineblob_ptr_array(w, &sequence->regions);
+    }
+}
+
+static void _spineblob_walk_vertex_attachment(_spineblob_walk_t* w, const spVertexAttachment* attachment) {
+    _spineblob_ptr(w, &attachment->bones);
+    _spineblob_ptr(w, &attachment->vertices);
+    _spineblob_ptr(w, &attachment->timelineAttachment);
+}
+
+static void _spineblob_walk_attachment(_spineblob_walk_t* w, const spAttachment* attachment) {
+    _spineblob_ptr(w, &attachment->name);
+    _spineblob_ptr(w, &attachment->attachmentLoader);
+    const void* vtable = _spineblob_ptr(w, &attachment->vtable);
+    if (!vtable || ((unsigned)attachment->type > SP_ATTACHMENT_CLIPPING)) {
+        w->failed = true;
+        return;
+    }
+    _spineblob_add_reloc(w, vtable, _SPINEBLOB_RELOC_ATTACHMENT | (uint32_t)attachment->type, sizeof(_spineblob_attachment_vtable_t));
+    switch (attachment->type) {
+        case SP_ATTACHMENT_REGION: {
+            const spRegionAttachment* region = (const spRegionAttachment*)attachment;
+            _spineblob_ptr(w, &region->path);
+            _spineblob_renderer(w, &region->rendererObject);
+            _spineblob_ptr(w, &region->region);
+            _spineblob_walk_sequence(w, &region->sequence);
+        } break;
+        case SP_ATTACHMENT_MESH:
+        case SP_ATTACHMENT_LINKED_MESH: {
+            const spMeshAttachment* mesh = (const spMeshAttachment*)attachment;
+            _spineblob_walk_vertex_attachment(w, &mesh->super);
+            _spineblob_renderer(w, &mesh->rendererObject);
+            _spineblob_ptr(w, &mesh->region);
+            _spineblob_walk_sequence(w, &mesh->sequence);
+            _spineblob_ptr(w, &mesh->path);
+            _spineblob_ptr(w, &mesh->regionUVs);
+            _spineblob_ptr(w, &mesh->uvs);
+            _spineblob_ptr(w, &mesh->triangles);
+            _spineblob_ptr(w, &mesh->parentMesh);
+            _spineblob_ptr(w, &mesh->edges);
+        } break;
+        case SP_ATTACHMENT_BOUNDING_BOX:
+            _spineblob_walk_vertex_attachment(w, &((const spBoundingBoxAttachment*)attachment)->super);
+            break;
+        case SP_ATTACHMENT_PATH:
+            _spineblob_walk_vertex_attachment(w, &((const spPathAttachment*)attachment)->super);
+            _spineblob_ptr(w, &((const spPathAttachment*)attachment)->lengths);
+            break;
+        case SP_ATTACHMENT_POINT:
+            break;
+        case SP_ATTACHMENT_CLIPPING:
+            _spineblob_walk_vertex_attachment(w, &((const spClippingAttachment*)attachment)->super);
+            _spineblob_ptr(w, &((const spClippingAttachment*)attachment)->endSlot);
+            break;
+    }
+}
+
+static void _spineblob_walk_skin(_spineblob_walk_t* w, const spSkin* skin) {
+    const _spSkin* internal = (const _spSkin*)skin;
+    _spineblob_ptr(w, &skin->name);
+    _spineblob_ptr_array(w, &skin->bones);
+    _spineblob_ptr_array(w, &skin->ikConstraints);
+    _spineblob_ptr_array(w, &skin->transformConstraints);
+    _spineblob_ptr_array(w, &skin->pathConstraints);
+    const _Entry* entry = (const _Entry*)_spineblob_ptr(w, &internal->entries);
+    while (entry) {
+        _spineblob_ptr(w, &entry->name);
+        const spAttachment* attachment = (const spAttachment*)_spineblob_ptr(w, &entry->attachment);
+        if (attachment) {
+            _spineblob_walk_attachment(w, attachment);
+        }
+        entry = (const _Entry*)_spineblob_ptr(w, &entry->next);
+    }
+    for (int i = 0; i < SKIN_ENTRIES_HASH_TABLE_SIZE; i++) {
+        const _SkinHashTableEntry* hash_entry = (const _SkinHashTableEntry*)_spineblob_ptr(w, &internal->entriesHashTable[i]);
+        while (hash_entry) {
+            _spineblob_ptr(w, &hash_entry->entry);
+            hash_entry = (const _SkinHashTableEntry*)_spineblob_ptr(w, &hash_entry->next);
+        }
+    }
+}
+
+static void _spineblob_walk_timeline(_spineblob_walk_t* w, const spTimeline* timeline) {
+    if ((unsigned)timeline->type > SP_TIMELINE_EVENT) {
+        w->failed = true;
+        return;
+    }
+    _spineblob_add_reloc(w, &timeline->vtable, _SPINEBLOB_RELOC_TIMELINE | (uint32_t)timeline->type, sizeof(_spTimelineVtable));
+    _spineblob_array(w, &timeline->frames);
+    switch (timeline->type) {
+        case SP_TIMELINE_ATTACHMENT: {
+            const spAttachmentTimeline* t = (const spAttachmentTimeline*)timeline;
+            const char* const* names = (const char* const*)_spineblob_ptr(w, &t->attachmentNames);
+            for (int i = 0; names && (i < timeline->frameCount); i++) {
+                _spineblob_ptr(w, &names[i]);
+            }
+        } break;
+        case SP_TIMELINE_SEQUENCE:
+            _spineblob_ptr(w, &((const spSequenceTimeline*)timeline)->attachment);
+            break;
+        case SP_TIMELINE_EVENT: {
+            const spEventTimeline* t = (const spEventTimeline*)timeline;
+            spEvent* const* events = (spEvent* const*)_spineblob_ptr(w, &t->events);
+            for (int i = 0; events && (i < timeline->frameCount); i++) {
+                const spEvent* event = (const spEvent*)_spineblob_ptr(w, &events[i]);
+                if (event) {
+                    _spineblob_ptr(w, &event->data);
+                    _spineblob_ptr(w, &event->stringValue);
+                }
+            }
+        } break;
+        case SP_TIMELINE_DRAWORDER: {
+            const spDrawOrderTimeline* t = (const spDrawOrderTimeline*)timeline;
+            const int* const* draw_orders = (const int* const*)_spineblob_ptr(w, &t->drawOrders);
+            for (int i = 0; draw_orders && (i < timeline->frameCount); i++) {
+                _spineblob_ptr(w, &draw_orders[i]);
+            }
+        } break;
+        case SP_TIMELINE_DEFORM: {
+            const spDeformTimeline* t = (const spDeformTimeline*)timeline;
+            _spineblob_array(w, &t->super.curves);
+            const float* const* vertices = (const float* const*)_spineblob_ptr(w, &t->frameVertices);
+            for (int i = 0; vertices && (i < timeline->frameCount); i++) {
+                _spineblob_ptr(w, &vertices[i]);
+            }
+            _spineblob_ptr(w, &t->attachment);
+        } break;
+        default:
+            // all other timelines are curve timelines without further pointers
+            _spineblob_array(w, &((const spCurveTimeline*)timeline)->curves);
+            break;
+    }
+}
+
+static void _spineblob_walk_skeleton_data(_spineblob_walk_t* w, const spSkeletonData* data) {
+    _spineblob_ptr(w, &data->version);
+    _spineblob_ptr(w, &data->hash);
+    _spineblob_ptr(w, &data->imagesPath);
+    _spineblob_ptr(w, &data->audioPath);
+    char* const* strings = (char* const*)_spineblob_ptr(w, &data->strings);
+    for (int i = 0; strings && (i < data->stringsCount); i++) {
+        _spineblob_ptr(w, &strings[i]);
+    }
+    spBoneData* const* bones = (spBoneData* const*)_spineblob_ptr(w, &data->bones);
+    for (int i = 0; bones && (i < data->bonesCount); i++) {
+        const spBoneData* bone = (const spBoneData*)_spineblob_ptr(w, &bones[i]);
+        if (bone) {
+            _spineblob_ptr(w, &bone->name);
+            _spineblob_ptr(w, &bone->parent);
+        }
+    }
+    spSlotData* const* slots = (spSlotData* const*)_spineblob_ptr(w, &data->slots);
+    for (int i = 0; slots && (i < data->slotsCount); i++) {
+        const spSlotData* slot = (const spSlotData*)_spineblob_ptr(w, &slots[i]);
+        if (slot) {
+            _spineblob_ptr(w, &slot->name);
+            _spineblob_ptr(w, &slot->boneData);
+            _spineblob_ptr(w, &slot->attachmentName);
+            _spineblob_ptr(w, &slot->darkColor);
+        }
+    }
+    // the default skin is also in the skins array, duplicate sites are removed later
+    spSkin* const* skins = (spSkin* const*)_spineblob_ptr(w, &data->skins);
+    for (int i = 0; skins && (i < data->skinsCount); i++) {
+        const spSkin* skin = (const spSkin*)_spineblob_ptr(w, &skins[i]);
+        if (skin) {
+            _spineblob_walk_skin(w, skin);
+        }
+    }
+    const spSkin* default_skin = (const spSkin*)_spineblob_ptr(w, &data->defaultSkin);
+    if (default_skin) {
+        _spineblob_walk_skin(w, default_skin);
+    }
+    spEventData* const* events = (spEventData* const*)_spineblob_ptr(w, &data->events);
+    for (int i = 0; events && (i < data->eventsCount); i++) {
+        const spEventData* event = (const spEventData*)_spineblob_ptr(w, &events[i]);
+        if (event) {
+            _spineblob_ptr(w, &event->name);
+            _spineblob_ptr(w, &event->stringValue);
+            _spineblob_ptr(w, &event->audioPath);
+        }
+    }
+    spAnimation* const* animations = (spAnimation* const*)_spineblob_ptr(w, &data->animations);
+    for (int i = 0; animations && (i < data->animationsCount); i++) {
+        const spAnimation* anim = (const spAnimation*)_spineblob_ptr(w, &animations[i]);
+        if (anim) {
+            _spineblob_ptr(w, &anim->name);
+            const _spineblob_array_t* timelines = _spineblob_array(w, &anim->timelines);
+            for (int t = 0; timelines && (t < timelines->size); t++) {
+                const spTimeline* timeline = (const spTimeline*)_spineblob_ptr(w, &((spTimeline* const*)timelines->items)[t]);
+                if (timeline) {
+                    _spineblob_walk_timeline(w, timeline);
+                }
+            }
+            _spineblob_array(w, &anim->timelineIds);
+        }
+    }
+    spIkConstraintData* const* iks = (spIkConstraintData* const*)_spineblob_ptr(w, &data->ikConstraints);
+    for (int i = 0; iks && (i < data->ikConstraintsCount); i++) {
+        const spIkConstraintData* ik = (const spIkConstraintData*)_spineblob_ptr(w, &iks[i]);
+        if (ik) {
+            _spineblob_ptr(w, &ik->name);
+            spBoneData* const* ik_bones = (spBoneData* const*)_spineblob_ptr(w, &ik->bones);
+            for (int b = 0; ik_bones && (b < ik->bonesCount); b++) {
+                _spineblob_ptr(w, &ik_bones[b]);
+            }
+            _spineblob_ptr(w, &ik->target);
+        }
+    }
+    spTransformConstraintData* const* tcs = (spTransformConstraintData* const*)_spineblob_ptr(w, &data->transformConstraints);
+    for (int i = 0; tcs && (i < data->transformConstraintsCount); i++) {
+        const spTransformConstraintData* tc = (const spTransformConstraintData*)_spineblob_ptr(w, &tcs[i]);
+        if (tc) {
+            _spineblob_ptr(w, &tc->name);
+            spBoneData* const* tc_bones = (spBoneData* const*)_spineblob_ptr(w, &tc->bones);
+            for (int b = 0; tc_bones && (b < tc->bonesCount); b++) {
+                _spineblob_ptr(w, &tc_bones[b]);
+            }
+            _spineblob_ptr(w, &tc->target);
+        }
+    }
+    spPathConstraintData* const* pcs = (spPathConstraintData* const*)_spineblob_ptr(w, &data->pathConstraints);
+    for (int i = 0; pcs && (i < data->pathConstraintsCount); i++) {
+        const spPathConstraintData* pc = (const spPathConstraintData*)_spineblob_ptr(w, &pcs[i]);
+        if (pc) {
+            _spineblob_ptr(w, &pc->name);
+            spBoneData* const* pc_bones = (spBoneData* const*)_spineblob_ptr(w, &pc->bones);
+            for (int b = 0; pc_bones && (b < pc->bonesCount); b++) {
+                _spineblob_ptr(w, &pc_bones[b]);
+            }
+            _spineblob_ptr(w, &pc->target);
+        }
+    }
+}
+
+static int _spineblob_compare_relocs(const void* a, const void* b) {
+    const uint32_t offset_a = ((const _spineblob_reloc_t*)a)->offset;
+    const uint32_t offset_b = ((const _spineblob_reloc_t*)b)->offset;
+    return (offset_a < offset_b) ? -1 : ((offset_a > offset_b) ? 1 : 0);
+}
+
+// sort the relocations and remove sites which were visited more than once
+static void _spineblob_sort_relocs(_spineblob_walk_t* w) {
+    if (w->failed || (w->num_relocs == 0)) {
+        return;
+    }
+    qsort(w->relocs, w->num_relocs, sizeof(_spineblob_reloc_t), _spineblob_compare_relocs);
+    uint32_t num = 1;
+    for (uint32_t i = 1; i < w->num_relocs; i++) {
+        const _spineblob_reloc_t* prev = &w->relocs[num - 1];
+        const _spineblob_reloc_t* cur = &w->relocs[i];
+        if (cur->offset == prev->offset) {
+            if (cur->kind != prev->kind) {
+                w->failed = true;
+                return;
+            }
+            continue;
+        }
+        // vtables and pointers must not overlap
+        uint32_t prev_size = sizeof(void*);
+        if ((prev->kind & _SPINEBLOB_RELOC_KIND_MASK) == _SPINEBLOB_RELOC_ATTACHMENT) {
+            prev_size = sizeof(_spineblob_attachment_vtable_t);
+        } else if ((prev->kind & _SPINEBLOB_RELOC_KIND_MASK) == _SPINEBLOB_RELOC_TIMELINE) {
+            prev_size = sizeof(_spTimelineVtable);
+        }
+        if (cur->offset < (prev->offset + prev_size)) {
+            w->failed = true;
+            return;
+        }
+        w->relocs[num++] = *cur;
+    }
+    w->num_relocs = num;
+}
+
+static spAttachment* _spineblob_create_attachment(spAttachmentType type) {
+    switch (type) {
+        case SP_ATTACHMENT_REGION: return (spAttachment*)spRegionAttachment_create("");
+        case SP_ATTACHMENT_BOUNDING_BOX: return (spAttachment*)spBoundingBoxAttachment_create("");
+        case SP_ATTACHMENT_MESH:
+        case SP_ATTACHMENT_LINKED_MESH: return (spAttachment*)spMeshAttachment_create("");
+        case SP_ATTACHMENT_PATH: return (spAttachment*)spPathAttachment_create("");
+        case SP_ATTACHMENT_POINT: return (spAttachment*)spPointAttachment_create("");
+        case SP_ATTACHMENT_CLIPPING: return (spAttachment*)spClippingAttachment_create("");
+        default: return 0;
+    }
+}
+
+// vertex_attachment is used by the deform and sequence timelines (must not be a region or mesh)
+static spTimeline* _spineblob_create_timeline(spTimelineType type, spAttachment* vertex_attachment) {
+    switch (type) {
+        case SP_TIMELINE_ATTACHMENT: return (spTimeline*)spAttachmentTimeline_create(1, 0);
+        case SP_TIMELINE_ALPHA: return (spTimeline*)spAlphaTimeline_create(1, 0, 0);
+        case SP_TIMELINE_PATHCONSTRAINTPOSITION: return (spTimeline*)spPathConstraintPositionTimeline_create(1, 0, 0);
+        case SP_TIMELINE_PATHCONSTRAINTSPACING: return (spTimeline*)spPathConstraintSpacingTimeline_create(1, 0, 0);
+        case SP_TIMELINE_ROTATE: return (spTimeline*)spRotateTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SCALEX: return (spTimeline*)spScaleXTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SCALEY: return (spTimeline*)spScaleYTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SHEARX: return (spTimeline*)spShearXTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SHEARY: return (spTimeline*)spShearYTimeline_create(1, 0, 0);
+        case SP_TIMELINE_TRANSLATEX: return (spTimeline*)spTranslateXTimeline_create(1, 0, 0);
+        case SP_TIMELINE_TRANSLATEY: return (spTimeline*)spTranslateYTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SCALE: return (spTimeline*)spScaleTimeline_create(1, 0, 0);
+        case SP_TIMELINE_SHEAR: return (spTimeline*)spShearTimeline_create(1, 0, 0);
+        case SP_TIMELINE_TRANSLATE: return (spTimeline*)spTranslateTimeline_create(1, 0, 0);
+        case SP_TIMELINE_DEFORM: return (spTimeline*)spDeformTimeline_create(1, 0, 0, 0, (spVertexAttachment*)vertex_attachment);
+        case SP_TIMELINE_SEQUENCE: return (spTimeline*)spSequenceTimeline_create(1, 0, vertex_attachment);
+        case SP_TIMELINE_IKCONSTRAINT: return (spTimeline*)spIkConstraintTimeline_create(1, 0, 0);
+        case SP_TIMELINE_PATHCONSTRAINTMIX: return (spTimeline*)spPathConstraintMixTimeline_create(1, 0, 0);
+        case SP_TIMELINE_RGB2: return (spTimeline*)spRGB2Timeline_create(1, 0, 0);
+        case SP_TIMELINE_RGBA2: return (spTimeline*)spRGBA2Timeline_create(1, 0, 0);
+        case SP_TIMELINE_RGBA: return (spTimeline*)spRGBATimeline_create(1, 0, 0);
+        case SP_TIMELINE_RGB: return (spTimeline*)spRGBTimeline_create(1, 0, 0);
+        case SP_TIMELINE_TRANSFORMCONSTRAINT: return (spTimeline*)spTransformConstraintTimeline_create(1, 0, 0);
+        case SP_TIMELINE_DRAWORDER: return (spTimeline*)spDrawOrderTimeline_create(1, 0);
+        // the frames of an event timeline are disposed as events, so it must be empty
+        case SP_TIMELINE_EVENT: return (spTimeline*)spEventTimeline_create(0);
+        default: return 0;
+    }
+}
+
+// get the vtables of the running executable from template objects
+static bool _spineblob_init_vtables(void) {
+    if (_spineblob_vtables.valid) {
+        return true;
+    }
+    for (int type = 0; type <= SP_ATTACHMENT_CLIPPING; type++) {
+        spAttachment* attachment = _spineblob_create_attachment((spAttachmentType)type);
+        if (!attachment) {
+            return false;
+        }
+        _spineblob_vtables.attachments[type] = *(const _spineblob_attachment_vtable_t*)attachment->vtable;
+        spAttachment_dispose(attachment);
+    }
+    spAttachment* vertex_attachment = _spineblob_create_attachment(SP_ATTACHMENT_BOUNDING_BOX);
+    if (!vertex_attachment) {
+        return false;
+    }
+    bool ok = true;
+    for (int type = 0; type <= SP_TIMELINE_EVENT; type++) {
+        spTimeline* timeline = _spineblob_create_timeline((spTimelineType)type, vertex_attachment);
+        if (!timeline) {
+            ok = false;
+            break;
+        }
+        _spineblob_vtables.timelines[type] = timeline->vtable;
+        spTimeline_dispose(timeline);
+    }
+    spAttachment_dispose(vertex_attachment);
+    _spineblob_vtables.valid = ok;
+    return ok;
+}
+
+static void spineblob_free(spineblob_data_t* data) {
+    assert(data);
+    free(data->arena);
+    memset(data, 0, sizeof(spineblob_data_t));
+}
+
+// parse atlas and skeleton data into a new arena
+static bool spineblob_parse(const spineblob_parse_desc_t* desc, spineblob_data_t* out) {
+    assert(desc && out);
+    assert(desc->atlas_data && desc->skeleton_data);
+    assert(!_spineblob_arena.base);
+    memset(out, 0, sizeof(spineblob_data_t));
+    const size_t cap = desc->max_arena_size ? desc->max_arena_size : SPINEBLOB_DEFAULT_ARENA_SIZE;
+    out->arena = malloc(cap);
+    if (!out->arena) {
+        return false;
+    }
+    assert((((uintptr_t)out->arena) & (_SPINEBLOB_ALIGN - 1)) == 0);
+    _spineblob_arena.base = (uint8_t*)out->arena;
+    _spineblob_arena.cap = cap;
+    _spineblob_arena.pos = 0;
+    _spineblob_arena.last = 0;
+    _spineblob_arena.overflow = false;
+    _spineblob_arena.malloc_fn = desc->malloc_fn ? desc->malloc_fn : malloc;
+    _spineblob_arena.realloc_fn = desc->realloc_fn ? desc->realloc_fn : realloc;
+    _spineblob_arena.free_fn = desc->free_fn ? desc->free_fn : free;
+    // a debug malloc takes precedence over the regular one in spine-c
+    _spSetDebugMalloc(0);
+    _spSetMalloc(_spineblob_malloc);
+    _spSetRealloc(_spineblob_realloc);
+    _spSetFree(_spineblob_free);
+
+    out->atlas = spAtlas_create((const char*)desc->atlas_data, (int)desc->atlas_size, "", 0);
+    if (out->atlas) {
+        if (desc->json) {
+            spSkeletonJson* json = spSkeletonJson_create(out->atlas);
+            out->skeleton_data = spSkeletonJson_readSkeletonData(json, (const char*)desc->skeleton_data);
+            spSkeletonJson_dispose(json);
+        } else {
+            spSkeletonBinary* bin = spSkeletonBinary_create(out->atlas);
+            out->skeleton_data = spSkeletonBinary_readSkeletonData(bin, (const unsigned char*)desc->skeleton_data, (int)desc->skeleton_size);
+            spSkeletonBinary_dispose(bin);
+        }
+    }
+    const bool ok = out->atlas && out->skeleton_data && !_spineblob_arena.overflow;
+    if (!ok) {
+        // some objects may come from the regular allocator, the free hook sorts this out
+        if (out->skeleton_data) {
+            spSkeletonData_dispose(out->skeleton_data);
+        }
+        if (out->atlas) {
+            spAtlas_dispose(out->atlas);
+        }
+    }
+    out->arena_size = _spineblob_arena.pos;
+    _spSetMalloc(_spineblob_arena.malloc_fn);
+    _spSetRealloc(_spineblob_arena.realloc_fn);
+    _spSetFree(_spineblob_arena.free_fn);
+    _spSetDebugMalloc(desc->debug_malloc_fn);
+    memset(&_spineblob_arena, 0, sizeof(_spineblob_arena));
+    if (!ok) {
+        spineblob_free(out);
+    }
+    return ok;
+}
+
+// serialize parsed data into a new blob (free with free()), returns the blob size,
+// or 0 if the data contains pointers which can't be relocated
+static size_t spineblob_save(const spineblob_data_t* data, void** out_blob) {
+    assert(data && out_blob);
+    *out_blob = 0;
+    if (!data->arena || (data->arena_size > UINT32_MAX / 2)) {
+        return 0;
+    }
+    _spineblob_walk_t w;
+    memset(&w, 0, sizeof(w));
+    w.base = (uintptr_t)data->arena;
+    w.end = w.base + data->arena_size;
+    if (!_spineblob_walk_contains(&w, data->atlas, sizeof(spAtlas)) ||
+        !_spineblob_walk_contains(&w, data->skeleton_data, sizeof(spSkeletonData)))
+    {
+        return 0;
+    }
+    _spineblob_walk_atlas(&w, data->atlas);
+    _spineblob_walk_skeleton_data(&w, data->skeleton_data);
+    _spineblob_sort_relocs(&w);
+    if (w.failed) {
+        free(w.relocs);
+        return 0;
+    }
+    const size_t relocs_offset = _spineblob_round(sizeof(_spineblob_header_t));
+    const size_t arena_offset = _spineblob_round(relocs_offset + w.num_relocs * sizeof(_spineblob_reloc_t));
+    const size_t blob_size = arena_offset + data->arena_size;
+    uint8_t* blob = (uint8_t*) malloc(blob_size);
+    if (!blob) {
+        free(w.relocs);
+        return 0;
+    }
+    memset(blob, 0, arena_offset);
+    _spineblob_header_t* hdr = (_spineblob_header_t*)blob;
+    hdr->magic = _SPINEBLOB_MAGIC;
+    hdr->version = _SPINEBLOB_VERSION;
+    hdr->fingerprint = _spineblob_fingerprint();
+    hdr->base = w.base;
+    hdr->arena_size = (uint32_t)data->arena_size;
+    hdr->num_relocs = w.num_relocs;
+    hdr->atlas_offset = (uint32_t)((uintptr_t)data->atlas - w.base);
+    hdr->skeleton_data_offset = (uint32_t)((uintptr_t)data->skeleton_data - w.base);
+    if (w.num_relocs > 0) {
+        memcpy(blob + relocs_offset, w.relocs, w.num_relocs * sizeof(_spineblob_reloc_t));
+    }
+    memcpy(blob + arena_offset, data->arena, data->arena_size);
+    free(w.relocs);
+    *out_blob = blob;
+    return blob_size;
+}
+
+// apply one relocation to a loaded arena, returns false on invalid data
+static bool _spineblob_relocate(uint8_t* arena, const _spineblob_header_t* hdr, const _spineblob_reloc_t* reloc) {
+    const uint32_t kind = reloc->kind & _SPINEBLOB_RELOC_KIND_MASK;
+    const uint32_t type = reloc->kind & ~(uint32_t)_SPINEBLOB_RELOC_KIND_MASK;
+    size_t size = sizeof(void*);
+    if (kind == _SPINEBLOB_RELOC_ATTACHMENT) {
+        size = sizeof(_spineblob_attachment_vtable_t);
+    } else if (kind == _SPINEBLOB_RELOC_TIMELINE) {
+        size = sizeof(_spTimelineVtable);
+    }
+    if (((reloc->offset & (sizeof(void*) - 1)) != 0) || (size > hdr->arena_size) || (reloc->offset > (hdr->arena_size - size))) {
+        return false;
+    }
+    uint8_t* site = arena + reloc->offset;
+    switch (kind) {
+        case _SPINEBLOB_RELOC_POINTER: {
+            uintptr_t ptr;
+            memcpy(&ptr, site, sizeof(ptr));
+            if ((ptr < (uintptr_t)hdr->base) || ((ptr - (uintptr_t)hdr->base) >= hdr->arena_size)) {
+                return false;
+            }
+            ptr = (uintptr_t)arena + (ptr - (uintptr_t)hdr->base);
+            memcpy(site, &ptr, sizeof(ptr));
+        } break;
+        case _SPINEBLOB_RELOC_CLEAR:
+            memset(site, 0, sizeof(void*));
+            break;
+        case _SPINEBLOB_RELOC_ATTACHMENT:
+            if (type > SP_ATTACHMENT_CLIPPING) {
+                return false;
+            }
+            memcpy(site, &_spineblob_vtables.attachments[type], size);
+            break;
+        case _SPINEBLOB_RELOC_TIMELINE:
+            if (type > SP_TIMELINE_EVENT) {
+                return false;
+            }
+            memcpy(site, &_spineblob_vtables.timelines[type], size);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+// create a new arena from a blob and fix up the pointers and vtables
+static bool spineblob_load(const void* blob, size_t blob_size, spineblob_data_t* out) {
+    assert(blob && out);
+    memset(out, 0, sizeof(spineblob_data_t));
+    if (blob_size < sizeof(_spineblob_header_t)) {
+        return false;
+    }
+    _spineblob_header_t hdr;
+    memcpy(&hdr, blob, sizeof(hdr));
+    if ((hdr.magic != _SPINEBLOB_MAGIC) ||
+        (hdr.version != _SPINEBLOB_VERSION) ||
+        (hdr.fingerprint != _spineblob_fingerprint()) ||
+        (hdr.num_relocs > (blob_size / sizeof(_spineblob_reloc_t))))
+    {
+        return false;
+    }
+    const size_t relocs_offset = _spineblob_round(sizeof(_spineblob_header_t));
+    const size_t arena_offset = _spineblob_round(relocs_offset + hdr.num_relocs * sizeof(_spineblob_reloc_t));
+    if (((arena_offset + hdr.arena_size) > blob_size) ||
+        (hdr.atlas_offset >= hdr.arena_size) ||
+        (hdr.skeleton_data_offset >= hdr.arena_size))
+    {
+        return false;
+    }
+    if (!_spineblob_init_vtables()) {
+        return false;
+    }
+    uint8_t* arena = (uint8_t*) malloc(hdr.arena_size);
+    if (!arena) {
+        return false;
+    }
+    assert((((uintptr_t)arena) & (_SPINEBLOB_ALIGN - 1)) == 0);
+    memcpy(arena, (const uint8_t*)blob + arena_offset, hdr.arena_size);
+    const uint8_t* relocs = (const uint8_t*)blob + relocs_offset;
+    for (uint32_t i = 0; i < hdr.num_relocs; i++) {
+        _spineblob_reloc_t reloc;
+        memcpy(&reloc, relocs + i * sizeof(reloc), sizeof(reloc));
+        if (!_spineblob_relocate(arena, &hdr, &reloc)) {
+            free(arena);
+            return false;
+        }
+    }
+    out->arena = arena;
+    out->arena_size = hdr.arena_size;
+    out->atlas = (spAtlas*)(arena + hdr.atlas_offset);
+    out->skeleton_data = (spSkeletonData*)(arena + hdr.skeleton_data_offset);
+    return true;
+}
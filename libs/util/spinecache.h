@@ -0,0 +1,411 @@
+#pragma once
+/*
+    Pose-hash vertex reuse for sokol_spine.h.
+
+    sspine_draw_instance_in_layer() computes the skinned vertices of an
+    instance each time it is called, even if the instance is paused, or
+    shows exactly the same pose (same skeleton, attachments, bone transforms
+    and colors) as another instance which was already drawn. A spinecache_t
+    hashes an instance's pose relative to its position before drawing.
+    If the hash is known, the vertices, indices and draw commands generated
+    for it earlier are copied into the context (with the vertices moved to
+    the instance's position) instead of computing them again:
+
+        spinecache_t cache;
+        spinecache_init(&cache, sspine_default_context(), 256);
+        ...
+        // each frame, after updating the instances:
+        spinecache_begin_frame(&cache);
+        for (...) {
+            spinecache_draw_instance_in_layer(&cache, instance, layer);
+        }
+        ...
+        // reuse statistics of the current frame:
+        printf("%d of %d reused\n", cache.num_reused, cache.num_reused + cache.num_generated);
+
+    Bone transforms are quantized (1/64 unit for positions) into a pose key
+    before hashing, so poses which only differ by float rounding share their
+    vertices. Each entry keeps its pose key, and a hash hit is only reused
+    if the complete key matches.
+
+    All instances drawn into the context must go through the cache: sokol-spine
+    rewinds the context on the first draw of a frame, so the first draw after
+    spinecache_begin_frame() always generates its vertices.
+
+    Include after the sokol_spine.h implementation (SOKOL_SPINE_IMPL), the
+    generated vertices, indices and commands are taken from and copied into
+    the context internals.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+typedef struct {
+    uint64_t hash;
+    bool valid;
+    uint64_t last_used;     // frame index
+    int key_len;
+    int max_key;
+    uint64_t* key;          // the quantized pose
+    int num_vertices;
+    int num_indices;
+    int num_commands;
+    int max_vertices;
+    int max_indices;
+    int max_commands;
+    _sspine_vertex_t* vertices;     // relative to the skeleton position
+    uint32_t* indices;              // relative to the first vertex
+    _sspine_command_t* commands;    // base_element relative to the first index
+} _spinecache_entry_t;
+
+typedef struct {
+    sspine_context ctx;
+    uint64_t frame_index;
+    bool first_draw;
+    int max_entries;
+    int next_victim;
+    int num_inserted;               // table insertions since the last rebuild
+    _spinecache_entry_t* entries;
+    int table_size;                 // power of 2
+    int* table;                     // entry index + 1, 0 means empty
+    int key_len;                    // pose key of the current draw
+    int max_key;
+    uint64_t* key;
+    // statistics of the current frame...
+    int num_generated;
+    int num_reused;
+    // ...and since init
+    uint64_t total_generated;
+    uint64_t total_reused;
+} spinecache_t;
+
+static void spinecache_init(spinecache_t* cache, sspine_context ctx, int max_entries) {
+    assert(cache && (max_entries > 0));
+    memset(cache, 0, sizeof(spinecache_t));
+    cache->ctx = ctx;
+    cache->max_entries = max_entries;
+    cache->entries = (_spinecache_entry_t*) calloc((size_t)max_entries, sizeof(_spinecache_entry_t));
+    cache->table_size = 1;
+    while (cache->table_size < (4 * max_entries)) {
+        cache->table_size *= 2;
+    }
+    cache->table = (int*) calloc((size_t)cache->table_size, sizeof(int));
+}
+
+static void spinecache_discard(spinecache_t* cache) {
+    assert(cache && cache->entries);
+    for (int i = 0; i < cache->max_entries; i++) {
+        free(cache->entries[i].vertices);
+        free(cache->entries[i].indices);
+        free(cache->entries[i].commands);
+        free(cache->entries[i].key);
+    }
+    free(cache->key);
+    free(cache->entries);
+    free(cache->table);
+    memset(cache, 0, sizeof(spinecache_t));
+}
+
+static inline uint64_t _spinecache_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15 + (h << 6) + (h >> 2);
+    return h * 0xFF51AFD7ED558CCD;
+}
+
+static void* _spinecache_grow(void* ptr, int* cap, int num, size_t elm_size) {
+    if (num > *cap) {
+        *cap = num + num / 2;
+        free(ptr);
+        ptr = malloc((size_t)*cap * elm_size);
+    }
+    return ptr;
+}
+
+static inline uint64_t _spinecache_quantize(float v, float scale) {
+    return (uint64_t)(int64_t)lrintf(v * scale);
+}
+
+static inline uint64_t* _spinecache_put_color(uint64_t* k, const spColor* c) {
+    *k++ = _spinecache_quantize(c->r, 255.0f);
+    *k++ = _spinecache_quantize(c->g, 255.0f);
+    *k++ = _spinecache_quantize(c->b, 255.0f);
+    *k++ = _spinecache_quantize(c->a, 255.0f);
+    return k;
+}
+
+// build the pose key from everything which goes into the generated vertices
+// except the skeleton position, returns false if out of memory
+static bool _spinecache_build_key(spinecache_t* cache, const spSkeleton* skel, int layer) {
+    int len = 8 + 6 * skel->bonesCount;
+    for (int i = 0; i < skel->slotsCount; i++) {
+        len += 12 + skel->drawOrder[i]->deformCount;
+    }
+    cache->key = (uint64_t*) _spinecache_grow(cache->key, &cache->max_key, len, sizeof(uint64_t));
+    if (!cache->key) {
+        cache->max_key = 0;
+        return false;
+    }
+    uint64_t* k = cache->key;
+    *k++ = (uint64_t)(uintptr_t)skel->data;
+    *k++ = (uint64_t)layer;
+    *k++ = (uint64_t)skel->bonesCount;
+    *k++ = (uint64_t)skel->slotsCount;
+    k = _spinecache_put_color(k, &skel->color);
+    for (int i = 0; i < skel->bonesCount; i++) {
+        const spBone* bone = skel->bones[i];
+        *k++ = _spinecache_quantize(bone->a, 4096.0f);
+        *k++ = _spinecache_quantize(bone->b, 4096.0f);
+        *k++ = _spinecache_quantize(bone->c, 4096.0f);
+        *k++ = _spinecache_quantize(bone->d, 4096.0f);
+        *k++ = _spinecache_quantize(bone->worldX - skel->x, 64.0f);
+        *k++ = _spinecache_quantize(bone->worldY - skel->y, 64.0f);
+    }
+    for (int i = 0; i < skel->slotsCount; i++) {
+        const spSlot* slot = skel->drawOrder[i];
+        *k++ = (uint64_t)(uintptr_t)slot->attachment;
+        *k++ = (uint64_t)slot->sequenceIndex;
+        k = _spinecache_put_color(k, &slot->color);
+        *k++ = slot->darkColor ? 1 : 0;
+        if (slot->darkColor) {
+            k = _spinecache_put_color(k, slot->darkColor);
+        } else {
+            const spColor no_color = { 0.0f, 0.0f, 0.0f, 0.0f };
+            k = _spinecache_put_color(k, &no_color);
+        }
+        *k++ = (uint64_t)slot->deformCount;
+        for (int d = 0; d < slot->deformCount; d++) {
+            *k++ = _spinecache_quantize(slot->deform[d], 64.0f);
+        }
+    }
+    cache->key_len = (int)(k - cache->key);
+    assert(cache->key_len == len);
+    return true;
+}
+
+static uint64_t _spinecache_hash_key(const uint64_t* key, int len) {
+    uint64_t h = 0;
+    for (int i = 0; i < len; i++) {
+        h = _spinecache_mix(h, key[i]);
+    }
+    return h ? h : 1;
+}
+
+// find the entry with the current pose key
+static int _spinecache_find(const spinecache_t* cache, uint64_t hash) {
+    const int mask = cache->table_size - 1;
+    for (int i = (int)(hash & (uint64_t)mask), n = 0; n < cache->table_size; i = (i + 1) & mask, n++) {
+        const int index = cache->table[i] - 1;
+        if (index < 0) {
+            return -1;
+        }
+        const _spinecache_entry_t* entry = &cache->entries[index];
+        if (entry->valid &&
+            (entry->hash == hash) &&
+            (entry->key_len == cache->key_len) &&
+            (0 == memcmp(entry->key, cache->key, (size_t)cache->key_len * sizeof(uint64_t))))
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+static void _spinecache_insert(spinecache_t* cache, uint64_t hash, int index) {
+    const int mask = cache->table_size - 1;
+    int i = (int)(hash & (uint64_t)mask);
+    while (cache->table[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    cache->table[i] = index + 1;
+    cache->num_inserted++;
+}
+
+// evicted entries leave stale table slots behind, rebuild the table
+// from the valid entries before it fills up
+static void _spinecache_rebuild_table(spinecache_t* cache) {
+    memset(cache->table, 0, (size_t)cache->table_size * sizeof(int));
+    cache->num_inserted = 0;
+    for (int i = 0; i < cache->max_entries; i++) {
+        if (cache->entries[i].valid) {
+            _spinecache_insert(cache, cache->entries[i].hash, i);
+        }
+    }
+}
+
+static void spinecache_begin_frame(spinecache_t* cache) {
+    assert(cache && cache->entries);
+    cache->frame_index++;
+    cache->first_draw = true;
+    cache->num_generated = 0;
+    cache->num_reused = 0;
+    if (cache->num_inserted >= (cache->table_size / 2)) {
+        _spinecache_rebuild_table(cache);
+    }
+}
+
+// an entry which wasn't used in this frame, or -1
+static int _spinecache_alloc_entry(spinecache_t* cache) {
+    for (int n = 0; n < cache->max_entries; n++) {
+        const int index = cache->next_victim;
+        cache->next_victim = (cache->next_victim + 1) % cache->max_entries;
+        _spinecache_entry_t* entry = &cache->entries[index];
+        if (!entry->valid || (entry->last_used != cache->frame_index)) {
+            entry->valid = false;
+            return index;
+        }
+    }
+    return -1;
+}
+
+// copy what the last draw appended to the context into a cache entry
+static void _spinecache_record(spinecache_t* cache, uint64_t hash, const _sspine_context_t* ctx, const spSkeleton* skel, int v0, int i0, int c0) {
+    if (cache->num_inserted >= (cache->table_size / 2)) {
+        // the table holds at most max_entries valid entries, which is
+        // below table_size/4, so there's room again after the rebuild
+        _spinecache_rebuild_table(cache);
+    }
+    const int num_vertices = ctx->vertices.next - v0;
+    const int num_indices = ctx->indices.next - i0;
+    if ((num_vertices <= 0) || (num_indices <= 0)) {
+        return;
+    }
+    const int index = _spinecache_alloc_entry(cache);
+    if (index < 0) {
+        return;
+    }
+    _spinecache_entry_t* entry = &cache->entries[index];
+    entry->vertices = (_sspine_vertex_t*) _spinecache_grow(entry->vertices, &entry->max_vertices, num_vertices, sizeof(_sspine_vertex_t));
+    entry->indices = (uint32_t*) _spinecache_grow(entry->indices, &entry->max_indices, num_indices, sizeof(uint32_t));
+    // the first index range may have been merged into the previous command
+    const int first_cmd = (c0 > 0) ? (c0 - 1) : 0;
+    const int max_commands = ctx->commands.next - first_cmd;
+    entry->commands = (_sspine_command_t*) _spinecache_grow(entry->commands, &entry->max_commands, max_commands, sizeof(_sspine_command_t));
+    entry->key = (uint64_t*) _spinecache_grow(entry->key, &entry->max_key, cache->key_len, sizeof(uint64_t));
+    if (!entry->vertices || !entry->indices || !entry->commands || !entry->key) {
+        entry->max_vertices = entry->max_indices = entry->max_commands = entry->max_key = 0;
+        return;
+    }
+    memcpy(entry->key, cache->key, (size_t)cache->key_len * sizeof(uint64_t));
+    entry->key_len = cache->key_len;
+    for (int i = 0; i < num_vertices; i++) {
+        _sspine_vertex_t v = ctx->vertices.ptr[v0 + i];
+        v.x -= skel->x;
+        v.y -= skel->y;
+        entry->vertices[i] = v;
+    }
+    for (int i = 0; i < num_indices; i++) {
+        entry->indices[i] = (uint32_t)ctx->indices.ptr[i0 + i] - (uint32_t)v0;
+    }
+    entry->num_commands = 0;
+    for (int i = first_cmd; i < ctx->commands.next; i++) {
+        _sspine_command_t cmd = ctx->commands.ptr[i];
+        const int start = (cmd.base_element > i0) ? cmd.base_element : i0;
+        const int end = cmd.base_element + cmd.num_elements;
+        if (end > start) {
+            cmd.base_element = start - i0;
+            cmd.num_elements = end - start;
+            entry->commands[entry->num_commands++] = cmd;
+        }
+    }
+    entry->hash = hash;
+    entry->valid = true;
+    entry->last_used = cache->frame_index;
+    entry->num_vertices = num_vertices;
+    entry->num_indices = num_indices;
+    _spinecache_insert(cache, hash, index);
+}
+
+// same merge condition as in sokol-spine
+static bool _spinecache_same_state(const _sspine_command_t* a, const _sspine_command_t* b) {
+    return (a->layer == b->layer) &&
+           (a->pip.id == b->pip.id) &&
+           (a->img.id == b->img.id) &&
+           (a->smp.id == b->smp.id) &&
+           (a->pma == b->pma);
+}
+
+// append a cache entry to the context, returns false if it doesn't fit
+static bool _spinecache_replay(_sspine_context_t* ctx, const _spinecache_entry_t* entry, const spSkeleton* skel, int layer) {
+    if (((ctx->vertices.next + entry->num_vertices) > ctx->vertices.cap) ||
+        ((ctx->indices.next + entry->num_indices) > ctx->indices.cap) ||
+        ((ctx->commands.next + entry->num_commands) > ctx->commands.cap))
+    {
+        return false;
+    }
+    const int v0 = ctx->vertices.next;
+    const int i0 = ctx->indices.next;
+    for (int i = 0; i < entry->num_vertices; i++) {
+        _sspine_vertex_t v = entry->vertices[i];
+        v.x += skel->x;
+        v.y += skel->y;
+        ctx->vertices.ptr[v0 + i] = v;
+    }
+    for (int i = 0; i < entry->num_indices; i++) {
+        ctx->indices.ptr[i0 + i] = entry->indices[i] + (uint32_t)v0;
+    }
+    for (int i = 0; i < entry->num_commands; i++) {
+        _sspine_command_t cmd = entry->commands[i];
+        cmd.layer = layer;
+        cmd.base_element += i0;
+        // merge with the previous command like sokol-spine does
+        _sspine_command_t* prev = (ctx->commands.next > 0) ? &ctx->commands.ptr[ctx->commands.next - 1] : 0;
+        if (prev && _spinecache_same_state(prev, &cmd) && ((prev->base_element + prev->num_elements) == cmd.base_element)) {
+            prev->num_elements += cmd.num_elements;
+        } else {
+            ctx->commands.ptr[ctx->commands.next++] = cmd;
+        }
+    }
+    ctx->vertices.next += entry->num_vertices;
+    ctx->indices.next += entry->num_indices;
+    return true;
+}
+
+static void spinecache_draw_instance_in_layer(spinecache_t* cache, sspine_instance instance, int layer) {
+    assert(cache && cache->entries);
+    _sspine_context_t* ctx = _sspine_lookup_context(cache->ctx.id);
+    const _sspine_instance_t* inst = _sspine_lookup_instance(instance.id);
+    if (!ctx || !inst || !inst->sp_skel || !_spinecache_build_key(cache, inst->sp_skel, layer)) {
+        // only a draw of a valid instance rewinds the context
+        if (ctx && inst && inst->sp_skel) {
+            cache->first_draw = false;
+        }
+        sspine_context_draw_instance_in_layer(cache->ctx, instance, layer);
+        return;
+    }
+    const spSkeleton* skel = inst->sp_skel;
+    const uint64_t hash = _spinecache_hash_key(cache->key, cache->key_len);
+    if (!cache->first_draw) {
+        const int index = _spinecache_find(cache, hash);
+        if (index >= 0) {
+            _spinecache_entry_t* entry = &cache->entries[index];
+            if (_spinecache_replay(ctx, entry, skel, layer)) {
+                entry->last_used = cache->frame_index;
+                cache->num_reused++;
+                cache->total_reused++;
+                return;
+            }
+        }
+    }
+    // the first draw of a frame rewinds the context, so its output starts at 0
+    const int v0 = cache->first_draw ? 0 : ctx->vertices.next;
+    const int i0 = cache->first_draw ? 0 : ctx->indices.next;
+    const int c0 = cache->first_draw ? 0 : ctx->commands.next;
+    cache->first_draw = false;
+    sspine_context_draw_instance_in_layer(cache->ctx, instance, layer);
+    cache->num_generated++;
+    cache->total_generated++;
+    const int index = _spinecache_find(cache, hash);
+    if (index < 0) {
+        _spinecache_record(cache, hash, ctx, skel, v0, i0, c0);
+    } else {
+        cache->entries[index].last_used = cache->frame_index;
+    }
+}
+
+// reuse rate of the current frame (0..1)
+static float spinecache_reuse_rate(const spinecache_t* cache) {
+    const int num = cache->num_generated + cache->num_reused;
+    return (num > 0) ? ((float)cache->num_reused / (float)num) : 0.0f;
+}
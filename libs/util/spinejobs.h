@@ -0,0 +1,82 @@
+#pragma once
+/*
+    Update many sokol_spine.h instances on the util/jobs.h worker pool.
+
+    sspine_update_instance() (animation state update and apply, and the
+    skeleton's world transform) only touches the instance's own spine-c
+    objects, so different instances can be updated on different threads.
+    Recording draw commands however writes into the shared sokol-spine
+    context, so this happens on the calling thread afterwards, always in
+    instance array order. The resulting layer draw lists are the same
+    no matter how many threads did the update:
+
+        jobs_setup(&(jobs_desc_t){ 0 });
+        ...
+        // split the update into (at most) 8 jobs, 0 for one job per thread
+        spinejobs_update_instances(instances, num_instances, delta_time, 8);
+        // layers can be null to draw all instances into layer 0
+        spinejobs_draw_instances_in_layers(instances, layers, num_instances);
+
+    Include after sokol_spine.h and util/jobs.h, jobs_setup() must have
+    been called before the first update.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+typedef struct {
+    const sspine_instance* instances;
+    int num_instances;
+    int num_jobs;
+    float delta_time;
+} _spinejobs_update_t;
+
+static void _spinejobs_update_task(int job_index, void* user_data) {
+    const _spinejobs_update_t* upd = (const _spinejobs_update_t*) user_data;
+    // contiguous ranges, so the instances of a job are close in memory
+    const int start = (job_index * upd->num_instances) / upd->num_jobs;
+    const int end = ((job_index + 1) * upd->num_instances) / upd->num_jobs;
+    for (int i = start; i < end; i++) {
+        sspine_update_instance(upd->instances[i], upd->delta_time);
+    }
+}
+
+// returns the number of jobs the update was split into
+static int spinejobs_update_instances(const sspine_instance* instances, int num_instances, float delta_time, int num_jobs) {
+    assert(instances && (num_instances >= 0));
+    if (num_jobs <= 0) {
+        num_jobs = jobs_num_threads() + 1;
+    }
+    if (num_jobs > num_instances) {
+        num_jobs = num_instances;
+    }
+    if (num_jobs <= 1) {
+        for (int i = 0; i < num_instances; i++) {
+            sspine_update_instance(instances[i], delta_time);
+        }
+        return num_instances > 0 ? 1 : 0;
+    }
+    _spinejobs_update_t upd = {
+        .instances = instances,
+        .num_instances = num_instances,
+        .num_jobs = num_jobs,
+        .delta_time = delta_time,
+    };
+    jobs_wait(jobs_dispatch(_spinejobs_update_task, &upd, num_jobs));
+    return num_jobs;
+}
+
+// records the draw commands of all instances in array order
+static void spinejobs_draw_instances_in_layers(const sspine_instance* instances, const int* layers, int num_instances) {
+    assert(instances && (num_instances >= 0));
+    for (int i = 0; i < num_instances; i++) {
+        sspine_draw_instance_in_layer(instances[i], layers ? layers[i] : 0);
+    }
+}
+
+static void spinejobs_context_draw_instances_in_layers(sspine_context ctx, const sspine_instance* instances, const int* layers, int num_instances) {
+    assert(instances && (num_instances >= 0));
+    for (int i = 0; i < num_instances; i++) {
+        sspine_context_draw_instance_in_layer(ctx, instances[i], layers ? layers[i] : 0);
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+/*
+    Dirty-region tracking for dynamically updated sokol-gfx images.
+
+    sg_update_image() always replaces the complete image, and may only be
+    called once per frame and image. This header tracks which boxes of
+    texels were modified, so that an image is only uploaded in frames
+    where something actually changed:
+
+        // image must have been created with SG_USAGE_DYNAMIC or SG_USAGE_STREAM
+        sg_image img = sg_make_image(&(sg_image_desc){ .usage = SG_USAGE_DYNAMIC, ... });
+        ...
+        // each frame, mark the modified regions...
+        subimage_dirty_t dirty;
+        subimage_dirty_clear(&dirty);
+        subimage_dirty_add(&dirty, (subimage_box_t){ x, y, z, w, h, d });
+        ...
+        // ...and upload the image if anything is dirty, pixels is the
+        // tightly packed CPU-side copy of the complete image, the result
+        // is the number of uploaded bytes (0 if nothing was dirty)
+        size_t num_bytes = subimage_update_dirty(img, &dirty, SG_RANGE(pixels));
+
+    Overlapping and touching boxes are merged when added, if the maximum
+    number of boxes is reached the two boxes which waste the least volume
+    when merged are combined. subimage_dirty_volume() returns the number
+    of modified texels, e.g. to compare against the uploaded size.
+
+    Only the public sokol-gfx API is used, so only mip level 0 of 2D,
+    2D-array and 3D images can be updated this way. Include after
+    sokol_gfx.h.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+#include <string.h> // memset()
+
+#define SUBIMAGE_MAX_BOXES (32)
+
+typedef struct {
+    int x, y, z;
+    int width, height, depth;
+} subimage_box_t;
+
+typedef struct {
+    int num_boxes;
+    subimage_box_t boxes[SUBIMAGE_MAX_BOXES];
+} subimage_dirty_t;
+
+static inline bool subimage_box_empty(subimage_box_t b) {
+    return (b.width <= 0) || (b.height <= 0) || (b.depth <= 0);
+}
+
+static inline int64_t subimage_box_volume(subimage_box_t b) {
+    return (int64_t)b.width * b.height * b.depth;
+}
+
+// smallest box containing both boxes
+static inline subimage_box_t subimage_box_union(subimage_box_t a, subimage_box_t b) {
+    const int x0 = a.x < b.x ? a.x : b.x;
+    const int y0 = a.y < b.y ? a.y : b.y;
+    const int z0 = a.z < b.z ? a.z : b.z;
+    const int x1 = (a.x + a.width) > (b.x + b.width) ? (a.x + a.width) : (b.x + b.width);
+    const int y1 = (a.y + a.height) > (b.y + b.height) ? (a.y + a.height) : (b.y + b.height);
+    const int z1 = (a.z + a.depth) > (b.z + b.depth) ? (a.z + a.depth) : (b.z + b.depth);
+    subimage_box_t u;
+    u.x = x0; u.y = y0; u.z = z0;
+    u.width = x1 - x0; u.height = y1 - y0; u.depth = z1 - z0;
+    return u;
+}
+
+// true if the union of both boxes covers no texels outside of the two boxes
+static inline bool _subimage_box_mergeable(subimage_box_t a, subimage_box_t b) {
+    const subimage_box_t u = subimage_box_union(a, b);
+    if (subimage_box_volume(u) <= subimage_box_volume(a)) {
+        return true;    // b is inside a
+    }
+    if (subimage_box_volume(u) <= subimage_box_volume(b)) {
+        return true;    // a is inside b
+    }
+    // identical extent on two axes and overlapping or touching on the third
+    const bool same_x = (a.x == b.x) && (a.width == b.width);
+    const bool same_y = (a.y == b.y) && (a.height == b.height);
+    const bool same_z = (a.z == b.z) && (a.depth == b.depth);
+    const bool touch_x = (a.x <= (b.x + b.width)) && (b.x <= (a.x + a.width));
+    const bool touch_y = (a.y <= (b.y + b.height)) && (b.y <= (a.y + a.height));
+    const bool touch_z = (a.z <= (b.z + b.depth)) && (b.z <= (a.z + a.depth));
+    return (same_y && same_z && touch_x) || (same_x && same_z && touch_y) || (same_x && same_y && touch_z);
+}
+
+static inline void subimage_dirty_clear(subimage_dirty_t* dirty) {
+    assert(dirty);
+    dirty->num_boxes = 0;
+}
+
+static inline bool subimage_dirty_empty(const subimage_dirty_t* dirty) {
+    assert(dirty);
+    return 0 == dirty->num_boxes;
+}
+
+// number of dirty texels (overlapping boxes are counted twice)
+static inline int64_t subimage_dirty_volume(const subimage_dirty_t* dirty) {
+    assert(dirty);
+    int64_t vol = 0;
+    for (int i = 0; i < dirty->num_boxes; i++) {
+        vol += subimage_box_volume(dirty->boxes[i]);
+    }
+    return vol;
+}
+
+static inline void subimage_dirty_add(subimage_dirty_t* dirty, subimage_box_t box) {
+    assert(dirty);
+    if (subimage_box_empty(box)) {
+        return;
+    }
+    // merge with existing boxes as long as this doesn't add clean texels,
+    // a merged box might now be mergeable with another box, so start over
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < dirty->num_boxes; i++) {
+            if (_subimage_box_mergeable(dirty->boxes[i], box)) {
+                box = subimage_box_union(dirty->boxes[i], box);
+                dirty->boxes[i] = dirty->boxes[--dirty->num_boxes];
+                merged = true;
+                break;
+            }
+        }
+    }
+    if (dirty->num_boxes == SUBIMAGE_MAX_BOXES) {
+        // out of boxes, merge the pair which adds the fewest clean texels
+        int best_i = 0, best_j = 1;
+        int64_t best_waste = INT64_MAX;
+        for (int i = 0; i < dirty->num_boxes; i++) {
+            for (int j = i + 1; j < dirty->num_boxes; j++) {
+                const subimage_box_t a = dirty->boxes[i];
+                const subimage_box_t b = dirty->boxes[j];
+                const int64_t waste = subimage_box_volume(subimage_box_union(a, b)) - subimage_box_volume(a) - subimage_box_volume(b);
+                if (waste < best_waste) {
+                    best_waste = waste;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        dirty->boxes[best_i] = subimage_box_union(dirty->boxes[best_i], dirty->boxes[best_j]);
+        dirty->boxes[best_j] = dirty->boxes[--dirty->num_boxes];
+    }
+    dirty->boxes[dirty->num_boxes++] = box;
+}
+
+// upload the complete image if any box is dirty, returns the number of uploaded bytes,
+// must not be called more than once per frame for the same image, and not inside a pass
+static inline size_t subimage_update_dirty(sg_image img, const subimage_dirty_t* dirty, sg_range pixels) {
+    assert(dirty && pixels.ptr && (pixels.size > 0));
+    if (subimage_dirty_empty(dirty)) {
+        return 0;
+    }
+    sg_image_data data;
+    memset(&data, 0, sizeof(data));
+    data.subimage[0][0] = pixels;
+    sg_update_image(img, &data);
+    return pixels.size;
+}
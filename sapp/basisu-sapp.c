@@ -6,6 +6,11 @@
 //  textures. Basis Univsersal compressed textures are embedded as C arrays
 //  so that texture data doesn't need to be loaded (for instance via sokol_fetch.h)
 //
+//  If the .basis files are found next to the executable and memory-mapped
+//  files are supported on the platform, the files are mapped via
+//  fileutil_mmap() and transcoded directly from the mapped memory instead
+//  (the embedded data is the fallback).
+//
 //  Texture credits: Paul Vera-Broadbent (twitter: @PVBroadz)
 //
 //  And some useful info from Carl Woffenden (twitter: @monsieurwoof):
@@ -26,6 +31,7 @@
 #include "dbgui/dbgui.h"
 #include "data/basisu-assets.h"
 #include "basisu/sokol_basisu.h"
+#include "util/fileutil.h"
 
 static struct {
     sg_pass_action pass_action;
@@ -34,6 +40,7 @@ static struct {
     sg_image alpha_img;
     sg_sampler smp;
     double angle_deg;
+    bool mmapped;
 } state = {
     .pass_action = {
         .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.25f, 0.25f, 1.0f, 1.0f }}
@@ -53,6 +60,25 @@ static const char* pixelformat_to_str(sg_pixel_format fmt) {
     }
 }
 
+// transcode a Basis Universal file directly from a memory mapping if
+// possible, otherwise fall back to the embedded data
+static sg_image make_image(const char* filename, sg_range embedded_data, bool* out_mmapped) {
+    char path_buf[512];
+    fileutil_mmap_t map;
+    if (fileutil_mmap(fileutil_get_path(filename, path_buf, sizeof(path_buf)), FILEUTIL_ADVICE_SEQUENTIAL, &map)) {
+        sg_image img = sbasisu_make_image(fileutil_mmap_as_sg_range(&map));
+        // the transcoded pixel data has been copied into the texture, so the mapping can go
+        fileutil_munmap(&map);
+        if (sg_query_image_state(img) == SG_RESOURCESTATE_VALID) {
+            *out_mmapped = true;
+            return img;
+        }
+        sg_destroy_image(img);
+    }
+    *out_mmapped = false;
+    return sbasisu_make_image(embedded_data);
+}
+
 void init(void) {
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
@@ -70,9 +96,11 @@ void init(void) {
     // setup Basis Universal via our own minimal wrapper code
     sbasisu_setup();
 
-    // create sokol-gfx textures from the embedded Basis Universal textures
-    state.opaque_img = sbasisu_make_image(SG_RANGE(embed_testcard_basis));
-    state.alpha_img  = sbasisu_make_image(SG_RANGE(embed_testcard_rgba_basis));
+    // create sokol-gfx textures from the memory-mapped or embedded Basis Universal textures
+    bool opaque_mmapped, alpha_mmapped;
+    state.opaque_img = make_image("testcard.basis", SG_RANGE(embed_testcard_basis), &opaque_mmapped);
+    state.alpha_img  = make_image("testcard_rgba.basis", SG_RANGE(embed_testcard_rgba_basis), &alpha_mmapped);
+    state.mmapped = opaque_mmapped && alpha_mmapped;
 
     // create a sampler object
     state.smp = sg_make_sampler(&(sg_sampler_desc){
@@ -129,7 +157,8 @@ void frame(void) {
     sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
     sdtx_origin(0.5f, 2.0f);
     sdtx_printf("Opaque format: %s\n\n", pixelformat_to_str(sbasisu_pixelformat(false)));
-    sdtx_printf("Alpha format: %s", pixelformat_to_str(sbasisu_pixelformat(true)));
+    sdtx_printf("Alpha format: %s\n\n", pixelformat_to_str(sbasisu_pixelformat(true)));
+    sdtx_printf("Source: %s", state.mmapped ? "memory-mapped files" : "embedded data");
 
     // draw some textured quads via sokol-gl
     sgl_defaults();
@@ -2,6 +2,13 @@
 //  cubemap-jpeg-sapp.c
 //
 //  Load and render cubemap from individual jpeg files.
+//
+//  The 6 faces are loaded in parallel via sokol_fetch.h, and as soon as
+//  a face has been loaded, it is decoded on a worker thread (see
+//  util/jobs.h) so that JPEG decoding doesn't stall the frame loop.
+//  The JPEG decoder writes directly into the preallocated pixel memory
+//  (via stbi_load_from_memory_into()), and the cubemap texture is
+//  initialized once all faces have been decoded.
 //------------------------------------------------------------------------------
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
@@ -10,45 +17,79 @@
 #include "sokol_gfx.h"
 #include "sokol_app.h"
 #include "sokol_fetch.h"
+#include "sokol_time.h"
 #include "sokol_debugtext.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
-#include "stb/stb_image.h"
+#include "stb/stb_image_ext.h"
 #include "dbgui/dbgui.h"
 #include "util/camera.h"
 #include "util/fileutil.h"
+#include "util/jobs.h"
 #include "cubemap-jpeg-sapp.glsl.h"
 
+typedef struct {
+    int face_index;
+    bool fetched;
+    bool decoded;
+    sfetch_range_t jpeg;
+    jobs_batch_t job;
+    double decode_ms;
+} face_t;
+
 static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
     sg_bindings bind;
     camera_t camera;
-    int load_count;
+    int fetch_count;
     bool load_failed;
+    bool image_valid;
     sg_range pixels;
+    sg_range jpeg_data;
+    face_t faces[SG_CUBEFACE_NUM];
+    uint64_t load_start_time;
+    double load_ms;
 } state;
 
+static const char* face_names[SG_CUBEFACE_NUM] = {
+    "+X", "-X", "+Y", "-Y", "+Z", "-Z"
+};
+
 // room for loading all cubemap faces in parallel
 #define FACE_WIDTH (2048)
 #define FACE_HEIGHT (2048)
 #define FACE_NUM_BYTES (FACE_WIDTH * FACE_HEIGHT * 4)
+// the JPEG decoder needs a little bit of extra room to decode in place
+#define FACE_STRIDE (FACE_NUM_BYTES + 16)
+#define MAX_JPEG_SIZE (2 * 1024 * 1024)
 
 static void fetch_cb(const sfetch_response_t*);
 
 static sg_range cubeface_range(int face_index) {
     assert(state.pixels.ptr);
     assert((face_index >= 0) && (face_index < SG_CUBEFACE_NUM));
-    size_t offset = (size_t)(face_index * FACE_NUM_BYTES);
-    assert((offset + FACE_NUM_BYTES) <= state.pixels.size);
+    size_t offset = (size_t)(face_index * FACE_STRIDE);
+    assert((offset + FACE_STRIDE) <= state.pixels.size);
     return (sg_range){
         .ptr = ((uint8_t*)state.pixels.ptr) + offset,
         .size = FACE_NUM_BYTES
     };
 }
 
-static void init(void) {
+static sfetch_range_t jpeg_range(int face_index) {
+    assert(state.jpeg_data.ptr);
+    assert((face_index >= 0) && (face_index < SG_CUBEFACE_NUM));
+    size_t offset = (size_t)(face_index * MAX_JPEG_SIZE);
+    assert((offset + MAX_JPEG_SIZE) <= state.jpeg_data.size);
+    return (sfetch_range_t){
+        .ptr = ((uint8_t*)state.jpeg_data.ptr) + offset,
+        .size = MAX_JPEG_SIZE
+    };
+}
 
+static void init(void) {
+    stm_setup();
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
@@ -68,6 +109,11 @@ static void init(void) {
         .logger.func = slog_func,
     });
 
+    // setup the worker thread pool for decoding the JPEG files
+    jobs_setup(&(jobs_desc_t){
+        .num_threads = SG_CUBEFACE_NUM,
+    });
+
     // setup camera helper
     cam_init(&state.camera, &(camera_desc_t){
         .latitude = 0.0f,
@@ -77,10 +123,13 @@ static void init(void) {
         .max_dist = 0.1f,
     });
 
-    // allocate memory for pixel data (both as io buffer for JPEG data, and for the decoded pixel data)
-    state.pixels.size = SG_CUBEFACE_NUM * FACE_NUM_BYTES;
+    // allocate memory for the decoded pixel data, and separate io buffers for the JPEG data
+    state.pixels.size = SG_CUBEFACE_NUM * FACE_STRIDE;
     state.pixels.ptr = malloc(state.pixels.size);
     assert(state.pixels.ptr);
+    state.jpeg_data.size = SG_CUBEFACE_NUM * MAX_JPEG_SIZE;
+    state.jpeg_data.ptr = malloc(state.jpeg_data.size);
+    assert(state.jpeg_data.ptr);
 
     // pass action, clear to black
     state.pass_action = (sg_pass_action){
@@ -166,58 +215,90 @@ static void init(void) {
         "nb2_posy.jpg", "nb2_negy.jpg",
         "nb2_posz.jpg", "nb2_negz.jpg"
     };
+    state.load_start_time = stm_now();
     for (int i = 0; i < SG_CUBEFACE_NUM; i++) {
+        state.faces[i].face_index = i;
         sfetch_send(&(sfetch_request_t){
             .path = fileutil_get_path(filenames[i], path_buf, sizeof(path_buf)),
             .callback = fetch_cb,
-            .buffer = { .ptr = cubeface_range(i).ptr, .size = cubeface_range(i).size },
+            .buffer = jpeg_range(i),
+            .user_data = SFETCH_RANGE(i),
         });
     }
 }
 
+// decode a JPEG cubemap face on a worker thread
+static void decode_face(int job_index, void* user_data) {
+    (void)job_index;
+    face_t* face = (face_t*)user_data;
+    const uint64_t start_time = stm_now();
+    int width, height, channels_in_file;
+    const int desired_channels = 4;
+    // decode straight into the face's pixel memory, this fails if the image is too big
+    const int ok = stbi_load_from_memory_into(
+        face->jpeg.ptr,
+        (int)face->jpeg.size,
+        &width, &height,
+        &channels_in_file, desired_channels,
+        (stbi_uc*)cubeface_range(face->face_index).ptr,
+        FACE_STRIDE);
+    face->decoded = ok && (width == FACE_WIDTH) && (height == FACE_HEIGHT);
+    face->decode_ms = stm_ms(stm_since(start_time));
+}
+
 static void fetch_cb(const sfetch_response_t* response) {
     if (response->fetched) {
-        // decode loaded jpeg data
-        int width, height, channels_in_file;
-        const int desired_channels = 4;
-        stbi_uc* decoded_pixels = stbi_load_from_memory(
-            response->data.ptr,
-            (int)response->data.size,
-            &width, &height,
-            &channels_in_file, desired_channels);
-        if (decoded_pixels) {
-            assert(width == FACE_WIDTH);
-            assert(height == FACE_HEIGHT);
-            // overwrite JPEG data with decoded pixel data
-            memcpy((void*)response->buffer.ptr, decoded_pixels, FACE_NUM_BYTES);
-            stbi_image_free(decoded_pixels);
-            // all 6 faces loaded?
-            if (++state.load_count == SG_CUBEFACE_NUM) {
-                sg_init_image(state.bind.images[IMG_tex], &(sg_image_desc){
-                    .type = SG_IMAGETYPE_CUBE,
-                    .width = width,
-                    .height = height,
-                    .pixel_format = SG_PIXELFORMAT_RGBA8,
-                    .data.subimage = {
-                        [SG_CUBEFACE_POS_X][0] = cubeface_range(SG_CUBEFACE_POS_X),
-                        [SG_CUBEFACE_NEG_X][0] = cubeface_range(SG_CUBEFACE_NEG_X),
-                        [SG_CUBEFACE_POS_Y][0] = cubeface_range(SG_CUBEFACE_POS_Y),
-                        [SG_CUBEFACE_NEG_Y][0] = cubeface_range(SG_CUBEFACE_NEG_Y),
-                        [SG_CUBEFACE_POS_Z][0] = cubeface_range(SG_CUBEFACE_POS_Z),
-                        [SG_CUBEFACE_NEG_Z][0] = cubeface_range(SG_CUBEFACE_NEG_Z),
-                    },
-                    .label = "cubemap-image",
-                });
-                free((void*)state.pixels.ptr); state.pixels.ptr = 0;
-            }
-        }
+        // kick off decoding the loaded JPEG data on a worker thread
+        face_t* face = &state.faces[*(int*)response->user_data];
+        face->fetched = true;
+        face->jpeg = response->data;
+        face->job = jobs_dispatch(decode_face, face, 1);
+        state.fetch_count++;
     } else if (response->failed) {
         state.load_failed = true;
     }
 }
 
+// check if all faces have been decoded, and if yes, initialize the cubemap texture
+static void update_cubemap(void) {
+    if (state.image_valid || state.load_failed || (state.fetch_count < SG_CUBEFACE_NUM)) {
+        return;
+    }
+    for (int i = 0; i < SG_CUBEFACE_NUM; i++) {
+        if (!jobs_done(state.faces[i].job)) {
+            return;
+        }
+    }
+    for (int i = 0; i < SG_CUBEFACE_NUM; i++) {
+        if (!state.faces[i].decoded) {
+            state.load_failed = true;
+            return;
+        }
+    }
+    sg_init_image(state.bind.images[IMG_tex], &(sg_image_desc){
+        .type = SG_IMAGETYPE_CUBE,
+        .width = FACE_WIDTH,
+        .height = FACE_HEIGHT,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .data.subimage = {
+            [SG_CUBEFACE_POS_X][0] = cubeface_range(SG_CUBEFACE_POS_X),
+            [SG_CUBEFACE_NEG_X][0] = cubeface_range(SG_CUBEFACE_NEG_X),
+            [SG_CUBEFACE_POS_Y][0] = cubeface_range(SG_CUBEFACE_POS_Y),
+            [SG_CUBEFACE_NEG_Y][0] = cubeface_range(SG_CUBEFACE_NEG_Y),
+            [SG_CUBEFACE_POS_Z][0] = cubeface_range(SG_CUBEFACE_POS_Z),
+            [SG_CUBEFACE_NEG_Z][0] = cubeface_range(SG_CUBEFACE_NEG_Z),
+        },
+        .label = "cubemap-image",
+    });
+    free((void*)state.pixels.ptr); state.pixels.ptr = 0;
+    free((void*)state.jpeg_data.ptr); state.jpeg_data.ptr = 0;
+    state.image_valid = true;
+    state.load_ms = stm_ms(stm_since(state.load_start_time));
+}
+
 static void frame(void) {
     sfetch_dowork();
+    update_cubemap();
     cam_update(&state.camera, sapp_width(), sapp_height());
 
     const vs_params_t vs_params = {
@@ -228,10 +309,15 @@ static void frame(void) {
     sdtx_origin(1, 1);
     if (state.load_failed) {
         sdtx_puts("LOAD FAILED!");
-    } else if (state.load_count < 6) {
+    } else if (!state.image_valid) {
         sdtx_puts("LOADING ...");
     } else {
-        sdtx_puts("LMB + move mouse to look around");
+        sdtx_puts("LMB + move mouse to look around\n\n");
+        sdtx_printf("decode threads: %d\n", jobs_num_threads());
+        for (int i = 0; i < SG_CUBEFACE_NUM; i++) {
+            sdtx_printf("  face %s: %.2fms\n", face_names[i], state.faces[i].decode_ms);
+        }
+        sdtx_printf("load + decode: %.2fms", state.load_ms);
     }
 
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
@@ -247,6 +333,8 @@ static void frame(void) {
 
 static void cleanup(void) {
     __dbgui_shutdown();
+    // wait for decode jobs that might still be in flight
+    jobs_shutdown();
     sfetch_shutdown();
     sdtx_shutdown();
     sg_shutdown();
@@ -1,6 +1,14 @@
 //------------------------------------------------------------------------------
 //  cubemaprt-sapp.c
 //  Cubemap as render target.
+//
+//  The environment cubemap can be updated in three ways (keys 1..3):
+//
+//  1: all faces every frame, all shapes rendered into each face
+//  2: all faces every frame, shapes are culled against each face frustum
+//  3: like 2, but only 1 or 2 faces (key F) are updated per frame
+//
+//  Draw calls and CPU time are shown per frame and per full cubemap refresh.
 //------------------------------------------------------------------------------
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
@@ -9,6 +17,9 @@
 #include "sokol_app.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
 #include "dbgui/dbgui.h"
 #include <stddef.h> /* offsetof */
 #include "cubemaprt-sapp.glsl.h"
@@ -17,6 +28,17 @@
 #define OFFSCREEN_SAMPLE_COUNT (1)
 #define DISPLAY_SAMPLE_COUNT (4)
 #define NUM_SHAPES (32)
+#define SHAPE_RADIUS (0.433f)   // bounding sphere radius of the scaled shape cubes (0.25 * sqrt(3))
+#define OFFSCREEN_FAR (100.0f)
+#define NUM_AVG_FRAMES (60)
+
+// cubemap update modes
+enum {
+    UPDATE_ALL,
+    UPDATE_CULLED,
+    UPDATE_AMORTIZED,
+    NUM_UPDATE_MODES,
+};
 
 /* state struct for the little cubes rotating around the big cube */
 typedef struct {
@@ -56,10 +78,24 @@ typedef struct {
     hmm_vec4 light_dir;
     float rx, ry;
     shape_t shapes[NUM_SHAPES];
+    int update_mode;
+    int faces_per_frame;    // only used in UPDATE_AMORTIZED mode
+    int next_face;
+    struct {
+        int num_frames;
+        int draw_calls;
+        int faces;
+        double cpu_ms;
+    } accum;
+    struct {
+        double draw_calls;  // per frame
+        double faces;       // per frame
+        double cpu_ms;      // per frame
+    } stats;
 } app_t;
 static app_t app;
 
-static void draw_cubes(sg_pipeline pip, hmm_vec3 eye_pos, hmm_mat4 view_proj);
+static int draw_cubes(sg_pipeline pip, hmm_vec3 eye_pos, hmm_mat4 view_proj, const bool* visible);
 static mesh_t make_cube_mesh(void);
 
 static inline uint32_t xorshift32(void) {
@@ -80,6 +116,13 @@ void init(void) {
         .logger.func = slog_func,
     });
     __dbgui_setup(DISPLAY_SAMPLE_COUNT);
+    stm_setup();
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    app.update_mode = UPDATE_CULLED;
+    app.faces_per_frame = 1;
 
     // create a cubemap as render target, and a matching depth-buffer texture
     app.cubemap = sg_make_image(&(sg_image_desc){
@@ -177,7 +220,7 @@ void init(void) {
     });
 
     // 1:1 aspect ration projection matrix for offscreen rendering
-    app.offscreen_proj = HMM_Perspective(90.0f, 1.0f, 0.01f, 100.0f);
+    app.offscreen_proj = HMM_Perspective(90.0f, 1.0f, 0.01f, OFFSCREEN_FAR);
     app.light_dir = HMM_Vec4v(HMM_NormalizeVec3(HMM_Vec3(-0.75f, 1.0f, 0.0f)), 0.0f);
 
     // setup initial state for the orbiting cubes
@@ -190,6 +233,53 @@ void init(void) {
     }
 }
 
+static void reset_stats(void) {
+    app.accum.num_frames = 0;
+    app.accum.draw_calls = 0;
+    app.accum.faces = 0;
+    app.accum.cpu_ms = 0.0;
+}
+
+// cull the shapes against the frustum of a 90 degree cubemap face looking
+// from the origin along 'dir', a bounding sphere is visible if it's not
+// completely outside any of the 4 side planes (which all go through the origin
+// at 45 degrees between 'dir' and the face's side axes) or the far plane
+static void cull_shapes(hmm_vec3 dir, hmm_vec3 up, bool* visible) {
+    const hmm_vec3 right = HMM_Cross(dir, up);
+    const float k = 0.70710678f;    // 1 / sqrt(2)
+    const hmm_vec3 planes[4] = {
+        HMM_MultiplyVec3f(HMM_AddVec3(dir, right), k),
+        HMM_MultiplyVec3f(HMM_SubtractVec3(dir, right), k),
+        HMM_MultiplyVec3f(HMM_AddVec3(dir, up), k),
+        HMM_MultiplyVec3f(HMM_SubtractVec3(dir, up), k),
+    };
+    for (int i = 0; i < NUM_SHAPES; i++) {
+        const float* t = app.shapes[i].model.Elements[3];
+        const hmm_vec3 pos = HMM_Vec3(t[0], t[1], t[2]);
+        bool vis = (HMM_DotVec3(pos, dir) - SHAPE_RADIUS) < OFFSCREEN_FAR;
+        for (int p = 0; vis && (p < 4); p++) {
+            vis = HMM_DotVec3(pos, planes[p]) > -SHAPE_RADIUS;
+        }
+        visible[i] = vis;
+    }
+}
+
+static void draw_stats(void) {
+    static const char* mode_names[NUM_UPDATE_MODES] = { "all faces", "culled", "amortized" };
+    // one full refresh takes 6/faces_per_frame frames in amortized mode
+    const double frames_per_refresh = (app.stats.faces > 0.0) ? (SG_CUBEFACE_NUM / app.stats.faces) : 0.0;
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("mode: %s (1..3)\n", mode_names[app.update_mode]);
+    if (app.update_mode == UPDATE_AMORTIZED) {
+        sdtx_printf("faces per frame: %d (F)\n", app.faces_per_frame);
+    }
+    sdtx_puts("\n           frame  refresh\n");
+    sdtx_printf("draws:   %7.1f  %7.1f\n", app.stats.draw_calls, app.stats.draw_calls * frames_per_refresh);
+    sdtx_printf("cpu ms:  %7.3f  %7.3f\n", app.stats.cpu_ms, app.stats.cpu_ms * frames_per_refresh);
+}
+
 void frame(void) {
     // compute a frame time multiplier
     const float t = (float)sapp_frame_duration();
@@ -227,13 +317,38 @@ void frame(void) {
         { { .X= 0.0f, .Y= 0.0f, .Z=-1.0f }, { .X=0.0f, .Y=-1.0f, .Z= 0.0f } }
     };
     #endif
-    for (int face = 0; face < SG_CUBEFACE_NUM; face++) {
+    // the CPU time includes culling and recording the offscreen passes
+    const uint64_t start = stm_now();
+    int num_faces = SG_CUBEFACE_NUM;
+    int first_face = 0;
+    if (app.update_mode == UPDATE_AMORTIZED) {
+        num_faces = app.faces_per_frame;
+        first_face = app.next_face;
+        app.next_face = (app.next_face + num_faces) % SG_CUBEFACE_NUM;
+    }
+    int draw_calls = 0;
+    for (int i = 0; i < num_faces; i++) {
+        const int face = (first_face + i) % SG_CUBEFACE_NUM;
+        bool visible[NUM_SHAPES];
+        const bool cull = app.update_mode != UPDATE_ALL;
+        if (cull) {
+            cull_shapes(center_and_up[face][0], center_and_up[face][1], visible);
+        }
         sg_begin_pass(&(sg_pass){ .action = app.offscreen_pass_action, .attachments = app.offscreen_attachments[face] });
         hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 0.0f, 0.0f), center_and_up[face][0], center_and_up[face][1]);
         hmm_mat4 view_proj = HMM_MultiplyMat4(app.offscreen_proj, view);
-        draw_cubes(app.offscreen_shapes_pip, HMM_Vec3(0.0f, 0.0f, 0.0f), view_proj);
+        draw_calls += draw_cubes(app.offscreen_shapes_pip, HMM_Vec3(0.0f, 0.0f, 0.0f), view_proj, cull ? visible : 0);
         sg_end_pass();
     }
+    app.accum.cpu_ms += stm_ms(stm_since(start));
+    app.accum.draw_calls += draw_calls;
+    app.accum.faces += num_faces;
+    if (++app.accum.num_frames == NUM_AVG_FRAMES) {
+        app.stats.cpu_ms = app.accum.cpu_ms / NUM_AVG_FRAMES;
+        app.stats.draw_calls = (double)app.accum.draw_calls / NUM_AVG_FRAMES;
+        app.stats.faces = (double)app.accum.faces / NUM_AVG_FRAMES;
+        reset_stats();
+    }
 
     // render the default pass
     const int w = sapp_width();
@@ -246,7 +361,7 @@ void frame(void) {
     hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
 
     // render the orbiting cubes
-    draw_cubes(app.display_shapes_pip, eye_pos, view_proj);
+    draw_cubes(app.display_shapes_pip, eye_pos, view_proj, 0);
 
     // render a big cube in the middle with environment mapping
     app.rx += 0.1f * 60.0f * t; app.ry += 0.2f * 60.0f * t;
@@ -270,13 +385,29 @@ void frame(void) {
     sg_apply_uniforms(UB_shape_uniforms, &SG_RANGE(uniforms));
     sg_draw(0, app.cube.num_elements, 1);
 
+    draw_stats();
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
     sg_commit();
 }
 
+void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        if ((ev->key_code >= SAPP_KEYCODE_1) && (ev->key_code <= SAPP_KEYCODE_3)) {
+            app.update_mode = (int)(ev->key_code - SAPP_KEYCODE_1);
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_F) {
+            app.faces_per_frame = (app.faces_per_frame == 1) ? 2 : 1;
+            reset_stats();
+        }
+    }
+    __dbgui_event(ev);
+}
+
 void cleanup(void) {
     __dbgui_shutdown();
+    sdtx_shutdown();
     sg_shutdown();
 }
 
@@ -287,7 +418,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .sample_count = DISPLAY_SAMPLE_COUNT,
@@ -297,13 +428,18 @@ sapp_desc sokol_main(int argc, char* argv[]) {
     };
 }
 
-static void draw_cubes(sg_pipeline pip, hmm_vec3 eye_pos, hmm_mat4 view_proj) {
+// draw the orbiting cubes, visible is an optional per-shape mask, returns number of draw calls
+static int draw_cubes(sg_pipeline pip, hmm_vec3 eye_pos, hmm_mat4 view_proj, const bool* visible) {
     sg_apply_pipeline(pip);
     sg_apply_bindings(&(sg_bindings){
         .vertex_buffers[0] = app.cube.vbuf,
         .index_buffer = app.cube.ibuf
     });
+    int draw_calls = 0;
     for (int i = 0; i < NUM_SHAPES; i++) {
+        if (visible && !visible[i]) {
+            continue;
+        }
         const shape_t* shape = &app.shapes[i];
         shape_uniforms_t uniforms = {
             .mvp = HMM_MultiplyMat4(view_proj, shape->model),
@@ -314,7 +450,9 @@ static void draw_cubes(sg_pipeline pip, hmm_vec3 eye_pos, hmm_mat4 view_proj) {
         };
         sg_apply_uniforms(UB_shape_uniforms, &SG_RANGE(uniforms));
         sg_draw(0, app.cube.num_elements, 1);
+        draw_calls++;
     }
+    return draw_calls;
 }
 
 static mesh_t make_cube_mesh(void) {
@@ -3,11 +3,29 @@
 //
 //  Demonstrate custom MSAA resolve in a render pass which reads individual
 //  MSAA samples in the fragment shader.
+//
+//  The benchmark window compares three resolve strategies over render
+//  target sizes up to 3840x2160 and 2, 4 and 8 samples:
+//
+//  - builtin: the MSAA pass has a resolve attachment and also stores the
+//    MSAA samples (sokol-gfx resolves with a framebuffer blit on GL,
+//    ResolveSubresource on D3D11 and a store action on Metal and WebGPU)
+//  - store action: the same, but the MSAA samples are not stored, which
+//    allows tile-based GPUs to resolve from tile memory
+//  - custom: the MSAA samples are stored and resolved in a separate pass
+//    with a shader (not available on WebGL2/GLES3/macOS+GL)
+//
+//  GPU time is measured with libs/util/gputimer.h, CPU time is the time
+//  spent in the sokol-gfx calls of the benchmarked passes. Results are
+//  also written to stdout in CSV format.
 //------------------------------------------------------------------------------
+#include <stdio.h>
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#include "util/gputimer.h"
 #define SOKOL_IMGUI_IMPL
 #define SOKOL_GFX_IMGUI_IMPL
 #include "cimgui.h"
@@ -18,6 +36,31 @@
 #define WIDTH (160)
 #define HEIGHT (120)
 
+#define NUM_BENCH_SIZES (4)
+#define NUM_BENCH_SAMPLE_COUNTS (3)
+#define NUM_BENCH_CONFIGS (NUM_BENCH_SIZES * NUM_BENCH_SAMPLE_COUNTS * NUM_RESOLVE_STRATEGIES)
+#define BENCH_FRAMES (60)
+
+typedef enum {
+    RESOLVE_BUILTIN,
+    RESOLVE_STOREACTION,
+    RESOLVE_CUSTOM,
+    NUM_RESOLVE_STRATEGIES,
+} resolve_strategy_t;
+
+static const struct { int width, height; } bench_sizes[NUM_BENCH_SIZES] = {
+    { 160, 120 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 },
+};
+static const int bench_sample_counts[NUM_BENCH_SAMPLE_COUNTS] = { 2, 4, 8 };
+static const char* strategy_names[NUM_RESOLVE_STRATEGIES] = { "builtin", "store-action", "custom" };
+
+typedef struct {
+    bool valid;
+    bool gpu_valid;     // false without GPU timer support, gpu_ms is meaningless then
+    double gpu_ms;
+    double cpu_ms;
+} bench_result_t;
+
 static struct {
     struct {
         sg_image img;
@@ -38,6 +81,17 @@ static struct {
         sg_pass_action action;
         sg_bindings bind;
     } display;
+    struct {
+        gputimer_bench_t run;   // config is an index into size x sample count x strategy
+        sg_image msaa_img;
+        sg_image resolve_img;
+        sg_attachments msaa_atts;       // for the custom resolve
+        sg_attachments resolve_atts;    // MSAA image plus resolve attachment
+        sg_attachments custom_atts;     // the custom resolve pass
+        sg_pipeline msaa_pip[NUM_BENCH_SAMPLE_COUNTS];
+        sg_pipeline resolve_pip;
+        bench_result_t results[NUM_BENCH_SIZES][NUM_BENCH_SAMPLE_COUNTS][NUM_RESOLVE_STRATEGIES];
+    } bench;
     struct {
         sgimgui_t sgimgui;
     } ui;
@@ -53,6 +107,9 @@ const fs_params_t default_weights = {
 
 static void draw_fallback(void);
 static void draw_ui(void);
+static void bench_setup(void);
+static void bench_start(void);
+static void bench_frame(void);
 
 static void init(void) {
     sg_setup(&(sg_desc){
@@ -61,6 +118,9 @@ static void init(void) {
     });
     simgui_setup(&(simgui_desc_t){ .logger.func = slog_func });
     sgimgui_init(&state.ui.sgimgui, &(sgimgui_desc_t){0});
+    stm_setup();
+    gputimer_setup();
+    bench_setup();
 
     // catch WebGL2/GLES3
     if (!sg_query_features().msaa_image_bindings) {
@@ -149,6 +209,9 @@ static void init(void) {
 
 static void frame(void) {
     draw_ui();
+    if (state.bench.run.active) {
+        bench_frame();
+    }
     if (!sg_query_features().msaa_image_bindings) {
         draw_fallback();
         return;
@@ -179,6 +242,7 @@ static void frame(void) {
 }
 
 static void cleanup(void) {
+    gputimer_shutdown();
     sgimgui_discard(&state.ui.sgimgui);
     simgui_shutdown();
     sg_shutdown();
@@ -214,6 +278,259 @@ static void draw_ui(void) {
         }
     }
     igEnd();
+
+    igSetNextWindowPos((ImVec2){10, 200}, ImGuiCond_Once);
+    if (igBegin("Resolve Benchmark", 0, ImGuiWindowFlags_AlwaysAutoResize)) {
+        if (state.bench.run.active) {
+            igText("running %d/%d...", state.bench.run.config + 1, NUM_BENCH_CONFIGS);
+        } else if (igButton("Run")) {
+            bench_start();
+        }
+        if (!gputimer_supported()) {
+            igText("GPU timers not supported on this backend");
+        }
+        if (state.bench.run.done) {
+            igText("%-10s %7s %-12s %8s %8s", "size", "samples", "strategy", "gpu ms", "cpu ms");
+            for (int size = 0; size < NUM_BENCH_SIZES; size++) {
+                for (int sc = 0; sc < NUM_BENCH_SAMPLE_COUNTS; sc++) {
+                    for (int strat = 0; strat < NUM_RESOLVE_STRATEGIES; strat++) {
+                        const bench_result_t* res = &state.bench.results[size][sc][strat];
+                        if (res->valid) {
+                            char gpu[32] = "n/a";
+                            if (res->gpu_valid) {
+                                snprintf(gpu, sizeof(gpu), "%.3f", res->gpu_ms);
+                            }
+                            igText("%4dx%-5d %7d %-12s %8s %8.3f",
+                                bench_sizes[size].width, bench_sizes[size].height,
+                                bench_sample_counts[sc], strategy_names[strat],
+                                gpu, res->cpu_ms);
+                        } else {
+                            igText("%4dx%-5d %7d %-12s %8s %8s",
+                                bench_sizes[size].width, bench_sizes[size].height,
+                                bench_sample_counts[sc], strategy_names[strat], "n/a", "n/a");
+                        }
+                    }
+                }
+            }
+        }
+    }
+    igEnd();
+}
+
+static void bench_setup(void) {
+    sg_shader msaa_shd = sg_make_shader(msaa_shader_desc(sg_query_backend()));
+    for (int i = 0; i < NUM_BENCH_SAMPLE_COUNTS; i++) {
+        state.bench.msaa_pip[i] = sg_make_pipeline(&(sg_pipeline_desc){
+            .shader = msaa_shd,
+            .sample_count = bench_sample_counts[i],
+            .depth.pixel_format = SG_PIXELFORMAT_NONE,
+            .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+            .label = "bench msaa pipeline",
+        });
+    }
+    if (sg_query_features().msaa_image_bindings) {
+        state.bench.resolve_pip = sg_make_pipeline(&(sg_pipeline_desc){
+            .shader = sg_make_shader(bench_resolve_shader_desc(sg_query_backend())),
+            .sample_count = 1,
+            .depth.pixel_format = SG_PIXELFORMAT_NONE,
+            .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+            .label = "bench resolve pipeline",
+        });
+    }
+}
+
+static void bench_config(int config, int* out_size, int* out_sc, int* out_strat) {
+    *out_strat = config % NUM_RESOLVE_STRATEGIES;
+    *out_sc = (config / NUM_RESOLVE_STRATEGIES) % NUM_BENCH_SAMPLE_COUNTS;
+    *out_size = config / (NUM_RESOLVE_STRATEGIES * NUM_BENCH_SAMPLE_COUNTS);
+}
+
+static void bench_release_targets(void) {
+    sg_destroy_attachments(state.bench.custom_atts);
+    sg_destroy_attachments(state.bench.resolve_atts);
+    sg_destroy_attachments(state.bench.msaa_atts);
+    sg_destroy_image(state.bench.resolve_img);
+    sg_destroy_image(state.bench.msaa_img);
+    state.bench.custom_atts = (sg_attachments){0};
+    state.bench.resolve_atts = (sg_attachments){0};
+    state.bench.msaa_atts = (sg_attachments){0};
+    state.bench.resolve_img = (sg_image){0};
+    state.bench.msaa_img = (sg_image){0};
+}
+
+// check a benchmark configuration before creating any resources for it
+static bool bench_config_supported(int config) {
+    int size, sc, strat;
+    bench_config(config, &size, &sc, &strat);
+    if ((strat == RESOLVE_CUSTOM) && !sg_query_features().msaa_image_bindings) {
+        return false;
+    }
+    const sg_pixelformat_info fmt = sg_query_pixelformat(SG_PIXELFORMAT_RGBA8);
+    if (!fmt.render || !fmt.msaa) {
+        return false;
+    }
+    const int max_size = sg_query_limits().max_image_size_2d;
+    if ((bench_sizes[size].width > max_size) || (bench_sizes[size].height > max_size)) {
+        return false;
+    }
+    // the MSAA pipelines are created upfront, one with an unsupported sample count is invalid
+    return sg_query_pipeline_state(state.bench.msaa_pip[sc]) == SG_RESOURCESTATE_VALID;
+}
+
+// (re-)create the render targets for a benchmark configuration, returns false
+// if the configuration isn't supported (e.g. 8 samples or no MSAA texture bindings)
+static bool bench_create_targets(int config) {
+    int size, sc, strat;
+    bench_config(config, &size, &sc, &strat);
+    bench_release_targets();
+    if (!bench_config_supported(config)) {
+        return false;
+    }
+    const int width = bench_sizes[size].width;
+    const int height = bench_sizes[size].height;
+    state.bench.msaa_img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = bench_sample_counts[sc],
+        .label = "bench msaa image",
+    });
+    state.bench.resolve_img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = 1,
+        .label = "bench resolve image",
+    });
+    // sokol-gfx has no public sample count limit, so a backend may still reject the image
+    if ((sg_query_image_state(state.bench.msaa_img) != SG_RESOURCESTATE_VALID) ||
+        (sg_query_image_state(state.bench.resolve_img) != SG_RESOURCESTATE_VALID))
+    {
+        return false;
+    }
+    if (strat == RESOLVE_CUSTOM) {
+        state.bench.msaa_atts = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = state.bench.msaa_img,
+            .label = "bench msaa attachments",
+        });
+        state.bench.custom_atts = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = state.bench.resolve_img,
+            .label = "bench custom resolve attachments",
+        });
+    } else {
+        state.bench.resolve_atts = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = state.bench.msaa_img,
+            .resolves[0].image = state.bench.resolve_img,
+            .label = "bench resolve attachments",
+        });
+    }
+    return true;
+}
+
+// skip over unsupported configurations, returns false when all configurations are done
+static bool bench_next_config(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    while (run->active) {
+        if (bench_create_targets(run->config)) {
+            return true;
+        }
+        gputimer_bench_next(run);
+    }
+    return false;
+}
+
+static void bench_print_csv(void) {
+    printf("width,height,samples,strategy,gpu_ms,cpu_ms\n");
+    for (int size = 0; size < NUM_BENCH_SIZES; size++) {
+        for (int sc = 0; sc < NUM_BENCH_SAMPLE_COUNTS; sc++) {
+            for (int strat = 0; strat < NUM_RESOLVE_STRATEGIES; strat++) {
+                const bench_result_t* res = &state.bench.results[size][sc][strat];
+                if (res->valid) {
+                    printf("%d,%d,%d,%s,", bench_sizes[size].width, bench_sizes[size].height,
+                        bench_sample_counts[sc], strategy_names[strat]);
+                    // leave the GPU column empty without GPU timer support
+                    if (res->gpu_valid) {
+                        printf("%.4f", res->gpu_ms);
+                    }
+                    printf(",%.4f\n", res->cpu_ms);
+                }
+            }
+        }
+    }
+}
+
+static void bench_finish(void) {
+    bench_release_targets();
+    bench_print_csv();
+}
+
+static void bench_start(void) {
+    for (int i = 0; i < NUM_BENCH_SIZES; i++) {
+        for (int j = 0; j < NUM_BENCH_SAMPLE_COUNTS; j++) {
+            for (int k = 0; k < NUM_RESOLVE_STRATEGIES; k++) {
+                state.bench.results[i][j][k] = (bench_result_t){0};
+            }
+        }
+    }
+    gputimer_bench_start(&state.bench.run, NUM_BENCH_CONFIGS, BENCH_FRAMES);
+    if (!bench_next_config()) {
+        bench_finish();
+    }
+}
+
+// render and resolve the current benchmark configuration, once per frame
+static void bench_frame(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    int size, sc, strat;
+    bench_config(run->config, &size, &sc, &strat);
+
+    gputimer_begin_frame();
+    gputimer_begin(0);
+    const uint64_t start = stm_now();
+    const sg_pass_action msaa_action = {
+        .colors[0] = {
+            .load_action = SG_LOADACTION_CLEAR,
+            .store_action = (strat == RESOLVE_STOREACTION) ? SG_STOREACTION_DONTCARE : SG_STOREACTION_STORE,
+            .clear_value = { 0, 0, 0, 1 },
+        },
+    };
+    sg_begin_pass(&(sg_pass){
+        .action = msaa_action,
+        .attachments = (strat == RESOLVE_CUSTOM) ? state.bench.msaa_atts : state.bench.resolve_atts,
+    });
+    sg_apply_pipeline(state.bench.msaa_pip[sc]);
+    sg_draw(0, 3, 1);
+    sg_end_pass();
+    if (strat == RESOLVE_CUSTOM) {
+        sg_begin_pass(&(sg_pass){ .action = state.resolve.action, .attachments = state.bench.custom_atts });
+        sg_apply_pipeline(state.bench.resolve_pip);
+        sg_apply_bindings(&(sg_bindings){
+            .images[IMG_texms] = state.bench.msaa_img,
+            .samplers[SMP_smp] = state.smp,
+        });
+        const bench_fs_params_t params = { .num_samples = bench_sample_counts[sc] };
+        sg_apply_uniforms(UB_bench_fs_params, &SG_RANGE(params));
+        sg_draw(0, 3, 1);
+        sg_end_pass();
+    }
+    const double cpu_ms = stm_ms(stm_since(start));
+    gputimer_end(0);
+    gputimer_end_frame();
+
+    gputimer_avg_add_cpu(&run->avg, cpu_ms);
+    if (gputimer_bench_update(run)) {
+        bench_result_t* res = &state.bench.results[size][sc][strat];
+        res->valid = true;
+        res->gpu_valid = gputimer_supported();
+        res->gpu_ms = gputimer_avg_ms(&run->avg, 0);
+        res->cpu_ms = gputimer_avg_cpu_ms(&run->avg);
+        gputimer_bench_next(run);
+        if (!bench_next_config()) {
+            bench_finish();
+        }
+    }
 }
 
 static void draw_fallback(void) {
@@ -87,6 +87,28 @@ void main() {
 
 @program resolve resolve_vs resolve_fs
 
+// a plain box-filter resolve shader for any sample count, used by the benchmark
+@fs bench_resolve_fs
+layout(binding=0) uniform texture2DMS texms;
+layout(binding=0) uniform sampler smp;
+layout(binding=0) uniform bench_fs_params {
+    int num_samples;
+};
+
+out vec4 frag_color;
+
+void main() {
+    ivec2 uv = ivec2(gl_FragCoord.xy);
+    vec4 c = vec4(0);
+    for (int i = 0; i < num_samples; i++) {
+        c += texelFetch(sampler2DMS(texms, smp), uv, i);
+    }
+    frag_color = c / float(num_samples);
+}
+@end
+
+@program bench_resolve resolve_vs bench_resolve_fs
+
 // the final display pass shader which renders the custom-resolved texture to the display
 @vs display_vs
 @glsl_options flip_vert_y
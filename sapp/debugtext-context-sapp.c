@@ -9,6 +9,11 @@
 //  render targets uses different framebuffer attributes than the default
 //  framebuffer (no depth buffer, no MSAA), so this needs to happen
 //  with separate sokol-debugtext contexts.
+//
+//  Each text is rendered through an sdtxcache_t (libs/util/sdtxcache.h),
+//  which owns its own context, the face texts only change every 16 frames
+//  and are reused from the cache in between without being rebuilt or
+//  uploaded.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -19,6 +24,7 @@
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
+#include "util/sdtxcache.h"
 #include "dbgui/dbgui.h"
 #include "debugtext-context-sapp.glsl.h"
 
@@ -43,8 +49,9 @@ static struct {
     sg_pipeline pip;
     sg_pass_action pass_action;     // just keep this default-initialized, which clears to gray
     sg_sampler smp;
+    sdtxcache_t main_text;
     struct {
-        sdtx_context text_context;
+        sdtxcache_t text;
         sg_image img;
         sg_attachments attachments;
         sg_pass_action pass_action;
@@ -86,6 +93,7 @@ static void init(void) {
         },
         .logger.func = slog_func,
     });
+    sdtxcache_init(&state.main_text, &(sdtxcache_desc_t){0});
 
     // create resources to render a textured cube (vertex buffer, index buffer
     // shader and pipeline state object)
@@ -152,10 +160,11 @@ static void init(void) {
 
     // create resources for each offscreen-rendered cube face
     for (int i = 0; i < NUM_FACES; i++) {
-        // each face gets its separate text context, the text canvas size
-        // will remain fixed, so we can just provide the default canvas
-        // size here and don't need to call sdtx_canvas() later
-        state.passes[i].text_context = sdtx_make_context(&(sdtx_context_desc_t) {
+        // each face gets its separate text cache (and with it, a separate
+        // text context), the text canvas size will remain fixed, so we can
+        // just provide the default canvas size here and don't need to call
+        // sdtx_canvas() later
+        sdtxcache_init(&state.passes[i].text, &(sdtxcache_desc_t){
             .char_buf_size = 64,
             .canvas_width = OFFSCREEN_WIDTH,
             .canvas_height = OFFSCREEN_HEIGHT / 2,
@@ -214,20 +223,34 @@ static void frame(void) {
     state.ry += 0.5f * t;
     vs_params_t vs_params = compute_vs_params(disp_width, disp_height);
 
-    // text in the main display
-    sdtx_set_context(SDTX_DEFAULT_CONTEXT);
-    sdtx_canvas(disp_width * 0.5f, disp_height * 0.5f);
-    sdtx_origin(3, 3);
-    sdtx_puts("Hello from main context!\n");
-    sdtx_printf("Frame count: %d\n", frame_count);
-
-    // text in each offscreen render target
+    // text in each offscreen render target, only rebuilt when the
+    // displayed number changes
+    int num_rebuilt = 0;
     for (int i = 0; i < NUM_FACES; i++) {
-        sdtx_set_context(state.passes[i].text_context);
-        sdtx_origin(1.0f, 0.5f);
-        sdtx_font(i);
-        sdtx_printf("%02X", ((frame_count / 16) + (uint32_t)i)& 0xFF);
+        const uint32_t value = ((frame_count / 16) + (uint32_t)i) & 0xFF;
+        if (sdtxcache_begin(&state.passes[i].text, OFFSCREEN_WIDTH, OFFSCREEN_HEIGHT, sdtxcache_hash(0, &value, sizeof(value)))) {
+            sdtx_origin(1.0f, 0.5f);
+            sdtx_font(i);
+            sdtx_printf("%02X", value);
+            num_rebuilt++;
+        }
+        sdtxcache_end(&state.passes[i].text);
+    }
+
+    // text in the main display, this changes every frame
+    const int canvas[2] = { disp_width, disp_height };
+    uint64_t hash = sdtxcache_hash(0, canvas, sizeof(canvas));
+    hash = sdtxcache_hash(hash, &frame_count, sizeof(frame_count));
+    hash = sdtxcache_hash(hash, &num_rebuilt, sizeof(num_rebuilt));
+    if (sdtxcache_begin(&state.main_text, disp_width, disp_height, hash)) {
+        sdtx_canvas(disp_width * 0.5f, disp_height * 0.5f);
+        sdtx_origin(3, 3);
+        sdtx_puts("Hello from main context!\n");
+        sdtx_printf("Frame count: %d\n", frame_count);
+        num_rebuilt++;
+        sdtx_printf("Contexts rebuilt: %d reused: %d\n", num_rebuilt, (NUM_FACES + 1) - num_rebuilt);
     }
+    sdtxcache_end(&state.main_text);
 
     // rasterize text into offscreen render targets, we could also put this
     // right into the loop above, but this shows that the "text definition"
@@ -237,8 +260,7 @@ static void frame(void) {
             .action = state.passes[i].pass_action,
             .attachments = state.passes[i].attachments,
         });
-        sdtx_set_context(state.passes[i].text_context);
-        sdtx_draw();
+        sdtxcache_draw(&state.passes[i].text);
         sg_end_pass();
     }
 
@@ -259,8 +281,7 @@ static void frame(void) {
     }
 
     // draw default-display text
-    sdtx_set_context(SDTX_DEFAULT_CONTEXT);
-    sdtx_draw();
+    sdtxcache_draw(&state.main_text);
 
     // conclude the default pass and frame
     __dbgui_draw();
@@ -269,6 +290,10 @@ static void frame(void) {
 }
 
 static void cleanup(void) {
+    for (int i = 0; i < NUM_FACES; i++) {
+        sdtxcache_discard(&state.passes[i].text);
+    }
+    sdtxcache_discard(&state.main_text);
     sdtx_shutdown();
     __dbgui_shutdown();
     sg_shutdown();
@@ -1,6 +1,11 @@
 //------------------------------------------------------------------------------
 //  debugtext-layers-sapp.c
 //  Demonstrates layered rendering with sokol_debugtext.h and sokol_gl.h
+//
+//  The layer labels are static, so they are rendered through an
+//  sdtxcache_t (libs/util/sdtxcache.h) with one cached image per layer,
+//  and only rebuilt when SPACE is pressed or the window is resized, a
+//  separate context shows the cache status.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -10,6 +15,7 @@
 #include "sokol_debugtext.h"
 #define SOKOL_GL_IMPL
 #include "sokol_gl.h"
+#include "util/sdtxcache.h"
 #include "dbgui/dbgui.h"
 
 #define NUM_LAYERS (3)
@@ -17,6 +23,9 @@
 static struct {
     sg_pass_action pass_action;
     sgl_pipeline sgl_pip;
+    sdtxcache_t labels;
+    sdtx_context hud_ctx;
+    bool alt_labels;
 } state;
 
 static void init(void) {
@@ -29,6 +38,10 @@ static void init(void) {
         .fonts[0] = sdtx_font_cpc(),
         .logger.func = slog_func,
     });
+    sdtxcache_init(&state.labels, &(sdtxcache_desc_t){ .num_layers = NUM_LAYERS });
+    state.hud_ctx = sdtx_make_context(&(sdtx_context_desc_t){
+        .char_buf_size = 256,
+    });
     sgl_setup(&(sgl_desc_t){
         .logger.func = slog_func
     });
@@ -56,16 +69,30 @@ static void init(void) {
 
 static void frame(void) {
 
-    // render debugtext into layers
-    sdtx_canvas(64.0f, 48.0f);
-    sdtx_font(0);
-    sdtx_color3b(255, 255, 255);
-    sdtx_home();
-    for (int i = 0; i < NUM_LAYERS; i++) {
-        sdtx_layer(i);
-        sdtx_pos(0.5f, 0.5f + 2.0f * (float)i);
-        sdtx_printf("Layer %d", i);
+    // render debugtext into layers, only if the labels changed
+    if (sdtxcache_begin(&state.labels, sapp_width(), sapp_height(), sdtxcache_hash(0, &state.alt_labels, sizeof(state.alt_labels)))) {
+        sdtx_canvas(64.0f, 48.0f);
+        sdtx_font(0);
+        sdtx_color3b(255, 255, 255);
+        sdtx_home();
+        for (int i = 0; i < NUM_LAYERS; i++) {
+            sdtx_layer(i);
+            sdtx_pos(0.5f, 0.5f + 2.0f * (float)i);
+            sdtx_printf(state.alt_labels ? "LAYER #%d" : "Layer %d", i);
+        }
     }
+    sdtxcache_end(&state.labels);
+
+    // the cache status changes every frame
+    sdtx_set_context(state.hud_ctx);
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_font(0);
+    sdtx_pos(1.0f, sapp_heightf() * 0.5f / 8.0f - 4.0f);
+    sdtx_color3b(255, 255, 0);
+    sdtx_printf("labels %s (rebuilt: %d reused: %d)\n",
+        state.labels.rebuilt ? "rebuilt" : "reused",
+        (int)state.labels.num_rebuilt, (int)state.labels.num_reused);
+    sdtx_puts("press SPACE to change labels");
 
     // render horizontal bars into layers via sokol-gl
     const float h = 2.0f / (float)NUM_LAYERS;
@@ -91,16 +118,27 @@ static void frame(void) {
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
     for (int i = 0; i < NUM_LAYERS; i++) {
         sgl_draw_layer(i);
-        sdtx_draw_layer(i);
+        sdtxcache_draw_layer(&state.labels, i);
     }
     sgl_draw_layer(NUM_LAYERS);
+    sdtx_set_context(state.hud_ctx);
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    __dbgui_event(ev);
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE)) {
+        state.alt_labels = !state.alt_labels;
+    }
+}
+
 static void cleanup(void) {
     sgl_shutdown();
+    sdtxcache_discard(&state.labels);
+    sdtx_destroy_context(state.hud_ctx);
     sdtx_shutdown();
     sg_shutdown();
 }
@@ -111,7 +149,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .window_title = "debugtext-layers-sapp",
@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+//  debugtext-perf-sapp.c
+//
+//  Fills a 4K debug text canvas (480x270 characters) with log text
+//  every frame and measures how many characters per millisecond are
+//  emitted via sdtx_printf() per line, sdtx_puts() of the whole text,
+//  and the bulk path sdtxbulk_puts() from libs/util/sdtxbulk.h.
+//
+//  Press 1, 2 or 3 to select the emission path.
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/sdtxbulk.h"
+#include <stdio.h>
+
+#define CANVAS_WIDTH (3840)
+#define CANVAS_HEIGHT (2160)
+#define NUM_COLUMNS (CANVAS_WIDTH / 8)
+#define NUM_LINES (CANVAS_HEIGHT / 8)
+#define NUM_AVG_FRAMES (60)
+
+typedef enum {
+    PATH_PRINTF,
+    PATH_PUTS,
+    PATH_BULK,
+    NUM_PATHS,
+} path_t;
+
+static const char* path_names[NUM_PATHS] = {
+    "sdtx_printf() per line",
+    "sdtx_puts()",
+    "sdtxbulk_puts()",
+};
+
+typedef struct {
+    double emit_ms;     // text emission into the vertex buffer
+    double draw_ms;     // sdtx_draw() of the 4K canvas
+    double frame_ms;
+} timings_t;
+
+static struct {
+    path_t path;
+    sdtx_context stats_ctx;
+    char lines[NUM_LINES][NUM_COLUMNS];     // each line without newline
+    char text[NUM_LINES * NUM_COLUMNS];     // all lines separated by newlines
+    int num_chars;
+    timings_t accum;
+    timings_t avg;
+    int num_frames;
+} state = {
+    .path = PATH_BULK,
+};
+
+// build some fake log output
+static void init_text(void) {
+    static const char* words[] = {
+        "[info]", "[warn]", "frame", "buffer", "update", "texture", "loaded", "shader",
+        "pipeline", "0x7F3A", "ms", "ok", "failed", "retry", "sokol", "pass", "=", "42",
+    };
+    const int num_words = (int)(sizeof(words) / sizeof(words[0]));
+    uint32_t rnd = 0x12345678;
+    char* dst = state.text;
+    for (int l = 0; l < NUM_LINES; l++) {
+        char* line = state.lines[l];
+        int len = snprintf(line, NUM_COLUMNS, "%05d ", l);
+        while (len < (NUM_COLUMNS - 1)) {
+            rnd ^= rnd<<13; rnd ^= rnd>>17; rnd ^= rnd<<5;
+            const char* w = words[rnd % (uint32_t)num_words];
+            while (*w && (len < (NUM_COLUMNS - 1))) {
+                line[len++] = *w++;
+            }
+            if (len < (NUM_COLUMNS - 1)) {
+                line[len++] = ' ';
+            }
+        }
+        line[len] = 0;
+        memcpy(dst, line, (size_t)len);
+        dst += len;
+        state.num_chars += len;
+        *dst++ = (l < (NUM_LINES - 1)) ? '\n' : 0;
+    }
+}
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .context = {
+            .char_buf_size = NUM_LINES * NUM_COLUMNS,
+        },
+        .fonts = {
+            [0] = sdtx_font_kc853(),
+            [1] = sdtx_font_oric(),
+        },
+        .logger.func = slog_func,
+    });
+    state.stats_ctx = sdtx_make_context(&(sdtx_context_desc_t){
+        .char_buf_size = 1024,
+    });
+    init_text();
+}
+
+static void frame(void) {
+    // fill the 4K canvas in the default context
+    sdtx_set_context(SDTX_DEFAULT_CONTEXT);
+    sdtx_canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+    sdtx_font(0);
+    sdtx_color3b(0x30, 0x50, 0x70);
+    uint64_t start = stm_now();
+    switch (state.path) {
+        case PATH_PRINTF:
+            for (int i = 0; i < NUM_LINES; i++) {
+                sdtx_printf("%s\n", state.lines[i]);
+            }
+            break;
+        case PATH_PUTS:
+            sdtx_puts(state.text);
+            break;
+        default:
+            sdtxbulk_puts(state.text);
+            break;
+    }
+    const double emit_ms = stm_ms(stm_since(start));
+
+    // the results go into a separate context with a readable canvas size
+    sdtx_set_context(state.stats_ctx);
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_font(1);
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_printf("%d chars per frame\n\n", state.num_chars);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("path:  %s", path_names[state.path]);
+    if (state.path == PATH_BULK) {
+        sdtx_puts(SDTXBULK_SSE2 ? " (SSE2)" : " (scalar)");
+    }
+    sdtx_puts("\n\n");
+    sdtx_printf("emit:  %.3f ms\n", state.avg.emit_ms);
+    sdtx_printf("       %.0f chars/ms\n", (state.avg.emit_ms > 0.0) ? (state.num_chars / state.avg.emit_ms) : 0.0);
+    sdtx_printf("draw:  %.3f ms\n", state.avg.draw_ms);
+    sdtx_printf("frame: %.3f ms\n\n", state.avg.frame_ms);
+    sdtx_puts("press 1..3 to select path");
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.0f, 0.0f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    sdtx_set_context(SDTX_DEFAULT_CONTEXT);
+    start = stm_now();
+    sdtx_draw();
+    const double draw_ms = stm_ms(stm_since(start));
+    sdtx_set_context(state.stats_ctx);
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+
+    state.accum.emit_ms += emit_ms;
+    state.accum.draw_ms += draw_ms;
+    state.accum.frame_ms += sapp_frame_duration() * 1000.0;
+    if (++state.num_frames == NUM_AVG_FRAMES) {
+        state.avg = (timings_t){
+            .emit_ms = state.accum.emit_ms / NUM_AVG_FRAMES,
+            .draw_ms = state.accum.draw_ms / NUM_AVG_FRAMES,
+            .frame_ms = state.accum.frame_ms / NUM_AVG_FRAMES,
+        };
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        switch (ev->key_code) {
+            case SAPP_KEYCODE_1: state.path = PATH_PRINTF; break;
+            case SAPP_KEYCODE_2: state.path = PATH_PUTS; break;
+            case SAPP_KEYCODE_3: state.path = PATH_BULK; break;
+            default: return;
+        }
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void cleanup(void) {
+    sdtx_destroy_context(state.stats_ctx);
+    sdtx_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 960,
+        .height = 540,
+        .window_title = "debugtext-perf-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
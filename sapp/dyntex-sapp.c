@@ -1,50 +1,109 @@
 //------------------------------------------------------------------------------
 //  dyntex-sapp.c
 //  Update dynamic texture with CPU-generated data each frame.
+//
+//  The texture content is a Game of Life simulation from libs/util/life.h,
+//  with one bit per cell, SIMD neighbour counting and the rows split
+//  across all CPU cores. Cells are only expanded to RGBA8 right before
+//  the texture upload.
+//
+//  1..7:       grid size from 64x64 to 4096x4096
+//  UP/DOWN:    generations per frame
+//  J:          toggle single-threaded / all threads
 //------------------------------------------------------------------------------
-#include <stdlib.h> /* rand */
+#include <stdlib.h> // malloc, free
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
+#include "util/jobs.h"
+#include "util/life.h"
 #include "dbgui/dbgui.h"
 #include "dyntex-sapp.glsl.h"
 
-#define IMAGE_WIDTH (64)
-#define IMAGE_HEIGHT (64)
+#define NUM_SIZES (7)
+#define MAX_GENS_PER_FRAME (64)
+#define NUM_AVG_FRAMES (60)
+#define RESEED_FRAMES (240)
 #define LIVING (0xFFFFFFFF)
 #define DEAD (0xFF000000)
 
+static const int grid_sizes[NUM_SIZES] = { 64, 128, 256, 512, 1024, 2048, 4096 };
+
 static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
     sg_bindings bind;
     float rx, ry;
     int update_count;
-    uint32_t pixels[IMAGE_WIDTH][IMAGE_HEIGHT];
-} state;
+    int size_index;
+    int gens_per_frame;
+    bool single_threaded;
+    life_t life;
+    uint32_t* pixels;
+    struct {
+        int num_frames;
+        double step_ms;
+        double rgba_ms;
+    } accum;
+    double step_ms;     // per generation, averaged over NUM_AVG_FRAMES
+    double rgba_ms;
+} state = {
+    .size_index = 4,
+    .gens_per_frame = 1,
+};
 
-static void game_of_life_init();
-static void game_of_life_update();
+static void reset_stats(void) {
+    state.accum.num_frames = 0;
+    state.accum.step_ms = 0.0;
+    state.accum.rgba_ms = 0.0;
+    state.step_ms = 0.0;
+    state.rgba_ms = 0.0;
+}
 
-void init(void) {
+// (re-)create the simulation, pixel buffer and streaming texture for a grid size
+static void set_grid_size(int size_index) {
+    state.size_index = size_index;
+    const int size = grid_sizes[size_index];
+    if (state.life.cur) {
+        life_discard(&state.life);
+    }
+    life_init(&state.life, size, size);
+    life_randomize(&state.life, stm_now());
+    free(state.pixels);
+    state.pixels = (uint32_t*) malloc((size_t)(size * size) * sizeof(uint32_t));
+    if (state.bind.images[IMG_tex].id != SG_INVALID_ID) {
+        sg_destroy_image(state.bind.images[IMG_tex]);
+    }
+    state.bind.images[IMG_tex] = sg_make_image(&(sg_image_desc){
+        .width = size,
+        .height = size,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .usage = SG_USAGE_STREAM,
+        .label = "dynamic-texture"
+    });
+    state.update_count = 0;
+    reset_stats();
+}
+
+static void init(void) {
+    stm_setup();
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
     });
     __dbgui_setup(sapp_sample_count());
-
-    // a 128x128 image with streaming update strategy
-    sg_image img = sg_make_image(&(sg_image_desc){
-        .width = IMAGE_WIDTH,
-        .height = IMAGE_HEIGHT,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-        .usage = SG_USAGE_STREAM,
-        .label = "dynamic-texture"
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
     });
+    jobs_setup(&(jobs_desc_t){ 0 });
 
     // a sampler object
     sg_sampler smp = sg_make_sampler(&(sg_sampler_desc){
@@ -131,15 +190,14 @@ void init(void) {
     state.bind = (sg_bindings) {
         .vertex_buffers[0] = vbuf,
         .index_buffer = ibuf,
-        .images[IMG_tex] = img,
         .samplers[SMP_smp] = smp,
     };
 
-    // initialize the game-of-life state
-    game_of_life_init();
+    // initialize the game-of-life state and the streaming texture
+    set_grid_size(state.size_index);
 }
 
-void frame(void) {
+static void frame(void) {
     // compute model-view-projection matrix
     const float t = (float)(sapp_frame_duration() * 60.0);
     hmm_mat4 proj = HMM_Perspective(60.0f, sapp_widthf()/sapp_heightf(), 0.01f, 10.0f);
@@ -152,75 +210,93 @@ void frame(void) {
     hmm_mat4 model = HMM_MultiplyMat4(rxm, rym);
     vs_params.mvp = HMM_MultiplyMat4(view_proj, model);
 
-    // update game-of-life state
-    game_of_life_update();
+    // update game-of-life state, restart with a new random state from time to time
+    if (state.update_count++ > RESEED_FRAMES) {
+        life_randomize(&state.life, stm_now());
+        state.update_count = 0;
+    }
+    const int num_jobs = state.single_threaded ? 1 : 0;
+    uint64_t start = stm_now();
+    for (int i = 0; i < state.gens_per_frame; i++) {
+        life_step(&state.life, num_jobs);
+    }
+    const double step_ms = stm_ms(stm_laptime(&start)) / state.gens_per_frame;
+    life_to_rgba(&state.life, state.pixels, LIVING, DEAD, num_jobs);
+    const double rgba_ms = stm_ms(stm_since(start));
+    state.accum.step_ms += step_ms;
+    state.accum.rgba_ms += rgba_ms;
+    if (++state.accum.num_frames == NUM_AVG_FRAMES) {
+        state.step_ms = state.accum.step_ms / NUM_AVG_FRAMES;
+        state.rgba_ms = state.accum.rgba_ms / NUM_AVG_FRAMES;
+        state.accum.num_frames = 0;
+        state.accum.step_ms = 0.0;
+        state.accum.rgba_ms = 0.0;
+    }
 
     // update the texture
-    sg_update_image(state.bind.images[0], &(sg_image_data){
-        .subimage[0][0] = SG_RANGE(state.pixels)
+    const int size = grid_sizes[state.size_index];
+    sg_update_image(state.bind.images[IMG_tex], &(sg_image_data){
+        .subimage[0][0] = { .ptr = state.pixels, .size = (size_t)(size * size) * sizeof(uint32_t) }
     });
 
+    // performance stats
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_font(0);
+    sdtx_printf("grid:   %dx%d (1..7)\n", size, size);
+    sdtx_printf("gens:   %d per frame (UP/DOWN)\n", state.gens_per_frame);
+    sdtx_printf("jobs:   %d of %d threads (J), %s\n",
+        state.single_threaded ? 1 : jobs_num_threads() + 1,
+        jobs_num_threads() + 1,
+        LIFE_SSE2 ? "SSE2" : "scalar");
+    if (state.step_ms > 0.0) {
+        sdtx_printf("step:   %.3f ms/gen\n", state.step_ms);
+        sdtx_printf("rate:   %.0f gens/s\n", 1000.0 / state.step_ms);
+        sdtx_printf("rgba:   %.3f ms", state.rgba_ms);
+    } else {
+        sdtx_puts("measuring...");
+    }
+
     // render the frame
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
     sg_apply_pipeline(state.pip);
     sg_apply_bindings(&state.bind);
     sg_apply_uniforms(UB_vs_params, &SG_RANGE(vs_params));
     sg_draw(0, 36, 1);
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
     sg_commit();
 }
 
-void cleanup(void) {
-    __dbgui_shutdown();
-    sg_shutdown();
-}
-
-void game_of_life_init() {
-    for (int y = 0; y < IMAGE_HEIGHT; y++) {
-        for (int x = 0; x < IMAGE_WIDTH; x++) {
-            if ((rand() & 255) > 230) {
-                state.pixels[y][x] = LIVING;
-            } else {
-                state.pixels[y][x] = DEAD;
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        if ((ev->key_code >= SAPP_KEYCODE_1) && (ev->key_code < (SAPP_KEYCODE_1 + NUM_SIZES))) {
+            const int size_index = (int)(ev->key_code - SAPP_KEYCODE_1);
+            if (size_index != state.size_index) {
+                set_grid_size(size_index);
             }
+        } else if ((ev->key_code == SAPP_KEYCODE_UP) && (state.gens_per_frame < MAX_GENS_PER_FRAME)) {
+            state.gens_per_frame *= 2;
+            reset_stats();
+        } else if ((ev->key_code == SAPP_KEYCODE_DOWN) && (state.gens_per_frame > 1)) {
+            state.gens_per_frame /= 2;
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_J) {
+            state.single_threaded = !state.single_threaded;
+            reset_stats();
         }
     }
+    __dbgui_event(ev);
 }
 
-void game_of_life_update() {
-    for (int y = 0; y < IMAGE_HEIGHT; y++) {
-        for (int x = 0; x < IMAGE_WIDTH; x++) {
-            int num_living_neighbours = 0;
-            for (int ny = -1; ny < 2; ny++) {
-                for (int nx = -1; nx < 2; nx++) {
-                    if ((nx == 0) && (ny == 0)) {
-                        continue;
-                    }
-                    if (state.pixels[(y+ny)&(IMAGE_HEIGHT-1)][(x+nx)&(IMAGE_WIDTH-1)] == LIVING) {
-                        num_living_neighbours++;
-                    }
-                }
-            }
-            // any live cell...
-            if (state.pixels[y][x] == LIVING) {
-                if (num_living_neighbours < 2) {
-                    /* ... with fewer than 2 living neighbours dies, as if caused by underpopulation */
-                    state.pixels[y][x] = DEAD;
-                } else if (num_living_neighbours > 3) {
-                    /* ... with more than 3 living neighbours dies, as if caused by overpopulation */
-                    state.pixels[y][x] = DEAD;
-                }
-            } else if (num_living_neighbours == 3) {
-                // any dead cell with exactly 3 living neighbours becomes a live cell, as if by reproduction
-                state.pixels[y][x] = LIVING;
-            }
-        }
-    }
-    if (state.update_count++ > 240) {
-        game_of_life_init();
-        state.update_count = 0;
-    }
+static void cleanup(void) {
+    life_discard(&state.life);
+    free(state.pixels);
+    jobs_shutdown();
+    __dbgui_shutdown();
+    sdtx_shutdown();
+    sg_shutdown();
 }
 
 sapp_desc sokol_main(int argc, char* argv[]) {
@@ -230,7 +306,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .sample_count = 4,
@@ -3,11 +3,19 @@
 //
 //  Test/demo immutable and dynamically updated 3D texture for various
 //  texture sizes.
+//
+//  The changed regions of dynamic textures are tracked with the dirty
+//  boxes from libs/util/subimage.h, and a texture is only uploaded in
+//  frames where something actually changed. The 'Window' mode streams a
+//  moving 128^3 window of a large procedural volume into a 3D texture
+//  with wrap-around addressing, so that only the slabs which enter the
+//  window need to be regenerated on the CPU.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "util/subimage.h"
 #include "dyntex3d-sapp.glsl.h"
 #include "cimgui.h"
 #define SOKOL_IMGUI_IMPL
@@ -20,27 +28,64 @@
 #define MIN_WIDTH_HEIGHT (16)
 #define MAX_WIDTH_HEIGHT (256)
 #define DEPTH (3)
+#define WINDOW_DIM (128)
+#define NUM_AVG_FRAMES (60)
 #define RED 0xFF0000FF
 #define GREEN 0xFF00FF00
 #define BLUE 0xFFFF0000
 
+enum {
+    MODE_LINES,
+    MODE_WINDOW,
+};
+
 static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
     sg_image img;
+    sg_image window_img;
     sg_bindings bind;
+    sg_sampler clamp_smp;
+    sg_sampler repeat_smp;
+    int mode;
     int width_height;
     bool immutable;
+    bool recreate;      // image uploads are not allowed inside a pass, so UI changes are deferred
+    bool skip_clean;    // only upload in frames where something changed
+    bool upload_all;    // the lines image was recreated and needs its initial content
+    subimage_dirty_t dirty;
+    int line_pos[DEPTH];
+    struct {
+        bool valid;
+        float speed;            // in voxels per frame
+        float pos[3];
+        int origin[3];          // current window origin in the volume
+    } window;
+    struct {
+        size_t bytes;           // uploaded in the last frame
+        size_t dirty_bytes;     // modified in the last frame
+        size_t accum_bytes;
+        size_t accum_dirty_bytes;
+        int accum_frames;
+        double avg_bytes;       // averaged over NUM_AVG_FRAMES
+        double avg_dirty_bytes;
+    } stats;
     sgimgui_t sgimgui;
 } state = {
+    .mode = MODE_LINES,
     .width_height = 16,
     .immutable = false,
+    .skip_clean = true,
+    .window.speed = 0.5f,
 };
 
 static uint32_t pixels[DEPTH * MAX_WIDTH_HEIGHT * MAX_WIDTH_HEIGHT];
+static uint32_t window_pixels[WINDOW_DIM * WINDOW_DIM * WINDOW_DIM];
 
 static void recreate_image(void);
 static void update_pixels(uint64_t frame_count);
+static void update_lines(uint64_t frame_count);
+static void update_window(void);
 static void draw_ui(void);
 static sg_range pixels_as_range(void);
 
@@ -69,28 +114,78 @@ static void init(void) {
     });
 
     state.img = sg_alloc_image();
-    state.bind.images[IMG_tex] = state.img;
     recreate_image();
 
-    state.bind.samplers[SMP_smp] = sg_make_sampler(&(sg_sampler_desc){
+    // the streaming window, content is uploaded on the first frame
+    state.window_img = sg_make_image(&(sg_image_desc){
+        .type = SG_IMAGETYPE_3D,
+        .usage = SG_USAGE_STREAM,
+        .width = WINDOW_DIM,
+        .height = WINDOW_DIM,
+        .num_slices = WINDOW_DIM,
+        .num_mipmaps = 1,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .label = "volume-window",
+    });
+
+    state.clamp_smp = sg_make_sampler(&(sg_sampler_desc){
         .min_filter = SG_FILTER_NEAREST,
         .mag_filter = SG_FILTER_NEAREST,
         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
         .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
         .wrap_w = SG_WRAP_CLAMP_TO_EDGE,
     });
+    // repeat-wrapping for the wrap-around window addressing
+    state.repeat_smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_REPEAT,
+        .wrap_v = SG_WRAP_REPEAT,
+        .wrap_w = SG_WRAP_REPEAT,
+    });
 }
 
 static void frame(void) {
-    if (!state.immutable) {
-        update_pixels(sapp_frame_count());
-        sg_update_image(state.img, &(sg_image_data){ .subimage[0][0] = pixels_as_range() });
+    if (state.recreate) {
+        state.recreate = false;
+        recreate_image();
+    }
+    state.stats.bytes = 0;
+    state.stats.dirty_bytes = 0;
+    subimage_dirty_clear(&state.dirty);
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+    if (state.mode == MODE_LINES) {
+        if (!state.immutable) {
+            update_lines(sapp_frame_count());
+        }
+        state.bind.images[IMG_tex] = state.img;
+        state.bind.samplers[SMP_smp] = state.clamp_smp;
+    } else {
+        update_window();
+        for (int i = 0; i < 3; i++) {
+            offset[i] = (float)(state.window.origin[i] & (WINDOW_DIM - 1)) / WINDOW_DIM;
+        }
+        state.bind.images[IMG_tex] = state.window_img;
+        state.bind.samplers[SMP_smp] = state.repeat_smp;
+    }
+    state.stats.accum_bytes += state.stats.bytes;
+    state.stats.accum_dirty_bytes += state.stats.dirty_bytes;
+    if (++state.stats.accum_frames == NUM_AVG_FRAMES) {
+        state.stats.avg_bytes = (double)state.stats.accum_bytes / NUM_AVG_FRAMES;
+        state.stats.avg_dirty_bytes = (double)state.stats.accum_dirty_bytes / NUM_AVG_FRAMES;
+        state.stats.accum_bytes = 0;
+        state.stats.accum_dirty_bytes = 0;
+        state.stats.accum_frames = 0;
     }
+
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
     sg_apply_pipeline(state.pip);
     sg_apply_bindings(&state.bind);
     for (int slice = 0; slice < 3; slice++) {
-        const vs_params_t vs_params = (vs_params_t){ .w = 0.1f + ((float)slice) / 3.0 };
+        const vs_params_t vs_params = (vs_params_t){
+            .offset = { offset[0], offset[1], offset[2] },
+            .w = 0.1f + ((float)slice) / 3.0f,
+        };
         sg_apply_uniforms(UB_vs_params, &SG_RANGE(vs_params));
         sg_draw(0, 6, 1);
     }
@@ -124,12 +219,28 @@ static void draw_ui(void) {
     igSetNextWindowSize((ImVec2){220, 150}, ImGuiCond_Once);
     igSetNextWindowBgAlpha(0.35f);
     if (igBegin("Controls", 0, ImGuiWindowFlags_NoDecoration|ImGuiWindowFlags_AlwaysAutoResize)) {
-        if (igSliderIntEx("Size", &state.width_height, MIN_WIDTH_HEIGHT, MAX_WIDTH_HEIGHT, "%d", ImGuiSliderFlags_Logarithmic)) {
-            recreate_image();
+        igRadioButtonIntPtr("Lines", &state.mode, MODE_LINES);
+        igSameLine();
+        if (igRadioButtonIntPtr("Window", &state.mode, MODE_WINDOW)) {
+            state.window.valid = false;
         }
-        if (igCheckbox("Immutable", &state.immutable)) {
-            recreate_image();
+        if (state.mode == MODE_LINES) {
+            if (igSliderIntEx("Size", &state.width_height, MIN_WIDTH_HEIGHT, MAX_WIDTH_HEIGHT, "%d", ImGuiSliderFlags_Logarithmic)) {
+                state.recreate = true;
+            }
+            if (igCheckbox("Immutable", &state.immutable)) {
+                state.recreate = true;
+            }
+        } else {
+            igSliderFloat("Speed", &state.window.speed, 0.0f, 8.0f);
+            igText("Origin: %d %d %d", state.window.origin[0], state.window.origin[1], state.window.origin[2]);
         }
+        igCheckbox("Skip clean frames", &state.skip_clean);
+        const size_t full_bytes = (state.mode == MODE_LINES) ? pixels_as_range().size : sizeof(window_pixels);
+        igText("Image:    %.1f KB", (double)full_bytes / 1024.0);
+        igText("Modified: %.1f KB/frame", state.stats.avg_dirty_bytes / 1024.0);
+        igText("Uploaded: %.1f KB/frame", state.stats.avg_bytes / 1024.0);
+        igText("Boxes:    %d", state.dirty.num_boxes);
     }
     igEnd();
     sgimgui_draw(&state.sgimgui);
@@ -143,6 +254,10 @@ static sg_range pixels_as_range(void) {
     };
 }
 
+static subimage_box_t full_box(void) {
+    return (subimage_box_t){ 0, 0, 0, state.width_height, state.width_height, DEPTH };
+}
+
 static void recreate_image(void) {
     if (sg_query_image_state(state.img) == SG_RESOURCESTATE_VALID) {
         sg_uninit_image(state.img);
@@ -158,6 +273,9 @@ static void recreate_image(void) {
         .pixel_format = SG_PIXELFORMAT_RGBA8,
         .data.subimage[0][0] = state.immutable ? pixels_as_range() : (sg_range){0},
     });
+    // a dynamic image gets its initial content with the next update_lines(),
+    // sg_update_image() may only be called once per frame
+    state.upload_all = !state.immutable;
 }
 
 // put these into macros instead of functions so we don't get an unused warning in release mode
@@ -192,26 +310,145 @@ static void border(int offset, int z, uint32_t color) {
     vert_line(wh - 1 - offset, offset, z, wh - 2 * offset, color);
 }
 
+// position of the moving horizontal and vertical line in a slice
+static int line_pos(uint64_t frame_count, int i) {
+    const int wh = state.width_height;
+    return (int)((frame_count / 8) % (uint64_t)(wh - 2 * i)) + i;
+}
+
 static void update_pixels(uint64_t frame_count) {
     memset(pixels, 0, sizeof(pixels));
     static const uint32_t colors[3] = { RED, GREEN, BLUE };
     const int wh = state.width_height;
     for (int i = 0; i < DEPTH; i++) {
         border(i, i, colors[i]);
-        int z = i;
-        {
-            int x = i;
-            int len = wh - 2 * i;
-            int y = ((int)((frame_count / 8) % (uint64_t)(wh - 2 * i)) + i);
-            hori_line(x, y, z, len, colors[i]);
+        const int pos = line_pos(frame_count, i);
+        hori_line(i, pos, i, wh - 2 * i, colors[i]);
+        vert_line(pos, i, i, wh - 2 * i, colors[i]);
+        state.line_pos[i] = pos;
+    }
+}
+
+// redraw the lines and mark the rows and columns dirty where a line moved away or to
+static void update_lines(uint64_t frame_count) {
+    const int wh = state.width_height;
+    subimage_dirty_clear(&state.dirty);
+    for (int i = 0; i < DEPTH; i++) {
+        const int old_pos = state.line_pos[i];
+        const int new_pos = line_pos(frame_count, i);
+        if (old_pos != new_pos) {
+            subimage_dirty_add(&state.dirty, (subimage_box_t){ i, old_pos, i, wh - 2 * i, 1, 1 });
+            subimage_dirty_add(&state.dirty, (subimage_box_t){ i, new_pos, i, wh - 2 * i, 1, 1 });
+            subimage_dirty_add(&state.dirty, (subimage_box_t){ old_pos, i, i, 1, wh - 2 * i, 1 });
+            subimage_dirty_add(&state.dirty, (subimage_box_t){ new_pos, i, i, 1, wh - 2 * i, 1 });
+        }
+    }
+    if (state.upload_all) {
+        state.upload_all = false;
+        subimage_dirty_add(&state.dirty, full_box());
+    }
+    update_pixels(frame_count);
+    state.stats.dirty_bytes = (size_t)subimage_dirty_volume(&state.dirty) * sizeof(uint32_t);
+    if (!state.skip_clean) {
+        subimage_dirty_add(&state.dirty, full_box());
+    }
+    state.stats.bytes = subimage_update_dirty(state.img, &state.dirty, pixels_as_range());
+}
+
+// the 'large volume': 16^3 blocks with random colors, about one in 4 blocks
+// is solid, and a grid of gray lines, generated on demand for any position
+static uint32_t volume_voxel(int x, int y, int z) {
+    if (((x & 15) == 0) && ((y & 15) == 0)) {
+        return 0xFF808080;
+    }
+    uint32_t h = (uint32_t)(x >> 4) * 0x8DA6B343u ^ (uint32_t)(y >> 4) * 0xD8163841u ^ (uint32_t)(z >> 4) * 0xCB1AB31Fu;
+    h ^= h >> 13;
+    h *= 0x5BD1E995u;
+    h ^= h >> 15;
+    return ((h & 3) == 0) ? (0xFF000000 | (h >> 8)) : 0;
+}
+
+// split a range of volume coordinates into at most 2 ranges of wrapped texture coordinates
+static int wrap_range(int start, int len, int out_start[2], int out_len[2]) {
+    const int tex_start = start & (WINDOW_DIM - 1);
+    if ((tex_start + len) <= WINDOW_DIM) {
+        out_start[0] = tex_start;
+        out_len[0] = len;
+        return 1;
+    }
+    out_start[0] = tex_start;
+    out_len[0] = WINDOW_DIM - tex_start;
+    out_start[1] = 0;
+    out_len[1] = len - out_len[0];
+    return 2;
+}
+
+// generate a box of the volume into the window texture, and mark it dirty
+static void fill_window_box(int x0, int y0, int z0, int w, int h, int d) {
+    assert((w <= WINDOW_DIM) && (h <= WINDOW_DIM) && (d <= WINDOW_DIM));
+    for (int z = z0; z < (z0 + d); z++) {
+        for (int y = y0; y < (y0 + h); y++) {
+            uint32_t* dst = &window_pixels[((z & (WINDOW_DIM - 1)) * WINDOW_DIM + (y & (WINDOW_DIM - 1))) * WINDOW_DIM];
+            for (int x = x0; x < (x0 + w); x++) {
+                dst[x & (WINDOW_DIM - 1)] = volume_voxel(x, y, z);
+            }
+        }
+    }
+    int xs[2], xl[2], ys[2], yl[2], zs[2], zl[2];
+    const int nx = wrap_range(x0, w, xs, xl);
+    const int ny = wrap_range(y0, h, ys, yl);
+    const int nz = wrap_range(z0, d, zs, zl);
+    for (int iz = 0; iz < nz; iz++) {
+        for (int iy = 0; iy < ny; iy++) {
+            for (int ix = 0; ix < nx; ix++) {
+                subimage_dirty_add(&state.dirty, (subimage_box_t){ xs[ix], ys[iy], zs[iz], xl[ix], yl[iy], zl[iz] });
+            }
+        }
+    }
+}
+
+// move the window through the volume and regenerate the slabs which entered the window
+static void update_window(void) {
+    static const float dir[3] = { 1.0f, 0.5f, 0.25f };
+    int origin[3];
+    for (int i = 0; i < 3; i++) {
+        state.window.pos[i] += dir[i] * state.window.speed;
+        origin[i] = (int)state.window.pos[i];
+    }
+    subimage_dirty_clear(&state.dirty);
+    const int* old = state.window.origin;
+    bool refill = !state.window.valid;
+    for (int i = 0; i < 3; i++) {
+        const int delta = origin[i] - old[i];
+        if ((delta >= WINDOW_DIM) || (delta <= -WINDOW_DIM)) {
+            refill = true;
         }
-        {
-            int y = i;
-            int len = wh - 2 * i;
-            int x = ((int)((frame_count / 8) % (uint64_t)(wh - 2 * i)) + i);
-            vert_line(x, y, z, len, colors[i]);
+    }
+    if (refill) {
+        fill_window_box(origin[0], origin[1], origin[2], WINDOW_DIM, WINDOW_DIM, WINDOW_DIM);
+        state.window.valid = true;
+    } else {
+        for (int axis = 0; axis < 3; axis++) {
+            const int delta = origin[axis] - old[axis];
+            if (delta == 0) {
+                continue;
+            }
+            // the new window, reduced to the slab which wasn't part of the old window
+            int start[3] = { origin[0], origin[1], origin[2] };
+            int size[3] = { WINDOW_DIM, WINDOW_DIM, WINDOW_DIM };
+            start[axis] = (delta > 0) ? (old[axis] + WINDOW_DIM) : origin[axis];
+            size[axis] = (delta > 0) ? delta : -delta;
+            fill_window_box(start[0], start[1], start[2], size[0], size[1], size[2]);
         }
     }
+    for (int i = 0; i < 3; i++) {
+        state.window.origin[i] = origin[i];
+    }
+    state.stats.dirty_bytes = (size_t)subimage_dirty_volume(&state.dirty) * sizeof(uint32_t);
+    if (!state.skip_clean) {
+        subimage_dirty_add(&state.dirty, (subimage_box_t){ 0, 0, 0, WINDOW_DIM, WINDOW_DIM, WINDOW_DIM });
+    }
+    state.stats.bytes = subimage_update_dirty(state.window_img, &state.dirty, SG_RANGE(window_pixels));
 }
 
 sapp_desc sokol_main(int argc, char* argv[]) {
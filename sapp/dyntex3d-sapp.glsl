@@ -5,6 +5,7 @@
 
 @vs vs
 layout(binding=0) uniform vs_params {
+    vec3 offset;
     float w;
 };
 
@@ -16,7 +17,7 @@ out vec3 uvw;
 void main() {
     int idx = indices[gl_VertexIndex];
     gl_Position = vec4(vertices[idx] - 0.5, 0.5, 1.0);
-    uvw = vec3(vertices[idx], w);
+    uvw = vec3(vertices[idx], w) + offset;
 }
 @end
 
@@ -1,6 +1,9 @@
 //------------------------------------------------------------------------------
 //  fontstash-layers.c
 //  Demomstrates layered rendering with sokol_fontstash.h
+//
+//  Press G to switch to the glyph cache in libs/util/glyphcache.h, which
+//  only uploads the dirty rectangle of the glyph atlas.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -25,6 +28,7 @@
 #endif
 #define SOKOL_FONTSTASH_IMPL
 #include "sokol_fontstash.h"
+#include "util/glyphcache.h"
 #include "dbgui/dbgui.h"
 #include "util/fileutil.h"
 #include "fontstash-layers-sapp.glsl.h"
@@ -33,7 +37,9 @@ static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
     sg_bindings bind;
-    FONScontext* fons;
+    FONScontext* fons;      // the active one of sfons and gcache
+    FONScontext* sfons;
+    FONScontext* gcache;
     int font;
     uint8_t font_data[256 * 1024];
 } state;
@@ -50,7 +56,12 @@ static int round_pow2(float v) {
 // sokol-fetch callback for TTF font data
 static void font_loaded(const sfetch_response_t* response) {
     if (response->fetched) {
-        state.font = fonsAddFontMem(state.fons, "sans", (void*)response->data.ptr, (int)response->data.size, false);
+        // the font index is the same in both contexts
+        state.font = fonsAddFontMem(state.sfons, "sans", (void*)response->data.ptr, (int)response->data.size, false);
+        fonsAddFontMem(state.gcache, "sans", (void*)response->data.ptr, (int)response->data.size, false);
+        // rasterize all glyphs into the atlases upfront, so each atlas is only uploaded once
+        gcache_prewarm(state.sfons, state.font, 124.0f * sapp_dpi_scale(), 0.0f, "BackgroundForeground");
+        gcache_prewarm(state.gcache, state.font, 124.0f * sapp_dpi_scale(), 0.0f, "BackgroundForeground");
     }
 }
 
@@ -71,7 +82,9 @@ static void init(void) {
 
     // make sure fontstash atlas width/height is pow 2
     const int atlas_dim = round_pow2(512.0f * sapp_dpi_scale());
-    state.fons = sfons_create(&(sfons_desc_t){ .width = atlas_dim, .height = atlas_dim });
+    state.sfons = sfons_create(&(sfons_desc_t){ .width = atlas_dim, .height = atlas_dim });
+    state.gcache = gcache_create(&(gcache_desc_t){ .width = atlas_dim, .height = atlas_dim, .mode = GCACHE_UPLOAD_DIRTY });
+    state.fons = state.sfons;
     state.font = FONS_INVALID;
 
     // use sokol-fetch to load TTF font file
@@ -159,7 +172,11 @@ static void frame(void) {
             fonsDrawText(fs, x, y, text, 0);
         }
     }
-    sfons_flush(fs);
+    if (fs == state.gcache) {
+        gcache_flush(fs);
+    } else {
+        sfons_flush(fs);
+    }
 
     // sokol-gfx render pass
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
@@ -180,10 +197,18 @@ static void frame(void) {
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_G)) {
+        state.fons = (state.fons == state.sfons) ? state.gcache : state.sfons;
+    }
+    __dbgui_event(ev);
+}
+
 static void cleanup(void) {
     __dbgui_shutdown();
     sfetch_shutdown();
-    sfons_destroy(state.fons);
+    gcache_destroy(state.gcache);
+    sfons_destroy(state.sfons);
     sgl_shutdown();
     sg_shutdown();
 }
@@ -194,7 +219,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .high_dpi = true,
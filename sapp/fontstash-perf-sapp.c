@@ -0,0 +1,380 @@
+//------------------------------------------------------------------------------
+//  fontstash-perf-sapp.c
+//
+//  Renders 100k glyphs per frame via fontstash and measures the CPU time
+//  spent in text layout and atlas updates, comparing sokol_fontstash.h
+//  against the glyph cache in libs/util/glyphcache.h, once uploading
+//  the whole atlas on each change, and once only the dirty rectangle.
+//
+//  Keys:
+//      1, 2, 3:    select renderer
+//      C:          toggle glyph churn (rasterize a few new glyphs each frame)
+//      P:          toggle pre-warming the glyph set after an atlas reset
+//      R:          reset the glyph atlas
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_fetch.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_GL_IMPL
+#include "sokol_gl.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include <stdio.h>  // needed by fontstash's IO functions even though they are not used
+#define FONTSTASH_IMPLEMENTATION
+#if defined(_MSC_VER )
+#pragma warning(disable:4996)   // strncpy use in fontstash.h
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#endif
+#include "fontstash/fontstash.h"
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#define SOKOL_FONTSTASH_IMPL
+#include "sokol_fontstash.h"
+#include "util/glyphcache.h"
+#include "util/fileutil.h"
+
+#define NUM_GLYPHS (100000)
+#define NUM_AVG_FRAMES (60)
+#define FONT_SIZE (10.0f)
+#define CHURN_TEXT "0123456789"
+
+typedef enum {
+    RENDERER_SFONS,
+    RENDERER_GCACHE_FULL,
+    RENDERER_GCACHE_DIRTY,
+    NUM_RENDERERS,
+} renderer_t;
+
+// one fontstash context per renderer implementation
+typedef enum {
+    STASH_SFONS,
+    STASH_GCACHE,
+    NUM_STASHES,
+} stash_t;
+
+typedef struct {
+    double text_ms;
+    double flush_ms;
+    size_t upload_bytes;
+    int num_uploads;
+    int num_frames;
+} timings_t;
+
+static const char* renderer_names[NUM_RENDERERS] = {
+    "sokol_fontstash.h",
+    "glyphcache (full upload)",
+    "glyphcache (dirty rect)",
+};
+
+static const char* bench_text =
+    "The quick brown fox jumps over the lazy dog. 0123456789 "
+    "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG! ";
+
+static const char* prewarm_glyphs =
+    " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+static struct {
+    renderer_t renderer;
+    bool churn;
+    bool prewarm;
+    bool reset_requested;
+    int atlas_dim;
+    float dpi_scale;
+    uint64_t frame_count;
+    FONScontext* fons[NUM_STASHES];
+    int font[NUM_STASHES];
+    bool atlas_full[NUM_STASHES];
+    int num_glyphs;
+    double reset_ms;            // atlas reset (+ pre-warming)
+    double first_frame_ms;      // text layout in the first frame after a reset
+    bool measure_first_frame;
+    timings_t accum;
+    timings_t avg;
+    uint8_t font_data[256 * 1024];
+} state = {
+    .renderer = RENDERER_GCACHE_DIRTY,
+    .prewarm = true,
+};
+
+// round to next power of 2 (see bit-twiddling-hacks)
+static int round_pow2(float v) {
+    uint32_t vi = ((uint32_t) v) - 1;
+    for (uint32_t i = 0; i < 5; i++) {
+        vi |= (vi >> (1<<i));
+    }
+    return (int) (vi + 1);
+}
+
+static stash_t current_stash(void) {
+    return (state.renderer == RENDERER_SFONS) ? STASH_SFONS : STASH_GCACHE;
+}
+
+static void prewarm(stash_t stash) {
+    if (state.prewarm && (state.font[stash] != FONS_INVALID)) {
+        gcache_prewarm(state.fons[stash], state.font[stash], FONT_SIZE * state.dpi_scale, 0.0f, prewarm_glyphs);
+    }
+}
+
+static void font_loaded(const sfetch_response_t* response) {
+    if (response->fetched) {
+        for (int i = 0; i < NUM_STASHES; i++) {
+            state.font[i] = fonsAddFontMem(state.fons[i], "sans", (void*)response->data.ptr, (int)response->data.size, false);
+            prewarm((stash_t)i);
+        }
+    }
+}
+
+// fontstash error callback, the atlas will be reset at the start of the next frame
+static void atlas_error(void* uptr, int error, int val) {
+    (void)val;
+    if (error == FONS_ATLAS_FULL) {
+        state.atlas_full[(intptr_t)uptr] = true;
+    }
+}
+
+static void init(void) {
+    state.dpi_scale = sapp_dpi_scale();
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sgl_setup(&(sgl_desc_t){
+        .max_vertices = NUM_GLYPHS * 6 + 1024,
+        .max_commands = 16 * 1024,
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    sfetch_setup(&(sfetch_desc_t){
+        .num_channels = 1,
+        .num_lanes = 1,
+        .logger.func = slog_func,
+    });
+
+    state.atlas_dim = round_pow2(512.0f * state.dpi_scale);
+    state.fons[STASH_SFONS] = sfons_create(&(sfons_desc_t){
+        .width = state.atlas_dim,
+        .height = state.atlas_dim,
+    });
+    state.fons[STASH_GCACHE] = gcache_create(&(gcache_desc_t){
+        .width = state.atlas_dim,
+        .height = state.atlas_dim,
+        .mode = GCACHE_UPLOAD_DIRTY,
+    });
+    for (int i = 0; i < NUM_STASHES; i++) {
+        state.font[i] = FONS_INVALID;
+        fonsSetErrorCallback(state.fons[i], atlas_error, (void*)(intptr_t)i);
+    }
+
+    char path_buf[512];
+    sfetch_send(&(sfetch_request_t){
+        .path = fileutil_get_path("DroidSerif-Regular.ttf", path_buf, sizeof(path_buf)),
+        .callback = font_loaded,
+        .buffer = SFETCH_RANGE(state.font_data),
+    });
+}
+
+static void reset_atlas(stash_t stash) {
+    const uint64_t start = stm_now();
+    fonsResetAtlas(state.fons[stash], state.atlas_dim, state.atlas_dim);
+    prewarm(stash);
+    state.reset_ms = stm_ms(stm_since(start));
+    state.atlas_full[stash] = false;
+    state.measure_first_frame = true;
+}
+
+static int draw_text(FONScontext* fs, int font) {
+    const float dpis = state.dpi_scale;
+    const float disp_w = sapp_widthf();
+    const float disp_h = sapp_heightf();
+    fonsClearState(fs);
+    fonsSetFont(fs, font);
+    fonsSetSize(fs, FONT_SIZE * dpis);
+    fonsSetAlign(fs, FONS_ALIGN_LEFT | FONS_ALIGN_TOP);
+    float lh = 0.0f;
+    fonsVertMetrics(fs, 0, 0, &lh);
+    const int text_len = (int)strlen(bench_text);
+    const uint32_t colors[4] = {
+        sfons_rgba(255, 255, 255, 96),
+        sfons_rgba(255, 200, 0, 96),
+        sfons_rgba(0, 200, 255, 96),
+        sfons_rgba(128, 255, 128, 96),
+    };
+    // draw the text in columns over the whole window until the glyph budget is used up
+    int num_glyphs = 0;
+    int line = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    while (num_glyphs < NUM_GLYPHS) {
+        fonsSetColor(fs, colors[line & 3]);
+        fonsDrawText(fs, x, y, bench_text, 0);
+        num_glyphs += text_len;
+        line++;
+        y += lh;
+        if (y > disp_h) {
+            y = 0.0f;
+            x += 7.0f * dpis;
+            if (x > disp_w) {
+                x = 0.0f;
+            }
+        }
+    }
+    if (state.churn) {
+        // a new font size every frame means new glyphs for the atlas
+        fonsSetColor(fs, sfons_rgba(255, 64, 64, 255));
+        fonsSetSize(fs, (12.0f + (float)(state.frame_count % 400) * 0.1f) * dpis);
+        fonsDrawText(fs, 16.0f * dpis, disp_h - 48.0f * dpis, CHURN_TEXT, 0);
+        num_glyphs += (int)strlen(CHURN_TEXT);
+    }
+    return num_glyphs;
+}
+
+static void print_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    for (int i = 0; i < NUM_RENDERERS; i++) {
+        if (i == (int)state.renderer) {
+            sdtx_color3b(0xFF, 0xCC, 0x00);
+        } else {
+            sdtx_color3b(0xAA, 0xAA, 0xAA);
+        }
+        sdtx_printf("%d: %s\n", i + 1, renderer_names[i]);
+    }
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("\nC: churn   %s\n", state.churn ? "ON" : "OFF");
+    sdtx_printf("P: prewarm %s\n", state.prewarm ? "ON" : "OFF");
+    sdtx_printf("R: reset atlas\n\n");
+    const timings_t* t = &state.avg;
+    sdtx_color3b(0x00, 0xFF, 0x00);
+    sdtx_printf("glyphs:      %d\n", state.num_glyphs);
+    sdtx_printf("layout:      %.3f ms\n", t->text_ms);
+    sdtx_printf("flush:       %.3f ms\n", t->flush_ms);
+    sdtx_printf("glyphs/ms:   %.0f\n", (t->text_ms > 0.0) ? (state.num_glyphs / t->text_ms) : 0.0);
+    if (state.renderer == RENDERER_SFONS) {
+        sdtx_printf("uploads:     n/a\n");
+    } else {
+        sdtx_printf("uploads:     %d/%d frames, %.1f KB/frame\n",
+            t->num_uploads, NUM_AVG_FRAMES, (double)t->upload_bytes / 1024.0);
+    }
+    sdtx_printf("\nlast reset:  %.3f ms\n", state.reset_ms);
+    sdtx_printf("first frame: %.3f ms\n", state.first_frame_ms);
+}
+
+static void frame(void) {
+    sfetch_dowork();
+
+    const stash_t stash = current_stash();
+    FONScontext* fs = state.fons[stash];
+    if (stash == STASH_GCACHE) {
+        gcache_set_mode(fs, (state.renderer == RENDERER_GCACHE_FULL) ? GCACHE_UPLOAD_FULL : GCACHE_UPLOAD_DIRTY);
+    }
+    if (state.reset_requested || state.atlas_full[stash]) {
+        state.reset_requested = false;
+        reset_atlas(stash);
+    }
+
+    sgl_defaults();
+    sgl_matrix_mode_projection();
+    sgl_ortho(0.0f, sapp_widthf(), sapp_heightf(), 0.0f, -1.0f, +1.0f);
+
+    // measure text layout (including rasterizing new glyphs) and atlas update separately
+    uint64_t start = stm_now();
+    if (state.font[stash] != FONS_INVALID) {
+        state.num_glyphs = draw_text(fs, state.font[stash]);
+    }
+    const double text_ms = stm_ms(stm_since(start));
+    start = stm_now();
+    if (stash == STASH_SFONS) {
+        sfons_flush(fs);
+    } else {
+        gcache_flush(fs);
+    }
+    const double flush_ms = stm_ms(stm_since(start));
+    if (state.measure_first_frame) {
+        state.measure_first_frame = false;
+        state.first_frame_ms = text_ms;
+    }
+
+    state.accum.text_ms += text_ms;
+    state.accum.flush_ms += flush_ms;
+    if (stash == STASH_GCACHE) {
+        const gcache_stats_t stats = gcache_query_stats(fs);
+        state.accum.num_uploads += stats.num_uploads;
+        state.accum.upload_bytes += stats.upload_bytes;
+    }
+    if (++state.accum.num_frames == NUM_AVG_FRAMES) {
+        state.avg = (timings_t){
+            .text_ms = state.accum.text_ms / NUM_AVG_FRAMES,
+            .flush_ms = state.accum.flush_ms / NUM_AVG_FRAMES,
+            .upload_bytes = state.accum.upload_bytes / NUM_AVG_FRAMES,
+            .num_uploads = state.accum.num_uploads,
+            .num_frames = NUM_AVG_FRAMES,
+        };
+        state.accum = (timings_t){0};
+    }
+    state.frame_count++;
+
+    print_stats();
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.1f, 0.1f, 0.12f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    sgl_draw();
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if (ev->type != SAPP_EVENTTYPE_KEY_DOWN) {
+        return;
+    }
+    switch (ev->key_code) {
+        case SAPP_KEYCODE_1: state.renderer = RENDERER_SFONS; break;
+        case SAPP_KEYCODE_2: state.renderer = RENDERER_GCACHE_FULL; break;
+        case SAPP_KEYCODE_3: state.renderer = RENDERER_GCACHE_DIRTY; break;
+        case SAPP_KEYCODE_C: state.churn = !state.churn; break;
+        case SAPP_KEYCODE_P: state.prewarm = !state.prewarm; break;
+        case SAPP_KEYCODE_R: state.reset_requested = true; break;
+        default: return;
+    }
+    state.accum = (timings_t){0};
+}
+
+static void cleanup(void) {
+    sfetch_shutdown();
+    gcache_destroy(state.fons[STASH_GCACHE]);
+    sfons_destroy(state.fons[STASH_SFONS]);
+    sdtx_shutdown();
+    sgl_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 1024,
+        .height = 768,
+        .high_dpi = true,
+        .window_title = "fontstash-perf-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
@@ -2,6 +2,10 @@
 //  fontstash-sapp.c
 //
 //  Text rendering via fontstash, stb_truetype and sokol_fontstash.h
+//
+//  Press G to switch to the glyph cache in libs/util/glyphcache.h, which
+//  only uploads the dirty rectangle of the glyph atlas instead of the
+//  whole atlas. The glyphs are rasterized upfront with gcache_prewarm().
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -26,11 +30,14 @@
 #endif
 #define SOKOL_FONTSTASH_IMPL
 #include "sokol_fontstash.h"
+#include "util/glyphcache.h"
 #include "dbgui/dbgui.h"
 #include "util/fileutil.h"
 
 typedef struct {
-    FONScontext* fons;
+    FONScontext* fons;      // the active one of sfons and gcache
+    FONScontext* sfons;
+    FONScontext* gcache;
     float dpi_scale;
     int font_normal;
     int font_italic;
@@ -54,28 +61,56 @@ static void my_free(void* ptr, void* user_data) {
     free(ptr);
 }
 
+// add a font to both fontstash contexts, the font index is the same in
+// both since fonts are always added to both in the same order
+static int add_font(const char* name, const sfetch_response_t* response) {
+    const int font = fonsAddFontMem(state.sfons, name, (void*)response->data.ptr, (int)response->data.size, false);
+    fonsAddFontMem(state.gcache, name, (void*)response->data.ptr, (int)response->data.size, false);
+    return font;
+}
+
+// rasterize the glyphs of a string into both font atlases right after
+// loading, so that all glyphs are added in a single atlas update
+static void prewarm_glyphs(int font, float size, float blur, const char* text) {
+    gcache_prewarm(state.sfons, font, size * state.dpi_scale, blur, text);
+    gcache_prewarm(state.gcache, font, size * state.dpi_scale, blur, text);
+}
+
 // sokol-fetch load callbacks
 static void font_normal_loaded(const sfetch_response_t* response) {
     if (response->fetched) {
-        state.font_normal = fonsAddFontMem(state.fons, "sans", (void*)response->data.ptr, (int)response->data.size,  false);
+        state.font_normal = add_font("sans", response);
+        prewarm_glyphs(state.font_normal, 124.0f, 0.0f, "The quick ");
+        prewarm_glyphs(state.font_normal, 24.0f, 0.0f, "fox dog.");
+        prewarm_glyphs(state.font_normal, 12.0f, 0.0f, "Now is the time for all good men to come to the aid of the party.");
+        prewarm_glyphs(state.font_normal, 18.0f, 0.0f, "TopMiddleBaselineBottomLeftCenterRight");
+        prewarm_glyphs(state.font_normal, 14.0f, 0.0f, "G: sokol_fontstash.h (full atlas) glyph cache (dirty rect), uploads KB 0123456789");
     }
 }
 
 static void font_italic_loaded(const sfetch_response_t* response) {
     if (response->fetched) {
-        state.font_italic = fonsAddFontMem(state.fons, "sans-italic", (void*)response->data.ptr, (int)response->data.size, false);
+        state.font_italic = add_font("sans-italic", response);
+        prewarm_glyphs(state.font_italic, 48.0f, 0.0f, "brown ");
+        prewarm_glyphs(state.font_italic, 24.0f, 0.0f, "jumps over ");
+        prewarm_glyphs(state.font_italic, 18.0f, 0.0f, "Ég get etið gler án þess að meiða mig.");
+        prewarm_glyphs(state.font_italic, 60.0f, 10.0f, "Blurry...");
     }
 }
 
 static void font_bold_loaded(const sfetch_response_t* response) {
     if (response->fetched) {
-        state.font_bold = fonsAddFontMem(state.fons, "sans-bold", (void*)response->data.ptr, (int)response->data.size, false);
+        state.font_bold = add_font("sans-bold", response);
+        prewarm_glyphs(state.font_bold, 24.0f, 0.0f, "the lazy ");
+        prewarm_glyphs(state.font_bold, 18.0f, 3.0f, "DROP THAT SHADOW");
+        prewarm_glyphs(state.font_bold, 18.0f, 0.0f, "DROP THAT SHADOW");
     }
 }
 
 static void font_japanese_loaded(const sfetch_response_t* response) {
     if (response->fetched) {
-        state.font_japanese = fonsAddFontMem(state.fons, "sans-japanese", (void*)response->data.ptr, (int)response->data.size, false);
+        state.font_japanese = add_font("sans-japanese", response);
+        prewarm_glyphs(state.font_japanese, 18.0f, 0.0f, "私はガラスを食べられます。それは私を傷つけません。");
     }
 }
 
@@ -110,7 +145,13 @@ static void init(void) {
             .free_fn = my_free,
         }
     });
-    state.fons = fons_context;
+    state.sfons = fons_context;
+    state.gcache = gcache_create(&(gcache_desc_t){
+        .width = atlas_dim,
+        .height = atlas_dim,
+        .mode = GCACHE_UPLOAD_DIRTY,
+    });
+    state.fons = state.sfons;
     state.font_normal = FONS_INVALID;
     state.font_italic = FONS_INVALID;
     state.font_bold = FONS_INVALID;
@@ -288,8 +329,31 @@ static void frame(void) {
         fonsDrawText(fs, dx,dy,"DROP THAT SHADOW",NULL);
     }
 
+    // renderer info and upload statistics
+    if (state.font_normal != FONS_INVALID) {
+        char buf[128];
+        if (fs == state.gcache) {
+            const gcache_stats_t stats = gcache_query_stats(fs);
+            snprintf(buf, sizeof(buf), "G: glyph cache (dirty rect), %d uploads, %d KB",
+                stats.total_uploads, (int)(stats.total_upload_bytes / 1024));
+        } else {
+            snprintf(buf, sizeof(buf), "G: sokol_fontstash.h (full atlas)");
+        }
+        fonsSetAlign(fs, FONS_ALIGN_LEFT | FONS_ALIGN_BOTTOM);
+        fonsSetSize(fs, 14.0f*dpis);
+        fonsSetFont(fs, state.font_normal);
+        fonsSetColor(fs, white);
+        fonsSetSpacing(fs, 0.0f);
+        fonsSetBlur(fs, 0);
+        fonsDrawText(fs, 10*dpis, sapp_heightf() - 10*dpis, buf, NULL);
+    }
+
     // flush fontstash's font atlas to sokol-gfx texture
-    sfons_flush(fs);
+    if (fs == state.gcache) {
+        gcache_flush(fs);
+    } else {
+        sfons_flush(fs);
+    }
 
     // render pass
     sg_begin_pass(&(sg_pass){
@@ -307,10 +371,18 @@ static void frame(void) {
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_G)) {
+        state.fons = (state.fons == state.sfons) ? state.gcache : state.sfons;
+    }
+    __dbgui_event(ev);
+}
+
 static void cleanup(void) {
     __dbgui_shutdown();
     sfetch_shutdown();
-    sfons_destroy(state.fons);
+    gcache_destroy(state.gcache);
+    sfons_destroy(state.sfons);
     sgl_shutdown();
     sg_shutdown();
 }
@@ -322,7 +394,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .high_dpi = true,
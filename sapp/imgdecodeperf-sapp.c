@@ -0,0 +1,239 @@
+//------------------------------------------------------------------------------
+//  imgdecodeperf-sapp.c
+//
+//  Measures stb_image.h decoding throughput for the PNG and JPEG files
+//  in sapp/data, once via the regular stbi_load_from_memory() /
+//  stbi_image_free() round trip, and once decoding directly into a
+//  preallocated buffer via stbi_load_from_memory_into(). The results of
+//  both paths are validated against a scalar reference decode (a second
+//  copy of stb_image.h compiled with STBI_NO_SIMD, see
+//  libs/stb/stb_image_ref.c), allowing for a difference of up to
+//  MAX_CHANNEL_DIFF per channel in the SIMD JPEG code paths.
+//
+//  The active SIMD code path depends on the STB_IMAGE_SIMD cmake option
+//  (ON by default), configure with -DSTB_IMAGE_SIMD=OFF to get the
+//  scalar numbers for comparison.
+//
+//  Results are also written to stdout in CSV format.
+//  Press SPACE to run the benchmark again.
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "stb/stb_image_ext.h"
+#include "util/fileutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_FILES (7)
+#define NUM_RUNS (5)
+#define MAX_IMAGE_SIZE (2048 * 2048 * 4)
+#define MAX_CHANNEL_DIFF (2)
+
+typedef struct {
+    int width;
+    int height;
+    size_t file_size;
+    double alloc_ms;        // stbi_load_from_memory + stbi_image_free
+    double into_ms;         // stbi_load_from_memory_into
+    int max_diff;           // max per-channel difference to the scalar reference decode
+    bool valid;
+    bool failed;
+} result_t;
+
+static const char* filenames[NUM_FILES] = {
+    "baboon.png",
+    "nb2_posx.jpg",
+    "nb2_negx.jpg",
+    "nb2_posy.jpg",
+    "nb2_negy.jpg",
+    "nb2_posz.jpg",
+    "nb2_negz.jpg",
+};
+
+static struct {
+    bool run_requested;
+    result_t results[NUM_FILES];
+    double total_mpix;
+    double total_alloc_ms;
+    double total_into_ms;
+    uint8_t* pixels;
+} state = {
+    .run_requested = true,
+};
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_kc853(),
+        .logger.func = slog_func,
+    });
+    // one extra byte so that JPEGs can be decoded in place
+    state.pixels = (uint8_t*) malloc(MAX_IMAGE_SIZE + 1);
+}
+
+// max per-channel difference between two decoded images
+static int max_channel_diff(const uint8_t* a, const uint8_t* b, size_t num_bytes) {
+    int max_diff = 0;
+    for (size_t i = 0; i < num_bytes; i++) {
+        const int diff = abs((int)a[i] - (int)b[i]);
+        if (diff > max_diff) {
+            max_diff = diff;
+        }
+    }
+    return max_diff;
+}
+
+static void bench_file(const char* filename, result_t* res) {
+    char path_buf[512];
+    fileutil_mmap_t map;
+    if (!fileutil_mmap(fileutil_get_path(filename, path_buf, sizeof(path_buf)), FILEUTIL_ADVICE_WILLNEED, &map)) {
+        res->failed = true;
+        return;
+    }
+    res->file_size = map.size;
+    const stbi_uc* data = (const stbi_uc*)map.ptr;
+    const int data_size = (int)map.size;
+    int w, h, n;
+    // the scalar reference decode isn't timed
+    stbi_uc* ref_pixels = stbi_ref_load_from_memory(data, data_size, &w, &h, &n, 4);
+    if (!ref_pixels || ((size_t)(w * h * 4) > MAX_IMAGE_SIZE)) {
+        res->failed = true;
+        stbi_ref_image_free(ref_pixels);
+        fileutil_munmap(&map);
+        return;
+    }
+    const size_t num_bytes = (size_t)(w * h * 4);
+    double alloc_ms = 0.0;
+    double into_ms = 0.0;
+    res->valid = true;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        uint64_t t0 = stm_now();
+        stbi_uc* pixels = stbi_load_from_memory(data, data_size, &w, &h, &n, 4);
+        alloc_ms += stm_ms(stm_since(t0));
+        if (!pixels || ((size_t)(w * h * 4) != num_bytes)) {
+            res->failed = true;
+            stbi_image_free(pixels);
+            break;
+        }
+        t0 = stm_now();
+        const int ok = stbi_load_from_memory_into(data, data_size, &w, &h, &n, 4, state.pixels, MAX_IMAGE_SIZE + 1);
+        into_ms += stm_ms(stm_since(t0));
+        // both decode paths must match the scalar reference within MAX_CHANNEL_DIFF
+        if (ok) {
+            const int alloc_diff = max_channel_diff(pixels, ref_pixels, num_bytes);
+            const int into_diff = max_channel_diff(state.pixels, ref_pixels, num_bytes);
+            res->max_diff = (alloc_diff > res->max_diff) ? alloc_diff : res->max_diff;
+            res->max_diff = (into_diff > res->max_diff) ? into_diff : res->max_diff;
+        }
+        if (!ok || (res->max_diff > MAX_CHANNEL_DIFF)) {
+            res->valid = false;
+        }
+        stbi_image_free(pixels);
+    }
+    stbi_ref_image_free(ref_pixels);
+    fileutil_munmap(&map);
+    if (!res->failed) {
+        res->width = w;
+        res->height = h;
+        res->alloc_ms = alloc_ms / NUM_RUNS;
+        res->into_ms = into_ms / NUM_RUNS;
+    }
+}
+
+static void run_benchmark(void) {
+    memset(state.results, 0, sizeof(state.results));
+    state.total_mpix = state.total_alloc_ms = state.total_into_ms = 0.0;
+    printf("simd,file,width,height,file_bytes,alloc_ms,into_ms,max_diff,valid\n");
+    for (int i = 0; i < NUM_FILES; i++) {
+        result_t* res = &state.results[i];
+        bench_file(filenames[i], res);
+        if (res->failed) {
+            continue;
+        }
+        state.total_mpix += (res->width * res->height) / 1000000.0;
+        state.total_alloc_ms += res->alloc_ms;
+        state.total_into_ms += res->into_ms;
+        printf("%s,%s,%d,%d,%zu,%.3f,%.3f,%d,%d\n", stbi_simd_path(), filenames[i], res->width, res->height,
+            res->file_size, res->alloc_ms, res->into_ms, res->max_diff, res->valid ? 1 : 0);
+    }
+}
+
+static void frame(void) {
+    if (state.run_requested) {
+        state.run_requested = false;
+        run_benchmark();
+    }
+
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("STB_IMAGE DECODE THROUGHPUT (SIMD: %s)\n\n", stbi_simd_path());
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_printf("  %-14s %10s %10s %10s %5s %6s\n", "file", "size", "alloc+free", "into", "diff", "valid");
+    sdtx_color3b(0xAA, 0xAA, 0xAA);
+    for (int i = 0; i < NUM_FILES; i++) {
+        const result_t* res = &state.results[i];
+        if (res->failed) {
+            sdtx_printf("  %-14s FAILED\n", filenames[i]);
+        } else {
+            sdtx_printf("  %-14s %4dx%-5d %8.2fms %8.2fms %5d %6s\n", filenames[i],
+                res->width, res->height, res->alloc_ms, res->into_ms, res->max_diff, res->valid ? "yes" : "NO");
+        }
+    }
+    sdtx_color3b(0x00, 0xFF, 0x00);
+    if (state.total_alloc_ms > 0.0) {
+        sdtx_printf("\n  alloc+free: %.1f MPix/s\n", state.total_mpix / (state.total_alloc_ms / 1000.0));
+    }
+    if (state.total_into_ms > 0.0) {
+        sdtx_printf("  into:       %.1f MPix/s\n", state.total_mpix / (state.total_into_ms / 1000.0));
+    }
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_puts("\n\npress SPACE to run again");
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.125f, 0.25f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE)) {
+        state.run_requested = true;
+    }
+}
+
+static void cleanup(void) {
+    free(state.pixels);
+    sdtx_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 800,
+        .height = 400,
+        .window_title = "imgdecodeperf-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
@@ -6,6 +6,11 @@
 //
 //  Uses sokol-gl to render into a render target texture, and then
 //  render the render target texture with different samplers in Dear ImGui.
+//
+//  Also renders a grid of small icon images, either with one texture per
+//  icon (which breaks the UI rendering into one draw call per icon), or
+//  packed into a single texture atlas via util/atlas.h (which allows Dear
+//  ImGui to merge all icons into a single draw call).
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -19,12 +24,17 @@
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
+#include "util/atlas.h"
 
 #define OFFSCREEN_WIDTH (32)
 #define OFFSCREEN_HEIGHT (32)
 #define OFFSCREEN_COLOR_FORMAT (SG_PIXELFORMAT_RGBA8)
 #define OFFSCREEN_DEPTH_FORMAT (SG_PIXELFORMAT_DEPTH)
 #define OFFSCREEN_SAMPLE_COUNT (1)
+#define NUM_ICONS (64)
+#define ICONS_PER_ROW (16)
+#define ICON_SIZE (ATLAS_ICON_SIZE)
+#define ATLAS_SIZE (256)
 
 static struct {
     double angle_deg;
@@ -45,6 +55,14 @@ static struct {
         sg_sampler nearest_repeat;
         sg_sampler linear_mirror;
     } smp;
+    struct {
+        bool use_atlas;
+        sg_image images[NUM_ICONS];
+        sg_image atlas_img;
+        atlas_uv_t uvs[NUM_ICONS];
+        int num_draws[2];           // [0]: separate textures, [1]: atlas
+        int num_bindings[2];
+    } icons;
 } state;
 
 static void draw_cube(void);
@@ -137,9 +155,38 @@ static void init(void) {
         .wrap_u = SG_WRAP_MIRRORED_REPEAT,
         .wrap_v = SG_WRAP_MIRRORED_REPEAT,
     });
+
+    // create the icon images, both as separate textures, and packed into an atlas
+    atlas_t atlas;
+    atlas_init(&atlas, &(atlas_desc_t){ .width = ATLAS_SIZE, .height = ATLAS_SIZE });
+    for (int i = 0; i < NUM_ICONS; i++) {
+        uint32_t pixels[ICON_SIZE * ICON_SIZE];
+        atlas_make_icon_pixels(i, pixels);
+        state.icons.images[i] = sg_make_image(&(sg_image_desc){
+            .width = ICON_SIZE,
+            .height = ICON_SIZE,
+            .pixel_format = SG_PIXELFORMAT_RGBA8,
+            .data.subimage[0][0] = SG_RANGE(pixels),
+        });
+        atlas_rect_t rect;
+        const bool packed = atlas_add(&atlas, ICON_SIZE, ICON_SIZE, pixels, &rect);
+        assert(packed); (void)packed;
+        state.icons.uvs[i] = atlas_uv(&atlas, rect);
+    }
+    state.icons.atlas_img = atlas_make_image(&atlas, "icon-atlas");
+    atlas_discard(&atlas);
+    state.icons.use_atlas = true;
+
+    // frame stats are used to display the number of draw calls
+    sg_enable_frame_stats();
 }
 
 static void frame(void) {
+    // draw call statistics of the previous frame
+    const sg_frame_stats stats = sg_query_frame_stats();
+    state.icons.num_draws[state.icons.use_atlas ? 1 : 0] = (int)stats.num_draw;
+    state.icons.num_bindings[state.icons.use_atlas ? 1 : 0] = (int)stats.num_apply_bindings;
+
     state.angle_deg += sapp_frame_duration() * 60.0;
     const float a = sgl_rad((float)state.angle_deg);
 
@@ -164,7 +211,7 @@ static void frame(void) {
         .dpi_scale = sapp_dpi_scale(),
     });
     igSetNextWindowPos((ImVec2){20, 20}, ImGuiCond_Once);
-    igSetNextWindowSize((ImVec2){540, 560}, ImGuiCond_Once);
+    igSetNextWindowSize((ImVec2){540, 720}, ImGuiCond_Once);
     if (igBegin("Sokol + Dear ImGui Image Test", 0, 0)) {
         const ImVec4 white = { 1, 1, 1, 1 };
         const ImVec2 size = { 256, 256 };
@@ -180,6 +227,25 @@ static void frame(void) {
         igImageEx(texid1, size, uv0, uv1, white, white);
         igImageEx(texid2, size, uv0, uv2, white, white); igSameLineEx(0, 4);
         igImageEx(texid3, size, uv0, uv2, white, white);
+
+        igSeparator();
+        igCheckbox("Pack icons into atlas", &state.icons.use_atlas);
+        igText("sg_draw() per frame: %d (separate), %d (atlas)", state.icons.num_draws[0], state.icons.num_draws[1]);
+        igText("sg_apply_bindings() per frame: %d (separate), %d (atlas)", state.icons.num_bindings[0], state.icons.num_bindings[1]);
+        const ImVec2 icon_size = { 2 * ICON_SIZE, 2 * ICON_SIZE };
+        for (int i = 0; i < NUM_ICONS; i++) {
+            if ((i % ICONS_PER_ROW) != 0) {
+                igSameLineEx(0, 0);
+            }
+            if (state.icons.use_atlas) {
+                const atlas_uv_t uv = state.icons.uvs[i];
+                ImTextureID texid = simgui_imtextureid_with_sampler(state.icons.atlas_img, state.smp.nearest_clamp);
+                igImageEx(texid, icon_size, (ImVec2){ uv.u0, uv.v0 }, (ImVec2){ uv.u1, uv.v1 }, white, (ImVec4){0,0,0,0});
+            } else {
+                ImTextureID texid = simgui_imtextureid_with_sampler(state.icons.images[i], state.smp.nearest_clamp);
+                igImageEx(texid, icon_size, uv0, uv1, white, (ImVec4){0,0,0,0});
+            }
+        }
     }
     igEnd();
 
@@ -216,7 +282,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
     (void)argc; (void)argv;
     return (sapp_desc) {
         .width = 580,
-        .height = 600,
+        .height = 760,
         .init_cb = init,
         .frame_cb = frame,
         .event_cb = input,
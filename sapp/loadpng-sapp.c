@@ -7,6 +7,11 @@
 //  The CMakeLists.txt entry for loadpng-sapp.c also demonstrates the
 //  sokol_file_copy() macro to copy assets into the fips deployment directory.
 //
+//  On platforms with memory-mapped file support the PNG file is instead
+//  mapped via fileutil_mmap() and decoded directly from the mapped memory,
+//  this avoids copying the file content into an intermediate buffer.
+//  Set LOADPNG_USE_MMAP to 0 to always go through sokol_fetch.h.
+//
 //  This is a modified version of texcube-sapp.c
 //------------------------------------------------------------------------------
 #define HANDMADE_MATH_IMPLEMENTATION
@@ -22,6 +27,10 @@
 #include "util/fileutil.h"
 #include "loadpng-sapp.glsl.h"
 
+#if !defined(LOADPNG_USE_MMAP)
+#define LOADPNG_USE_MMAP (FILEUTIL_HAS_MMAP)
+#endif
+
 static struct {
     float rx, ry;
     sg_pass_action pass_action;
@@ -36,6 +45,7 @@ typedef struct {
 } vertex_t;
 
 static void fetch_callback(const sfetch_response_t*);
+static bool create_texture(const void* png_data, size_t png_size);
 
 static void init(void) {
     // setup sokol-gfx and the optional debug-ui
@@ -142,15 +152,32 @@ static void init(void) {
         .label = "cube-pipeline"
     });
 
+    char path_buf[512];
+    fileutil_get_path("baboon.png", path_buf, sizeof(path_buf));
+
+    #if LOADPNG_USE_MMAP
+    /* if the PNG file can be memory-mapped, decode it straight from the
+       mapped memory, the mapping can be released right after decoding
+       since stb_image.h has copied the pixel data into its own buffer
+    */
+    fileutil_mmap_t map;
+    if (fileutil_mmap(path_buf, FILEUTIL_ADVICE_SEQUENTIAL, &map)) {
+        const bool ok = create_texture(map.ptr, map.size);
+        fileutil_munmap(&map);
+        if (ok) {
+            return;
+        }
+    }
+    #endif
+
     /* start loading the PNG file, we don't need the returned handle since
        we can also get that inside the fetch-callback from the response
        structure.
         - NOTE that we're not using the user_data member, since all required
           state is in a global variable anyway
     */
-    char path_buf[512];
     sfetch_send(&(sfetch_request_t){
-        .path = fileutil_get_path("baboon.png", path_buf, sizeof(path_buf)),
+        .path = path_buf,
         .callback = fetch_callback,
         .buffer = SFETCH_RANGE(state.file_buffer)
     });
@@ -164,26 +191,7 @@ static void fetch_callback(const sfetch_response_t* response) {
         /* the file data has been fetched, since we provided a big-enough
            buffer we can be sure that all data has been loaded here
         */
-        int png_width, png_height, num_channels;
-        const int desired_channels = 4;
-        stbi_uc* pixels = stbi_load_from_memory(
-            response->data.ptr,
-            (int)response->data.size,
-            &png_width, &png_height,
-            &num_channels, desired_channels);
-        if (pixels) {
-            // ok, time to actually initialize the sokol-gfx texture
-            sg_init_image(state.bind.images[IMG_tex], &(sg_image_desc){
-                .width = png_width,
-                .height = png_height,
-                .pixel_format = SG_PIXELFORMAT_RGBA8,
-                .data.subimage[0][0] = {
-                    .ptr = pixels,
-                    .size = (size_t)(png_width * png_height * 4),
-                }
-            });
-            stbi_image_free(pixels);
-        }
+        create_texture(response->data.ptr, response->data.size);
     } else if (response->failed) {
         // if loading the file failed, set clear color to red
         state.pass_action = (sg_pass_action) {
@@ -192,6 +200,35 @@ static void fetch_callback(const sfetch_response_t* response) {
     }
 }
 
+/* Decode the PNG data and initialize the sokol-gfx texture, this is called
+   either with the memory-mapped file content, or with the data loaded
+   by sokol_fetch.h
+*/
+static bool create_texture(const void* png_data, size_t png_size) {
+    int png_width, png_height, num_channels;
+    const int desired_channels = 4;
+    stbi_uc* pixels = stbi_load_from_memory(
+        png_data,
+        (int)png_size,
+        &png_width, &png_height,
+        &num_channels, desired_channels);
+    if (!pixels) {
+        return false;
+    }
+    // ok, time to actually initialize the sokol-gfx texture
+    sg_init_image(state.bind.images[IMG_tex], &(sg_image_desc){
+        .width = png_width,
+        .height = png_height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .data.subimage[0][0] = {
+            .ptr = pixels,
+            .size = (size_t)(png_width * png_height * 4),
+        }
+    });
+    stbi_image_free(pixels);
+    return true;
+}
+
 /* The frame-function is fairly boring, note that no special handling is
    needed for the case where the texture isn't loaded yet.
    Also note the sfetch_dowork() function, this is usually called once a
@@ -0,0 +1,488 @@
+//------------------------------------------------------------------------------
+//  mipgen-sapp.c
+//
+//  Generating the mip chain of a 4096x4096 render target on the GPU with
+//  libs/util/mipgen.h, compared against CPU mip generation of a texture
+//  with the same size.
+//
+//  1: box filter
+//  2: Kaiser filter
+//  C: toggle between the GPU render target and the CPU generated texture
+//  B: run the CPU mip generation with both filters (blocks for a moment)
+//
+//  Also see miprender-sapp for rendering directly into mip levels.
+//------------------------------------------------------------------------------
+#include <stdlib.h> // malloc/free
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_SHAPE_IMPL
+#include "sokol_shape.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/gputimer.h"
+#include "util/mipgen.h"
+#define HANDMADE_MATH_IMPLEMENTATION
+#define HANDMADE_MATH_NO_SSE
+#include "HandmadeMath.h"
+#include "dbgui/dbgui.h"
+#include "mipgen-sapp.glsl.h"
+#include "mipgen.glsl.h"
+
+#define IMG_SIZE (4096)
+#define IMG_NUM_MIPMAPS (13)
+#define NUM_AVG_FRAMES (60)
+#define KAISER_TAPS (6)
+
+#define SHAPE_BOX (0)
+#define SHAPE_DONUT (1)
+#define SHAPE_SPHERE (2)
+#define NUM_SHAPES (3)
+
+// same weights as the Kaiser filter in mipgen.glsl
+static const float kaiser_weights[KAISER_TAPS] = { -0.020992f, 0.094502f, 0.426490f, 0.426490f, 0.094502f, -0.020992f };
+static const char* filter_names[MIPGEN_NUM_FILTERS] = { "box", "kaiser" };
+
+static struct {
+    float rx, ry;
+    double time;
+    mipgen_filter_t filter;
+    bool show_cpu;
+    sg_buffer vbuf;
+    sg_buffer ibuf;
+    sg_sampler smp;
+    struct {
+        sg_image img;
+        sg_pipeline pip;
+        sg_pass_action pass_action;
+        sg_bindings bindings;
+        sg_attachments atts;
+        mipgen_chain_t chain;
+        sshape_element_range_t shapes[NUM_SHAPES];
+    } offscreen;
+    struct {
+        sg_pipeline pip;
+        sg_pass_action pass_action;
+        sg_bindings bindings;
+        sshape_element_range_t plane;
+    } display;
+    struct {
+        sg_image img;
+        uint8_t* pixels;                    // all mip levels of the CPU texture
+        size_t level_offset[IMG_NUM_MIPMAPS];
+        float* rows;                        // horizontally filtered rows for the Kaiser filter
+        bool measured[MIPGEN_NUM_FILTERS];
+        double gen_ms[MIPGEN_NUM_FILTERS];
+        double upload_ms[MIPGEN_NUM_FILTERS];
+    } cpu;
+    gputimer_avg_t avg;
+    bool gpu_measured[MIPGEN_NUM_FILTERS];
+    double gpu_ms[MIPGEN_NUM_FILTERS];
+} state;
+
+static vs_params_t compute_offscreen_vsparams(void);
+static vs_params_t compute_display_vsparams(void);
+static void cpu_generate(mipgen_filter_t filter);
+
+static int level_size(int level) {
+    const int size = IMG_SIZE >> level;
+    return (size > 0) ? size : 1;
+}
+
+static int clamp_int(int v, int min_val, int max_val) {
+    return (v < min_val) ? min_val : ((v > max_val) ? max_val : v);
+}
+
+static void reset_stats(void) {
+    gputimer_avg_reset(&state.avg);
+}
+
+static void init(void) {
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    __dbgui_setup(sapp_sample_count());
+    stm_setup();
+    gputimer_setup();
+    gputimer_avg_init(&state.avg, NUM_AVG_FRAMES);
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    mipgen_setup(&(mipgen_desc_t){
+        .shader = sg_make_shader(mipgen_shader_desc(sg_query_backend())),
+    });
+
+    // setup a couple of shape geometries
+    static sshape_vertex_t vertices[4 * 1024];
+    static uint16_t indices[12 * 1024];
+    sshape_buffer_t buf = {
+        .vertices.buffer = SSHAPE_RANGE(vertices),
+        .indices.buffer = SSHAPE_RANGE(indices),
+    };
+    buf = sshape_build_box(&buf, &(sshape_box_t){ .width = 1.5f, .height = 1.5f, .depth = 1.5f });
+    state.offscreen.shapes[SHAPE_BOX] = sshape_element_range(&buf);
+    buf = sshape_build_torus(&buf, &(sshape_torus_t){ .radius = 1.0f, .ring_radius = 0.3f, .rings = 36, .sides = 18 });
+    state.offscreen.shapes[SHAPE_DONUT] = sshape_element_range(&buf);
+    buf = sshape_build_sphere(&buf, &(sshape_sphere_t){ .radius = 1.0f, .slices = 36, .stacks = 20 });
+    state.offscreen.shapes[SHAPE_SPHERE] = sshape_element_range(&buf);
+    buf = sshape_build_plane(&buf, &(sshape_plane_t){ .width = 2.0f, .depth = 2.0f });
+    state.display.plane = sshape_element_range(&buf);
+    assert(buf.valid);
+
+    // create one vertex- and one index-buffer for all shapes
+    const sg_buffer_desc vbuf_desc = sshape_vertex_buffer_desc(&buf);
+    const sg_buffer_desc ibuf_desc = sshape_index_buffer_desc(&buf);
+    state.vbuf = sg_make_buffer(&vbuf_desc);
+    state.ibuf = sg_make_buffer(&ibuf_desc);
+
+    // an offscreen render target with a complete mipmap chain, the scene
+    // is rendered into mip level 0, and the other levels are generated by mipgen
+    state.offscreen.img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = IMG_SIZE,
+        .height = IMG_SIZE,
+        .num_mipmaps = IMG_NUM_MIPMAPS,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = 1,
+        .label = "offscreen-image",
+    });
+    sg_image depth_img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = IMG_SIZE,
+        .height = IMG_SIZE,
+        .pixel_format = SG_PIXELFORMAT_DEPTH,
+        .sample_count = 1,
+        .label = "offscreen-depth",
+    });
+    state.offscreen.atts = sg_make_attachments(&(sg_attachments_desc){
+        .colors[0].image = state.offscreen.img,
+        .depth_stencil.image = depth_img,
+        .label = "offscreen-pass",
+    });
+    state.offscreen.chain = mipgen_make_chain(state.offscreen.img, "offscreen-mipgen");
+
+    // create a sampler which smoothly blends between mipmaps
+    state.smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .mipmap_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+    });
+
+    // a pipeline object for the offscreen pass
+    state.offscreen.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .buffers[0].stride = sizeof(sshape_vertex_t),
+            .attrs = {
+                [ATTR_offscreen_in_pos] = sshape_position_vertex_attr_state(),
+                [ATTR_offscreen_in_nrm] = sshape_normal_vertex_attr_state(),
+            },
+        },
+        .shader = sg_make_shader(offscreen_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        .cull_mode = SG_CULLMODE_BACK,
+        .sample_count = 1,
+        .depth = {
+            .write_enabled = true,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .pixel_format = SG_PIXELFORMAT_DEPTH,
+        },
+        .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+    });
+
+    // ...and a pipeline object for the display pass
+    state.display.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .buffers[0].stride = sizeof(sshape_vertex_t),
+            .attrs = {
+                [ATTR_display_in_pos] = sshape_position_vertex_attr_state(),
+                [ATTR_display_in_uv] = sshape_texcoord_vertex_attr_state(),
+            },
+        },
+        .shader = sg_make_shader(display_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        .cull_mode = SG_CULLMODE_NONE,
+        .depth = {
+            .write_enabled = true,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+        }
+    });
+
+    // initialize resource bindings, the display image is selected per frame
+    state.offscreen.bindings = (sg_bindings) {
+        .vertex_buffers[0] = state.vbuf,
+        .index_buffer = state.ibuf,
+    };
+    state.display.bindings = (sg_bindings) {
+        .vertex_buffers[0] = state.vbuf,
+        .index_buffer = state.ibuf,
+        .samplers[SMP_smp] = state.smp,
+    };
+
+    // initialize pass actions
+    state.offscreen.pass_action = (sg_pass_action) {
+        .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.5f, 0.5f, 0.5f, 1.0f } },
+    };
+    state.display.pass_action = (sg_pass_action) {
+        .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.0f, 0.0f, 1.0f } },
+    };
+
+    // a CPU texture with concentric rings for the CPU mip generation, mip level 0
+    // stays untouched, the other levels are written by cpu_generate()
+    size_t num_bytes = 0;
+    for (int level = 0; level < IMG_NUM_MIPMAPS; level++) {
+        state.cpu.level_offset[level] = num_bytes;
+        num_bytes += (size_t)(level_size(level) * level_size(level) * 4);
+    }
+    state.cpu.pixels = (uint8_t*) malloc(num_bytes);
+    state.cpu.rows = (float*) malloc(KAISER_TAPS * (IMG_SIZE / 2) * 4 * sizeof(float));
+    uint8_t* dst = state.cpu.pixels;
+    for (int y = 0; y < IMG_SIZE; y++) {
+        for (int x = 0; x < IMG_SIZE; x++, dst += 4) {
+            const int dx = x - IMG_SIZE / 2;
+            const int dy = y - IMG_SIZE / 2;
+            const uint32_t r2 = (uint32_t)(dx * dx + dy * dy);
+            const uint8_t ring = ((r2 >> 9) & 1) ? 0xFF : 0x40;
+            dst[0] = (uint8_t)(x >> 4);
+            dst[1] = ring;
+            dst[2] = (uint8_t)(y >> 4);
+            dst[3] = 0xFF;
+        }
+    }
+    cpu_generate(MIPGEN_FILTER_BOX);
+}
+
+// downsample with a 2x2 box filter, src_size must be a power of two >= 2
+static void cpu_downsample_box(const uint8_t* src, int src_size, uint8_t* dst) {
+    const int dst_size = src_size / 2;
+    const int src_pitch = src_size * 4;
+    for (int y = 0; y < dst_size; y++) {
+        const uint8_t* s0 = src + (2 * y) * src_pitch;
+        const uint8_t* s1 = s0 + src_pitch;
+        for (int x = 0; x < dst_size; x++, s0 += 8, s1 += 8, dst += 4) {
+            for (int c = 0; c < 4; c++) {
+                dst[c] = (uint8_t)((s0[c] + s0[c + 4] + s1[c] + s1[c + 4] + 2) >> 2);
+            }
+        }
+    }
+}
+
+// downsample with the separable 6x6 Kaiser filter, the horizontally filtered
+// source rows are kept in a ring of KAISER_TAPS rows
+static void cpu_downsample_kaiser(const uint8_t* src, int src_size, uint8_t* dst) {
+    const int dst_size = src_size / 2;
+    int cached_row[KAISER_TAPS];
+    for (int i = 0; i < KAISER_TAPS; i++) {
+        cached_row[i] = -1;
+    }
+    for (int y = 0; y < dst_size; y++) {
+        const float* rows[KAISER_TAPS];
+        for (int j = 0; j < KAISER_TAPS; j++) {
+            const int sy = clamp_int(2 * y - 2 + j, 0, src_size - 1);
+            const int slot = sy % KAISER_TAPS;
+            float* row = state.cpu.rows + slot * dst_size * 4;
+            if (cached_row[slot] != sy) {
+                cached_row[slot] = sy;
+                const uint8_t* s = src + sy * src_size * 4;
+                for (int x = 0; x < dst_size; x++) {
+                    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                    for (int i = 0; i < KAISER_TAPS; i++) {
+                        const int sx = clamp_int(2 * x - 2 + i, 0, src_size - 1);
+                        for (int c = 0; c < 4; c++) {
+                            acc[c] += kaiser_weights[i] * (float)s[sx * 4 + c];
+                        }
+                    }
+                    for (int c = 0; c < 4; c++) {
+                        row[x * 4 + c] = acc[c];
+                    }
+                }
+            }
+            rows[j] = row;
+        }
+        for (int x = 0; x < dst_size * 4; x++, dst++) {
+            float acc = 0.0f;
+            for (int j = 0; j < KAISER_TAPS; j++) {
+                acc += kaiser_weights[j] * rows[j][x];
+            }
+            acc = (acc < 0.0f) ? 0.0f : ((acc > 255.0f) ? 255.0f : acc);
+            *dst = (uint8_t)(acc + 0.5f);
+        }
+    }
+}
+
+// generate the mip chain of the CPU texture and upload it into a new immutable image
+static void cpu_generate(mipgen_filter_t filter) {
+    uint64_t start = stm_now();
+    for (int level = 1; level < IMG_NUM_MIPMAPS; level++) {
+        const uint8_t* src = state.cpu.pixels + state.cpu.level_offset[level - 1];
+        uint8_t* dst = state.cpu.pixels + state.cpu.level_offset[level];
+        if (filter == MIPGEN_FILTER_KAISER) {
+            cpu_downsample_kaiser(src, level_size(level - 1), dst);
+        } else {
+            cpu_downsample_box(src, level_size(level - 1), dst);
+        }
+    }
+    state.cpu.gen_ms[filter] = stm_ms(stm_laptime(&start));
+
+    sg_destroy_image(state.cpu.img);
+    sg_image_data img_data = {0};
+    for (int level = 0; level < IMG_NUM_MIPMAPS; level++) {
+        const size_t size = (size_t)(level_size(level) * level_size(level) * 4);
+        img_data.subimage[0][level] = (sg_range){ state.cpu.pixels + state.cpu.level_offset[level], size };
+    }
+    state.cpu.img = sg_make_image(&(sg_image_desc){
+        .width = IMG_SIZE,
+        .height = IMG_SIZE,
+        .num_mipmaps = IMG_NUM_MIPMAPS,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .data = img_data,
+        .label = "cpu-image",
+    });
+    state.cpu.upload_ms[filter] = stm_ms(stm_laptime(&start));
+    state.cpu.measured[filter] = true;
+}
+
+static void draw_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("%dx%d RGBA8, %d mips\n", IMG_SIZE, IMG_SIZE, IMG_NUM_MIPMAPS);
+    sdtx_printf("filter: %s (1..2)\n", filter_names[state.filter]);
+    sdtx_printf("showing: %s (C)\n\n", state.show_cpu ? "cpu texture" : "gpu render target");
+    sdtx_puts("        gpu ms   cpu ms upload ms\n");
+    for (int i = 0; i < MIPGEN_NUM_FILTERS; i++) {
+        sdtx_printf("%-6s", filter_names[i]);
+        if (!gputimer_supported()) {
+            sdtx_puts("     n/a");
+        } else if (state.gpu_measured[i]) {
+            sdtx_printf("%8.3f", state.gpu_ms[i]);
+        } else {
+            sdtx_puts("       -");
+        }
+        if (state.cpu.measured[i]) {
+            sdtx_printf(" %8.1f %9.1f\n", state.cpu.gen_ms[i], state.cpu.upload_ms[i]);
+        } else {
+            sdtx_puts("        -         -\n");
+        }
+    }
+    sdtx_puts("\nB: run cpu benchmark\n");
+}
+
+static void frame(void) {
+    double dt = sapp_frame_duration();
+    state.time += dt;
+    state.rx += (float)(dt * 20.0f);
+    state.ry += (float)(dt * 40.0f);
+
+    if (gputimer_avg_update(&state.avg)) {
+        state.gpu_ms[state.filter] = gputimer_avg_ms(&state.avg, 0);
+        state.gpu_measured[state.filter] = true;
+    }
+
+    const vs_params_t offscreen_vsparams = compute_offscreen_vsparams();
+    const vs_params_t display_vsparams = compute_display_vsparams();
+
+    // render a shape into mip level 0, and generate the remaining mip levels
+    gputimer_begin_frame();
+    sg_begin_pass(&(sg_pass) {
+        .action = state.offscreen.pass_action,
+        .attachments = state.offscreen.atts,
+    });
+    sg_apply_pipeline(state.offscreen.pip);
+    sg_apply_bindings(&state.offscreen.bindings);
+    sg_apply_uniforms(UB_vs_params, &SG_RANGE(offscreen_vsparams));
+    const sshape_element_range_t shape = state.offscreen.shapes[((int)state.time / 2) % NUM_SHAPES];
+    sg_draw(shape.base_element, shape.num_elements, 1);
+    sg_end_pass();
+    gputimer_begin(0);
+    mipgen_generate(&state.offscreen.chain, state.filter);
+    gputimer_end(0);
+
+    // default pass: render a textured plane that moves back and forth to use different mipmap levels
+    state.display.bindings.images[IMG_tex] = state.show_cpu ? state.cpu.img : state.offscreen.img;
+    sg_begin_pass(&(sg_pass){ .action = state.display.pass_action, .swapchain = sglue_swapchain() });
+    sg_apply_pipeline(state.display.pip);
+    sg_apply_bindings(&state.display.bindings);
+    sg_apply_uniforms(UB_vs_params, &SG_RANGE(display_vsparams));
+    sg_draw(state.display.plane.base_element, state.display.plane.num_elements, 1);
+    draw_stats();
+    sdtx_draw();
+    __dbgui_draw();
+    sg_end_pass();
+    gputimer_end_frame();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        if ((ev->key_code == SAPP_KEYCODE_1) || (ev->key_code == SAPP_KEYCODE_2)) {
+            state.filter = (ev->key_code == SAPP_KEYCODE_1) ? MIPGEN_FILTER_BOX : MIPGEN_FILTER_KAISER;
+            cpu_generate(state.filter);
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_C) {
+            state.show_cpu = !state.show_cpu;
+        } else if (ev->key_code == SAPP_KEYCODE_B) {
+            // run the current filter last so that the CPU texture matches it
+            const mipgen_filter_t other = (state.filter == MIPGEN_FILTER_BOX) ? MIPGEN_FILTER_KAISER : MIPGEN_FILTER_BOX;
+            cpu_generate(other);
+            cpu_generate(state.filter);
+        }
+    }
+    __dbgui_event(ev);
+}
+
+static void cleanup(void) {
+    free(state.cpu.rows);
+    free(state.cpu.pixels);
+    mipgen_destroy_chain(&state.offscreen.chain);
+    mipgen_shutdown();
+    __dbgui_shutdown();
+    sdtx_shutdown();
+    gputimer_shutdown();
+    sg_shutdown();
+}
+
+// compute a model-view-projection matrix for offscreen rendering (aspect ratio 1:1)
+static vs_params_t compute_offscreen_vsparams(void) {
+    hmm_mat4 proj = HMM_Perspective(60.0f, 1.0f, 0.01f, 10.0f);
+    hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 0.0f, 3.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
+    hmm_mat4 rxm = HMM_Rotate(state.rx, HMM_Vec3(1.0f, 0.0f, 0.0f));
+    hmm_mat4 rym = HMM_Rotate(state.ry, HMM_Vec3(0.0f, 0.0f, 1.0f));
+    hmm_mat4 model = HMM_MultiplyMat4(rxm, rym);
+    return (vs_params_t){ .mvp = HMM_MultiplyMat4(view_proj, model) };
+}
+
+// compute a model-view-projection matrix with display aspect ratio
+static vs_params_t compute_display_vsparams(void) {
+    const float w = sapp_widthf();
+    const float h = sapp_heightf();
+    const float scale = (HMM_SinF((float)state.time) + 1.0f) * 0.5f;
+    hmm_mat4 proj = HMM_Perspective(40.0f, w/h, 0.01f, 10.0f);
+    hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 0.0f, 3.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
+    hmm_mat4 model = HMM_Rotate(90.0f, HMM_Vec3(1.0f, 0.0f, 0.0f));
+    model = HMM_MultiplyMat4(HMM_Scale(HMM_Vec3(scale, scale, 1.0f)), model);
+    return (vs_params_t){ .mvp = HMM_MultiplyMat4(view_proj, model) };
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .cleanup_cb = cleanup,
+        .event_cb = input,
+        .width = 800,
+        .height = 600,
+        .sample_count = 1,
+        .window_title = "mipgen-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------
+//  Shader for GPU mipmap generation with libs/util/mipgen.h.
+//
+//  Renders one mip level from the previous level with a 2x2 box filter,
+//  a 6x6 Kaiser-windowed sinc filter, or copies a level 1:1. All taps are
+//  texelFetch() reads, so this also works for formats which can't be
+//  filtered.
+//------------------------------------------------------------------------------
+@vs mipgen_vs
+const vec2 positions[3] = {
+    vec2(-1.0, -1.0),
+    vec2(3.0, -1.0),
+    vec2(-1.0, 3.0),
+};
+
+void main() {
+    gl_Position = vec4(positions[gl_VertexIndex], 0.5, 1.0);
+}
+@end
+
+@fs mipgen_fs
+@image_sample_type mipgen_tex unfilterable_float
+@sampler_type mipgen_smp nonfiltering
+layout(binding=0) uniform texture2D mipgen_tex;
+layout(binding=0) uniform sampler mipgen_smp;
+
+layout(binding=0) uniform mipgen_params {
+    int src_level;
+    int mode;       // 0: copy, 1: box filter, 2: kaiser filter
+};
+
+out vec4 frag_color;
+
+vec4 fetch(ivec2 pos, ivec2 max_pos) {
+    return texelFetch(sampler2D(mipgen_tex, mipgen_smp), clamp(pos, ivec2(0), max_pos), src_level);
+}
+
+void main() {
+    ivec2 dst_pos = ivec2(gl_FragCoord.xy);
+    ivec2 max_pos = textureSize(sampler2D(mipgen_tex, mipgen_smp), src_level) - 1;
+    if (mode == 0) {
+        frag_color = fetch(dst_pos, max_pos);
+    } else if (mode == 1) {
+        ivec2 p = dst_pos * 2;
+        frag_color = (fetch(p, max_pos) +
+                      fetch(p + ivec2(1, 0), max_pos) +
+                      fetch(p + ivec2(0, 1), max_pos) +
+                      fetch(p + ivec2(1, 1), max_pos)) * 0.25;
+    } else {
+        // Kaiser-windowed sinc (alpha=4, radius 3 source texels), the weights
+        // are for the texel offsets 0.5, 1.5 and 2.5 from the destination
+        // texel center, normalized so that the 6 weights sum up to 1
+        const float w[6] = { -0.020992, 0.094502, 0.426490, 0.426490, 0.094502, -0.020992 };
+        ivec2 p = dst_pos * 2 - 2;
+        vec4 c = vec4(0.0);
+        for (int y = 0; y < 6; y++) {
+            vec4 row = vec4(0.0);
+            for (int x = 0; x < 6; x++) {
+                row += fetch(p + ivec2(x, y), max_pos) * w[x];
+            }
+            c += row * w[y];
+        }
+        frag_color = c;
+    }
+}
+@end
+
+@program mipgen mipgen_vs mipgen_fs
@@ -0,0 +1,275 @@
+//------------------------------------------------------------------------------
+//  mmapperf-sapp.c
+//
+//  Compares file loading via sokol_fetch.h (read into a buffer) against
+//  memory-mapped file access via fileutil_mmap() (consumed in place).
+//
+//  Each file is loaded and every byte is touched (by computing a simple
+//  checksum), so that both paths actually pull all data from disk.
+//
+//  'Cold' runs are measured right after evicting the files from the
+//  OS page cache, this only works on Linux (via posix_fadvise()), on other
+//  platforms the cold numbers are only meaningful for the very first
+//  run after a reboot. 'Warm' runs are the average over several
+//  repeated loads with the files in the page cache.
+//
+//  Press SPACE to run the benchmark again.
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_fetch.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/fileutil.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define NUM_FILES (8)
+#define NUM_WARM_RUNS (8)
+#define MAX_FILE_SIZE (2 * 1024 * 1024)
+
+typedef enum {
+    METHOD_SFETCH,
+    METHOD_MMAP,
+    NUM_METHODS,
+} method_t;
+
+typedef struct {
+    double cold_ms;
+    double warm_ms;
+    size_t num_bytes;
+    bool failed;
+} result_t;
+
+static const char* filenames[NUM_FILES] = {
+    "baboon.png",
+    "DroidSansJapanese.ttf",
+    "nb2_posx.jpg",
+    "nb2_negx.jpg",
+    "nb2_posy.jpg",
+    "nb2_negy.jpg",
+    "nb2_posz.jpg",
+    "nb2_negz.jpg",
+};
+
+static const char* method_names[NUM_METHODS] = { "sokol_fetch", "mmap" };
+
+static struct {
+    bool run_requested;
+    bool fetch_done;
+    bool fetch_failed;
+    size_t fetch_size;
+    uint32_t checksum;
+    result_t results[NUM_METHODS][NUM_FILES];
+    struct {
+        double cold_ms;
+        double warm_ms;
+        size_t num_bytes;
+    } totals[NUM_METHODS];
+} state = {
+    .run_requested = true,
+};
+
+static uint8_t fetch_buffer[MAX_FILE_SIZE];
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_kc853(),
+        .logger.func = slog_func,
+    });
+    sfetch_setup(&(sfetch_desc_t){
+        .max_requests = 1,
+        .num_channels = 1,
+        .num_lanes = 1,
+        .logger.func = slog_func,
+    });
+}
+
+// touch every byte of the loaded data so that all pages are actually read
+static uint32_t checksum(const uint8_t* ptr, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum = (sum << 1 | sum >> 31) ^ ptr[i];
+    }
+    return sum;
+}
+
+// try to drop a file from the OS page cache
+static void evict_from_page_cache(const char* path) {
+    #if defined(__linux__)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    #else
+    (void)path;
+    #endif
+}
+
+static void fetch_callback(const sfetch_response_t* response) {
+    if (response->fetched) {
+        state.checksum ^= checksum(response->data.ptr, response->data.size);
+        state.fetch_size = response->data.size;
+    }
+    state.fetch_failed = response->failed;
+    state.fetch_done = response->finished;
+}
+
+// load a file via sokol_fetch.h and spin until it has been loaded, returns file size or 0
+static size_t load_sfetch(const char* path) {
+    state.fetch_done = state.fetch_failed = false;
+    state.fetch_size = 0;
+    sfetch_send(&(sfetch_request_t){
+        .path = path,
+        .callback = fetch_callback,
+        .buffer = SFETCH_RANGE(fetch_buffer),
+    });
+    while (!state.fetch_done) {
+        sfetch_dowork();
+    }
+    return state.fetch_failed ? 0 : state.fetch_size;
+}
+
+// map a file and touch all bytes, returns file size or 0
+static size_t load_mmap(const char* path) {
+    fileutil_mmap_t map;
+    if (!fileutil_mmap(path, FILEUTIL_ADVICE_SEQUENTIAL, &map)) {
+        return 0;
+    }
+    state.checksum ^= checksum(map.ptr, map.size);
+    const size_t num_bytes = map.size;
+    fileutil_munmap(&map);
+    return num_bytes;
+}
+
+static double measure(method_t method, const char* path, size_t* out_num_bytes) {
+    const uint64_t start = stm_now();
+    size_t num_bytes = 0;
+    if (method == METHOD_SFETCH) {
+        num_bytes = load_sfetch(path);
+    } else {
+        num_bytes = load_mmap(path);
+    }
+    const double ms = stm_ms(stm_since(start));
+    *out_num_bytes = num_bytes;
+    return ms;
+}
+
+static void run_benchmark(void) {
+    memset(state.results, 0, sizeof(state.results));
+    memset(state.totals, 0, sizeof(state.totals));
+    char path_buf[512];
+    printf("method,file,bytes,cold_ms,warm_ms\n");
+    for (int m = 0; m < NUM_METHODS; m++) {
+        for (int i = 0; i < NUM_FILES; i++) {
+            result_t* res = &state.results[m][i];
+            const char* path = fileutil_get_path(filenames[i], path_buf, sizeof(path_buf));
+            evict_from_page_cache(path);
+            res->cold_ms = measure((method_t)m, path, &res->num_bytes);
+            if (res->num_bytes == 0) {
+                res->failed = true;
+                continue;
+            }
+            double warm_ms = 0.0;
+            for (int run = 0; run < NUM_WARM_RUNS; run++) {
+                size_t num_bytes;
+                warm_ms += measure((method_t)m, path, &num_bytes);
+            }
+            res->warm_ms = warm_ms / NUM_WARM_RUNS;
+            state.totals[m].cold_ms += res->cold_ms;
+            state.totals[m].warm_ms += res->warm_ms;
+            state.totals[m].num_bytes += res->num_bytes;
+        }
+        for (int i = 0; i < NUM_FILES; i++) {
+            const result_t* res = &state.results[m][i];
+            printf("%s,%s,%zu,%.3f,%.3f\n", method_names[m], filenames[i], res->num_bytes, res->cold_ms, res->warm_ms);
+        }
+    }
+}
+
+static double mb_per_sec(size_t num_bytes, double ms) {
+    return (ms > 0.0) ? (((double)num_bytes / (1024.0 * 1024.0)) / (ms / 1000.0)) : 0.0;
+}
+
+static void frame(void) {
+    if (state.run_requested) {
+        state.run_requested = false;
+        run_benchmark();
+    }
+
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("FILE LOADING: sokol_fetch vs mmap (%s)\n\n", FILEUTIL_HAS_MMAP ? "mmap supported" : "mmap NOT supported");
+    for (int m = 0; m < NUM_METHODS; m++) {
+        sdtx_color3b(0xFF, 0xCC, 0x00);
+        sdtx_printf("%s:\n", method_names[m]);
+        sdtx_color3b(0xAA, 0xAA, 0xAA);
+        for (int i = 0; i < NUM_FILES; i++) {
+            const result_t* res = &state.results[m][i];
+            if (res->failed) {
+                sdtx_printf("  %-21s FAILED\n", filenames[i]);
+            } else {
+                sdtx_printf("  %-21s %6zuKB cold %7.3fms warm %7.3fms\n",
+                    filenames[i], res->num_bytes / 1024, res->cold_ms, res->warm_ms);
+            }
+        }
+        sdtx_color3b(0x00, 0xFF, 0x00);
+        sdtx_printf("  total cold: %8.3fms %8.1f MB/s\n",
+            state.totals[m].cold_ms, mb_per_sec(state.totals[m].num_bytes, state.totals[m].cold_ms));
+        sdtx_printf("  total warm: %8.3fms %8.1f MB/s\n\n",
+            state.totals[m].warm_ms, mb_per_sec(state.totals[m].num_bytes, state.totals[m].warm_ms));
+    }
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("checksum: %08X\n\npress SPACE to run again", state.checksum);
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.125f, 0.25f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE)) {
+        state.run_requested = true;
+    }
+}
+
+static void cleanup(void) {
+    sfetch_shutdown();
+    sdtx_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 1024,
+        .height = 600,
+        .window_title = "mmapperf-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
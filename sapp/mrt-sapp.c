@@ -2,12 +2,26 @@
 //  mrt-sapp.c
 //  Rendering with multi-rendertargets, and recreating render targets
 //  when window size changes.
+//
+//  The cube is rendered into a small G-buffer (albedo, view space normal
+//  and linear depth) which is then lit in a fullscreen pass. Press 1..6
+//  to switch between G-buffer layouts with different pixel formats and
+//  normal encodings, layouts with pixel formats that can't be rendered
+//  to with MSAA on the current backend are disabled (see
+//  mrt-pixelformats-sapp for a pixel format test). The attachment memory
+//  (MSAA, resolve and depth images) and the GPU times of the G-buffer
+//  and lighting pass are displayed, press B to run a benchmark over all
+//  layouts. GPU times are measured with libs/util/gputimer.h.
 //------------------------------------------------------------------------------
 #include <stddef.h> /* offsetof */
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/gputimer.h"
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
@@ -15,14 +29,59 @@
 #include "mrt-sapp.glsl.h"
 
 #define OFFSCREEN_SAMPLE_COUNT (4)
+#define NUM_GBUFFER_TARGETS (3)
+#define NUM_AVG_FRAMES (60)
+#define BENCH_FRAMES (120)
+
+// must match the normal encodings in mrt-sapp.glsl
+enum {
+    NORMAL_XYZ,
+    NORMAL_XYZ_UNORM,
+    NORMAL_XY,
+    NORMAL_OCT,
+};
+
+enum {
+    TIMER_GBUFFER,
+    TIMER_LIGHTING,
+};
+
+// G-buffer render target pixel formats for albedo+coverage, normal and linear depth,
+// the albedo format needs at least 8 alpha bits since the coverage is resolved
+// to multiples of 1/OFFSCREEN_SAMPLE_COUNT (RGB10A2 only has 2 alpha bits)
+typedef struct {
+    const char* name;
+    sg_pixel_format formats[NUM_GBUFFER_TARGETS];
+    int normal_encoding;
+} gbuffer_layout_t;
+
+#define NUM_LAYOUTS (6)
+static const gbuffer_layout_t layouts[NUM_LAYOUTS] = {
+    { "RGBA32F x3",       { SG_PIXELFORMAT_RGBA32F, SG_PIXELFORMAT_RGBA32F, SG_PIXELFORMAT_RGBA32F }, NORMAL_XYZ },
+    { "RGBA16F x3",       { SG_PIXELFORMAT_RGBA16F, SG_PIXELFORMAT_RGBA16F, SG_PIXELFORMAT_RGBA16F }, NORMAL_XYZ },
+    { "RG16F xy normals", { SG_PIXELFORMAT_RGBA8,   SG_PIXELFORMAT_RG16F,   SG_PIXELFORMAT_R32F },    NORMAL_XY },
+    { "RG16 octahedral",  { SG_PIXELFORMAT_RGBA8,   SG_PIXELFORMAT_RG16,    SG_PIXELFORMAT_R16F },    NORMAL_OCT },
+    { "RGB10A2 normals",  { SG_PIXELFORMAT_RGBA8,   SG_PIXELFORMAT_RGB10A2, SG_PIXELFORMAT_R16F },    NORMAL_XYZ_UNORM },
+    { "RGBA8 x3",         { SG_PIXELFORMAT_RGBA8,   SG_PIXELFORMAT_RGBA8,   SG_PIXELFORMAT_RGBA8 },   NORMAL_XYZ_UNORM },
+};
+
+typedef struct {
+    bool valid;
+    double gbuffer_ms;
+    double lighting_ms;
+    size_t num_bytes;
+} result_t;
 
 static struct {
+    int layout;
+    bool layout_supported[NUM_LAYOUTS];
     struct {
         sg_pass_action pass_action;
         sg_attachments_desc atts_desc;
         sg_attachments atts;
-        sg_pipeline pip;
+        sg_pipeline pip[NUM_LAYOUTS];
         sg_bindings bind;
+        size_t num_bytes;
     } offscreen;
     struct {
         sg_pipeline pip;
@@ -34,24 +93,47 @@ static struct {
     } dbg;
     sg_pass_action pass_action;
     float rx, ry;
+    gputimer_avg_t avg;
+    struct {
+        gputimer_bench_t run;   // config is the layout index
+        int saved_layout;
+        result_t results[NUM_LAYOUTS];
+    } bench;
 } state;
 
 typedef struct {
-    float x, y, z, b;
+    float x, y, z;
+    float nx, ny, nz;
 } vertex_t;
 
+static void reset_stats(void) {
+    gputimer_avg_reset(&state.avg);
+}
+
+// a layout is only usable if all its pixel formats can be rendered to with MSAA and sampled
+static bool layout_supported(const gbuffer_layout_t* layout) {
+    for (int i = 0; i < NUM_GBUFFER_TARGETS; i++) {
+        const sg_pixelformat_info info = sg_query_pixelformat(layout->formats[i]);
+        if (!(info.render && info.msaa && info.sample)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 
 // called initially and when window size changes
 void create_offscreen_attachments(int width, int height) {
     // destroy previous resource (can be called for invalid id)
     sg_destroy_attachments(state.offscreen.atts);
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < NUM_GBUFFER_TARGETS; i++) {
         sg_destroy_image(state.offscreen.atts_desc.colors[i].image);
         sg_destroy_image(state.offscreen.atts_desc.resolves[i].image);
     }
     sg_destroy_image(state.offscreen.atts_desc.depth_stencil.image);
 
-    // create offscreen rendertarget images and pass
+    // create offscreen rendertarget images and pass with the current G-buffer layout
+    const gbuffer_layout_t* layout = &layouts[state.layout];
     sg_image_desc color_img_desc = {
         .render_target = true,
         .width = width,
@@ -66,31 +148,131 @@ void create_offscreen_attachments(int width, int height) {
     depth_img_desc.pixel_format = SG_PIXELFORMAT_DEPTH;
     depth_img_desc.label = "depth image";
     state.offscreen.atts_desc = (sg_attachments_desc){
-        .colors = {
-            [0].image = sg_make_image(&color_img_desc),
-            [1].image = sg_make_image(&color_img_desc),
-            [2].image = sg_make_image(&color_img_desc)
-        },
-        .resolves = {
-            [0].image = sg_make_image(&resolve_img_desc),
-            [1].image = sg_make_image(&resolve_img_desc),
-            [2].image = sg_make_image(&resolve_img_desc),
-        },
         .depth_stencil.image = sg_make_image(&depth_img_desc),
         .label = "offscreen pass"
     };
+    state.offscreen.num_bytes = (size_t)sg_query_surface_pitch(SG_PIXELFORMAT_DEPTH, width, height, 1) * OFFSCREEN_SAMPLE_COUNT;
+    for (int i = 0; i < NUM_GBUFFER_TARGETS; i++) {
+        color_img_desc.pixel_format = layout->formats[i];
+        resolve_img_desc.pixel_format = layout->formats[i];
+        state.offscreen.atts_desc.colors[i].image = sg_make_image(&color_img_desc);
+        state.offscreen.atts_desc.resolves[i].image = sg_make_image(&resolve_img_desc);
+        // one MSAA image plus one resolve image per G-buffer target
+        state.offscreen.num_bytes += (size_t)sg_query_surface_pitch(layout->formats[i], width, height, 1) * (OFFSCREEN_SAMPLE_COUNT + 1);
+    }
     state.offscreen.atts = sg_make_attachments(&state.offscreen.atts_desc);
 
     // also need to update the fullscreen-quad texture bindings
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < NUM_GBUFFER_TARGETS; i++) {
         state.fsq.bind.images[i] = state.offscreen.atts_desc.resolves[i].image;
     }
 }
 
+static void select_layout(int layout) {
+    if (state.layout_supported[layout]) {
+        state.layout = layout;
+        create_offscreen_attachments(sapp_width(), sapp_height());
+        reset_stats();
+    }
+}
+
+// returns the first supported layout starting at 'layout', or NUM_LAYOUTS
+static int next_supported_layout(int layout) {
+    while ((layout < NUM_LAYOUTS) && !state.layout_supported[layout]) {
+        layout++;
+    }
+    return layout;
+}
+
+// skip unsupported layouts and select the benchmark's current layout,
+// or restore the layout from before the benchmark when done
+static void bench_select_layout(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    while (run->active && !state.layout_supported[run->config]) {
+        gputimer_bench_next(run);
+    }
+    select_layout(run->active ? run->config : state.bench.saved_layout);
+}
+
+// the benchmark steps through all supported layouts and averages the
+// GPU times of each over BENCH_FRAMES frames
+static void bench_start(void) {
+    state.bench.saved_layout = state.layout;
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        state.bench.results[i] = (result_t){0};
+    }
+    gputimer_bench_start(&state.bench.run, NUM_LAYOUTS, BENCH_FRAMES);
+    bench_select_layout();
+}
+
+static void bench_update(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    if (!gputimer_bench_update(run)) {
+        return;
+    }
+    result_t* res = &state.bench.results[state.layout];
+    res->valid = true;
+    res->gbuffer_ms = gputimer_avg_ms(&run->avg, TIMER_GBUFFER);
+    res->lighting_ms = gputimer_avg_ms(&run->avg, TIMER_LIGHTING);
+    res->num_bytes = state.offscreen.num_bytes;
+    gputimer_bench_next(run);
+    bench_select_layout();
+}
+
+static void draw_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        if (!state.layout_supported[i]) {
+            sdtx_color3b(0x80, 0x80, 0x80);
+        } else if (i == state.layout) {
+            sdtx_color3b(0xFF, 0xFF, 0x00);
+        } else {
+            sdtx_color3b(0xFF, 0xFF, 0xFF);
+        }
+        sdtx_printf("%d: %s%s\n", i + 1, layouts[i].name, state.layout_supported[i] ? "" : " (n/a)");
+    }
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("\nmemory: %.1f MB\n", (double)state.offscreen.num_bytes / (1024.0 * 1024.0));
+    if (gputimer_supported()) {
+        sdtx_printf("gbuffer pass:  %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_GBUFFER));
+        sdtx_printf("lighting pass: %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_LIGHTING));
+    } else {
+        sdtx_puts("gpu timers not supported\n");
+    }
+    if (state.bench.run.active) {
+        sdtx_printf("\nbenchmark running: %s\n", layouts[state.layout].name);
+    } else if (state.bench.run.done) {
+        sdtx_printf("\nbenchmark (%dx%d):\n", sapp_width(), sapp_height());
+        sdtx_puts("layout               MB gbuffer lighting\n");
+        for (int i = 0; i < NUM_LAYOUTS; i++) {
+            const result_t* res = &state.bench.results[i];
+            if (res->valid) {
+                sdtx_printf("%-16s %6.1f %7.3f %8.3f\n",
+                    layouts[i].name,
+                    (double)res->num_bytes / (1024.0 * 1024.0),
+                    res->gbuffer_ms,
+                    res->lighting_ms);
+            } else {
+                sdtx_printf("%-16s    n/a\n", layouts[i].name);
+            }
+        }
+    } else {
+        sdtx_puts("\npress B to run benchmark\n");
+    }
+}
+
 // listen for window-resize events and recreate offscreen rendertargets
 void event(const sapp_event* e) {
     if (e->type == SAPP_EVENTTYPE_RESIZED) {
         create_offscreen_attachments(e->framebuffer_width, e->framebuffer_height);
+        reset_stats();
+    } else if ((e->type == SAPP_EVENTTYPE_KEY_DOWN) && !state.bench.run.active) {
+        if ((e->key_code >= SAPP_KEYCODE_1) && (e->key_code <= SAPP_KEYCODE_6)) {
+            select_layout((int)(e->key_code - SAPP_KEYCODE_1));
+        } else if (e->key_code == SAPP_KEYCODE_B) {
+            bench_start();
+        }
     }
     __dbgui_event(e);
 }
@@ -101,6 +283,20 @@ void init(void) {
         .logger.func = slog_func,
     });
     __dbgui_setup(sapp_sample_count());
+    stm_setup();
+    gputimer_setup();
+    gputimer_avg_init(&state.avg, NUM_AVG_FRAMES);
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+
+    // find the G-buffer layouts which are supported on this backend and start
+    // with the first, the RGBA8 layout is supported everywhere
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        state.layout_supported[i] = layout_supported(&layouts[i]);
+    }
+    state.layout = next_supported_layout(0);
 
     // a pass action for the default render pass
     state.pass_action = (sg_pass_action) {
@@ -109,41 +305,41 @@ void init(void) {
         .stencil.load_action = SG_LOADACTION_DONTCARE
     };
 
-    // render pass attachments with 3 color images, and a depth image
+    // render pass attachments with 3 G-buffer color images, and a depth image
     create_offscreen_attachments(sapp_width(), sapp_height());
 
     // cube vertex buffer
     vertex_t cube_vertices[] = {
-        // pos + brightness
-        { -1.0f, -1.0f, -1.0f,   1.0f },
-        {  1.0f, -1.0f, -1.0f,   1.0f },
-        {  1.0f,  1.0f, -1.0f,   1.0f },
-        { -1.0f,  1.0f, -1.0f,   1.0f },
-
-        { -1.0f, -1.0f,  1.0f,   0.8f },
-        {  1.0f, -1.0f,  1.0f,   0.8f },
-        {  1.0f,  1.0f,  1.0f,   0.8f },
-        { -1.0f,  1.0f,  1.0f,   0.8f },
-
-        { -1.0f, -1.0f, -1.0f,   0.6f },
-        { -1.0f,  1.0f, -1.0f,   0.6f },
-        { -1.0f,  1.0f,  1.0f,   0.6f },
-        { -1.0f, -1.0f,  1.0f,   0.6f },
-
-        { 1.0f, -1.0f, -1.0f,    0.4f },
-        { 1.0f,  1.0f, -1.0f,    0.4f },
-        { 1.0f,  1.0f,  1.0f,    0.4f },
-        { 1.0f, -1.0f,  1.0f,    0.4f },
-
-        { -1.0f, -1.0f, -1.0f,   0.5f },
-        { -1.0f, -1.0f,  1.0f,   0.5f },
-        {  1.0f, -1.0f,  1.0f,   0.5f },
-        {  1.0f, -1.0f, -1.0f,   0.5f },
-
-        { -1.0f,  1.0f, -1.0f,   0.7f },
-        { -1.0f,  1.0f,  1.0f,   0.7f },
-        {  1.0f,  1.0f,  1.0f,   0.7f },
-        {  1.0f,  1.0f, -1.0f,   0.7f },
+        // pos + normal
+        { -1.0f, -1.0f, -1.0f,   0.0f,  0.0f, -1.0f },
+        {  1.0f, -1.0f, -1.0f,   0.0f,  0.0f, -1.0f },
+        {  1.0f,  1.0f, -1.0f,   0.0f,  0.0f, -1.0f },
+        { -1.0f,  1.0f, -1.0f,   0.0f,  0.0f, -1.0f },
+
+        { -1.0f, -1.0f,  1.0f,   0.0f,  0.0f,  1.0f },
+        {  1.0f, -1.0f,  1.0f,   0.0f,  0.0f,  1.0f },
+        {  1.0f,  1.0f,  1.0f,   0.0f,  0.0f,  1.0f },
+        { -1.0f,  1.0f,  1.0f,   0.0f,  0.0f,  1.0f },
+
+        { -1.0f, -1.0f, -1.0f,  -1.0f,  0.0f,  0.0f },
+        { -1.0f,  1.0f, -1.0f,  -1.0f,  0.0f,  0.0f },
+        { -1.0f,  1.0f,  1.0f,  -1.0f,  0.0f,  0.0f },
+        { -1.0f, -1.0f,  1.0f,  -1.0f,  0.0f,  0.0f },
+
+        {  1.0f, -1.0f, -1.0f,   1.0f,  0.0f,  0.0f },
+        {  1.0f,  1.0f, -1.0f,   1.0f,  0.0f,  0.0f },
+        {  1.0f,  1.0f,  1.0f,   1.0f,  0.0f,  0.0f },
+        {  1.0f, -1.0f,  1.0f,   1.0f,  0.0f,  0.0f },
+
+        { -1.0f, -1.0f, -1.0f,   0.0f, -1.0f,  0.0f },
+        { -1.0f, -1.0f,  1.0f,   0.0f, -1.0f,  0.0f },
+        {  1.0f, -1.0f,  1.0f,   0.0f, -1.0f,  0.0f },
+        {  1.0f, -1.0f, -1.0f,   0.0f, -1.0f,  0.0f },
+
+        { -1.0f,  1.0f, -1.0f,   0.0f,  1.0f,  0.0f },
+        { -1.0f,  1.0f,  1.0f,   0.0f,  1.0f,  0.0f },
+        {  1.0f,  1.0f,  1.0f,   0.0f,  1.0f,  0.0f },
+        {  1.0f,  1.0f, -1.0f,   0.0f,  1.0f,  0.0f },
     };
     sg_buffer cube_vbuf = sg_make_buffer(&(sg_buffer_desc){
         .data = SG_RANGE(cube_vertices),
@@ -165,51 +361,62 @@ void init(void) {
         .label = "cube indices"
     });
 
-    // a shader to render the cube into offscreen MRT render targest
+    // a shader to render the cube into the offscreen MRT G-buffer
     sg_shader offscreen_shd = sg_make_shader(offscreen_shader_desc(sg_query_backend()));
 
-    // pass action for offscreen pass
+    // pass action for offscreen pass, a zero albedo alpha marks the background,
+    // the MSAA images don't need to be stored since only the resolved images are sampled
     state.offscreen.pass_action = (sg_pass_action) {
         .colors = {
             [0] = {
                 .load_action = SG_LOADACTION_CLEAR,
                 .store_action = SG_STOREACTION_DONTCARE,
-                .clear_value = { 0.25f, 0.0f, 0.0f, 1.0f }
+                .clear_value = { 0.0f, 0.0f, 0.0f, 0.0f }
             },
             [1] = {
                 .load_action = SG_LOADACTION_CLEAR,
                 .store_action = SG_STOREACTION_DONTCARE,
-                .clear_value = { 0.0f, 0.25f, 0.0f, 1.0f }
+                .clear_value = { 0.0f, 0.0f, 0.0f, 0.0f }
             },
             [2] = {
                 .load_action = SG_LOADACTION_CLEAR,
                 .store_action = SG_STOREACTION_DONTCARE,
-                .clear_value = { 0.0f, 0.0f, 0.25f, 1.0f }
+                .clear_value = { 0.0f, 0.0f, 0.0f, 0.0f }
             }
         }
     };
 
-    // pipeline object for the offscreen-rendered cube
-    state.offscreen.pip = sg_make_pipeline(&(sg_pipeline_desc){
-        .layout = {
-            .buffers[0].stride = sizeof(vertex_t),
-            .attrs = {
-                [ATTR_offscreen_pos]     = { .offset=offsetof(vertex_t,x), .format=SG_VERTEXFORMAT_FLOAT3 },
-                [ATTR_offscreen_bright0] = { .offset=offsetof(vertex_t,b), .format=SG_VERTEXFORMAT_FLOAT }
-            }
-        },
-        .shader = offscreen_shd,
-        .index_type = SG_INDEXTYPE_UINT16,
-        .cull_mode = SG_CULLMODE_BACK,
-        .sample_count = OFFSCREEN_SAMPLE_COUNT,
-        .depth = {
-            .pixel_format = SG_PIXELFORMAT_DEPTH,
-            .compare = SG_COMPAREFUNC_LESS_EQUAL,
-            .write_enabled = true
-        },
-        .color_count = 3,
-        .label = "offscreen pipeline"
-    });
+    // one pipeline object per G-buffer layout for the offscreen-rendered cube
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        if (!state.layout_supported[i]) {
+            continue;
+        }
+        state.offscreen.pip[i] = sg_make_pipeline(&(sg_pipeline_desc){
+            .layout = {
+                .buffers[0].stride = sizeof(vertex_t),
+                .attrs = {
+                    [ATTR_offscreen_pos] = { .offset=offsetof(vertex_t,x), .format=SG_VERTEXFORMAT_FLOAT3 },
+                    [ATTR_offscreen_nrm] = { .offset=offsetof(vertex_t,nx), .format=SG_VERTEXFORMAT_FLOAT3 }
+                }
+            },
+            .shader = offscreen_shd,
+            .index_type = SG_INDEXTYPE_UINT16,
+            .cull_mode = SG_CULLMODE_BACK,
+            .sample_count = OFFSCREEN_SAMPLE_COUNT,
+            .depth = {
+                .pixel_format = SG_PIXELFORMAT_DEPTH,
+                .compare = SG_COMPAREFUNC_LESS_EQUAL,
+                .write_enabled = true
+            },
+            .color_count = NUM_GBUFFER_TARGETS,
+            .colors = {
+                [0].pixel_format = layouts[i].formats[0],
+                [1].pixel_format = layouts[i].formats[1],
+                [2].pixel_format = layouts[i].formats[2],
+            },
+            .label = "offscreen pipeline"
+        });
+    }
 
     // resource bindings for offscreen rendering
     state.offscreen.bind = (sg_bindings){
@@ -224,7 +431,7 @@ void init(void) {
         .label = "quad vertices"
     });
 
-    // a shader to render a fullscreen rectangle by adding the 3 offscreen-rendered images
+    // a shader to render a fullscreen rectangle which lights the G-buffer
     sg_shader fsq_shd = sg_make_shader(fsq_shader_desc(sg_query_backend()));
 
     // the pipeline object to render the fullscreen quad
@@ -237,10 +444,11 @@ void init(void) {
         .label = "fullscreen quad pipeline"
     });
 
-    // a sampler object to sample the offscreen render targets as textures
+    // a sampler object to sample the offscreen render targets as textures,
+    // not all G-buffer pixel formats are filterable (e.g. RGBA32F)
     sg_sampler smp = sg_make_sampler(&(sg_sampler_desc){
-        .min_filter = SG_FILTER_LINEAR,
-        .mag_filter = SG_FILTER_LINEAR,
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
         .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
     });
@@ -249,9 +457,9 @@ void init(void) {
     state.fsq.bind = (sg_bindings){
         .vertex_buffers[0] = quad_vbuf,
         .images = {
-            [IMG_tex0] = state.offscreen.atts_desc.resolves[0].image,
-            [IMG_tex1] = state.offscreen.atts_desc.resolves[1].image,
-            [IMG_tex2] = state.offscreen.atts_desc.resolves[2].image
+            [IMG_albedo_tex] = state.offscreen.atts_desc.resolves[0].image,
+            [IMG_normal_tex] = state.offscreen.atts_desc.resolves[1].image,
+            [IMG_depth_tex] = state.offscreen.atts_desc.resolves[2].image
         },
         .samplers[SMP_smp] = smp,
     };
@@ -273,6 +481,12 @@ void init(void) {
 }
 
 void frame(void) {
+    if (state.bench.run.active) {
+        bench_update();
+    } else {
+        gputimer_avg_update(&state.avg);
+    }
+
     // view-projection matrix
     hmm_mat4 proj = HMM_Perspective(60.0f, sapp_widthf()/sapp_heightf(), 0.01f, 10.0f);
     hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 1.5f, 6.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
@@ -287,37 +501,52 @@ void frame(void) {
     hmm_mat4 rym = HMM_Rotate(state.ry, HMM_Vec3(0.0f, 1.0f, 0.0f));
     hmm_mat4 model = HMM_MultiplyMat4(rxm, rym);
     offscreen_params.mvp = HMM_MultiplyMat4(view_proj, model);
-    fsq_params.offset = HMM_Vec2(HMM_SinF(state.rx*0.01f)*0.1f, HMM_SinF(state.ry*0.01f)*0.1f);
+    offscreen_params.mv = HMM_MultiplyMat4(view, model);
+    const offscreen_fs_params_t offscreen_fs_params = { .normal_encoding = layouts[state.layout].normal_encoding };
+    // the G-buffer normals are in view space, so the light direction is too
+    fsq_params.light_dir = HMM_NormalizeVec3(HMM_MultiplyMat4ByVec4(view, HMM_Vec4(1.0f, 1.0f, 1.0f, 0.0f)).XYZ);
+    fsq_params.normal_encoding = layouts[state.layout].normal_encoding;
 
     // render cube into MRT offscreen render targets
+    gputimer_begin_frame();
+    gputimer_begin(TIMER_GBUFFER);
     sg_begin_pass(&(sg_pass){ .action = state.offscreen.pass_action, .attachments = state.offscreen.atts });
-    sg_apply_pipeline(state.offscreen.pip);
+    sg_apply_pipeline(state.offscreen.pip[state.layout]);
     sg_apply_bindings(&state.offscreen.bind);
     sg_apply_uniforms(UB_offscreen_params, &SG_RANGE(offscreen_params));
+    sg_apply_uniforms(UB_offscreen_fs_params, &SG_RANGE(offscreen_fs_params));
     sg_draw(0, 36, 1);
     sg_end_pass();
+    gputimer_end(TIMER_GBUFFER);
 
-    // render fullscreen quad with the 'composed image', plus 3 small debug-view quads
+    // render fullscreen quad which lights the G-buffer, plus 3 small debug-view quads
+    gputimer_begin(TIMER_LIGHTING);
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
     sg_apply_pipeline(state.fsq.pip);
     sg_apply_bindings(&state.fsq.bind);
     sg_apply_uniforms(UB_fsq_params, &SG_RANGE(fsq_params));
     sg_draw(0, 4, 1);
     sg_apply_pipeline(state.dbg.pip);
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < NUM_GBUFFER_TARGETS; i++) {
         sg_apply_viewport(i*100, 0, 100, 100, false);
         state.dbg.bind.images[IMG_tex] = state.offscreen.atts_desc.resolves[i].image;
         sg_apply_bindings(&state.dbg.bind);
         sg_draw(0, 4, 1);
     }
     sg_apply_viewport(0, 0, sapp_width(), sapp_height(), false);
+    draw_stats();
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
+    gputimer_end(TIMER_LIGHTING);
+    gputimer_end_frame();
     sg_commit();
 }
 
 void cleanup(void) {
     __dbgui_shutdown();
+    sdtx_shutdown();
+    gputimer_shutdown();
     sg_shutdown();
 }
 
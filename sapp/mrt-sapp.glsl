@@ -2,81 +2,157 @@
 //  shaders for mrt-sapp sample
 //------------------------------------------------------------------------------
 @ctype mat4 hmm_mat4
-@ctype vec2 hmm_vec2
+@ctype vec3 hmm_vec3
 
-// shaders for offscreen-pass rendering
+// G-buffer normal encodings, must match the NORMAL_* enum in mrt-sapp.c
+@block normal_encoding
+const int NORMAL_XYZ = 0;           // signed xyz in a float format
+const int NORMAL_XYZ_UNORM = 1;     // xyz * 0.5 + 0.5 in a unorm format
+const int NORMAL_XY = 2;            // view space xy, z is reconstructed
+const int NORMAL_OCT = 3;           // octahedral encoding in two unorm channels
+
+vec2 oct_wrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2((v.x >= 0.0) ? 1.0 : -1.0, (v.y >= 0.0) ? 1.0 : -1.0);
+}
+
+vec2 oct_encode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = (n.z >= 0.0) ? n.xy : oct_wrap(n.xy);
+    return e * 0.5 + 0.5;
+}
+
+vec3 oct_decode(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2((n.x >= 0.0) ? -t : t, (n.y >= 0.0) ? -t : t);
+    return normalize(n);
+}
+
+vec4 encode_normal(vec3 n, int encoding) {
+    if (encoding == NORMAL_XYZ) {
+        return vec4(n, 0.0);
+    } else if (encoding == NORMAL_XYZ_UNORM) {
+        return vec4(n * 0.5 + 0.5, 0.0);
+    } else if (encoding == NORMAL_XY) {
+        return vec4(n.xy, 0.0, 0.0);
+    } else {
+        return vec4(oct_encode(n), 0.0, 0.0);
+    }
+}
+
+vec3 decode_normal(vec4 e, int encoding) {
+    if (encoding == NORMAL_XYZ) {
+        return normalize(e.xyz);
+    } else if (encoding == NORMAL_XYZ_UNORM) {
+        return normalize(e.xyz * 2.0 - 1.0);
+    } else if (encoding == NORMAL_XY) {
+        return vec3(e.xy, sqrt(max(0.0, 1.0 - dot(e.xy, e.xy))));
+    } else {
+        return oct_decode(e.xy);
+    }
+}
+@end
+
+// shaders for offscreen-pass rendering into the G-buffer
 @vs vs_offscreen
 
 layout(binding=0) uniform offscreen_params {
     mat4 mvp;
+    mat4 mv;
 };
 
 in vec4 pos;
-in float bright0;
+in vec3 nrm;
+
+out vec3 albedo;
+out vec3 view_nrm;
+out float view_depth;
 
-out float bright;
+// the far plane distance of the projection matrix in mrt-sapp.c, linear
+// depth is stored normalized to 0..1 so that it also fits into unorm formats
+const float far_plane = 10.0;
 
 void main() {
     gl_Position = mvp * pos;
-    bright = bright0;
+    albedo = abs(nrm) * 0.6 + 0.3;
+    view_nrm = (mv * vec4(nrm, 0.0)).xyz;
+    view_depth = -(mv * pos).z / far_plane;
 }
 @end
 
 @fs fs_offscreen
-in float bright;
+@include_block normal_encoding
 
-layout(location=0) out vec4 frag_color_0;
-layout(location=1) out vec4 frag_color_1;
-layout(location=2) out vec4 frag_color_2;
+layout(binding=1) uniform offscreen_fs_params {
+    int normal_encoding;
+};
+
+in vec3 albedo;
+in vec3 view_nrm;
+in float view_depth;
+
+layout(location=0) out vec4 frag_albedo;
+layout(location=1) out vec4 frag_normal;
+layout(location=2) out vec4 frag_depth;
 
 void main() {
-    frag_color_0 = vec4(bright, 0.0, 0.0, 1.0);
-    frag_color_1 = vec4(0.0, bright, 0.0, 1.0);
-    frag_color_2 = vec4(0.0, 0.0, bright, 1.0);
+    // albedo alpha is the coverage, after the MSAA resolve this is the
+    // fraction of samples covered by geometry (so the albedo format needs
+    // enough alpha bits to represent 1/sample_count steps)
+    frag_albedo = vec4(albedo, 1.0);
+    frag_normal = encode_normal(normalize(view_nrm), normal_encoding);
+    frag_depth = vec4(view_depth, 0.0, 0.0, 0.0);
 }
 @end
 
 @program offscreen vs_offscreen fs_offscreen
 
-// shaders for rendering a fullscreen-quad in default pass
+// shaders for the fullscreen lighting pass which reads the G-buffer
 @vs vs_fsq
-@glsl_options flip_vert_y
-
-layout(binding=0) uniform fsq_params {
-    vec2 offset;
-};
-
 in vec2 pos;
 
-out vec2 uv0;
-out vec2 uv1;
-out vec2 uv2;
-
 void main() {
     gl_Position = vec4(pos*2.0-1.0, 0.5, 1.0);
-    uv0 = pos + vec2(offset.x, 0.0);
-    uv1 = pos + vec2(0.0, offset.y);
-    uv2 = pos;
 }
 @end
 
 @fs fs_fsq
-layout(binding=0) uniform texture2D tex0;
-layout(binding=1) uniform texture2D tex1;
-layout(binding=2) uniform texture2D tex2;
+@include_block normal_encoding
+@image_sample_type albedo_tex unfilterable_float
+@image_sample_type normal_tex unfilterable_float
+@image_sample_type depth_tex unfilterable_float
+@sampler_type smp nonfiltering
+layout(binding=0) uniform texture2D albedo_tex;
+layout(binding=1) uniform texture2D normal_tex;
+layout(binding=2) uniform texture2D depth_tex;
 layout(binding=0) uniform sampler smp;
 
-in vec2 uv0;
-in vec2 uv1;
-in vec2 uv2;
+layout(binding=0) uniform fsq_params {
+    vec3 light_dir;
+    int normal_encoding;
+};
 
 out vec4 frag_color;
 
 void main() {
-    vec3 c0 = texture(sampler2D(tex0, smp), uv0).xyz;
-    vec3 c1 = texture(sampler2D(tex1, smp), uv1).xyz;
-    vec3 c2 = texture(sampler2D(tex2, smp), uv2).xyz;
-    frag_color = vec4(c0 + c1 + c2, 1.0);
+    // the G-buffer has the same size as the framebuffer
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    vec4 albedo = texelFetch(sampler2D(albedo_tex, smp), p, 0);
+    vec4 enc_nrm = texelFetch(sampler2D(normal_tex, smp), p, 0);
+    float depth = texelFetch(sampler2D(depth_tex, smp), p, 0).x;
+    vec3 bg_color = vec3(0.25, 0.3, 0.35);
+    float coverage = albedo.a;
+    if (coverage > 0.0) {
+        // all G-buffer targets are cleared to zero and MSAA-resolved, at
+        // silhouettes they hold the encoded values scaled by the coverage
+        vec3 n = decode_normal(enc_nrm / coverage, normal_encoding);
+        float diff = max(dot(n, light_dir), 0.0);
+        float fog = clamp((depth / coverage - 0.45) * 2.0, 0.0, 0.6);
+        vec3 lit = (albedo.xyz / coverage) * (0.2 + 0.8 * diff);
+        bg_color = mix(bg_color, mix(lit, bg_color, fog), coverage);
+    }
+    frag_color = vec4(bg_color, 1.0);
 }
 @end
 
@@ -96,6 +172,8 @@ void main() {
 @end
 
 @fs fs_dbg
+@image_sample_type tex unfilterable_float
+@sampler_type smp nonfiltering
 layout(binding=0) uniform texture2D tex;
 layout(binding=0) uniform sampler smp;
 
@@ -108,5 +186,3 @@ void main() {
 @end
 
 @program dbg vs_dbg fs_dbg
-
-
@@ -2,6 +2,11 @@
 //  nuklear-images-sapp.c
 //
 //  Demonstrate/test using sg_image textures via nk_image in Nuklear UI.
+//
+//  Also renders a grid of small icon images, either with one texture per
+//  icon (which breaks the UI rendering into one draw call per icon), or
+//  packed into a single texture atlas via util/atlas.h (which allows
+//  Nuklear to merge all icons into a single draw call).
 //------------------------------------------------------------------------------
 #include "sokol_gfx.h"
 #include "sokol_app.h"
@@ -23,12 +28,17 @@
 #include "nuklear/nuklear.h"
 #define SOKOL_NUKLEAR_IMPL
 #include "sokol_nuklear.h"
+#include "util/atlas.h"
 
 #define OFFSCREEN_WIDTH (32)
 #define OFFSCREEN_HEIGHT (32)
 #define OFFSCREEN_COLOR_FORMAT (SG_PIXELFORMAT_RGBA8)
 #define OFFSCREEN_DEPTH_FORMAT (SG_PIXELFORMAT_DEPTH)
 #define OFFSCREEN_SAMPLE_COUNT (1)
+#define NUM_ICONS (64)
+#define ICONS_PER_ROW (12)
+#define ICON_SIZE (ATLAS_ICON_SIZE)
+#define ATLAS_SIZE (256)
 
 static struct {
     double angle_deg;
@@ -49,6 +59,14 @@ static struct {
         snk_image_t img_nearest_repeat;
         snk_image_t img_linear_mirror;
     } ui;
+    struct {
+        nk_bool use_atlas;
+        snk_image_t images[NUM_ICONS];
+        snk_image_t atlas;
+        atlas_rect_t rects[NUM_ICONS];
+        int num_draws[2];           // [0]: separate textures, [1]: atlas
+        int num_bindings[2];
+    } icons;
 } state;
 
 static void draw_cube(void);
@@ -157,9 +175,48 @@ static void init(void) {
             .wrap_v = SG_WRAP_MIRRORED_REPEAT,
         })
     });
+
+    // create the icon images, both as separate textures, and packed into an atlas
+    sg_sampler icon_smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+    });
+    atlas_t atlas;
+    atlas_init(&atlas, &(atlas_desc_t){ .width = ATLAS_SIZE, .height = ATLAS_SIZE });
+    for (int i = 0; i < NUM_ICONS; i++) {
+        uint32_t pixels[ICON_SIZE * ICON_SIZE];
+        atlas_make_icon_pixels(i, pixels);
+        state.icons.images[i] = snk_make_image(&(snk_image_desc_t){
+            .image = sg_make_image(&(sg_image_desc){
+                .width = ICON_SIZE,
+                .height = ICON_SIZE,
+                .pixel_format = SG_PIXELFORMAT_RGBA8,
+                .data.subimage[0][0] = SG_RANGE(pixels),
+            }),
+            .sampler = icon_smp,
+        });
+        const bool packed = atlas_add(&atlas, ICON_SIZE, ICON_SIZE, pixels, &state.icons.rects[i]);
+        assert(packed); (void)packed;
+    }
+    state.icons.atlas = snk_make_image(&(snk_image_desc_t){
+        .image = atlas_make_image(&atlas, "icon-atlas"),
+        .sampler = icon_smp,
+    });
+    atlas_discard(&atlas);
+    state.icons.use_atlas = true;
+
+    // frame stats are used to display the number of draw calls
+    sg_enable_frame_stats();
 }
 
 static void frame(void) {
+    // draw call statistics of the previous frame
+    const sg_frame_stats stats = sg_query_frame_stats();
+    state.icons.num_draws[state.icons.use_atlas ? 1 : 0] = (int)stats.num_draw;
+    state.icons.num_bindings[state.icons.use_atlas ? 1 : 0] = (int)stats.num_apply_bindings;
+
     state.angle_deg += sapp_frame_duration() * 60.0;
     const float a = sgl_rad((float)state.angle_deg);
 
@@ -179,13 +236,28 @@ static void frame(void) {
     // are then rendered later in the frame in the sokol-gfx default pass)
     struct nk_context* ctx = snk_new_frame();
     nk_style_hide_cursor(ctx);
-    if (nk_begin(ctx, "Sokol + Nuklear Image Test", nk_rect(10, 10, 540, 570), NK_WINDOW_BORDER|NK_WINDOW_SCALABLE|NK_WINDOW_MOVABLE|NK_WINDOW_MINIMIZABLE)) {
+    if (nk_begin(ctx, "Sokol + Nuklear Image Test", nk_rect(10, 10, 540, 770), NK_WINDOW_BORDER|NK_WINDOW_SCALABLE|NK_WINDOW_MOVABLE|NK_WINDOW_MINIMIZABLE)) {
         nk_layout_row_static(ctx, 256, 256, 2);
         const struct nk_rect region = { 0, 0, 4, 4 };
         nk_image(ctx, nk_image_handle(snk_nkhandle(state.ui.img_nearest_clamp)));
         nk_image(ctx, nk_image_handle(snk_nkhandle(state.ui.img_linear_clamp)));
         nk_image(ctx, nk_subimage_handle(snk_nkhandle(state.ui.img_nearest_repeat), 1, 1, region));
         nk_image(ctx, nk_subimage_handle(snk_nkhandle(state.ui.img_linear_mirror), 1, 1, region));
+
+        nk_layout_row_dynamic(ctx, 20, 1);
+        nk_checkbox_label(ctx, "Pack icons into atlas", &state.icons.use_atlas);
+        nk_labelf(ctx, NK_TEXT_LEFT, "sg_draw() per frame: %d (separate), %d (atlas)", state.icons.num_draws[0], state.icons.num_draws[1]);
+        nk_labelf(ctx, NK_TEXT_LEFT, "sg_apply_bindings() per frame: %d (separate), %d (atlas)", state.icons.num_bindings[0], state.icons.num_bindings[1]);
+        nk_layout_row_static(ctx, 2 * ICON_SIZE, 2 * ICON_SIZE, ICONS_PER_ROW);
+        for (int i = 0; i < NUM_ICONS; i++) {
+            if (state.icons.use_atlas) {
+                const atlas_rect_t r = state.icons.rects[i];
+                const struct nk_rect sub_region = { (float)r.x, (float)r.y, (float)r.w, (float)r.h };
+                nk_image(ctx, nk_subimage_handle(snk_nkhandle(state.icons.atlas), ATLAS_SIZE, ATLAS_SIZE, sub_region));
+            } else {
+                nk_image(ctx, nk_image_handle(snk_nkhandle(state.icons.images[i])));
+            }
+        }
     }
     nk_end(ctx);
 
@@ -225,7 +297,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .event_cb = input,
         .enable_clipboard = true,
         .width = 580,
-        .height = 600,
+        .height = 800,
         .window_title = "nuklear-image-sapp.c",
         .icon.sokol_default = true,
         .logger.func = slog_func,
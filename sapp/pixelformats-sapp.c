@@ -1,11 +1,30 @@
 //------------------------------------------------------------------------------
 //  pixelformats-sapp.c
 //  Test pixelformat capabilities.
+//
+//  The benchmark window measures for each pixel format:
+//
+//  - upload: the CPU time of sg_update_image() on a 1024x1024 stream
+//    image, as MB/s (on GL this includes the driver copy, but not
+//    necessarily the transfer to GPU memory)
+//  - sample: the GPU time of rendering a 1024x1024 RGBA8 target with
+//    8 texture reads per pixel from the format, as GTexel/s (with linear
+//    filtering if the format is filterable)
+//  - fill: the GPU time of rendering a fullscreen quad 16 times into a
+//    1024x1024 render target of the format, as GPixel/s
+//
+//  GPU times are measured with libs/util/gputimer.h (GL and D3D11 only).
+//  Results are also written to stdout in CSV format.
 //------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "sokol_gfx.h"
 #include "sokol_app.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#include "util/gputimer.h"
 #include "cimgui.h"
 #define SOKOL_IMGUI_IMPL
 #include "sokol_imgui.h"
@@ -14,6 +33,24 @@
 #include "HandmadeMath.h"
 #include "pixelformats-sapp.glsl.h"
 
+#define BENCH_SIZE (1024)
+#define BENCH_FILL_OVERDRAW (16)
+#define BENCH_SAMPLE_TAPS (8)       // must match fs_sample in pixelformats-sapp.glsl
+#define BENCH_FRAMES (32)
+
+typedef enum {
+    BENCH_UPLOAD,
+    BENCH_SAMPLE,
+    BENCH_FILL,
+    BENCH_NUM_PHASES,
+} bench_phase_t;
+
+typedef struct {
+    size_t bytes_per_pixel;
+    bool valid[BENCH_NUM_PHASES];
+    double ms[BENCH_NUM_PHASES];
+} bench_result_t;
+
 static struct {
     struct {
         bool valid;
@@ -37,10 +74,35 @@ static struct {
     float rx, ry;
     cube_vs_params_t cube_vs_params;
     bg_fs_params_t bg_fs_params;
+    struct {
+        gputimer_bench_t run;   // config is an index into format x phase
+        int fmt;                // format of the per-format resources
+        size_t num_bytes;       // size of the BENCH_SIZE x BENCH_SIZE image for the current format
+        uint8_t* pixels;
+        // per-format resources, created when the benchmark moves to the next format
+        sg_image img;
+        sg_image rt;
+        sg_attachments rt_atts;
+        sg_pipeline fill_pip;
+        // format-independent resources
+        sg_image sample_rt;
+        sg_attachments sample_atts;
+        sg_shader fill_shd;
+        sg_pipeline sample_pip;
+        sg_pipeline sample_nofilter_pip;
+        sg_sampler smp_linear;
+        sg_sampler smp_nearest;
+        bench_result_t results[_SG_PIXELFORMAT_NUM];
+    } bench;
 } state;
 
 static const char* pixelformat_string(sg_pixel_format fmt);
 static sg_range gen_pixels(sg_pixel_format fmt);
+static void bench_setup(void);
+static void bench_start(void);
+static void bench_finish(void);
+static void bench_frame(void);
+static void draw_bench_ui(void);
 
 // a 'disabled' texture pattern with a cross
 #define X 0xFF0000FF
@@ -72,6 +134,8 @@ static void init(void) {
     simgui_setup(&(simgui_desc_t){
         .logger.func = slog_func,
     });
+    stm_setup();
+    gputimer_setup();
 
     // create all the textures, samplers and render targets
     sg_image render_depth_img = sg_make_image(&(sg_image_desc){
@@ -281,6 +345,8 @@ static void init(void) {
     state.bg_bindings.vertex_buffers[0] = sg_make_buffer(&(sg_buffer_desc){
         .data = SG_RANGE(vertices)
     });
+
+    bench_setup();
 }
 
 static void frame(void) {
@@ -300,6 +366,11 @@ static void frame(void) {
     state.cube_vs_params.mvp = HMM_MultiplyMat4(view_proj, model);
     state.bg_fs_params.tick += 1.0f * t;
 
+    gputimer_begin_frame();
+    if (state.bench.run.active) {
+        bench_frame();
+    }
+
     // render into all the offscreen render targets
     for (int i = SG_PIXELFORMAT_NONE+1; i < SG_PIXELFORMAT_DEPTH; i++) {
         if (!state.fmt[i].valid) {
@@ -385,6 +456,7 @@ static void frame(void) {
         igEndChild();
     }
     igEnd();
+    draw_bench_ui();
 
     // sokol-gfx rendering...
     sg_begin_pass(&(sg_pass){
@@ -395,6 +467,7 @@ static void frame(void) {
     });
     simgui_render();
     sg_end_pass();
+    gputimer_end_frame();
     sg_commit();
 }
 
@@ -403,6 +476,8 @@ static void input(const sapp_event* e) {
 }
 
 static void cleanup(void) {
+    free(state.bench.pixels);
+    gputimer_shutdown();
     simgui_shutdown();
     sg_shutdown();
 }
@@ -422,6 +497,294 @@ sapp_desc sokol_main(int argc, char* argv[]) {
     };
 }
 
+/* the benchmark steps through all formats and the phases supported by
+   each format, and averages each over BENCH_FRAMES frames
+*/
+static const char* bench_phase_names[BENCH_NUM_PHASES] = { "upload", "sample", "fill" };
+
+static void bench_setup(void) {
+    state.bench.fill_shd = sg_make_shader(bg_shader_desc(sg_query_backend()));
+    state.bench.sample_rt = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = BENCH_SIZE,
+        .height = BENCH_SIZE,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = 1,
+    });
+    state.bench.sample_atts = sg_make_attachments(&(sg_attachments_desc){
+        .colors[0].image = state.bench.sample_rt,
+    });
+    state.bench.sample_pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout.attrs[ATTR_sample_position].format = SG_VERTEXFORMAT_FLOAT2,
+        .shader = sg_make_shader(sample_shader_desc(sg_query_backend())),
+        .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
+        .sample_count = 1,
+        .depth.pixel_format = SG_PIXELFORMAT_NONE,
+        .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+    });
+    state.bench.sample_nofilter_pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout.attrs[ATTR_sample_nofilter_position].format = SG_VERTEXFORMAT_FLOAT2,
+        .shader = sg_make_shader(sample_nofilter_shader_desc(sg_query_backend())),
+        .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
+        .sample_count = 1,
+        .depth.pixel_format = SG_PIXELFORMAT_NONE,
+        .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+    });
+    state.bench.smp_linear = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_REPEAT,
+        .wrap_v = SG_WRAP_REPEAT,
+    });
+    state.bench.smp_nearest = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_REPEAT,
+        .wrap_v = SG_WRAP_REPEAT,
+    });
+}
+
+static bool bench_phase_supported(sg_pixel_format fmt, bench_phase_t phase) {
+    const sg_pixelformat_info fmt_info = sg_query_pixelformat(fmt);
+    switch (phase) {
+        case BENCH_UPLOAD:
+        case BENCH_SAMPLE:
+            return fmt_info.sample;
+        case BENCH_FILL:
+            return fmt_info.render;
+        default:
+            return false;
+    }
+}
+
+static void bench_destroy_resources(void) {
+    sg_destroy_pipeline(state.bench.fill_pip);
+    sg_destroy_attachments(state.bench.rt_atts);
+    sg_destroy_image(state.bench.rt);
+    sg_destroy_image(state.bench.img);
+    state.bench.fill_pip = (sg_pipeline){0};
+    state.bench.rt_atts = (sg_attachments){0};
+    state.bench.rt = (sg_image){0};
+    state.bench.img = (sg_image){0};
+}
+
+// create the benchmark resources for a format, and fill the upload
+// data by tiling the 8x8 checkerboard of the capability test
+static void bench_create_resources(sg_pixel_format fmt) {
+    bench_destroy_resources();
+    const sg_range tile = gen_pixels(fmt);
+    const size_t tile_row_bytes = tile.size / 8;
+    state.bench.num_bytes = tile.size * (BENCH_SIZE / 8) * (BENCH_SIZE / 8);
+    uint8_t* dst = state.bench.pixels;
+    for (int y = 0; y < BENCH_SIZE; y++) {
+        const uint8_t* src = (const uint8_t*)tile.ptr + (size_t)(y & 7) * tile_row_bytes;
+        for (int x = 0; x < BENCH_SIZE; x += 8) {
+            memcpy(dst, src, tile_row_bytes);
+            dst += tile_row_bytes;
+        }
+    }
+    if (bench_phase_supported(fmt, BENCH_UPLOAD)) {
+        state.bench.img = sg_make_image(&(sg_image_desc){
+            .usage = SG_USAGE_STREAM,
+            .width = BENCH_SIZE,
+            .height = BENCH_SIZE,
+            .pixel_format = fmt,
+        });
+    }
+    if (bench_phase_supported(fmt, BENCH_FILL)) {
+        state.bench.rt = sg_make_image(&(sg_image_desc){
+            .render_target = true,
+            .width = BENCH_SIZE,
+            .height = BENCH_SIZE,
+            .pixel_format = fmt,
+            .sample_count = 1,
+        });
+        state.bench.rt_atts = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = state.bench.rt,
+        });
+        state.bench.fill_pip = sg_make_pipeline(&(sg_pipeline_desc){
+            .layout.attrs[ATTR_bg_position].format = SG_VERTEXFORMAT_FLOAT2,
+            .shader = state.bench.fill_shd,
+            .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
+            .sample_count = 1,
+            .depth.pixel_format = SG_PIXELFORMAT_NONE,
+            .colors[0].pixel_format = fmt,
+        });
+    }
+}
+
+static sg_pixel_format bench_format(void) {
+    return (sg_pixel_format)(state.bench.run.config / BENCH_NUM_PHASES);
+}
+
+static bench_phase_t bench_phase(void) {
+    return (bench_phase_t)(state.bench.run.config % BENCH_NUM_PHASES);
+}
+
+// skip over unsupported format/phase combinations and create the per-format
+// resources when moving to the next format, returns false when all formats are done
+static bool bench_next(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    while (run->active) {
+        const sg_pixel_format fmt = bench_format();
+        if ((fmt > SG_PIXELFORMAT_NONE) && state.fmt[fmt].valid && bench_phase_supported(fmt, bench_phase())) {
+            if (state.bench.fmt != (int)fmt) {
+                state.bench.fmt = (int)fmt;
+                bench_create_resources(fmt);
+            }
+            return true;
+        }
+        gputimer_bench_next(run);
+    }
+    return false;
+}
+
+static void bench_print_csv(void) {
+    printf("format,bytes_per_pixel,upload_ms,upload_mb_per_sec,sample_ms,sample_gtexel_per_sec,fill_ms,fill_gpixel_per_sec\n");
+    const double num_pixels = (double)(BENCH_SIZE * BENCH_SIZE);
+    for (int i = SG_PIXELFORMAT_NONE+1; i < SG_PIXELFORMAT_DEPTH; i++) {
+        if (!state.fmt[i].valid) {
+            continue;
+        }
+        const bench_result_t* res = &state.bench.results[i];
+        printf("%s,%zu", pixelformat_string((sg_pixel_format)i), res->bytes_per_pixel);
+        if (res->valid[BENCH_UPLOAD]) {
+            printf(",%.4f,%.1f", res->ms[BENCH_UPLOAD], (num_pixels * (double)res->bytes_per_pixel / (1024.0 * 1024.0)) / (res->ms[BENCH_UPLOAD] / 1000.0));
+        } else {
+            printf(",,");
+        }
+        if (res->valid[BENCH_SAMPLE]) {
+            printf(",%.4f,%.3f", res->ms[BENCH_SAMPLE], (num_pixels * BENCH_SAMPLE_TAPS) / (res->ms[BENCH_SAMPLE] * 1000000.0));
+        } else {
+            printf(",,");
+        }
+        if (res->valid[BENCH_FILL]) {
+            printf(",%.4f,%.3f\n", res->ms[BENCH_FILL], (num_pixels * BENCH_FILL_OVERDRAW) / (res->ms[BENCH_FILL] * 1000000.0));
+        } else {
+            printf(",,\n");
+        }
+    }
+}
+
+static void bench_start(void) {
+    if (!state.bench.pixels) {
+        // big enough for the biggest format (RGBA32F)
+        state.bench.pixels = (uint8_t*) malloc(BENCH_SIZE * BENCH_SIZE * 16);
+    }
+    for (int i = 0; i < _SG_PIXELFORMAT_NUM; i++) {
+        state.bench.results[i] = (bench_result_t){0};
+    }
+    state.bench.fmt = SG_PIXELFORMAT_NONE;
+    gputimer_bench_start(&state.bench.run, SG_PIXELFORMAT_DEPTH * BENCH_NUM_PHASES, BENCH_FRAMES);
+    if (!bench_next()) {
+        bench_finish();
+    }
+}
+
+static void bench_finish(void) {
+    bench_destroy_resources();
+    bench_print_csv();
+}
+
+// run one frame of the current benchmark phase
+static void bench_frame(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    const sg_pixel_format fmt = bench_format();
+    const bench_phase_t phase = bench_phase();
+    switch (phase) {
+        case BENCH_UPLOAD: {
+            // stream images can only be updated once per frame
+            const uint64_t start = stm_now();
+            sg_update_image(state.bench.img, &(sg_image_data){
+                .subimage[0][0] = { .ptr = state.bench.pixels, .size = state.bench.num_bytes },
+            });
+            gputimer_avg_add_cpu(&run->avg, stm_ms(stm_since(start)));
+        } break;
+        case BENCH_SAMPLE: {
+            const bool filter = sg_query_pixelformat(fmt).filter;
+            gputimer_begin(0);
+            sg_begin_pass(&(sg_pass){
+                .action.colors[0].load_action = SG_LOADACTION_DONTCARE,
+                .attachments = state.bench.sample_atts,
+            });
+            sg_apply_pipeline(filter ? state.bench.sample_pip : state.bench.sample_nofilter_pip);
+            sg_apply_bindings(&(sg_bindings){
+                .vertex_buffers[0] = state.bg_bindings.vertex_buffers[0],
+                .images[0] = state.bench.img,
+                .samplers[0] = filter ? state.bench.smp_linear : state.bench.smp_nearest,
+            });
+            sg_draw(0, 4, 1);
+            sg_end_pass();
+            gputimer_end(0);
+        } break;
+        case BENCH_FILL: {
+            gputimer_begin(0);
+            sg_begin_pass(&(sg_pass){
+                .action.colors[0].load_action = SG_LOADACTION_DONTCARE,
+                .attachments = state.bench.rt_atts,
+            });
+            sg_apply_pipeline(state.bench.fill_pip);
+            sg_apply_bindings(&state.bg_bindings);
+            sg_apply_uniforms(UB_bg_fs_params, &SG_RANGE(state.bg_fs_params));
+            // the bg vertex shader ignores the instance index, so each instance covers the whole target
+            sg_draw(0, 4, BENCH_FILL_OVERDRAW);
+            sg_end_pass();
+            gputimer_end(0);
+        } break;
+        default: break;
+    }
+    if (gputimer_bench_update(run)) {
+        bench_result_t* res = &state.bench.results[fmt];
+        res->bytes_per_pixel = state.bench.num_bytes / (BENCH_SIZE * BENCH_SIZE);
+        // GPU-timed phases have no results without GPU timer support
+        res->valid[phase] = (phase == BENCH_UPLOAD) || gputimer_supported();
+        res->ms[phase] = (phase == BENCH_UPLOAD) ? gputimer_avg_cpu_ms(&run->avg) : gputimer_avg_ms(&run->avg, 0);
+        gputimer_bench_next(run);
+        if (!bench_next()) {
+            bench_finish();
+        }
+    }
+}
+
+static void draw_bench_ui(void) {
+    igSetNextWindowPos((ImVec2){40, 40}, ImGuiCond_Once);
+    igSetNextWindowSize((ImVec2){640, 320}, ImGuiCond_Once);
+    if (igBegin("Pixel Format Benchmark", 0, 0)) {
+        if (state.bench.run.active) {
+            igText("running: %s %s...", pixelformat_string(bench_format()), bench_phase_names[bench_phase()]);
+        } else if (igButton("Run")) {
+            bench_start();
+        }
+        if (!gputimer_supported()) {
+            igSameLine();
+            igText("(no GPU timers, only upload is measured)");
+        }
+        if (state.bench.run.done) {
+            igText("%-28s %12s %14s %14s", "format", "upload MB/s", "sample GTex/s", "fill GPix/s");
+            igSeparator();
+            const double num_pixels = (double)(BENCH_SIZE * BENCH_SIZE);
+            for (int i = SG_PIXELFORMAT_NONE+1; i < SG_PIXELFORMAT_DEPTH; i++) {
+                if (!state.fmt[i].valid) {
+                    continue;
+                }
+                const bench_result_t* res = &state.bench.results[i];
+                char upload[32] = "n/a", sample[32] = "n/a", fill[32] = "n/a";
+                if (res->valid[BENCH_UPLOAD]) {
+                    snprintf(upload, sizeof(upload), "%.1f", (num_pixels * (double)res->bytes_per_pixel / (1024.0 * 1024.0)) / (res->ms[BENCH_UPLOAD] / 1000.0));
+                }
+                if (res->valid[BENCH_SAMPLE]) {
+                    snprintf(sample, sizeof(sample), "%.3f", (num_pixels * BENCH_SAMPLE_TAPS) / (res->ms[BENCH_SAMPLE] * 1000000.0));
+                }
+                if (res->valid[BENCH_FILL]) {
+                    snprintf(fill, sizeof(fill), "%.3f", (num_pixels * BENCH_FILL_OVERDRAW) / (res->ms[BENCH_FILL] * 1000000.0));
+                }
+                igText("%-28s %12s %14s %14s", pixelformat_string((sg_pixel_format)i), upload, sample, fill);
+            }
+        }
+    }
+    igEnd();
+}
+
 /* generate checkerboard pixel values */
 static uint8_t pixels[8 * 8 * 16];
 
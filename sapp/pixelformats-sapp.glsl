@@ -47,3 +47,50 @@ void main() {
 @end
 
 @program bg vs_bg fs_bg
+
+// sampling benchmark: BENCH_SAMPLE_TAPS (see pixelformats-sapp.c) texture
+// reads per pixel, with a filtering and a non-filtering variant
+@vs vs_sample
+in vec2 position;
+out vec2 uv;
+void main() {
+    gl_Position = vec4(position, 0.5, 1.0);
+    uv = position * 0.5 + 0.5;
+}
+@end
+
+@fs fs_sample
+layout(binding=0) uniform texture2D sample_tex;
+layout(binding=0) uniform sampler sample_smp;
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    vec4 c = vec4(0.0);
+    for (int i = 0; i < 8; i++) {
+        c += texture(sampler2D(sample_tex, sample_smp), uv + vec2(float(i) * 0.37, float(i) * 0.21));
+    }
+    frag_color = c * 0.125;
+}
+@end
+
+@program sample vs_sample fs_sample
+
+@fs fs_sample_nofilter
+@image_sample_type sample_nofilter_tex unfilterable_float
+@sampler_type sample_nofilter_smp nonfiltering
+layout(binding=0) uniform texture2D sample_nofilter_tex;
+layout(binding=0) uniform sampler sample_nofilter_smp;
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    vec4 c = vec4(0.0);
+    for (int i = 0; i < 8; i++) {
+        c += texture(sampler2D(sample_nofilter_tex, sample_nofilter_smp), uv + vec2(float(i) * 0.37, float(i) * 0.21));
+    }
+    frag_color = c * 0.125;
+}
+@end
+
+@program sample_nofilter vs_sample fs_sample_nofilter
@@ -4,43 +4,207 @@
 //  Signed-distance-field rendering demo to test the shader code generate
 //  with some non-trivial code.
 //
+//  The raymarching cost scales with the number of pixels, so the scene
+//  can be rendered into an offscreen render target at a reduced resolution
+//  and upsampled into the framebuffer:
+//
+//  - UP/DOWN selects the render scale (100% renders directly into the
+//    framebuffer)
+//  - A toggles the adaptive mode, which steps the render scale up and down
+//    to hold the target frame time (T cycles through the target times),
+//    the frame time is the sum of the GPU pass timers (see
+//    libs/util/gputimer.h), without GPU timers it falls back to
+//    sapp_frame_duration() (which can't go below the display refresh
+//    interval with vsync)
+//  - P toggles a coarse prepass which marches a cone per 4x4 pixel block
+//    at 1/4 resolution and stores a conservative start distance for the
+//    full-resolution rays, this shortens the marches of the full-resolution
+//    pass
+//  - B runs a benchmark over all render scales with and without prepass
+//    (the animation is paused during the benchmark)
+//
 //  https://www.iquilezles.org/www/articles/mandelbulb/mandelbulb.htm
 //  https://www.shadertoy.com/view/ltfSWn
 //------------------------------------------------------------------------------
+#include <math.h>
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/gputimer.h"
 #include "dbgui/dbgui.h"
 #include "sdf-sapp.glsl.h"
 
+#define NUM_SCALES (7)
+#define NUM_TARGETS (3)
+#define COARSE_FACTOR (4)
+#define RT_PIXEL_FORMAT SG_PIXELFORMAT_RGBA8
+#define COARSE_PIXEL_FORMAT SG_PIXELFORMAT_RGBA16F
+#define FOCAL_LENGTH (1.8f)     // must match focal_length in sdf-sapp.glsl
+#define NUM_AVG_FRAMES (16)
+#define BENCH_FRAMES (120)
+
+enum {
+    TIMER_COARSE,
+    TIMER_MARCH,
+    TIMER_UPSAMPLE,
+    NUM_TIMERS,
+};
+
+static const float scales[NUM_SCALES] = { 0.25f, 0.375f, 0.5f, 0.625f, 0.75f, 0.875f, 1.0f };
+static const float target_ms[NUM_TARGETS] = { 4.0f, 8.0f, 16.0f };
+
 static struct {
-    sg_pipeline pip;
-    sg_bindings bind;
-    sg_pass_action pass_action;
+    int scale_index;
+    bool adaptive;
+    bool prepass;
+    bool prepass_supported;
+    int target_index;
     vs_params_t vs_params;
+    sg_buffer vbuf;
+    // pipelines for rendering directly into the framebuffer, and into the offscreen render target
+    struct {
+        sg_pipeline pip;
+        sg_pipeline prepass_pip;
+    } display, offscreen;
+    sg_pipeline coarse_pip;
+    sg_pipeline upsample_pip;
+    sg_sampler nearest_smp;
+    sg_sampler linear_smp;
+    sg_pass_action pass_action;
+    // the reduced-resolution render target, and the coarse prepass target
+    struct {
+        int width, height;
+        sg_image img;
+        sg_attachments atts;
+    } rt, coarse;
+    gputimer_avg_t avg;
+    double frame_ms;
+    struct {
+        gputimer_bench_t run;   // config is an index into scale x prepass
+        int saved_scale_index;
+        bool saved_adaptive;
+        bool saved_prepass;
+        float time;
+        double results[NUM_SCALES][2];
+    } bench;
 } state;
 
+static void reset_stats(void) {
+    gputimer_avg_reset(&state.avg);
+}
+
+// the averaged frame time, the sum of the pass times with GPU timers,
+// otherwise the frame duration added by frame()
+static double avg_frame_ms(const gputimer_avg_t* avg) {
+    if (gputimer_supported()) {
+        double ms = 0.0;
+        for (int i = 0; i < NUM_TIMERS; i++) {
+            ms += gputimer_avg_ms(avg, i);
+        }
+        return ms;
+    } else {
+        return gputimer_avg_cpu_ms(avg);
+    }
+}
+
+// (re-)create a render target if the size has changed
+static void update_render_target(int width, int height, sg_pixel_format fmt, int* cur_width, int* cur_height, sg_image* img, sg_attachments* atts, const char* label) {
+    if ((width == *cur_width) && (height == *cur_height)) {
+        return;
+    }
+    sg_destroy_attachments(*atts);
+    sg_destroy_image(*img);
+    *cur_width = width;
+    *cur_height = height;
+    *img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = fmt,
+        .sample_count = 1,
+        .label = label,
+    });
+    *atts = sg_make_attachments(&(sg_attachments_desc){
+        .colors[0].image = *img,
+        .label = label,
+    });
+}
+
+// a pipeline for rendering into the framebuffer (color_format == SG_PIXELFORMAT_NONE)
+// or into an offscreen render target without depth buffer
+static sg_pipeline make_sdf_pipeline(sg_shader shd, sg_pixel_format color_format, const char* label) {
+    sg_pipeline_desc desc = {
+        .layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2,
+        .shader = shd,
+        .label = label,
+    };
+    if (color_format != SG_PIXELFORMAT_NONE) {
+        desc.colors[0].pixel_format = color_format;
+        desc.depth.pixel_format = SG_PIXELFORMAT_NONE;
+        desc.sample_count = 1;
+    }
+    return sg_make_pipeline(&desc);
+}
+
 void init(void) {
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
     });
     __dbgui_setup(sapp_sample_count());
+    stm_setup();
+    gputimer_setup();
+    gputimer_avg_init(&state.avg, NUM_AVG_FRAMES);
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    state.scale_index = NUM_SCALES - 1;
+    state.target_index = 2;
+    state.prepass_supported = sg_query_pixelformat(COARSE_PIXEL_FORMAT).render;
 
     // a vertex buffer to render a 'fullscreen triangle'
     float fsq_verts[] = { -1.0f, -3.0f, 3.0f, 1.0f, -1.0f, 1.0f };
-    state.bind.vertex_buffers[0] = sg_make_buffer(&(sg_buffer_desc){
+    state.vbuf = sg_make_buffer(&(sg_buffer_desc){
         .data = SG_RANGE(fsq_verts),
         .label = "fsq vertices"
     });
 
-    // shader and pipeline object for rendering a fullscreen quad
-    state.pip = sg_make_pipeline(&(sg_pipeline_desc){
-        .layout = {
-            .attrs[ATTR_sdf_position].format = SG_VERTEXFORMAT_FLOAT2
-        },
-        .shader = sg_make_shader(sdf_shader_desc(sg_query_backend())),
+    // shaders and pipeline objects for rendering a fullscreen quad, with and
+    // without prepass, into the framebuffer or the offscreen render target
+    sg_shader sdf_shd = sg_make_shader(sdf_shader_desc(sg_query_backend()));
+    sg_shader prepass_shd = sg_make_shader(sdf_prepass_shader_desc(sg_query_backend()));
+    state.display.pip = make_sdf_pipeline(sdf_shd, SG_PIXELFORMAT_NONE, "sdf pipeline");
+    state.display.prepass_pip = make_sdf_pipeline(prepass_shd, SG_PIXELFORMAT_NONE, "sdf prepass pipeline");
+    state.offscreen.pip = make_sdf_pipeline(sdf_shd, RT_PIXEL_FORMAT, "sdf offscreen pipeline");
+    state.offscreen.prepass_pip = make_sdf_pipeline(prepass_shd, RT_PIXEL_FORMAT, "sdf offscreen prepass pipeline");
+    if (state.prepass_supported) {
+        state.coarse_pip = make_sdf_pipeline(
+            sg_make_shader(sdf_coarse_shader_desc(sg_query_backend())),
+            COARSE_PIXEL_FORMAT, "sdf coarse pipeline");
+    }
+    state.upsample_pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout.attrs[ATTR_upsample_position].format = SG_VERTEXFORMAT_FLOAT2,
+        .shader = sg_make_shader(upsample_shader_desc(sg_query_backend())),
+        .label = "upsample pipeline",
+    });
+    state.nearest_smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "nearest sampler",
+    });
+    state.linear_smp = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .label = "linear sampler",
     });
 
     // don't need to clear since the whole framebuffer is overwritten
@@ -49,23 +213,244 @@ void init(void) {
     };
 }
 
+static void select_scale(int scale_index) {
+    if ((scale_index >= 0) && (scale_index < NUM_SCALES) && (scale_index != state.scale_index)) {
+        state.scale_index = scale_index;
+        reset_stats();
+    }
+}
+
+// the adaptive mode steps the render scale down when the averaged frame
+// time is above the target, and up when the frame time estimated from the
+// pixel count of the next bigger scale is comfortably below the target
+static void adapt_scale(void) {
+    const double target = (double)target_ms[state.target_index];
+    if (state.frame_ms > target) {
+        select_scale(state.scale_index - 1);
+    } else if (state.scale_index < (NUM_SCALES - 1)) {
+        const double ratio = (double)scales[state.scale_index + 1] / (double)scales[state.scale_index];
+        if ((state.frame_ms * ratio * ratio) < (target * 0.9)) {
+            select_scale(state.scale_index + 1);
+        }
+    }
+}
+
+static void update_stats(void) {
+    if (gputimer_avg_update(&state.avg)) {
+        state.frame_ms = avg_frame_ms(&state.avg);
+        if (state.adaptive) {
+            adapt_scale();
+        }
+    }
+}
+
+// the benchmark steps through all scale/prepass combinations with the
+// animation paused and averages the frame time of each over
+// BENCH_FRAMES frames
+static void bench_start(void) {
+    gputimer_bench_start(&state.bench.run, NUM_SCALES * (state.prepass_supported ? 2 : 1), BENCH_FRAMES);
+    state.bench.saved_scale_index = state.scale_index;
+    state.bench.saved_adaptive = state.adaptive;
+    state.bench.saved_prepass = state.prepass;
+    state.bench.time = state.vs_params.time;
+    state.adaptive = false;
+    state.prepass = false;
+    select_scale(0);
+}
+
+static void bench_update(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    if (!gputimer_bench_update(run)) {
+        return;
+    }
+    state.bench.results[state.scale_index][state.prepass ? 1 : 0] = avg_frame_ms(&run->avg);
+    if (gputimer_bench_next(run)) {
+        state.prepass = run->config >= NUM_SCALES;
+        select_scale(run->config % NUM_SCALES);
+    } else {
+        state.adaptive = state.bench.saved_adaptive;
+        state.prepass = state.bench.saved_prepass;
+        select_scale(state.bench.saved_scale_index);
+    }
+}
+
+static void draw_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("scale:    %d%% (UP/DOWN)\n", (int)(scales[state.scale_index] * 100.0f));
+    sdtx_printf("adaptive: %s (A)\n", state.adaptive ? "on" : "off");
+    sdtx_printf("target:   %.1f ms (T)\n", (double)target_ms[state.target_index]);
+    if (state.prepass_supported) {
+        sdtx_printf("prepass:  %s (P)\n", state.prepass ? "on" : "off");
+    } else {
+        sdtx_puts("prepass:  n/a\n");
+    }
+    if (gputimer_supported()) {
+        sdtx_printf("\nprepass:  %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_COARSE));
+        sdtx_printf("march:    %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_MARCH));
+        sdtx_printf("upsample: %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_UPSAMPLE));
+        sdtx_printf("frame:    %.3f ms\n", state.frame_ms);
+    } else {
+        sdtx_puts("\ngpu timers not supported\n");
+        sdtx_printf("frame:    %.3f ms (%s)\n", state.frame_ms, gputimer_frame_on_gpu() ? "gpu" : "cpu");
+    }
+    if (state.bench.run.active) {
+        sdtx_printf("\nbenchmark running: %d/%d\n", state.bench.run.config + 1, state.bench.run.num_configs);
+    } else if (state.bench.run.done) {
+        sdtx_printf("\nbenchmark (%dx%d):\n", sapp_width(), sapp_height());
+        sdtx_puts("scale     ms prepass\n");
+        for (int i = 0; i < NUM_SCALES; i++) {
+            if (state.prepass_supported) {
+                sdtx_printf("%4d%% %6.3f %7.3f\n", (int)(scales[i] * 100.0f), state.bench.results[i][0], state.bench.results[i][1]);
+            } else {
+                sdtx_printf("%4d%% %6.3f     n/a\n", (int)(scales[i] * 100.0f), state.bench.results[i][0]);
+            }
+        }
+    } else {
+        sdtx_puts("\npress B to run benchmark\n");
+    }
+}
+
+// render the scene with the current settings into the framebuffer (when
+// the render scale is 100%) or the offscreen render target, the caller
+// must end the march pass and its GPU timer
+static void draw_scene(bool offscreen) {
+    if (state.prepass) {
+        const int width = offscreen ? state.rt.width : sapp_width();
+        const int height = offscreen ? state.rt.height : sapp_height();
+        const coarse_params_t coarse_params = {
+            .pixel_radius = sqrtf(2.0f) / ((float)state.coarse.height * FOCAL_LENGTH),
+        };
+        const prepass_params_t prepass_params = {
+            .coarse_scale = {
+                (float)state.coarse.width / (float)width,
+                (float)state.coarse.height / (float)height,
+            },
+        };
+        gputimer_begin(TIMER_COARSE);
+        sg_begin_pass(&(sg_pass){ .action = state.pass_action, .attachments = state.coarse.atts });
+        sg_apply_pipeline(state.coarse_pip);
+        sg_apply_bindings(&(sg_bindings){ .vertex_buffers[0] = state.vbuf });
+        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+        sg_apply_uniforms(UB_coarse_params, &SG_RANGE(coarse_params));
+        sg_draw(0, 3, 1);
+        sg_end_pass();
+        gputimer_end(TIMER_COARSE);
+
+        gputimer_begin(TIMER_MARCH);
+        if (offscreen) {
+            sg_begin_pass(&(sg_pass){ .action = state.pass_action, .attachments = state.rt.atts });
+            sg_apply_pipeline(state.offscreen.prepass_pip);
+        } else {
+            sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
+            sg_apply_pipeline(state.display.prepass_pip);
+        }
+        sg_apply_bindings(&(sg_bindings){
+            .vertex_buffers[0] = state.vbuf,
+            .images[IMG_coarse_tex] = state.coarse.img,
+            .samplers[SMP_coarse_smp] = state.nearest_smp,
+        });
+        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+        sg_apply_uniforms(UB_prepass_params, &SG_RANGE(prepass_params));
+    } else {
+        gputimer_begin(TIMER_MARCH);
+        if (offscreen) {
+            sg_begin_pass(&(sg_pass){ .action = state.pass_action, .attachments = state.rt.atts });
+            sg_apply_pipeline(state.offscreen.pip);
+        } else {
+            sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
+            sg_apply_pipeline(state.display.pip);
+        }
+        sg_apply_bindings(&(sg_bindings){ .vertex_buffers[0] = state.vbuf });
+        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+    }
+    sg_draw(0, 3, 1);
+}
+
 void frame(void) {
+    // the frame duration is the fallback frame time without GPU timers
+    const double frame_duration_ms = sapp_frame_duration() * 1000.0;
+    if (state.bench.run.active) {
+        gputimer_avg_add_cpu(&state.bench.run.avg, frame_duration_ms);
+        bench_update();
+        state.vs_params.time = state.bench.time;
+    } else {
+        gputimer_avg_add_cpu(&state.avg, frame_duration_ms);
+        update_stats();
+        state.vs_params.time += (float)sapp_frame_duration();
+    }
     int w = sapp_width();
     int h = sapp_height();
-    state.vs_params.time += (float)sapp_frame_duration();
     state.vs_params.aspect = (float)w / (float)h;
-    sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
-    sg_apply_pipeline(state.pip);
-    sg_apply_bindings(&state.bind);
-    sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
-    sg_draw(0, 3, 1);
+
+    // render target sizes for the current render scale
+    const bool offscreen = state.scale_index < (NUM_SCALES - 1);
+    const int rt_width = offscreen ? (int)fmaxf(1.0f, (float)w * scales[state.scale_index]) : w;
+    const int rt_height = offscreen ? (int)fmaxf(1.0f, (float)h * scales[state.scale_index]) : h;
+    if (offscreen) {
+        update_render_target(rt_width, rt_height, RT_PIXEL_FORMAT,
+            &state.rt.width, &state.rt.height, &state.rt.img, &state.rt.atts, "sdf render target");
+    }
+    if (state.prepass) {
+        update_render_target((rt_width + COARSE_FACTOR - 1) / COARSE_FACTOR, (rt_height + COARSE_FACTOR - 1) / COARSE_FACTOR,
+            COARSE_PIXEL_FORMAT, &state.coarse.width, &state.coarse.height, &state.coarse.img, &state.coarse.atts, "sdf coarse target");
+    }
+
+    gputimer_begin_frame();
+    // draw_scene() leaves the march pass open, at 100% scale this is the
+    // framebuffer pass which also renders the debug text
+    draw_scene(offscreen);
+    if (offscreen) {
+        sg_end_pass();
+        gputimer_end(TIMER_MARCH);
+        gputimer_begin(TIMER_UPSAMPLE);
+        const upsample_params_t upsample_params = { .inv_size = { 1.0f / (float)w, 1.0f / (float)h } };
+        sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
+        sg_apply_pipeline(state.upsample_pip);
+        sg_apply_bindings(&(sg_bindings){
+            .vertex_buffers[0] = state.vbuf,
+            .images[IMG_upsample_tex] = state.rt.img,
+            .samplers[SMP_upsample_smp] = state.linear_smp,
+        });
+        sg_apply_uniforms(UB_upsample_params, &SG_RANGE(upsample_params));
+        sg_draw(0, 3, 1);
+    }
+    draw_stats();
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
+    gputimer_end(offscreen ? TIMER_UPSAMPLE : TIMER_MARCH);
+    gputimer_end_frame();
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && !state.bench.run.active) {
+        if ((ev->key_code == SAPP_KEYCODE_UP) && !state.adaptive) {
+            select_scale(state.scale_index + 1);
+        } else if ((ev->key_code == SAPP_KEYCODE_DOWN) && !state.adaptive) {
+            select_scale(state.scale_index - 1);
+        } else if (ev->key_code == SAPP_KEYCODE_A) {
+            state.adaptive = !state.adaptive;
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_T) {
+            state.target_index = (state.target_index + 1) % NUM_TARGETS;
+            reset_stats();
+        } else if ((ev->key_code == SAPP_KEYCODE_P) && state.prepass_supported) {
+            state.prepass = !state.prepass;
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_B) {
+            bench_start();
+        }
+    }
+    __dbgui_event(ev);
+}
+
 void cleanup(void) {
     __dbgui_shutdown();
+    sdtx_shutdown();
+    gputimer_shutdown();
     sg_shutdown();
 }
 
@@ -75,7 +460,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 512,
         .height = 512,
         .window_title = "SDF Rendering",
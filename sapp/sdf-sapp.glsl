@@ -41,15 +41,12 @@ void main() {
 }
 @end
 
-//--- fragment shader
-@fs fs
-in vec2 pos;
-in vec3 eye;
-in vec3 up;
-in vec3 right;
-in vec3 fwd;
-
-out vec4 frag_color;
+//--- distance functions and shading shared by all raymarching fragment shaders
+@block sdf
+const float epsilon = 0.001;
+const float focal_length = 1.8;
+const float max_dist = 3.0;
+const int max_steps = 96;
 
 float sd_sphere(vec3 p, float s) {
     return length(p) - s;
@@ -152,17 +149,16 @@ vec3 calc_color(vec3 ro, vec3 rd, float t, vec4 tra) {
     return col;
 }
 
-void main() {
-    const float epsilon = 0.001;
-    const float focal_length = 1.8;
-
-    vec3 ray_origin = eye + fwd * focal_length + right * pos.x + up * pos.y;
-    vec3 ray_direction = normalize(ray_origin - eye);
-
+// march a ray starting at distance t, first_step is the number of steps
+// the coarse prepass has already taken, their glow is added up front so
+// that the result approximates a ray which starts at the ray origin, the
+// march itself always gets the full max_steps budget
+vec4 march(vec3 ray_origin, vec3 ray_direction, float t, int first_step) {
     vec4 tra;
     vec4 color = vec4(0.10,0.20,0.30,1.0);
-    float t = 0.0;
-    for (int i = 0; i < 96; i++) {
+    color.xyz += vec3(0.003, 0.001, 0.0) * float(first_step * (first_step - 1) / 2);
+    for (int n = 0; n < max_steps; n++) {
+        int i = first_step + n;
         vec3 p = ray_origin + ray_direction * t;
         float d = d_scene(p, tra);
         if (d < epsilon) {
@@ -172,13 +168,141 @@ void main() {
         else {
             color.xyz += vec3(0.003, 0.001, 0.0) * i;
         }
-        if (t > 3) {
+        if (t > max_dist) {
             break;
         }
         t += d;
     }
-    frag_color = color;
+    return color;
+}
+@end
+
+//--- fragment shader
+@fs fs
+@include_block sdf
+in vec2 pos;
+in vec3 eye;
+in vec3 up;
+in vec3 right;
+in vec3 fwd;
+
+out vec4 frag_color;
+
+void main() {
+    vec3 ray_origin = eye + fwd * focal_length + right * pos.x + up * pos.y;
+    vec3 ray_direction = normalize(ray_origin - eye);
+    frag_color = march(ray_origin, ray_direction, 0.0, 0);
 }
 @end
 
 @program sdf vs fs
+
+//--- coarse prepass at a fraction of the resolution, marches a cone with
+//--- the footprint of a coarse pixel until the surface gets closer than
+//--- the cone radius, and writes the distance minus the cone radius (a
+//--- safe start distance for all rays inside the cone) and the step count
+@fs fs_coarse
+@include_block sdf
+layout(binding=0) uniform coarse_params {
+    float pixel_radius;     // cone radius at distance 1 from the eye
+};
+
+in vec2 pos;
+in vec3 eye;
+in vec3 up;
+in vec3 right;
+in vec3 fwd;
+
+out vec4 frag_color;
+
+void main() {
+    vec3 ray_origin = eye + fwd * focal_length + right * pos.x + up * pos.y;
+    vec3 ray_direction = normalize(ray_origin - eye);
+    float eye_dist = length(ray_origin - eye);
+    vec4 tra;
+    float t = 0.0;
+    float r = eye_dist * pixel_radius;
+    int i = 0;
+    for (; i < max_steps; i++) {
+        float d = d_scene(ray_origin + ray_direction * t, tra);
+        r = (eye_dist + t) * pixel_radius;
+        if ((d < r) || (t > max_dist)) {
+            break;
+        }
+        t += d;
+    }
+    frag_color = vec4(max(t - r, 0.0), float(i), 0.0, 1.0);
+}
+@end
+
+@program sdf_coarse vs fs_coarse
+
+//--- the full-resolution raymarcher which starts at the coarse prepass result
+@fs fs_prepass
+@include_block sdf
+@image_sample_type coarse_tex unfilterable_float
+@sampler_type coarse_smp nonfiltering
+layout(binding=0) uniform texture2D coarse_tex;
+layout(binding=0) uniform sampler coarse_smp;
+layout(binding=0) uniform prepass_params {
+    vec2 coarse_scale;      // coarse target size divided by render target size
+};
+
+in vec2 pos;
+in vec3 eye;
+in vec3 up;
+in vec3 right;
+in vec3 fwd;
+
+out vec4 frag_color;
+
+void main() {
+    vec3 ray_origin = eye + fwd * focal_length + right * pos.x + up * pos.y;
+    vec3 ray_direction = normalize(ray_origin - eye);
+
+    // take the minimum of the nearest 2x2 coarse pixels, so that pixels
+    // near a coarse pixel border don't start behind a surface
+    vec2 coarse_pos = gl_FragCoord.xy * coarse_scale - 0.5;
+    ivec2 p0 = ivec2(floor(coarse_pos));
+    ivec2 max_pos = textureSize(sampler2D(coarse_tex, coarse_smp), 0) - 1;
+    vec2 start = vec2(max_dist, float(max_steps));
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            ivec2 p = clamp(p0 + ivec2(x, y), ivec2(0), max_pos);
+            start = min(start, texelFetch(sampler2D(coarse_tex, coarse_smp), p, 0).xy);
+        }
+    }
+    // pull back a bit more to cover the half-float precision of the coarse target
+    float t = max(start.x - 0.01, 0.0);
+    frag_color = march(ray_origin, ray_direction, t, int(start.y));
+}
+@end
+
+@program sdf_prepass vs fs_prepass
+
+//--- upsample the reduced-resolution render target to the framebuffer
+@vs vs_upsample
+in vec4 position;
+
+void main() {
+    gl_Position = position;
+}
+@end
+
+@fs fs_upsample
+layout(binding=0) uniform texture2D upsample_tex;
+layout(binding=0) uniform sampler upsample_smp;
+layout(binding=0) uniform upsample_params {
+    vec2 inv_size;      // 1.0 / framebuffer size
+};
+
+out vec4 frag_color;
+
+void main() {
+    // render target and framebuffer have the same orientation, so
+    // the fragment position can be used as texture coordinate
+    frag_color = texture(sampler2D(upsample_tex, upsample_smp), gl_FragCoord.xy * inv_size);
+}
+@end
+
+@program upsample vs_upsample fs_upsample
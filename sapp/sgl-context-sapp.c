@@ -3,6 +3,13 @@
 //
 //  Demonstrates how to render in different render passes with sokol_gl.h
 //  using sokol-gl contexts.
+//
+//  The per-context counters from libs/util/sglstats.h are displayed
+//  in a debug text overlay. Press 1, 2 or 3 to render that many quads
+//  into the offscreen context, which only has room for 12 vertices
+//  (sokol-gl emits 6 vertices per quad), so that 2 quads are merged
+//  into one draw, and 3 quads overflow the context and cause it to
+//  be dropped.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -10,10 +17,14 @@
 #include "sokol_glue.h"
 #define SOKOL_GL_IMPL
 #include "sokol_gl.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/sglstats.h"
 #include "dbgui/dbgui.h"
 
 static struct {
     double angle_deg;
+    int num_quads;
     struct {
         sg_pass_action pass_action;
         sg_attachments attachments;
@@ -25,7 +36,9 @@ static struct {
         sg_sampler smp;
         sgl_pipeline sgl_pip;
     } display;
-} state;
+} state = {
+    .num_quads = 1,
+};
 
 #define OFFSCREEN_PIXELFORMAT (SG_PIXELFORMAT_RGBA8)
 #define OFFSCREEN_SAMPLECOUNT (1)
@@ -34,7 +47,8 @@ static struct {
 
 // helper functions (at the end of this file)
 static void draw_cube(void);
-static void draw_quad(void);
+static void draw_quad(float scale);
+static void draw_stats(void);
 
 static void init(void) {
     sg_setup(&(sg_desc){
@@ -44,11 +58,18 @@ static void init(void) {
     __dbgui_setup(sapp_sample_count());
 
     // setup sokol-gl with the default context compatible with the default render pass
-    sgl_setup(&(sgl_desc_t){
+    const sgl_desc_t sgl_desc = {
         .max_vertices = 64,
         .max_commands = 16,
         .logger.func = slog_func,
+    };
+    sgl_setup(&sgl_desc);
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
     });
+    sglstats_setup();
+    sglstats_track(sgl_default_context(), sgl_desc.max_vertices, sgl_desc.max_commands);
 
     // pass action and pipeline for the default render pass
     state.display.pass_action = (sg_pass_action) {
@@ -67,13 +88,16 @@ static void init(void) {
 
     // create a sokol-gl context compatible with the offscreen render pass
     // (specific color pixel format, no depth-stencil-surface, no MSAA)
-    state.offscreen.sgl_ctx = sgl_make_context(&(sgl_context_desc_t){
-        .max_vertices = 8,
+    const sgl_context_desc_t offscreen_desc = {
+        // room for exactly 2 quads of 6 vertices each
+        .max_vertices = 12,
         .max_commands = 4,
         .color_format = OFFSCREEN_PIXELFORMAT,
         .depth_format = SG_PIXELFORMAT_NONE,
         .sample_count = OFFSCREEN_SAMPLECOUNT,
-    });
+    };
+    state.offscreen.sgl_ctx = sgl_make_context(&offscreen_desc);
+    sglstats_track(state.offscreen.sgl_ctx, offscreen_desc.max_vertices, offscreen_desc.max_commands);
 
     // create an offscreen render target texture, pass, and pass_action
     state.offscreen.img = sg_make_image(&(sg_image_desc){
@@ -111,7 +135,9 @@ static void frame(void) {
     sgl_defaults();
     sgl_matrix_mode_modelview();
     sgl_rotate(a, 0.0f, 0.0f, 1.0f);
-    draw_quad();
+    for (int i = 0; i < state.num_quads; i++) {
+        draw_quad(1.0f - (float)i * 0.3f);
+    }
 
     // draw a rotating 3D cube, using the offscreen render target as texture
     sgl_set_context(SGL_DEFAULT_CONTEXT);
@@ -125,20 +151,36 @@ static void frame(void) {
     sgl_matrix_mode_modelview();
     sgl_lookat(eye[0], eye[1], eye[2], 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
     draw_cube();
+    draw_stats();
 
     // do the actual offscreen and display rendering in sokol-gfx passes
     sg_begin_pass(&(sg_pass){ .action = state.offscreen.pass_action, .attachments = state.offscreen.attachments });
-    sgl_context_draw(state.offscreen.sgl_ctx);
+    sglstats_context_draw(state.offscreen.sgl_ctx);
     sg_end_pass();
     sg_begin_pass(&(sg_pass){ .action = state.display.pass_action, .swapchain = sglue_swapchain() });
-    sgl_context_draw(SGL_DEFAULT_CONTEXT);
+    sglstats_context_draw(SGL_DEFAULT_CONTEXT);
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    __dbgui_event(ev);
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        switch (ev->key_code) {
+            case SAPP_KEYCODE_1: state.num_quads = 1; break;
+            case SAPP_KEYCODE_2: state.num_quads = 2; break;
+            case SAPP_KEYCODE_3: state.num_quads = 3; break;
+            default: break;
+        }
+    }
+}
+
 static void cleanup(void) {
+    sglstats_shutdown();
     __dbgui_shutdown();
+    sdtx_shutdown();
     sgl_shutdown();
     sg_shutdown();
 }
@@ -150,7 +192,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .sample_count = 4,
@@ -161,13 +203,41 @@ sapp_desc sokol_main(int argc, char* argv[]) {
 }
 
 // helper function to draw a colored quad with sokol-gl
-static void draw_quad(void) {
+static void draw_quad(float scale) {
     sgl_begin_quads();
-    sgl_v2f_c3b( 0.0f, -1.0f, 255, 0, 0);
-    sgl_v2f_c3b( 1.0f,  0.0f, 0, 0, 255);
-    sgl_v2f_c3b( 0.0f,  1.0f, 0, 255, 255);
-    sgl_v2f_c3b(-1.0f,  0.0f, 0, 255, 0);
-    sgl_end();
+    sgl_v2f_c3b( 0.0f, -scale, 255, 0, 0);
+    sgl_v2f_c3b( scale,  0.0f, 0, 0, 255);
+    sgl_v2f_c3b( 0.0f,  scale, 0, 255, 255);
+    sgl_v2f_c3b(-scale,  0.0f, 0, 255, 0);
+    sglstats_end();
+}
+
+// helper function to print the sokol-gl counters of the previous frame
+static void print_stats(const char* name, sgl_context ctx) {
+    const sglstats_t s = sglstats_query(ctx);
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_printf("%s context:\n", name);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("  vertices:  %d/%d\n", s.num_vertices, s.max_vertices);
+    sdtx_printf("  commands:  %d/%d\n", s.num_commands, s.max_commands);
+    sdtx_printf("  batches:   %d (%d merged)\n", s.num_batches, s.num_merged);
+    sdtx_printf("  draws:     %d\n", s.num_draws);
+    sdtx_printf("  pipelines: %d\n", s.num_pipeline_switches);
+    sdtx_printf("  uploaded:  %d bytes\n", s.upload_bytes);
+    if (s.error != SGL_NO_ERROR) {
+        sdtx_color3b(0xFF, 0x40, 0x40);
+    }
+    sdtx_printf("  error:     %s\n", sglstats_error_string(s.error));
+    sdtx_printf("  dropped:   %d/%d frames\n\n", (int)s.num_dropped, (int)s.num_frames);
+}
+
+static void draw_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    print_stats("offscreen", state.offscreen.sgl_ctx);
+    print_stats("default", SGL_DEFAULT_CONTEXT);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("offscreen quads: %d (press 1..3)", state.num_quads);
 }
 
 // helper function to draw a textured cube with sokol-gl
@@ -197,5 +267,5 @@ static void draw_cube(void) {
     sgl_v3f_t2f(-1.0f,  1.0f,  1.0f, 1.0f, 1.0f);
     sgl_v3f_t2f( 1.0f,  1.0f,  1.0f, 1.0f, 0.0f);
     sgl_v3f_t2f( 1.0f,  1.0f, -1.0f, 0.0f, 0.0f);
-    sgl_end();
+    sglstats_end();
 }
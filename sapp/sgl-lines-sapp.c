@@ -1,6 +1,9 @@
 //------------------------------------------------------------------------------
 //  sgl-lines-sapp.c
 //  Line rendering with sokol_gl.h
+//
+//  The static grid is recorded once with libs/util/sglrec.h and replayed
+//  each frame, instead of being re-submitted via sokol-gl.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -9,12 +12,17 @@
 #define SOKOL_GL_IMPL
 #include "sokol_gl.h"
 #include "dbgui/dbgui.h"
+#include "util/sglrec.h"
+#include "sglrec.glsl.h"
 
 static struct {
     sg_pass_action pass_action;
     sgl_pipeline depth_test_pip;
+    sglrec_mesh_t grid;
 } state;
 
+static void record_grid(void);
+
 static void init(void) {
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
@@ -35,6 +43,12 @@ static void init(void) {
         }
     });
 
+    // record the static grid geometry into a vertex buffer
+    sglrec_setup(&(sglrec_desc_t){
+        .shader = sg_make_shader(sglrec_shader_desc(sg_query_backend())),
+    });
+    record_grid();
+
     // a default pass action
     state.pass_action = (sg_pass_action) {
         .colors[0] = {
@@ -44,22 +58,32 @@ static void init(void) {
     };
 }
 
-static void grid(float y, uint32_t frame_count) {
-    const int num = 64;
-    const float dist = 4.0f;
-    const float z_offset = (dist / 8) * (frame_count & 7);
-    sgl_begin_lines();
+#define GRID_NUM (64)
+#define GRID_DIST (4.0f)
+
+static void grid(float y) {
+    const int num = GRID_NUM;
+    const float dist = GRID_DIST;
+    sglrec_begin_lines();
     for (int i = 0; i < num; i++) {
         float x = i * dist - num * dist * 0.5f;
-        sgl_v3f(x, y, -num * dist);
-        sgl_v3f(x, y, 0.0f);
+        sglrec_v3f(x, y, -num * dist);
+        sglrec_v3f(x, y, 0.0f);
     }
     for (int i = 0; i < num; i++) {
-        float z = z_offset + i * dist - num * dist;
-        sgl_v3f(-num * dist * 0.5f, y, z);
-        sgl_v3f(num * dist * 0.5f, y, z);
+        float z = i * dist - num * dist;
+        sglrec_v3f(-num * dist * 0.5f, y, z);
+        sglrec_v3f(num * dist * 0.5f, y, z);
     }
-    sgl_end();
+    sglrec_end();
+}
+
+static void record_grid(void) {
+    sglrec_begin_recording();
+    sglrec_c3f(1.0f, 0.0f, 1.0f);
+    grid(-7.0f);
+    grid(+7.0f);
+    state.grid = sglrec_end_recording("grid-vertices");
 }
 
 static void floaty_thingy(uint32_t frame_count) {
@@ -136,6 +160,20 @@ static void hairball(void) {
     sgl_end();
 }
 
+// same result as sgl_perspective() followed by sgl_translate() (column-major)
+static void perspective_translate(float* m, float fovy, float aspect, float znear, float zfar, float tx, float ty, float tz) {
+    const float f = 1.0f / tanf(fovy * 0.5f);
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zfar + znear) / (znear - zfar);
+    m[11] = -1.0f;
+    m[12] = m[0] * tx;
+    m[13] = m[5] * ty;
+    m[14] = m[10] * tz + (2.0f * zfar * znear) / (znear - zfar);
+    m[15] = -tz;
+}
+
 static void frame(void) {
     const float aspect = sapp_widthf() / sapp_heightf();
     static uint32_t frame_count = 0;
@@ -147,10 +185,9 @@ static void frame(void) {
     sgl_matrix_mode_projection();
     sgl_perspective(sgl_rad(45.0f), aspect, 0.1f, 1000.0f);
     sgl_matrix_mode_modelview();
-    sgl_translate(sinf(frame_count * 0.02f) * 16.0f, sinf(frame_count * 0.01f) * 4.0f, 0.0f);
-    sgl_c3f(1.0f, 0.0f, 1.0f);
-    grid(-7.0f, frame_count);
-    grid(+7.0f, frame_count);
+    const float tx = sinf(frame_count * 0.02f) * 16.0f;
+    const float ty = sinf(frame_count * 0.01f) * 4.0f;
+    sgl_translate(tx, ty, 0.0f);
     sgl_push_matrix();
         sgl_translate(0.0f, 0.0f, -30.0f);
         sgl_rotate(frame_count * 0.05f, 0.0f, 1.0f, 1.0f);
@@ -171,8 +208,14 @@ static void frame(void) {
     sgl_pop_matrix();
     sgl_pop_pipeline();
 
+    // the grid is replayed with a transform which matches the sokol-gl matrix stack above
+    const float z_offset = (GRID_DIST / 8) * (frame_count & 7);
+    float mvp[16];
+    perspective_translate(mvp, sgl_rad(45.0f), aspect, 0.1f, 1000.0f, tx, ty, z_offset);
+
     // sokol-gfx default pass with the actual sokol-gl drawing
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
+    sglrec_draw(&state.grid, mvp);
     sgl_draw();
     __dbgui_draw();
     sg_end_pass();
@@ -181,6 +224,8 @@ static void frame(void) {
 
 static void cleanup(void) {
     __dbgui_shutdown();
+    sglrec_destroy_mesh(&state.grid);
+    sglrec_shutdown();
     sgl_shutdown();
     sg_shutdown();
 }
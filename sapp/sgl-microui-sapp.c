@@ -4,6 +4,9 @@
 //  https://github.com/rxi/microui sample using sokol_gl.h, sokol_gfx.h
 //  and sokol_app.h
 //
+//  The 'sokol-gl Stats' window shows the per-frame sokol-gl counters
+//  gathered with libs/util/sglstats.h.
+//
 //  NOTE: for the debugging UI, cimgui is used via sokol_gfx_cimgui.h
 //  (C bindings to Dear ImGui instead of the ImGui C++ API)
 //------------------------------------------------------------------------------
@@ -18,6 +21,7 @@
 #include "microui/atlas.inl"
 #define SOKOL_GL_IMPL
 #include "sokol_gl.h"
+#include "util/sglstats.h"
 #include "cdbgui/cdbgui.h"
 #include <stdio.h> // sprintf
 
@@ -38,6 +42,7 @@ static struct {
 static void test_window(mu_Context* ctx);
 static void log_window(mu_Context* ctx);
 static void style_window(mu_Context* ctx);
+static void stats_window(mu_Context* ctx);
 
 // microui renderer functions (implementation is at the end of this file)
 static void r_init(void);
@@ -84,10 +89,15 @@ static void init(void) {
     });
     __cdbgui_setup(1);
 
-    // setup sokol-gl
-    sgl_setup(&(sgl_desc_t){
+    // setup sokol-gl, with the default capacities spelled out for the stats window
+    const sgl_desc_t sgl_desc = {
+        .max_vertices = 1 << 16,
+        .max_commands = 1 << 14,
         .logger.func = slog_func,
-    });
+    };
+    sgl_setup(&sgl_desc);
+    sglstats_setup();
+    sglstats_track(sgl_default_context(), sgl_desc.max_vertices, sgl_desc.max_commands);
 
     // setup microui renderer
     r_init();
@@ -152,6 +162,7 @@ void frame(void) {
     test_window(&state.mu_ctx);
     log_window(&state.mu_ctx);
     style_window(&state.mu_ctx);
+    stats_window(&state.mu_ctx);
     mu_end(&state.mu_ctx);
 
     // micro-ui rendering
@@ -184,6 +195,7 @@ void frame(void) {
 }
 
 static void cleanup(void) {
+    sglstats_shutdown();
     __cdbgui_shutdown();
     sgl_shutdown();
     sg_shutdown();
@@ -363,6 +375,34 @@ static void style_window(mu_Context *ctx) {
     }
 }
 
+static void stats_window(mu_Context* ctx) {
+    if (mu_begin_window(ctx, "sokol-gl Stats", mu_rect(670, 40, 240, 250))) {
+        // these are the counters of the previous frame
+        const sglstats_t s = sglstats_query(sgl_default_context());
+        char buf[64];
+        mu_layout_row(ctx, 2, (int[]) { 80, -1 }, 0);
+        mu_label(ctx, "Vertices:");
+        sprintf(buf, "%d / %d", s.num_vertices, s.max_vertices); mu_label(ctx, buf);
+        mu_label(ctx, "Commands:");
+        sprintf(buf, "%d / %d", s.num_commands, s.max_commands); mu_label(ctx, buf);
+        mu_label(ctx, "Batches:");
+        sprintf(buf, "%d", s.num_batches); mu_label(ctx, buf);
+        mu_label(ctx, "Merged:");
+        sprintf(buf, "%d", s.num_merged); mu_label(ctx, buf);
+        mu_label(ctx, "Draws:");
+        sprintf(buf, "%d", s.num_draws); mu_label(ctx, buf);
+        mu_label(ctx, "Pipelines:");
+        sprintf(buf, "%d", s.num_pipeline_switches); mu_label(ctx, buf);
+        mu_label(ctx, "Uploaded:");
+        sprintf(buf, "%d bytes", s.upload_bytes); mu_label(ctx, buf);
+        mu_label(ctx, "Error:");
+        mu_label(ctx, sglstats_error_string(s.error));
+        mu_label(ctx, "Dropped:");
+        sprintf(buf, "%d / %d frames", (int)s.num_dropped, (int)s.num_frames); mu_label(ctx, buf);
+        mu_end_window(ctx);
+    }
+}
+
 sapp_desc sokol_main(int argc, char* argv[]) {
     (void)argc; (void)argv;
     return (sapp_desc){
@@ -370,7 +410,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .frame_cb = frame,
         .cleanup_cb = cleanup,
         .event_cb = event,
-        .width = 720,
+        .width = 960,
         .height = 540,
         .window_title = "microui+sokol_gl.h",
         .icon.sokol_default = true,
@@ -435,13 +475,13 @@ static void r_begin(int disp_width, int disp_height) {
 }
 
 static void r_end(void) {
-    sgl_end();
+    sglstats_end();
     sgl_pop_matrix();
     sgl_pop_pipeline();
 }
 
 static void r_draw(void) {
-    sgl_draw();
+    sglstats_draw();
 }
 
 static void r_push_quad(mu_Rect dst, mu_Rect src, mu_Color color) {
@@ -497,7 +537,7 @@ static int r_get_text_height(void) {
 }
 
 static void r_set_clip_rect(mu_Rect rect) {
-    sgl_end();
+    sglstats_end();
     sgl_scissor_rect(rect.x, rect.y, rect.w, rect.h, true);
     sgl_begin_quads();
 }
@@ -0,0 +1,225 @@
+//------------------------------------------------------------------------------
+//  sgl-points-perf-sapp.c
+//
+//  Renders 1M animated points per frame and compares the CPU cost of
+//  submitting them per vertex through sokol_gl.h (sgl_c1i(),
+//  sgl_point_size() and sgl_v2f() for each point) against appending
+//  them from arrays in one call via sglrec_stream_points() from
+//  libs/util/sglrec.h.
+//
+//  Press SPACE to switch between the per-vertex and bulk path.
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_GL_IMPL
+#include "sokol_gl.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/sglrec.h"
+#include "sglrec.glsl.h"
+#include <math.h>
+
+#define NUM_POINTS (1000000)
+#define NUM_AVG_FRAMES (60)
+
+typedef enum {
+    PATH_PER_VERTEX,
+    PATH_BULK,
+} path_t;
+
+typedef struct {
+    double update_ms;   // computing the point positions (same for both paths)
+    double submit_ms;   // sgl_*() calls or sglrec_stream_points()
+    double draw_ms;     // sgl_draw() or sglrec_stream_draw()
+    double frame_ms;
+} timings_t;
+
+static const float identity[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+};
+
+static struct {
+    path_t path;
+    float time;
+    float* radius;
+    float* phase;
+    float* xy;
+    uint32_t* rgba;
+    float* sizes;
+    timings_t accum;
+    timings_t avg;
+    int num_frames;
+} state = {
+    .path = PATH_BULK,
+};
+
+static inline uint32_t xorshift32(void) {
+    static uint32_t x = 0x12345678;
+    x ^= x<<13;
+    x ^= x>>17;
+    x ^= x<<5;
+    return x;
+}
+
+static inline float rnd(void) {
+    return ((float)(xorshift32() & 0xFFFF)) / 0x10000;
+}
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sgl_setup(&(sgl_desc_t){
+        .max_vertices = NUM_POINTS + 64,
+        .max_commands = 64,
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    sglrec_setup(&(sglrec_desc_t){
+        .shader = sg_make_shader(sglrec_shader_desc(sg_query_backend())),
+        .max_vertices = 1,
+        .max_stream_vertices = NUM_POINTS,
+    });
+
+    // the point arrays for the bulk path
+    state.radius = (float*) malloc(NUM_POINTS * sizeof(float));
+    state.phase = (float*) malloc(NUM_POINTS * sizeof(float));
+    state.xy = (float*) malloc(2 * NUM_POINTS * sizeof(float));
+    state.rgba = (uint32_t*) malloc(NUM_POINTS * sizeof(uint32_t));
+    state.sizes = (float*) malloc(NUM_POINTS * sizeof(float));
+    for (int i = 0; i < NUM_POINTS; i++) {
+        const float r = rnd();
+        state.radius[i] = r;
+        state.phase[i] = rnd() * 6.2831853f;
+        state.rgba[i] = 0xFF000000 | (uint32_t)(r * 255.0f) | ((xorshift32() & 0xFF) << 8) | ((uint32_t)((1.0f - r) * 255.0f) << 16);
+        state.sizes[i] = 1.0f + rnd() * 2.0f;
+    }
+}
+
+// a spinning disc, inner points rotate faster
+static void update_points(void) {
+    const float aspect = sapp_heightf() / sapp_widthf();
+    for (int i = 0; i < NUM_POINTS; i++) {
+        const float r = state.radius[i];
+        const float a = state.phase[i] + state.time / (0.2f + r);
+        state.xy[2 * i + 0] = cosf(a) * r * aspect;
+        state.xy[2 * i + 1] = sinf(a) * r;
+    }
+}
+
+static void frame(void) {
+    state.time += (float)sapp_frame_duration();
+
+    uint64_t start = stm_now();
+    update_points();
+    const double update_ms = stm_ms(stm_since(start));
+
+    start = stm_now();
+    if (state.path == PATH_PER_VERTEX) {
+        sgl_defaults();
+        sgl_begin_points();
+        for (int i = 0; i < NUM_POINTS; i++) {
+            sgl_c1i(state.rgba[i]);
+            sgl_point_size(state.sizes[i]);
+            sgl_v2f(state.xy[2 * i + 0], state.xy[2 * i + 1]);
+        }
+        sgl_end();
+    } else {
+        sglrec_stream_points(NUM_POINTS, state.xy, state.rgba, state.sizes);
+    }
+    const double submit_ms = stm_ms(stm_since(start));
+
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_printf("%d points per frame\n\n", NUM_POINTS);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    if (state.path == PATH_PER_VERTEX) {
+        sdtx_puts("path:   sokol-gl per vertex\n\n");
+    } else {
+        sdtx_printf("path:   bulk (%s)\n\n", SGLREC_SSE2 ? "SSE2" : "scalar");
+    }
+    sdtx_printf("update: %.3f ms\n", state.avg.update_ms);
+    sdtx_printf("submit: %.3f ms\n", state.avg.submit_ms);
+    sdtx_printf("draw:   %.3f ms\n", state.avg.draw_ms);
+    sdtx_printf("frame:  %.3f ms\n\n", state.avg.frame_ms);
+    sdtx_puts("press SPACE to switch path");
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.0f, 0.0f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    start = stm_now();
+    if (state.path == PATH_PER_VERTEX) {
+        sgl_draw();
+    } else {
+        sglrec_stream_draw(identity);
+    }
+    const double draw_ms = stm_ms(stm_since(start));
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+
+    state.accum.update_ms += update_ms;
+    state.accum.submit_ms += submit_ms;
+    state.accum.draw_ms += draw_ms;
+    state.accum.frame_ms += sapp_frame_duration() * 1000.0;
+    if (++state.num_frames == NUM_AVG_FRAMES) {
+        state.avg = (timings_t){
+            .update_ms = state.accum.update_ms / NUM_AVG_FRAMES,
+            .submit_ms = state.accum.submit_ms / NUM_AVG_FRAMES,
+            .draw_ms = state.accum.draw_ms / NUM_AVG_FRAMES,
+            .frame_ms = state.accum.frame_ms / NUM_AVG_FRAMES,
+        };
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE)) {
+        state.path = (state.path == PATH_PER_VERTEX) ? PATH_BULK : PATH_PER_VERTEX;
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void cleanup(void) {
+    free(state.radius);
+    free(state.phase);
+    free(state.xy);
+    free(state.rgba);
+    free(state.sizes);
+    sglrec_shutdown();
+    sdtx_shutdown();
+    sgl_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 800,
+        .height = 600,
+        .window_title = "sgl-points-perf-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
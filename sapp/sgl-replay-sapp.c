@@ -0,0 +1,224 @@
+//------------------------------------------------------------------------------
+//  sgl-replay-sapp.c
+//
+//  Compares the CPU cost of rendering 1M static line vertices per frame
+//  via sokol-gl immediate mode against recording the lines once with
+//  libs/util/sglrec.h and replaying the recorded vertex buffer.
+//
+//  Press SPACE to switch between immediate mode and replay.
+//------------------------------------------------------------------------------
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#define SOKOL_GL_IMPL
+#include "sokol_gl.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#define HANDMADE_MATH_IMPLEMENTATION
+#define HANDMADE_MATH_NO_SSE
+#include "HandmadeMath.h"
+#include "util/sglrec.h"
+#include "sglrec.glsl.h"
+
+#define NUM_ROWS (1000)
+#define NUM_SEGS (500)
+#define NUM_VERTICES (NUM_ROWS * NUM_SEGS * 2)
+#define NUM_AVG_FRAMES (60)
+
+typedef enum {
+    MODE_IMMEDIATE,
+    MODE_REPLAY,
+} replay_mode_t;
+
+typedef struct {
+    float x, y, z;
+    uint8_t r, g, b;
+} line_vertex_t;
+
+typedef struct {
+    double submit_ms;   // sgl_*() calls or sglrec_draw()
+    double draw_ms;     // sgl_draw()
+    double frame_ms;
+} timings_t;
+
+static struct {
+    replay_mode_t mode;
+    float angle;
+    sgl_pipeline sgl_pip;
+    sglrec_mesh_t mesh;
+    line_vertex_t* vertices;
+    timings_t accum;
+    timings_t avg;
+    int num_frames;
+} state = {
+    .mode = MODE_REPLAY,
+};
+
+// a wavy surface made of line segments, computed once
+static void init_vertices(void) {
+    state.vertices = (line_vertex_t*) malloc((size_t)NUM_VERTICES * sizeof(line_vertex_t));
+    line_vertex_t* v = state.vertices;
+    for (int row = 0; row < NUM_ROWS; row++) {
+        const float z = ((float)row / NUM_ROWS) * 20.0f - 10.0f;
+        for (int seg = 0; seg < NUM_SEGS; seg++) {
+            for (int i = 0; i < 2; i++) {
+                const float x = ((float)(seg + i) / NUM_SEGS) * 20.0f - 10.0f;
+                const float y = sinf(x * 0.7f) * cosf(z * 0.5f) * 1.5f;
+                *v++ = (line_vertex_t){
+                    .x = x, .y = y, .z = z,
+                    .r = (uint8_t)(128 + (int)(y * 80.0f)),
+                    .g = (uint8_t)((row * 255) / NUM_ROWS),
+                    .b = (uint8_t)((seg * 255) / NUM_SEGS),
+                };
+            }
+        }
+    }
+}
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sgl_setup(&(sgl_desc_t){
+        .max_vertices = NUM_VERTICES + 64,
+        .max_commands = 64,
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    state.sgl_pip = sgl_make_pipeline(&(sg_pipeline_desc){
+        .depth = {
+            .write_enabled = true,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+        },
+    });
+    init_vertices();
+
+    // record the same lines once into an immutable vertex buffer
+    sglrec_setup(&(sglrec_desc_t){
+        .shader = sg_make_shader(sglrec_shader_desc(sg_query_backend())),
+        .max_vertices = NUM_VERTICES,
+        .depth = {
+            .write_enabled = true,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+        },
+    });
+    sglrec_begin_recording();
+    sglrec_begin_lines();
+    for (int i = 0; i < NUM_VERTICES; i++) {
+        const line_vertex_t* v = &state.vertices[i];
+        sglrec_c3b(v->r, v->g, v->b);
+        sglrec_v3f(v->x, v->y, v->z);
+    }
+    sglrec_end();
+    state.mesh = sglrec_end_recording("lines");
+}
+
+static void frame(void) {
+    state.angle += (float)(sapp_frame_duration() * 20.0);
+    const hmm_mat4 proj = HMM_Perspective(60.0f, sapp_widthf() / sapp_heightf(), 0.1f, 100.0f);
+    const hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 8.0f, 16.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    const hmm_mat4 model = HMM_Rotate(state.angle, HMM_Vec3(0.0f, 1.0f, 0.0f));
+    const hmm_mat4 mvp = HMM_MultiplyMat4(HMM_MultiplyMat4(proj, view), model);
+
+    // immediate mode: submit all vertices through sokol-gl
+    double submit_ms = 0.0;
+    if (state.mode == MODE_IMMEDIATE) {
+        const uint64_t start = stm_now();
+        sgl_defaults();
+        sgl_load_pipeline(state.sgl_pip);
+        sgl_matrix_mode_projection();
+        sgl_load_matrix(&mvp.Elements[0][0]);
+        sgl_begin_lines();
+        for (int i = 0; i < NUM_VERTICES; i++) {
+            const line_vertex_t* v = &state.vertices[i];
+            sgl_c3b(v->r, v->g, v->b);
+            sgl_v3f(v->x, v->y, v->z);
+        }
+        sgl_end();
+        submit_ms = stm_ms(stm_since(start));
+    }
+
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_printf("%d static line vertices\n\n", NUM_VERTICES);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("mode:   %s\n\n", (state.mode == MODE_IMMEDIATE) ? "sokol-gl immediate" : "sglrec replay");
+    sdtx_printf("submit: %.3f ms\n", state.avg.submit_ms);
+    sdtx_printf("draw:   %.3f ms\n", state.avg.draw_ms);
+    sdtx_printf("total:  %.3f ms\n", state.avg.submit_ms + state.avg.draw_ms);
+    sdtx_printf("frame:  %.3f ms\n\n", state.avg.frame_ms);
+    sdtx_puts("press SPACE to switch mode");
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.0f, 0.0f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    // sgl_draw() includes copying the vertices into the sokol-gl vertex buffer
+    uint64_t start = stm_now();
+    sgl_draw();
+    const double draw_ms = stm_ms(stm_since(start));
+    if (state.mode == MODE_REPLAY) {
+        start = stm_now();
+        sglrec_draw(&state.mesh, &mvp.Elements[0][0]);
+        submit_ms = stm_ms(stm_since(start));
+    }
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+
+    state.accum.submit_ms += submit_ms;
+    state.accum.draw_ms += draw_ms;
+    state.accum.frame_ms += sapp_frame_duration() * 1000.0;
+    if (++state.num_frames == NUM_AVG_FRAMES) {
+        state.avg = (timings_t){
+            .submit_ms = state.accum.submit_ms / NUM_AVG_FRAMES,
+            .draw_ms = state.accum.draw_ms / NUM_AVG_FRAMES,
+            .frame_ms = state.accum.frame_ms / NUM_AVG_FRAMES,
+        };
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE)) {
+        state.mode = (state.mode == MODE_IMMEDIATE) ? MODE_REPLAY : MODE_IMMEDIATE;
+        state.accum = (timings_t){0};
+        state.num_frames = 0;
+    }
+}
+
+static void cleanup(void) {
+    sglrec_destroy_mesh(&state.mesh);
+    sglrec_shutdown();
+    free(state.vertices);
+    sdtx_shutdown();
+    sgl_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 800,
+        .height = 600,
+        .sample_count = 4,
+        .window_title = "sgl-replay-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
@@ -0,0 +1,39 @@
+//------------------------------------------------------------------------------
+//  Shader for replaying static geometry recorded with libs/util/sglrec.h,
+//  this has the same interface as the sokol-gl shader.
+//------------------------------------------------------------------------------
+@vs vs
+layout(binding=0) uniform vs_params {
+    mat4 mvp;
+};
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texcoord0;
+layout(location=2) in vec4 color0;
+layout(location=3) in float psize;
+
+out vec2 uv;
+out vec4 color;
+
+void main() {
+    gl_Position = mvp * position;
+    gl_PointSize = psize;
+    uv = texcoord0;
+    color = color0;
+}
+@end
+
+@fs fs
+layout(binding=0) uniform texture2D tex;
+layout(binding=0) uniform sampler smp;
+
+in vec2 uv;
+in vec4 color;
+out vec4 frag_color;
+
+void main() {
+    frag_color = texture(sampler2D(tex, smp), uv) * color;
+}
+@end
+
+@program sglrec vs fs
@@ -0,0 +1,621 @@
+//------------------------------------------------------------------------------
+//  shadows-csm-sapp.c
+//
+//  Cascaded shadow maps, based on shadows-depthtex-sapp.c
+//
+//  - 1 to 4 shadow cascades are rendered into the layers of a depth-only
+//    2D array texture, the display pass selects the cascade by view depth
+//  - each cascade covers the bounding sphere of its view frustum slice,
+//    with the cascade origin snapped to shadow-map texels so that shadow
+//    edges don't shimmer when the camera moves
+//  - shadow casters are culled per cascade against the cascade's light
+//    space box, the display pass is culled against the view frustum
+//  - all visible boxes of a pass are rendered with one instanced draw
+//  - GPU time per pass is measured with libs/util/gputimer.h, where
+//    per-pass timers are not supported only the frame time is shown
+//
+//  1..4:   number of cascades (1 is a single shadow map for the whole view)
+//  K:      toggle per-cascade caster culling
+//  V:      visualize cascades
+//  B:      toggle many-objects benchmark scene
+//------------------------------------------------------------------------------
+#include <stdlib.h> // rand
+#include <string.h> // memset
+#include <math.h>
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/gputimer.h"
+#include "dbgui/dbgui.h"
+#define HANDMADE_MATH_IMPLEMENTATION
+#define HANDMADE_MATH_NO_SSE
+#include "HandmadeMath.h"
+#include "shadows-csm-sapp.glsl.h"
+
+#define MAX_CASCADES (4)
+#define SHADOW_MAP_SIZE (2048)
+#define SMALL_SCENE_DIM (32)        // 32x32 boxes
+#define BENCH_SCENE_DIM (128)       // 128x128 boxes
+#define MAX_OBJECTS (BENCH_SCENE_DIM * BENCH_SCENE_DIM)
+#define GROUND_SIZE (400.0f)        // half size of the ground plane
+#define VIEW_NEAR (0.5f)
+#define VIEW_FAR (400.0f)
+#define VIEW_FOV (60.0f)
+#define CASTER_EXTEND (100.0f)      // extend cascades towards the light to catch casters outside the view
+#define SPLIT_LAMBDA (0.8f)         // blend between logarithmic and uniform split distances
+#define NUM_AVG_FRAMES (60)
+
+// GPU timer slots
+enum {
+    TIMER_CASCADE_0 = 0,
+    TIMER_DISPLAY = MAX_CASCADES,
+    TIMER_TOTAL,
+};
+
+// one box, also the per-instance vertex data
+typedef struct {
+    hmm_vec3 pos;
+    float hue;          // < 0 for the ground plane
+    hmm_vec3 size;      // half size
+    float radius;       // bounding sphere radius (unused in shaders)
+} instance_t;
+
+typedef struct {
+    float near_dist, far_dist;
+    hmm_mat4 view_proj;
+    // light-space culling box
+    float min_x, max_x, min_y, max_y, min_z, max_z;
+    int num_casters;
+} cascade_t;
+
+static struct {
+    sg_image shadow_map;
+    sg_sampler shadow_sampler;
+    sg_buffer vbuf;
+    sg_buffer ibuf;
+    sg_buffer inst_buf;
+    int num_cascades;
+    bool culling;
+    bool show_cascades;
+    bool bench_scene;
+    int num_objects;
+    instance_t objects[MAX_OBJECTS];
+    instance_t visible[MAX_OBJECTS];
+    cascade_t cascades[MAX_CASCADES];
+    int num_display_objects;
+    double time;
+    struct {
+        sg_pass_action pass_action;
+        sg_attachments atts[MAX_CASCADES];
+        sg_pipeline pip;
+    } shadow;
+    struct {
+        sg_pass_action pass_action;
+        sg_pipeline pip;
+    } display;
+    struct {
+        int num_frames;
+        double cull_ms;
+        double frame_ms;
+        double gpu_ms[TIMER_TOTAL + 1];
+    } accum;
+    double cull_ms;
+    double frame_ms;
+    double gpu_ms[TIMER_TOTAL + 1];
+} state = {
+    .num_cascades = 4,
+    .culling = true,
+};
+
+static void reset_stats(void) {
+    memset(&state.accum, 0, sizeof(state.accum));
+}
+
+static float rnd(float min_val, float max_val) {
+    return min_val + (max_val - min_val) * ((float)(rand() & 0x7FFF) / 32767.0f);
+}
+
+// boxes on a jittered grid covering the ground plane
+static void init_scene(bool bench) {
+    srand(12345);
+    const int dim = bench ? BENCH_SCENE_DIM : SMALL_SCENE_DIM;
+    const float cell = (2.0f * GROUND_SIZE) / (float)dim;
+    state.num_objects = 0;
+    for (int z = 0; z < dim; z++) {
+        for (int x = 0; x < dim; x++) {
+            instance_t* obj = &state.objects[state.num_objects++];
+            const float w = rnd(0.1f, 0.3f) * cell;
+            const float d = rnd(0.1f, 0.3f) * cell;
+            const float h = rnd(1.0f, 12.0f) * (rnd(0.0f, 1.0f) > 0.9f ? 2.5f : 1.0f);
+            obj->pos = HMM_Vec3(-GROUND_SIZE + ((float)x + rnd(0.3f, 0.7f)) * cell, h, -GROUND_SIZE + ((float)z + rnd(0.3f, 0.7f)) * cell);
+            obj->size = HMM_Vec3(w, h, d);
+            obj->hue = rnd(0.0f, 1.0f);
+            obj->radius = HMM_LengthVec3(obj->size);
+        }
+    }
+    reset_stats();
+}
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    __dbgui_setup(sapp_sample_count());
+    gputimer_setup();
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    init_scene(false);
+
+    // vertex buffer for a unit box and the ground plane
+    const float scene_vertices[] = {
+        // pos                  normals
+        -1.0f, -1.0f, -1.0f,    0.0f, 0.0f, -1.0f,  //CUBE BACK FACE
+         1.0f, -1.0f, -1.0f,    0.0f, 0.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,    0.0f, 0.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,    0.0f, 0.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,    0.0f, 0.0f, 1.0f,   //CUBE FRONT FACE
+         1.0f, -1.0f,  1.0f,    0.0f, 0.0f, 1.0f,
+         1.0f,  1.0f,  1.0f,    0.0f, 0.0f, 1.0f,
+        -1.0f,  1.0f,  1.0f,    0.0f, 0.0f, 1.0f,
+
+        -1.0f, -1.0f, -1.0f,    -1.0f, 0.0f, 0.0f,  //CUBE LEFT FACE
+        -1.0f,  1.0f, -1.0f,    -1.0f, 0.0f, 0.0f,
+        -1.0f,  1.0f,  1.0f,    -1.0f, 0.0f, 0.0f,
+        -1.0f, -1.0f,  1.0f,    -1.0f, 0.0f, 0.0f,
+
+         1.0f, -1.0f, -1.0f,    1.0f, 0.0f, 0.0f,   //CUBE RIGHT FACE
+         1.0f,  1.0f, -1.0f,    1.0f, 0.0f, 0.0f,
+         1.0f,  1.0f,  1.0f,    1.0f, 0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f,    1.0f, 0.0f, 0.0f,
+
+        -1.0f, -1.0f, -1.0f,    0.0f, -1.0f, 0.0f,  //CUBE BOTTOM FACE
+        -1.0f, -1.0f,  1.0f,    0.0f, -1.0f, 0.0f,
+         1.0f, -1.0f,  1.0f,    0.0f, -1.0f, 0.0f,
+         1.0f, -1.0f, -1.0f,    0.0f, -1.0f, 0.0f,
+
+        -1.0f,  1.0f, -1.0f,    0.0f, 1.0f, 0.0f,   //CUBE TOP FACE
+        -1.0f,  1.0f,  1.0f,    0.0f, 1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f,    0.0f, 1.0f, 0.0f,
+         1.0f,  1.0f, -1.0f,    0.0f, 1.0f, 0.0f,
+
+        -1.0f,  0.0f, -1.0f,    0.0f, 1.0f, 0.0f,   //PLANE GEOMETRY
+        -1.0f,  0.0f,  1.0f,    0.0f, 1.0f, 0.0f,
+         1.0f,  0.0f,  1.0f,    0.0f, 1.0f, 0.0f,
+         1.0f,  0.0f, -1.0f,    0.0f, 1.0f, 0.0f,
+    };
+    state.vbuf = sg_make_buffer(&(sg_buffer_desc){
+        .data = SG_RANGE(scene_vertices),
+        .label = "scene-vertices"
+    });
+    const uint16_t scene_indices[] = {
+        0, 1, 2,  0, 2, 3,
+        6, 5, 4,  7, 6, 4,
+        8, 9, 10,  8, 10, 11,
+        14, 13, 12,  15, 14, 12,
+        16, 17, 18,  16, 18, 19,
+        22, 21, 20,  23, 22, 20,
+        26, 25, 24,  27, 26, 24
+    };
+    state.ibuf = sg_make_buffer(&(sg_buffer_desc){
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .data = SG_RANGE(scene_indices),
+        .label = "scene-indices"
+    });
+
+    // a stream buffer for the culled instances of all passes, appended each frame
+    state.inst_buf = sg_make_buffer(&(sg_buffer_desc){
+        .size = ((MAX_CASCADES + 1) * MAX_OBJECTS + 1) * sizeof(instance_t),
+        .usage = SG_USAGE_STREAM,
+        .label = "instances",
+    });
+
+    state.shadow.pass_action = (sg_pass_action){
+        .depth = {
+            .load_action = SG_LOADACTION_CLEAR,
+            .store_action = SG_STOREACTION_STORE,
+            .clear_value = 1.0f,
+        },
+    };
+    state.display.pass_action = (sg_pass_action){
+        .colors[0] = {
+            .load_action = SG_LOADACTION_CLEAR,
+            .clear_value = { 0.5f, 0.6f, 0.8f, 1.0f}
+        },
+    };
+
+    // the shadow cascades are layers of a depth-only array texture
+    state.shadow_map = sg_make_image(&(sg_image_desc){
+        .type = SG_IMAGETYPE_ARRAY,
+        .render_target = true,
+        .width = SHADOW_MAP_SIZE,
+        .height = SHADOW_MAP_SIZE,
+        .num_slices = MAX_CASCADES,
+        .pixel_format = SG_PIXELFORMAT_DEPTH,
+        .sample_count = 1,
+        .label = "shadow-cascades",
+    });
+    for (int i = 0; i < MAX_CASCADES; i++) {
+        state.shadow.atts[i] = sg_make_attachments(&(sg_attachments_desc){
+            .depth_stencil = { .image = state.shadow_map, .slice = i },
+            .label = "shadow-pass",
+        });
+    }
+    state.shadow_sampler = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .compare = SG_COMPAREFUNC_LESS,
+        .label = "shadow-sampler",
+    });
+
+    state.shadow.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            // need to provide vertex stride, because normal component is skipped in shadow pass
+            .buffers = {
+                [0].stride = 6 * sizeof(float),
+                [1] = { .stride = sizeof(instance_t), .step_func = SG_VERTEXSTEP_PER_INSTANCE },
+            },
+            .attrs = {
+                [ATTR_shadow_pos] = { .format = SG_VERTEXFORMAT_FLOAT3, .buffer_index = 0 },
+                [ATTR_shadow_inst_pos] = { .format = SG_VERTEXFORMAT_FLOAT4, .buffer_index = 1, .offset = 0 },
+                [ATTR_shadow_inst_size] = { .format = SG_VERTEXFORMAT_FLOAT4, .buffer_index = 1, .offset = 16 },
+            },
+        },
+        .shader = sg_make_shader(shadow_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        // render back-faces in shadow pass to prevent shadow acne on front-faces
+        .cull_mode = SG_CULLMODE_FRONT,
+        .sample_count = 1,
+        .depth = {
+            .pixel_format = SG_PIXELFORMAT_DEPTH,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true,
+        },
+        .colors[0].pixel_format = SG_PIXELFORMAT_NONE,
+        .label = "shadow-pipeline"
+    });
+
+    state.display.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .buffers[1] = { .stride = sizeof(instance_t), .step_func = SG_VERTEXSTEP_PER_INSTANCE },
+            .attrs = {
+                [ATTR_display_pos] = { .format = SG_VERTEXFORMAT_FLOAT3, .buffer_index = 0 },
+                [ATTR_display_norm] = { .format = SG_VERTEXFORMAT_FLOAT3, .buffer_index = 0 },
+                [ATTR_display_inst_pos] = { .format = SG_VERTEXFORMAT_FLOAT4, .buffer_index = 1, .offset = 0 },
+                [ATTR_display_inst_size] = { .format = SG_VERTEXFORMAT_FLOAT4, .buffer_index = 1, .offset = 16 },
+            }
+        },
+        .shader = sg_make_shader(display_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        .cull_mode = SG_CULLMODE_BACK,
+        .depth = {
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true,
+        },
+        .label = "display-pipeline",
+    });
+}
+
+// maps the clip space z of a GL-style projection from -1..+1 to 0..+1,
+// together with fixup_clipspace in the shadow shader the shadow-map
+// depth then matches light_view_proj z on all backends
+static hmm_mat4 zero_to_one_depth(hmm_mat4 proj) {
+    hmm_mat4 m = HMM_Mat4d(1.0f);
+    m.Elements[2][2] = 0.5f;
+    m.Elements[3][2] = 0.5f;
+    return HMM_MultiplyMat4(m, proj);
+}
+
+// view distances where the cascades end, unused cascades are never selected
+static void compute_splits(float* splits, int num_cascades) {
+    for (int i = 0; i < MAX_CASCADES; i++) {
+        splits[i] = 2.0f * VIEW_FAR;
+    }
+    for (int i = 1; i <= num_cascades; i++) {
+        const float f = (float)i / (float)num_cascades;
+        const float log_split = VIEW_NEAR * powf(VIEW_FAR / VIEW_NEAR, f);
+        const float uni_split = VIEW_NEAR + (VIEW_FAR - VIEW_NEAR) * f;
+        splits[i - 1] = SPLIT_LAMBDA * log_split + (1.0f - SPLIT_LAMBDA) * uni_split;
+    }
+}
+
+// compute a cascade's light view-projection with texel snapping, and the light-space culling box
+static void compute_cascade(cascade_t* c, hmm_mat4 light_view, hmm_vec3 eye, hmm_vec3 fwd, hmm_vec3 right, hmm_vec3 up, float aspect) {
+    // corners of the view frustum slice
+    const float tan_half_fov = tanf(HMM_ToRadians(VIEW_FOV * 0.5f));
+    hmm_vec3 corners[8];
+    for (int i = 0; i < 2; i++) {
+        const float d = (i == 0) ? c->near_dist : c->far_dist;
+        const float hh = d * tan_half_fov;
+        const float hw = hh * aspect;
+        const hmm_vec3 center = HMM_AddVec3(eye, HMM_MultiplyVec3f(fwd, d));
+        for (int k = 0; k < 4; k++) {
+            const float sx = (k & 1) ? 1.0f : -1.0f;
+            const float sy = (k & 2) ? 1.0f : -1.0f;
+            corners[i * 4 + k] = HMM_AddVec3(center, HMM_AddVec3(HMM_MultiplyVec3f(right, sx * hw), HMM_MultiplyVec3f(up, sy * hh)));
+        }
+    }
+    // bounding sphere, the radius only depends on the slice's shape, not on
+    // the camera orientation, so the cascade size is constant
+    hmm_vec3 center = HMM_Vec3(0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 8; i++) {
+        center = HMM_AddVec3(center, corners[i]);
+    }
+    center = HMM_MultiplyVec3f(center, 1.0f / 8.0f);
+    float radius = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        radius = HMM_MAX(radius, HMM_LengthVec3(HMM_SubtractVec3(corners[i], center)));
+    }
+    radius = ceilf(radius * 16.0f) / 16.0f;
+
+    // snap the sphere center to whole shadow-map texels in light space
+    const float texel_size = (2.0f * radius) / (float)SHADOW_MAP_SIZE;
+    hmm_vec4 ls = HMM_MultiplyMat4ByVec4(light_view, HMM_Vec4(center.X, center.Y, center.Z, 1.0f));
+    ls.X = floorf(ls.X / texel_size) * texel_size;
+    ls.Y = floorf(ls.Y / texel_size) * texel_size;
+
+    // light view space looks along -z, pull the near plane towards the light
+    c->min_x = ls.X - radius; c->max_x = ls.X + radius;
+    c->min_y = ls.Y - radius; c->max_y = ls.Y + radius;
+    c->min_z = ls.Z - radius; c->max_z = ls.Z + radius + CASTER_EXTEND;
+    const hmm_mat4 proj = HMM_Orthographic(c->min_x, c->max_x, c->min_y, c->max_y, -c->max_z, -c->min_z);
+    c->view_proj = HMM_MultiplyMat4(zero_to_one_depth(proj), light_view);
+}
+
+// sphere against view frustum planes (extracted from the view-projection matrix)
+typedef struct { float x, y, z, w; } plane_t;
+
+static void extract_planes(hmm_mat4 m, plane_t planes[6]) {
+    for (int i = 0; i < 3; i++) {
+        for (int s = 0; s < 2; s++) {
+            const float sign = s ? -1.0f : 1.0f;
+            plane_t p = {
+                m.Elements[0][3] + sign * m.Elements[0][i],
+                m.Elements[1][3] + sign * m.Elements[1][i],
+                m.Elements[2][3] + sign * m.Elements[2][i],
+                m.Elements[3][3] + sign * m.Elements[3][i],
+            };
+            const float len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+            planes[i * 2 + s] = (plane_t){ p.x / len, p.y / len, p.z / len, p.w / len };
+        }
+    }
+}
+
+static bool sphere_visible(const plane_t planes[6], hmm_vec3 c, float r) {
+    for (int i = 0; i < 6; i++) {
+        if ((planes[i].x * c.X + planes[i].y * c.Y + planes[i].z * c.Z + planes[i].w) < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// cull objects against a cascade's light-space box into state.visible
+static int cull_casters(cascade_t* c, hmm_mat4 light_view) {
+    int n = 0;
+    for (int i = 0; i < state.num_objects; i++) {
+        const instance_t* obj = &state.objects[i];
+        if (state.culling) {
+            const float r = obj->radius;
+            const hmm_vec4 p = HMM_MultiplyMat4ByVec4(light_view, HMM_Vec4(obj->pos.X, obj->pos.Y, obj->pos.Z, 1.0f));
+            if (((p.X + r) < c->min_x) || ((p.X - r) > c->max_x) ||
+                ((p.Y + r) < c->min_y) || ((p.Y - r) > c->max_y) ||
+                ((p.Z + r) < c->min_z) || ((p.Z - r) > c->max_z))
+            {
+                continue;
+            }
+        }
+        state.visible[n++] = *obj;
+    }
+    c->num_casters = n;
+    return n;
+}
+
+static void draw_stats(void) {
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("cascades: %d (1..4)  %dx%d\n", state.num_cascades, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+    sdtx_printf("caster culling: %s (K)\n", state.culling ? "on" : "off");
+    sdtx_printf("objects: %d (B)  tint: V\n\n", state.num_objects);
+    const bool gpu = gputimer_supported();
+    sdtx_puts("casc    far  casters     gpu\n");
+    for (int i = 0; i < state.num_cascades; i++) {
+        const cascade_t* c = &state.cascades[i];
+        sdtx_printf("%4d %6.1f %8d", i, c->far_dist, c->num_casters);
+        if (gpu) {
+            sdtx_printf(" %6.3fms\n", state.gpu_ms[TIMER_CASCADE_0 + i]);
+        } else {
+            sdtx_puts("     n/a\n");
+        }
+    }
+    sdtx_printf("view        %8d", state.num_display_objects);
+    if (gpu) {
+        sdtx_printf(" %6.3fms\n", state.gpu_ms[TIMER_DISPLAY]);
+        sdtx_printf("\ngpu total: %.3f ms\n", state.gpu_ms[TIMER_TOTAL]);
+    } else {
+        // no per-pass timers, at least show the frame time
+        sdtx_printf("     n/a\n\n%s frame: %.3f ms\n", gputimer_frame_on_gpu() ? "gpu" : "cpu", state.frame_ms);
+    }
+    sdtx_printf("cpu cull:  %.3f ms\n", state.cull_ms);
+}
+
+static void frame(void) {
+    state.time += sapp_frame_duration();
+    const float t = (float)state.time;
+    const float aspect = sapp_widthf() / sapp_heightf();
+
+    // camera flies in a circle over the scene, looking ahead
+    const float cam_angle = t * 0.05f;
+    const hmm_vec3 eye = HMM_Vec3(150.0f * cosf(cam_angle), 30.0f, 150.0f * sinf(cam_angle));
+    const hmm_vec3 target = HMM_Vec3(150.0f * cosf(cam_angle + 0.3f), 5.0f, 150.0f * sinf(cam_angle + 0.3f));
+    const hmm_mat4 view = HMM_LookAt(eye, target, HMM_Vec3(0.0f, 1.0f, 0.0f));
+    const hmm_mat4 proj = HMM_Perspective(VIEW_FOV, aspect, VIEW_NEAR, VIEW_FAR);
+    const hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
+    const hmm_vec3 fwd = HMM_NormalizeVec3(HMM_SubtractVec3(target, eye));
+    const hmm_vec3 right = HMM_NormalizeVec3(HMM_Cross(fwd, HMM_Vec3(0.0f, 1.0f, 0.0f)));
+    const hmm_vec3 up = HMM_Cross(right, fwd);
+
+    // a fixed light direction, the light view matrix only defines the orientation
+    const hmm_vec3 light_dir = HMM_NormalizeVec3(HMM_Vec3(0.5f, 1.0f, -0.3f));
+    const hmm_mat4 light_view = HMM_LookAt(light_dir, HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+
+    // compute cascades and cull casters, append instances of all passes into the instance buffer
+    uint64_t start = stm_now();
+    float splits[MAX_CASCADES] = { 0 };
+    compute_splits(splits, state.num_cascades);
+    int cascade_offsets[MAX_CASCADES];
+    for (int i = 0; i < state.num_cascades; i++) {
+        cascade_t* c = &state.cascades[i];
+        c->near_dist = (i == 0) ? VIEW_NEAR : splits[i - 1];
+        c->far_dist = splits[i];
+        compute_cascade(c, light_view, eye, fwd, right, up, aspect);
+        const int n = cull_casters(c, light_view);
+        cascade_offsets[i] = n > 0 ? sg_append_buffer(state.inst_buf, &(sg_range){ state.visible, (size_t)n * sizeof(instance_t) }) : 0;
+    }
+    plane_t planes[6];
+    extract_planes(view_proj, planes);
+    int num_display = 0;
+    for (int i = 0; i < state.num_objects; i++) {
+        const instance_t* obj = &state.objects[i];
+        if (sphere_visible(planes, obj->pos, obj->radius)) {
+            state.visible[num_display++] = *obj;
+        }
+    }
+    state.num_display_objects = num_display;
+    const int display_offset = num_display > 0 ? sg_append_buffer(state.inst_buf, &(sg_range){ state.visible, (size_t)num_display * sizeof(instance_t) }) : 0;
+    const instance_t ground = { .pos = HMM_Vec3(0.0f, 0.0f, 0.0f), .hue = -1.0f, .size = HMM_Vec3(GROUND_SIZE, 1.0f, GROUND_SIZE) };
+    const int ground_offset = sg_append_buffer(state.inst_buf, &SG_RANGE(ground));
+    const double cull_ms = stm_ms(stm_since(start));
+
+    // average CPU and GPU times
+    state.accum.cull_ms += cull_ms;
+    state.accum.frame_ms += gputimer_frame_ms();
+    for (int i = 0; i <= TIMER_TOTAL; i++) {
+        state.accum.gpu_ms[i] += gputimer_ms(i);
+    }
+    if (++state.accum.num_frames == NUM_AVG_FRAMES) {
+        state.cull_ms = state.accum.cull_ms / NUM_AVG_FRAMES;
+        state.frame_ms = state.accum.frame_ms / NUM_AVG_FRAMES;
+        for (int i = 0; i <= TIMER_TOTAL; i++) {
+            state.gpu_ms[i] = state.accum.gpu_ms[i] / NUM_AVG_FRAMES;
+        }
+        reset_stats();
+    }
+    draw_stats();
+
+    gputimer_begin_frame();
+    gputimer_begin(TIMER_TOTAL);
+
+    // one depth-only pass per cascade
+    for (int i = 0; i < state.num_cascades; i++) {
+        const cascade_t* c = &state.cascades[i];
+        gputimer_begin(TIMER_CASCADE_0 + i);
+        sg_begin_pass(&(sg_pass){ .action = state.shadow.pass_action, .attachments = state.shadow.atts[i] });
+        if (c->num_casters > 0) {
+            sg_apply_pipeline(state.shadow.pip);
+            sg_apply_bindings(&(sg_bindings){
+                .vertex_buffers = { [0] = state.vbuf, [1] = state.inst_buf },
+                .vertex_buffer_offsets[1] = cascade_offsets[i],
+                .index_buffer = state.ibuf,
+            });
+            const vs_shadow_params_t vs_params = { .light_view_proj = c->view_proj };
+            sg_apply_uniforms(UB_vs_shadow_params, &SG_RANGE(vs_params));
+            sg_draw(0, 36, c->num_casters);
+        }
+        sg_end_pass();
+        gputimer_end(TIMER_CASCADE_0 + i);
+    }
+
+    // the display pass
+    fs_display_params_t fs_params = {
+        .splits = HMM_Vec4(splits[0], splits[1], splits[2], splits[3]),
+        .light_dir = light_dir,
+        .num_cascades = (float)state.num_cascades,
+        .eye_pos = eye,
+        .show_cascades = state.show_cascades ? 1.0f : 0.0f,
+        .eye_fwd = fwd,
+        .bias = 0.0005f,
+    };
+    for (int i = 0; i < MAX_CASCADES; i++) {
+        fs_params.light_view_proj[i] = state.cascades[i].view_proj;
+    }
+    const vs_display_params_t vs_params = { .view_proj = view_proj };
+    sg_bindings display_bind = {
+        .vertex_buffers = { [0] = state.vbuf, [1] = state.inst_buf },
+        .vertex_buffer_offsets[1] = ground_offset,
+        .index_buffer = state.ibuf,
+        .images[IMG_shadow_map] = state.shadow_map,
+        .samplers[SMP_shadow_sampler] = state.shadow_sampler,
+    };
+    gputimer_begin(TIMER_DISPLAY);
+    sg_begin_pass(&(sg_pass){ .action = state.display.pass_action, .swapchain = sglue_swapchain() });
+    sg_apply_pipeline(state.display.pip);
+    sg_apply_bindings(&display_bind);
+    sg_apply_uniforms(UB_vs_display_params, &SG_RANGE(vs_params));
+    sg_apply_uniforms(UB_fs_display_params, &SG_RANGE(fs_params));
+    sg_draw(36, 6, 1);
+    if (num_display > 0) {
+        display_bind.vertex_buffer_offsets[1] = display_offset;
+        sg_apply_bindings(&display_bind);
+        sg_draw(0, 36, num_display);
+    }
+    sdtx_draw();
+    __dbgui_draw();
+    sg_end_pass();
+    gputimer_end(TIMER_DISPLAY);
+    gputimer_end(TIMER_TOTAL);
+    gputimer_end_frame();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        if ((ev->key_code >= SAPP_KEYCODE_1) && (ev->key_code <= SAPP_KEYCODE_4)) {
+            state.num_cascades = (int)(ev->key_code - SAPP_KEYCODE_1) + 1;
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_K) {
+            state.culling = !state.culling;
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_V) {
+            state.show_cascades = !state.show_cascades;
+        } else if (ev->key_code == SAPP_KEYCODE_B) {
+            state.bench_scene = !state.bench_scene;
+            init_scene(state.bench_scene);
+        }
+    }
+    __dbgui_event(ev);
+}
+
+static void cleanup(void) {
+    __dbgui_shutdown();
+    sdtx_shutdown();
+    gputimer_shutdown();
+    sg_shutdown();
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 1024,
+        .height = 768,
+        .sample_count = 4,
+        .window_title = "shadows-csm-sapp",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
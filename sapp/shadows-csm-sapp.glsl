@@ -0,0 +1,124 @@
+@ctype mat4 hmm_mat4
+@ctype vec4 hmm_vec4
+@ctype vec3 hmm_vec3
+
+// per-instance box position and half-size, the w component of
+// inst_pos is a color hue in the display pass
+@block instance_inputs
+in vec3 pos;
+in vec3 norm;
+in vec4 inst_pos;
+in vec4 inst_size;
+@end
+
+//=== shadow pass
+@vs vs_shadow
+@glsl_options fixup_clipspace // important: map clipspace z from 0..+1 to -1..+1 on GL
+
+layout(binding=0) uniform vs_shadow_params {
+    mat4 light_view_proj;
+};
+
+@include_block instance_inputs
+
+void main() {
+    gl_Position = light_view_proj * vec4(inst_pos.xyz + pos * inst_size.xyz, 1.0);
+}
+@end
+
+@fs fs_shadow
+void main() { }
+@end
+
+@program shadow vs_shadow fs_shadow
+
+//=== display pass
+@vs vs_display
+
+layout(binding=0) uniform vs_display_params {
+    mat4 view_proj;
+};
+
+@include_block instance_inputs
+
+out vec3 color;
+out vec3 world_pos;
+out vec3 world_norm;
+
+vec3 hue_to_rgb(float h) {
+    vec3 c = clamp(abs(fract(vec3(h) + vec3(0.0, 2.0/3.0, 1.0/3.0)) * 6.0 - 3.0) - 1.0, 0.0, 1.0);
+    return mix(vec3(0.6), c, 0.5);
+}
+
+void main() {
+    world_pos = inst_pos.xyz + pos * inst_size.xyz;
+    gl_Position = view_proj * vec4(world_pos, 1.0);
+    world_norm = norm;
+    color = (inst_pos.w < 0.0) ? vec3(0.5, 0.45, 0.4) : hue_to_rgb(inst_pos.w);
+}
+@end
+
+@fs fs_display
+
+layout(binding=1) uniform fs_display_params {
+    mat4 light_view_proj[4];
+    vec4 splits;            // far distance of cascades 0..2, cascade 3 covers the rest
+    vec3 light_dir;
+    float num_cascades;
+    vec3 eye_pos;
+    float show_cascades;
+    vec3 eye_fwd;
+    float bias;
+};
+
+layout(binding=0) uniform texture2DArray shadow_map;
+layout(binding=0) uniform sampler shadow_sampler;
+
+in vec3 color;
+in vec3 world_pos;
+in vec3 world_norm;
+
+out vec4 frag_color;
+
+vec4 gamma(vec4 c) {
+    float p = 1.0 / 2.2;
+    return vec4(pow(c.xyz, vec3(p)), c.w);
+}
+
+void main() {
+    // select cascade by view depth
+    float view_depth = dot(world_pos - eye_pos, eye_fwd);
+    int cascade = 0;
+    if (view_depth > splits.x) { cascade = 1; }
+    if (view_depth > splits.y) { cascade = 2; }
+    if (view_depth > splits.z) { cascade = 3; }
+    cascade = min(cascade, int(num_cascades) - 1);
+
+    float ambient_intensity = 0.25;
+    vec3 l = normalize(light_dir);
+    vec3 n = normalize(world_norm);
+    float n_dot_l = dot(n, l);
+    float s = 0.0;
+    if (n_dot_l > 0.0) {
+        vec4 light_pos = light_view_proj[cascade] * vec4(world_pos, 1.0);
+        #if !SOKOL_GLSL
+            light_pos.y = -light_pos.y;
+        #endif
+        vec2 uv = (light_pos.xy + 1.0) * 0.5;
+        if (all(greaterThan(uv, vec2(0.0))) && all(lessThan(uv, vec2(1.0)))) {
+            s = texture(sampler2DArrayShadow(shadow_map, shadow_sampler), vec4(uv, float(cascade), light_pos.z - bias));
+        } else {
+            s = 1.0;
+        }
+    }
+    vec3 c = color;
+    if (show_cascades > 0.0) {
+        const vec3 tints[4] = { vec3(1.0, 0.5, 0.5), vec3(0.5, 1.0, 0.5), vec3(0.5, 0.5, 1.0), vec3(1.0, 1.0, 0.5) };
+        c *= tints[cascade];
+    }
+    float diff_intensity = max(n_dot_l * s, 0.0);
+    frag_color = gamma(vec4((diff_intensity + ambient_intensity) * c, 1.0));
+}
+@end
+
+@program display vs_display fs_display
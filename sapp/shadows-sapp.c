@@ -1,54 +1,179 @@
 //------------------------------------------------------------------------------
 //  shadows-sapp.c
 //
-//  Shadow mapping via a regular RGBA8 texture as shadow map. The depth value
-//  is encoded to RGBA8 in the shadow pass fragment shader, and decoded
-//  from RGBA8 in the display-pass fragment shader (this encoding was required for
-//  WebGL compatibility across all devices, but is probably no longer needed
-//  in WebGL2 and could be replaced with a regular R32F texture instead.
+//  Shadow mapping with two interchangeable shadow map implementations:
 //
-//  Also see shadows-depthtex-sapp for a similar sample using a depth-only
-//  pass and depth-buffer as shadow map.
+//  - encoded: the depth value is encoded to RGBA8 in the shadow pass
+//    fragment shader, and decoded from RGBA8 in the display-pass fragment
+//    shader (this encoding was required for WebGL compatibility across all
+//    devices), the shadow pass needs an RGBA8 color target plus a separate
+//    depth buffer
+//  - depth-only: the shadow pass has no color target and no fragment shader
+//    work, the display pass samples the depth buffer with a comparison sampler
+//
+//  Both display shaders use the same 5x5 PCF kernel. Press M to switch
+//  between the two, 1..3 to select the shadow map size, UP/DOWN to change
+//  how often the shadow casters are rendered into the shadow map (to make
+//  the shadow pass fill cost measurable), and B to run a benchmark over all
+//  modes and sizes. GPU times are measured with libs/util/gputimer.h.
+//
+//  Also see shadows-depthtex-sapp for a minimal depth-only sample.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_debugtext.h"
+#include "util/gputimer.h"
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
 #include "dbgui/dbgui.h"
 #include "shadows-sapp.glsl.h"
 
+#define NUM_SIZES (3)
+#define MAX_OVERDRAW (64)
+#define NUM_AVG_FRAMES (60)
+#define BENCH_FRAMES (120)
+
+enum {
+    MODE_ENCODED,
+    MODE_DEPTH,
+    NUM_MODES,
+};
+
+enum {
+    TIMER_SHADOW,
+    TIMER_DISPLAY,
+};
+
+static const int shadow_map_sizes[NUM_SIZES] = { 1024, 2048, 4096 };
+static const char* mode_names[NUM_MODES] = { "encoded", "depth-only" };
+
+typedef struct {
+    double shadow_ms;
+    double display_ms;
+    size_t num_bytes;
+} result_t;
+
 static struct {
-    sg_image shadow_map;
-    sg_sampler shadow_sampler;
+    int mode;
+    int size_index;
+    int overdraw;
     sg_buffer vbuf;
     sg_buffer ibuf;
     float ry;
+    // the current shadow map, color_img is only used by the encoded mode
     struct {
-        sg_pass_action pass_action;
+        sg_image color_img;
+        sg_image depth_img;
         sg_attachments atts;
-        sg_pipeline pip;
+        size_t num_bytes;
+    } shadow_map;
+    struct {
+        sg_pass_action pass_action[NUM_MODES];
+        sg_pipeline pip[NUM_MODES];
         sg_bindings bind;
     } shadow;
     struct {
         sg_pass_action pass_action;
-        sg_pipeline pip;
+        sg_pipeline pip[NUM_MODES];
+        sg_sampler smp[NUM_MODES];
         sg_bindings bind;
     } display;
     struct {
-        sg_pipeline pip;
+        sg_pipeline pip[NUM_MODES];
+        sg_sampler smp;
         sg_bindings bind;
     } dbg;
+    gputimer_avg_t avg;
+    struct {
+        gputimer_bench_t run;   // config is an index into mode x size
+        int saved_mode;
+        int saved_size_index;
+        result_t results[NUM_MODES][NUM_SIZES];
+    } bench;
 } state;
 
+static void reset_stats(void) {
+    gputimer_avg_reset(&state.avg);
+}
+
+// (re-)create the shadow map render targets for a mode and size, the
+// encoded mode needs an RGBA8 color target plus a depth buffer, the
+// depth-only mode renders straight into a depth texture
+static void create_shadow_map(int mode, int size_index) {
+    if (state.shadow_map.atts.id != SG_INVALID_ID) {
+        sg_destroy_attachments(state.shadow_map.atts);
+        sg_destroy_image(state.shadow_map.depth_img);
+        sg_destroy_image(state.shadow_map.color_img);
+        state.shadow_map.color_img.id = SG_INVALID_ID;
+    }
+    const int size = shadow_map_sizes[size_index];
+    state.shadow_map.depth_img = sg_make_image(&(sg_image_desc){
+        .render_target = true,
+        .width = size,
+        .height = size,
+        .pixel_format = SG_PIXELFORMAT_DEPTH,
+        .sample_count = 1,
+        .label = (mode == MODE_DEPTH) ? "shadow-map" : "shadow-depth-buffer",
+    });
+    state.shadow_map.num_bytes = (size_t)sg_query_surface_pitch(SG_PIXELFORMAT_DEPTH, size, size, 1);
+    if (mode == MODE_ENCODED) {
+        state.shadow_map.color_img = sg_make_image(&(sg_image_desc){
+            .render_target = true,
+            .width = size,
+            .height = size,
+            .pixel_format = SG_PIXELFORMAT_RGBA8,
+            .sample_count = 1,
+            .label = "shadow-map",
+        });
+        state.shadow_map.num_bytes += (size_t)sg_query_surface_pitch(SG_PIXELFORMAT_RGBA8, size, size, 1);
+        state.shadow_map.atts = sg_make_attachments(&(sg_attachments_desc){
+            .colors[0].image = state.shadow_map.color_img,
+            .depth_stencil.image = state.shadow_map.depth_img,
+            .label = "shadow-pass",
+        });
+    } else {
+        state.shadow_map.atts = sg_make_attachments(&(sg_attachments_desc){
+            .depth_stencil.image = state.shadow_map.depth_img,
+            .label = "shadow-pass",
+        });
+    }
+
+    // the shaders of both modes use binding slot 0 for the shadow map and its sampler
+    if (mode == MODE_ENCODED) {
+        state.display.bind.images[IMG_shadow_map] = state.shadow_map.color_img;
+        state.display.bind.samplers[SMP_shadow_sampler] = state.display.smp[MODE_ENCODED];
+        state.dbg.bind.images[IMG_dbg_tex] = state.shadow_map.color_img;
+        state.dbg.bind.samplers[SMP_dbg_smp] = state.dbg.smp;
+    } else {
+        state.display.bind.images[IMG_shadow_depth_map] = state.shadow_map.depth_img;
+        state.display.bind.samplers[SMP_shadow_cmp_sampler] = state.display.smp[MODE_DEPTH];
+        state.dbg.bind.images[IMG_dbg_depth_tex] = state.shadow_map.depth_img;
+        state.dbg.bind.samplers[SMP_dbg_depth_smp] = state.dbg.smp;
+    }
+    state.mode = mode;
+    state.size_index = size_index;
+    reset_stats();
+}
+
 void init(void) {
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
     });
     __dbgui_setup(sapp_sample_count());
+    stm_setup();
+    gputimer_setup();
+    gputimer_avg_init(&state.avg, NUM_AVG_FRAMES);
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    state.overdraw = 1;
 
     // vertex buffer for a cube and plane
     const float scene_vertices[] = {
@@ -109,14 +234,24 @@ void init(void) {
         .label = "cube-indices"
     });
 
-    // shadow map pass action: clear the shadow map to (1,1,1,1)
-    state.shadow.pass_action = (sg_pass_action){
+    // encoded shadow map pass action: clear the shadow map to (1,1,1,1),
+    // the depth buffer is only needed during the pass
+    state.shadow.pass_action[MODE_ENCODED] = (sg_pass_action){
         .colors[0] = {
             .load_action = SG_LOADACTION_CLEAR,
             .clear_value = { 1.0f, 1.0f, 1.0f, 1.0f },
         }
     };
 
+    // depth-only shadow map pass action: clear and keep the depth buffer
+    state.shadow.pass_action[MODE_DEPTH] = (sg_pass_action){
+        .depth = {
+            .load_action = SG_LOADACTION_CLEAR,
+            .store_action = SG_STOREACTION_STORE,
+            .clear_value = 1.0f,
+        },
+    };
+
     // display pass action
     state.display.pass_action = (sg_pass_action){
         .colors[0] = {
@@ -125,28 +260,8 @@ void init(void) {
         },
     };
 
-    // a regular RGBA8 render target image as shadow map
-    state.shadow_map = sg_make_image(&(sg_image_desc){
-        .render_target = true,
-        .width = 2048,
-        .height = 2048,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-        .sample_count = 1,
-        .label = "shadow-map",
-    });
-
-    // ...we also need a separate depth-buffer image for the shadow pass
-    sg_image shadow_depth_img = sg_make_image(&(sg_image_desc){
-        .render_target = true,
-        .width = 2048,
-        .height = 2048,
-        .pixel_format = SG_PIXELFORMAT_DEPTH,
-        .sample_count = 1,
-        .label = "shadow-depth-buffer",
-    });
-
-    // a regular sampler with nearest filtering to sample the shadow map
-    state.shadow_sampler = sg_make_sampler(&(sg_sampler_desc){
+    // a regular sampler with nearest filtering to sample the encoded shadow map
+    state.display.smp[MODE_ENCODED] = sg_make_sampler(&(sg_sampler_desc){
         .min_filter = SG_FILTER_NEAREST,
         .mag_filter = SG_FILTER_NEAREST,
         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
@@ -154,15 +269,18 @@ void init(void) {
         .label = "shadow-sampler",
     });
 
-    // the render pass object for the shadow pass
-    state.shadow.atts = sg_make_attachments(&(sg_attachments_desc){
-        .colors[0].image = state.shadow_map,
-        .depth_stencil.image = shadow_depth_img,
-        .label = "shadow-pass",
+    // a comparison sampler to sample the depth-only shadow map
+    state.display.smp[MODE_DEPTH] = sg_make_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_LINEAR,
+        .mag_filter = SG_FILTER_LINEAR,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+        .compare = SG_COMPAREFUNC_LESS,
+        .label = "shadow-cmp-sampler",
     });
 
-    // a pipeline object for the shadow pass
-    state.shadow.pip = sg_make_pipeline(&(sg_pipeline_desc){
+    // pipeline objects for the shadow pass
+    state.shadow.pip[MODE_ENCODED] = sg_make_pipeline(&(sg_pipeline_desc){
         .layout = {
             // need to provide vertex stride, because normal component is skipped in shadow pass
             .buffers[0].stride = 6 * sizeof(float),
@@ -183,6 +301,26 @@ void init(void) {
         },
         .label = "shadow-pipeline"
     });
+    state.shadow.pip[MODE_DEPTH] = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .buffers[0].stride = 6 * sizeof(float),
+            .attrs = {
+                [ATTR_shadow_depth_pos].format = SG_VERTEXFORMAT_FLOAT3,
+            },
+        },
+        .shader = sg_make_shader(shadow_depth_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        .cull_mode = SG_CULLMODE_FRONT,
+        .sample_count = 1,
+        .depth = {
+            .pixel_format = SG_PIXELFORMAT_DEPTH,
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true,
+        },
+        // important: 'deactivate' the default color target for 'depth-only-rendering'
+        .colors[0].pixel_format = SG_PIXELFORMAT_NONE,
+        .label = "shadow-depth-pipeline"
+    });
 
     // resource bindings to render shadow scene
     state.shadow.bind = (sg_bindings) {
@@ -190,8 +328,8 @@ void init(void) {
         .index_buffer = state.ibuf,
     };
 
-    // a pipeline object for the display pass
-    state.display.pip = sg_make_pipeline(&(sg_pipeline_desc){
+    // pipeline objects for the display pass, only the fragment shader differs
+    state.display.pip[MODE_ENCODED] = sg_make_pipeline(&(sg_pipeline_desc){
         .layout = {
             .attrs = {
                 [ATTR_display_pos].format = SG_VERTEXFORMAT_FLOAT3,
@@ -207,22 +345,36 @@ void init(void) {
         },
         .label = "display-pipeline",
     });
+    state.display.pip[MODE_DEPTH] = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .attrs = {
+                [ATTR_display_depth_pos].format = SG_VERTEXFORMAT_FLOAT3,
+                [ATTR_display_depth_norm].format = SG_VERTEXFORMAT_FLOAT3,
+            }
+        },
+        .shader = sg_make_shader(display_depth_shader_desc(sg_query_backend())),
+        .index_type = SG_INDEXTYPE_UINT16,
+        .cull_mode = SG_CULLMODE_BACK,
+        .depth = {
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true,
+        },
+        .label = "display-depth-pipeline",
+    });
 
-    // resource bindings to render display scene
+    // resource bindings to render display scene, the shadow map is filled in by create_shadow_map()
     state.display.bind = (sg_bindings) {
         .vertex_buffers[0] = state.vbuf,
         .index_buffer = state.ibuf,
-        .images[IMG_shadow_map] = state.shadow_map,
-        .samplers[SMP_shadow_sampler] = state.shadow_sampler,
     };
 
-    // a vertex buffer, pipeline and sampler to render a debug visualization of the shadow map
+    // a vertex buffer, pipelines and sampler to render a debug visualization of the shadow map
     float dbg_vertices[] = { 0.0f, 0.0f,  1.0f, 0.0f,  0.0f, 1.0f,  1.0f, 1.0f };
     sg_buffer dbg_vbuf = sg_make_buffer(&(sg_buffer_desc){
         .data = SG_RANGE(dbg_vertices),
         .label = "debug-vertices"
     });
-    state.dbg.pip = sg_make_pipeline(&(sg_pipeline_desc){
+    state.dbg.pip[MODE_ENCODED] = sg_make_pipeline(&(sg_pipeline_desc){
         .layout = {
             .attrs[ATTR_dbg_pos].format = SG_VERTEXFORMAT_FLOAT2,
         },
@@ -230,7 +382,17 @@ void init(void) {
         .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
         .label = "debug-pipeline",
     });
-    sg_sampler dbg_smp = sg_make_sampler(&(sg_sampler_desc){
+    state.dbg.pip[MODE_DEPTH] = sg_make_pipeline(&(sg_pipeline_desc){
+        .layout = {
+            .attrs[ATTR_dbg_depth_pos].format = SG_VERTEXFORMAT_FLOAT2,
+        },
+        .shader = sg_make_shader(dbg_depth_shader_desc(sg_query_backend())),
+        .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
+        .label = "debug-depth-pipeline",
+    });
+    // note: need to use nearest filtering for the depth texture because
+    // of portability restrictions (e.g. WebGL2)
+    state.dbg.smp = sg_make_sampler(&(sg_sampler_desc){
         .min_filter = SG_FILTER_NEAREST,
         .mag_filter = SG_FILTER_NEAREST,
         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
@@ -239,15 +401,85 @@ void init(void) {
     });
     state.dbg.bind = (sg_bindings){
         .vertex_buffers[0] = dbg_vbuf,
-        .images[IMG_dbg_tex] = state.shadow_map,
-        .samplers[SMP_dbg_smp] = dbg_smp,
     };
+
+    // start with the depth-only shadow map at 2048x2048
+    create_shadow_map(MODE_DEPTH, 1);
+}
+
+// the benchmark steps through all mode/size combinations and averages
+// the GPU times of each over BENCH_FRAMES frames
+static void bench_start(void) {
+    state.bench.saved_mode = state.mode;
+    state.bench.saved_size_index = state.size_index;
+    gputimer_bench_start(&state.bench.run, NUM_MODES * NUM_SIZES, BENCH_FRAMES);
+    create_shadow_map(0, 0);
+}
+
+static void bench_update(void) {
+    gputimer_bench_t* run = &state.bench.run;
+    if (!gputimer_bench_update(run)) {
+        return;
+    }
+    result_t* res = &state.bench.results[state.mode][state.size_index];
+    res->shadow_ms = gputimer_avg_ms(&run->avg, TIMER_SHADOW);
+    res->display_ms = gputimer_avg_ms(&run->avg, TIMER_DISPLAY);
+    res->num_bytes = state.shadow_map.num_bytes;
+    if (gputimer_bench_next(run)) {
+        create_shadow_map(run->config / NUM_SIZES, run->config % NUM_SIZES);
+    } else {
+        create_shadow_map(state.bench.saved_mode, state.bench.saved_size_index);
+    }
+}
+
+static void draw_stats(void) {
+    const int size = shadow_map_sizes[state.size_index];
+    const bool gpu = gputimer_supported();
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("mode: %s (M)\n", mode_names[state.mode]);
+    sdtx_printf("size: %dx%d (1..3)\n", size, size);
+    sdtx_printf("overdraw: %d (UP/DOWN)\n", state.overdraw);
+    sdtx_printf("memory: %.1f MB\n", (double)state.shadow_map.num_bytes / (1024.0 * 1024.0));
+    if (gpu) {
+        sdtx_printf("shadow pass:  %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_SHADOW));
+        sdtx_printf("display pass: %.3f ms\n", gputimer_avg_ms(&state.avg, TIMER_DISPLAY));
+    } else {
+        sdtx_puts("gpu timers not supported\n");
+    }
+    if (state.bench.run.active) {
+        sdtx_printf("\nbenchmark running: %d/%d\n", state.bench.run.config + 1, state.bench.run.num_configs);
+    } else if (state.bench.run.done) {
+        sdtx_printf("\nbenchmark (overdraw %d):\n", state.overdraw);
+        sdtx_puts("mode        size     MB  shadow display\n");
+        for (int m = 0; m < NUM_MODES; m++) {
+            for (int i = 0; i < NUM_SIZES; i++) {
+                const result_t* res = &state.bench.results[m][i];
+                sdtx_printf("%-10s %5d %6.1f %6.3f %7.3f\n",
+                    mode_names[m],
+                    shadow_map_sizes[i],
+                    (double)res->num_bytes / (1024.0 * 1024.0),
+                    res->shadow_ms,
+                    res->display_ms);
+            }
+        }
+    } else {
+        sdtx_puts("\npress B to run benchmark\n");
+    }
 }
 
 void frame(void) {
     const float t = (float)(sapp_frame_duration() * 60.0);
     state.ry += 0.2f * t;
 
+    if (state.bench.run.active) {
+        bench_update();
+    } else {
+        gputimer_avg_update(&state.avg);
+    }
+    const int mode = state.mode;
+
     const hmm_vec3 eye_pos = HMM_Vec3(5.0f, 5.0f, 5.0f);
     const hmm_mat4 plane_model = HMM_Mat4d(1.0f);
     const hmm_mat4 cube_model = HMM_Translate(HMM_Vec3(0.0f, 1.5f, 0.0f));
@@ -290,16 +522,24 @@ void frame(void) {
     };
 
     // the shadow map pass, render scene from light source into shadow map texture
-    sg_begin_pass(&(sg_pass){ .action = state.shadow.pass_action, .attachments = state.shadow.atts });
-    sg_apply_pipeline(state.shadow.pip);
+    gputimer_begin_frame();
+    gputimer_begin(TIMER_SHADOW);
+    sg_begin_pass(&(sg_pass){ .action = state.shadow.pass_action[mode], .attachments = state.shadow_map.atts });
+    sg_apply_pipeline(state.shadow.pip[mode]);
     sg_apply_bindings(&state.shadow.bind);
     sg_apply_uniforms(UB_vs_shadow_params, &SG_RANGE(cube_vs_shadow_params));
-    sg_draw(0, 36, 1);
+    // the same caster is rendered 'overdraw' times (the depth test is LESS_EQUAL,
+    // so each layer runs the fragment stage again) to make fill cost measurable
+    for (int i = 0; i < state.overdraw; i++) {
+        sg_draw(0, 36, 1);
+    }
     sg_end_pass();
+    gputimer_end(TIMER_SHADOW);
 
     // the display pass, render scene from camera and sample the shadow map
+    gputimer_begin(TIMER_DISPLAY);
     sg_begin_pass(&(sg_pass){ .action = state.display.pass_action, .swapchain = sglue_swapchain() });
-    sg_apply_pipeline(state.display.pip);
+    sg_apply_pipeline(state.display.pip[mode]);
     sg_apply_bindings(&state.display.bind);
     sg_apply_uniforms(UB_fs_display_params, &SG_RANGE(fs_display_params));
     // render plane
@@ -309,17 +549,43 @@ void frame(void) {
     sg_apply_uniforms(UB_vs_display_params, &SG_RANGE(cube_vs_display_params));
     sg_draw(0, 36, 1);
     // render debug visualization of shadow-map
-    sg_apply_pipeline(state.dbg.pip);
+    sg_apply_pipeline(state.dbg.pip[mode]);
     sg_apply_bindings(&state.dbg.bind);
     sg_apply_viewport(sapp_width() - 150, 0, 150, 150, false);
     sg_draw(0, 4, 1);
+    sg_apply_viewport(0, 0, sapp_width(), sapp_height(), true);
+    draw_stats();
+    sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
+    gputimer_end(TIMER_DISPLAY);
+    gputimer_end_frame();
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && !state.bench.run.active) {
+        if ((ev->key_code >= SAPP_KEYCODE_1) && (ev->key_code <= SAPP_KEYCODE_3)) {
+            create_shadow_map(state.mode, (int)(ev->key_code - SAPP_KEYCODE_1));
+        } else if (ev->key_code == SAPP_KEYCODE_M) {
+            create_shadow_map((state.mode + 1) % NUM_MODES, state.size_index);
+        } else if (ev->key_code == SAPP_KEYCODE_UP) {
+            state.overdraw = HMM_MIN(state.overdraw * 2, MAX_OVERDRAW);
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_DOWN) {
+            state.overdraw = HMM_MAX(state.overdraw / 2, 1);
+            reset_stats();
+        } else if (ev->key_code == SAPP_KEYCODE_B) {
+            bench_start();
+        }
+    }
+    __dbgui_event(ev);
+}
+
 void cleanup(void) {
     __dbgui_shutdown();
+    sdtx_shutdown();
+    gputimer_shutdown();
     sg_shutdown();
 }
 
@@ -329,7 +595,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 800,
         .height = 600,
         .sample_count = 4,
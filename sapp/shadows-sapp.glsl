@@ -5,6 +5,9 @@
 //
 //  http://aras-p.info/blog/2009/07/30/encoding-floats-to-rgba-the-final/
 //
+//  The *_depth programs implement the same shadow mapping with a depth-only
+//  shadow pass and comparison sampling.
+//
 @ctype mat4 hmm_mat4
 @ctype vec3 hmm_vec3
 @ctype vec2 hmm_vec2
@@ -70,6 +73,27 @@ void main() {
 
 @program shadow vs_shadow fs_shadow
 
+//=== depth-only shadow pass
+@vs vs_shadow_depth
+@glsl_options fixup_clipspace // important: map clipspace z from 0..+1 to -1..+1 on GL
+
+layout(binding=0) uniform vs_shadow_params {
+    mat4 mvp;
+};
+
+in vec4 pos;
+
+void main() {
+    gl_Position = mvp * pos;
+}
+@end
+
+@fs fs_shadow_depth
+void main() { }
+@end
+
+@program shadow_depth vs_shadow_depth fs_shadow_depth
+
 //=== display pass
 @vs vs_display
 
@@ -151,6 +175,70 @@ void main() {
 
 @program display vs_display fs_display
 
+//=== display pass sampling the depth-only shadow map with a comparison sampler
+@fs fs_display_depth
+
+layout(binding=1) uniform fs_display_params {
+    vec3 light_dir;
+    vec3 eye_pos;
+};
+
+layout(binding=0) uniform texture2D shadow_depth_map;
+layout(binding=0) uniform sampler shadow_cmp_sampler;
+
+in vec3 color;
+in vec4 light_proj_pos;
+in vec4 world_pos;
+in vec3 world_norm;
+
+out vec4 frag_color;
+
+// same 5x5 kernel as sample_shadow_pcf(), but each tap is a hardware depth comparison
+float sample_shadow_pcf_cmp(vec3 uv_depth, vec2 sm_size) {
+    float result = 0.0;
+    for (int x = -2; x <= 2; x++) {
+        for (int y = -2; y <= 2; y++) {
+            vec2 offset = vec2(x, y) / sm_size;
+            result += texture(sampler2DShadow(shadow_depth_map, shadow_cmp_sampler), vec3(uv_depth.xy + offset, uv_depth.z));
+        }
+    }
+    return result / 25.0;
+}
+
+vec4 gamma(vec4 c) {
+    float p = 1.0 / 2.2;
+    return vec4(pow(c.xyz, vec3(p)), c.w);
+}
+
+void main() {
+    vec2 sm_size = textureSize(sampler2DShadow(shadow_depth_map, shadow_cmp_sampler), 0);
+    float spec_power = 2.2;
+    float ambient_intensity = 0.25;
+    vec3 l = normalize(light_dir);
+    vec3 n = normalize(world_norm);
+    float n_dot_l = dot(n, l);
+    if (n_dot_l > 0.0) {
+
+        vec3 light_pos = light_proj_pos.xyz / light_proj_pos.w;
+        vec3 sm_pos = vec3((light_pos.xy + 1.0) * 0.5, light_pos.z);
+        float s = sample_shadow_pcf_cmp(sm_pos, sm_size);
+        float diff_intensity = max(n_dot_l * s, 0.0);
+
+        vec3 v = normalize(eye_pos - world_pos.xyz);
+        vec3 r = reflect(-l, n);
+        float r_dot_v = max(dot(r, v), 0.0);
+        float spec_intensity = pow(r_dot_v, spec_power) * n_dot_l * s;
+
+        frag_color = vec4(vec3(spec_intensity) + (diff_intensity + ambient_intensity) * color, 1.0);
+    } else {
+        frag_color = vec4(color * ambient_intensity, 1.0);
+    }
+    frag_color = gamma(frag_color);
+}
+@end
+
+@program display_depth vs_display fs_display_depth
+
 //=== debug visualization sampler to render shadow map as regular texture
 @vs vs_dbg
 @glsl_options flip_vert_y
@@ -180,3 +268,19 @@ void main() {
 @end
 
 @program dbg vs_dbg fs_dbg
+
+@fs fs_dbg_depth
+@image_sample_type dbg_depth_tex unfilterable_float
+@sampler_type dbg_depth_smp nonfiltering
+layout(binding=0) uniform texture2D dbg_depth_tex;
+layout(binding=0) uniform sampler dbg_depth_smp;
+
+in vec2 uv;
+out vec4 frag_color;
+
+void main() {
+    frag_color = vec4(texture(sampler2D(dbg_depth_tex, dbg_depth_smp), uv).xxx, 1.0);
+}
+@end
+
+@program dbg_depth vs_dbg fs_dbg_depth
@@ -1,11 +1,17 @@
 //------------------------------------------------------------------------------
 //  shapes-sapp.c
 //  Simple sokol_shape.h demo.
+//
+//  Press B to switch between one draw call per shape and a batched
+//  mode where the per-shape model matrices are written into a storage
+//  buffer and all shapes are rendered with a single instanced draw,
+//  press S to toggle a stress test with 50k shapes.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
 #define SOKOL_SHAPE_IMPL
 #include "sokol_shape.h"
 #define SOKOL_DEBUGTEXT_IMPL
@@ -30,19 +36,47 @@ enum {
     NUM_SHAPES
 };
 
+// in the stress test, the 5 shapes are repeated on a 100x100 grid
+#define STRESS_GRID (100)
+#define MAX_SHAPES (STRESS_GRID * STRESS_GRID * NUM_SHAPES)
+#define NUM_AVG_FRAMES (60)
+
 static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
+    sg_pipeline batch_pip;
     sg_buffer vbuf;
     sg_buffer ibuf;
+    sg_buffer shape_index_buf;
+    sg_buffer transform_buf;
     shape_t shapes[NUM_SHAPES];
+    sshape_element_range_t all_shapes;
     vs_params_t vs_params;
     float rx, ry;
+    bool batched;
+    bool stress;
+    sb_transform_t transforms[MAX_SHAPES];
+    double accum_cpu_ms;
+    double avg_cpu_ms;
+    int num_frames;
 } state;
 
+// write the shape index of the most recently built shape into the
+// per-vertex shape index array
+static void set_shape_index(float* shape_indices, const sshape_buffer_t* buf, int shape_index) {
+    const size_t first = buf->vertices.shape_offset / sizeof(sshape_vertex_t);
+    const size_t end = buf->vertices.data_size / sizeof(sshape_vertex_t);
+    for (size_t i = first; i < end; i++) {
+        shape_indices[i] = (float)shape_index;
+    }
+}
+
 static void init(void) {
+    stm_setup();
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
+        // the unbatched stress test needs one uniform update per shape
+        .uniform_buffer_size = 16 * 1024 * 1024,
         .logger.func = slog_func,
     });
     sdtx_setup(&(sdtx_desc_t) {
@@ -76,6 +110,39 @@ static void init(void) {
         },
     });
 
+    // the batched pipeline has an additional per-vertex shape index
+    // in a separate vertex buffer
+    if (sg_query_features().storage_buffer) {
+        state.batch_pip = sg_make_pipeline(&(sg_pipeline_desc){
+            .shader = sg_make_shader(shapes_batch_shader_desc(sg_query_backend())),
+            .layout = {
+                .buffers = {
+                    [0] = sshape_vertex_buffer_layout_state(),
+                    [1] = { .stride = sizeof(float) },
+                },
+                .attrs = {
+                    [0] = sshape_position_vertex_attr_state(),
+                    [1] = sshape_normal_vertex_attr_state(),
+                    [2] = sshape_texcoord_vertex_attr_state(),
+                    [3] = sshape_color_vertex_attr_state(),
+                    [4] = { .buffer_index = 1, .format = SG_VERTEXFORMAT_FLOAT },
+                }
+            },
+            .index_type = SG_INDEXTYPE_UINT16,
+            .cull_mode = SG_CULLMODE_NONE,
+            .depth = {
+                .compare = SG_COMPAREFUNC_LESS_EQUAL,
+                .write_enabled = true
+            },
+        });
+        state.transform_buf = sg_make_buffer(&(sg_buffer_desc){
+            .type = SG_BUFFERTYPE_STORAGEBUFFER,
+            .usage = SG_USAGE_STREAM,
+            .size = sizeof(state.transforms),
+            .label = "shape-transforms",
+        });
+    }
+
     // shape positions
     state.shapes[BOX].pos = HMM_Vec3(-1.0f, 1.0f, 0.0f);
     state.shapes[PLANE].pos = HMM_Vec3(1.0f, 1.0f, 0.0f);
@@ -86,6 +153,7 @@ static void init(void) {
     // generate shape geometries
     sshape_vertex_t vertices[6 * 1024];
     uint16_t indices[16 * 1024];
+    float shape_indices[6 * 1024];
     sshape_buffer_t buf = {
         .vertices.buffer = SSHAPE_RANGE(vertices),
         .indices.buffer  = SSHAPE_RANGE(indices),
@@ -98,6 +166,7 @@ static void init(void) {
         .random_colors = true,
     });
     state.shapes[BOX].draw = sshape_element_range(&buf);
+    set_shape_index(shape_indices, &buf, BOX);
     buf = sshape_build_plane(&buf, &(sshape_plane_t){
         .width = 1.0f,
         .depth = 1.0f,
@@ -105,6 +174,7 @@ static void init(void) {
         .random_colors = true,
     });
     state.shapes[PLANE].draw = sshape_element_range(&buf);
+    set_shape_index(shape_indices, &buf, PLANE);
     buf = sshape_build_sphere(&buf, &(sshape_sphere_t) {
         .radius = 0.75f,
         .slices = 36,
@@ -112,6 +182,7 @@ static void init(void) {
         .random_colors = true,
     });
     state.shapes[SPHERE].draw = sshape_element_range(&buf);
+    set_shape_index(shape_indices, &buf, SPHERE);
     buf = sshape_build_cylinder(&buf, &(sshape_cylinder_t) {
         .radius = 0.5f,
         .height = 1.5f,
@@ -120,6 +191,7 @@ static void init(void) {
         .random_colors = true,
     });
     state.shapes[CYLINDER].draw = sshape_element_range(&buf);
+    set_shape_index(shape_indices, &buf, CYLINDER);
     buf = sshape_build_torus(&buf, &(sshape_torus_t) {
         .radius = 0.5f,
         .ring_radius = 0.3f,
@@ -128,27 +200,70 @@ static void init(void) {
         .random_colors = true,
     });
     state.shapes[TORUS].draw = sshape_element_range(&buf);
+    set_shape_index(shape_indices, &buf, TORUS);
     assert(buf.valid);
+    state.all_shapes = (sshape_element_range_t){
+        .base_element = 0,
+        .num_elements = (int)(buf.indices.data_size / sizeof(uint16_t)),
+    };
 
     // one vertex/index-buffer-pair for all shapes
     const sg_buffer_desc vbuf_desc = sshape_vertex_buffer_desc(&buf);
     const sg_buffer_desc ibuf_desc = sshape_index_buffer_desc(&buf);
     state.vbuf = sg_make_buffer(&vbuf_desc);
     state.ibuf = sg_make_buffer(&ibuf_desc);
+    state.shape_index_buf = sg_make_buffer(&(sg_buffer_desc){
+        .data = { .ptr = shape_indices, .size = (buf.vertices.data_size / sizeof(sshape_vertex_t)) * sizeof(float) },
+        .label = "shape-indices",
+    });
+}
+
+// compute the model matrices of all shapes for this frame
+static int update_transforms(hmm_mat4 rm) {
+    const int num_groups = state.stress ? (STRESS_GRID * STRESS_GRID) : 1;
+    int num_shapes = 0;
+    for (int g = 0; g < num_groups; g++) {
+        hmm_vec3 offset = HMM_Vec3(0.0f, 0.0f, 0.0f);
+        if (state.stress) {
+            const float x = (float)((g % STRESS_GRID) - STRESS_GRID / 2) * 6.0f;
+            const float z = (float)((g / STRESS_GRID) - STRESS_GRID / 2) * 6.0f;
+            offset = HMM_Vec3(x, 0.0f, z);
+        }
+        for (int i = 0; i < NUM_SHAPES; i++) {
+            const hmm_vec3 pos = HMM_AddVec3(offset, state.shapes[i].pos);
+            state.transforms[num_shapes++].model = HMM_MultiplyMat4(HMM_Translate(pos), rm);
+        }
+    }
+    return num_shapes;
 }
 
 static void frame(void) {
+    const uint64_t start = stm_now();
+    const bool batched = state.batched && sg_query_features().storage_buffer;
+
     // help text
     sdtx_canvas(sapp_width()*0.5f, sapp_height()*0.5f);
     sdtx_pos(0.5f, 0.5f);
     sdtx_puts("press key to switch draw mode:\n\n"
               "  1: vertex normals\n"
               "  2: texture coords\n"
-              "  3: vertex color");
+              "  3: vertex color\n\n");
+    sdtx_printf("  B: batching (%s)\n", batched ? "on" : "off");
+    sdtx_printf("  S: 50k shapes (%s)\n\n", state.stress ? "on" : "off");
+    sdtx_printf("CPU: %.3f ms\n", state.avg_cpu_ms);
+    if (!sg_query_features().storage_buffer) {
+        sdtx_puts("(no storage buffer support, batching disabled)\n");
+    }
 
     // view-projection matrix...
-    hmm_mat4 proj = HMM_Perspective(60.0f, sapp_widthf()/sapp_heightf(), 0.01f, 10.0f);
-    hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 1.5f, 6.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 proj, view;
+    if (state.stress) {
+        proj = HMM_Perspective(60.0f, sapp_widthf()/sapp_heightf(), 1.0f, 1000.0f);
+        view = HMM_LookAt(HMM_Vec3(0.0f, 150.0f, 350.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    } else {
+        proj = HMM_Perspective(60.0f, sapp_widthf()/sapp_heightf(), 0.01f, 10.0f);
+        view = HMM_LookAt(HMM_Vec3(0.0f, 1.5f, 6.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    }
     hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
 
     // model-rotation matrix
@@ -159,24 +274,59 @@ static void frame(void) {
     hmm_mat4 rym = HMM_Rotate(state.ry, HMM_Vec3(0.0f, 1.0f, 0.0f));
     hmm_mat4 rm = HMM_MultiplyMat4(rxm, rym);
 
+    // per shape model matrices
+    const int num_shapes = update_transforms(rm);
+    if (batched) {
+        sg_update_buffer(state.transform_buf, &(sg_range){
+            .ptr = state.transforms,
+            .size = (size_t)num_shapes * sizeof(sb_transform_t),
+        });
+    }
+
     // render shapes...
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
-    sg_apply_pipeline(state.pip);
-    sg_apply_bindings(&(sg_bindings) {
-        .vertex_buffers[0] = state.vbuf,
-        .index_buffer = state.ibuf
-    });
-    for (int i = 0; i < NUM_SHAPES; i++) {
-        // per shape model-view-projection matrix
-        hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(state.shapes[i].pos), rm);
-        state.vs_params.mvp = HMM_MultiplyMat4(view_proj, model);
-        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
-        sg_draw(state.shapes[i].draw.base_element, state.shapes[i].draw.num_elements, 1);
+    if (batched) {
+        // all shapes in one instanced draw, one instance per group of 5 shapes
+        const vs_batch_params_t vs_batch_params = {
+            .view_proj = view_proj,
+            .batch_draw_mode = state.vs_params.draw_mode,
+        };
+        sg_apply_pipeline(state.batch_pip);
+        sg_apply_bindings(&(sg_bindings) {
+            .vertex_buffers = {
+                [0] = state.vbuf,
+                [1] = state.shape_index_buf,
+            },
+            .index_buffer = state.ibuf,
+            .storage_buffers[SBUF_transforms] = state.transform_buf,
+        });
+        sg_apply_uniforms(UB_vs_batch_params, &SG_RANGE(vs_batch_params));
+        sg_draw(state.all_shapes.base_element, state.all_shapes.num_elements, num_shapes / NUM_SHAPES);
+    } else {
+        sg_apply_pipeline(state.pip);
+        sg_apply_bindings(&(sg_bindings) {
+            .vertex_buffers[0] = state.vbuf,
+            .index_buffer = state.ibuf
+        });
+        for (int i = 0; i < num_shapes; i++) {
+            // per shape model-view-projection matrix
+            const sshape_element_range_t* draw = &state.shapes[i % NUM_SHAPES].draw;
+            state.vs_params.mvp = HMM_MultiplyMat4(view_proj, state.transforms[i].model);
+            sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+            sg_draw(draw->base_element, draw->num_elements, 1);
+        }
     }
     sdtx_draw();
     __dbgui_draw();
     sg_end_pass();
     sg_commit();
+
+    state.accum_cpu_ms += stm_ms(stm_since(start));
+    if (++state.num_frames == NUM_AVG_FRAMES) {
+        state.avg_cpu_ms = state.accum_cpu_ms / NUM_AVG_FRAMES;
+        state.accum_cpu_ms = 0.0;
+        state.num_frames = 0;
+    }
 }
 
 static void input(const sapp_event* ev) {
@@ -185,6 +335,8 @@ static void input(const sapp_event* ev) {
             case SAPP_KEYCODE_1: state.vs_params.draw_mode = 0.0f; break;
             case SAPP_KEYCODE_2: state.vs_params.draw_mode = 1.0f; break;
             case SAPP_KEYCODE_3: state.vs_params.draw_mode = 2.0f; break;
+            case SAPP_KEYCODE_B: state.batched = !state.batched; break;
+            case SAPP_KEYCODE_S: state.stress = !state.stress; break;
             default: break;
         }
     }
@@ -37,3 +37,47 @@ void main() {
 @end
 
 @program shapes vs fs
+
+// batched rendering: the per-shape model matrices come from a storage
+// buffer, and each vertex knows which shape it belongs to, so that
+// all shapes can be rendered with a single instanced draw
+@vs vs_batch
+layout(binding=1) uniform vs_batch_params {
+    mat4 view_proj;
+    float batch_draw_mode;
+};
+
+struct sb_transform {
+    mat4 model;
+};
+
+layout(binding=0) readonly buffer transforms {
+    sb_transform tf[];
+};
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec3 normal;
+layout(location=2) in vec2 texcoord;
+layout(location=3) in vec4 color0;
+layout(location=4) in float shape_index;
+
+out vec4 color;
+
+const int NUM_SHAPES = 5;
+
+void main() {
+    const int tf_index = gl_InstanceIndex * NUM_SHAPES + int(shape_index);
+    gl_Position = view_proj * tf[tf_index].model * position;
+    if (batch_draw_mode == 0.0) {
+        color = vec4((normal + 1.0) * 0.5, 1.0);
+    }
+    else if (batch_draw_mode == 1.0) {
+        color = vec4(texcoord, 0.0, 1.0);
+    }
+    else {
+        color = color0;
+    }
+}
+@end
+
+@program shapes_batch vs_batch fs
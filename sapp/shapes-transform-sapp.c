@@ -3,11 +3,18 @@
 //
 //  Demonstrates merging multiple transformed shapes into a single draw-shape
 //  with sokol_shape.h
+//
+//  At startup (and when pressing R) the same four shapes are also
+//  generated with the parallel SIMD builder in libs/util/pshape.h and
+//  the generation time is compared with sokol_shape.h, at a medium
+//  tessellation which still fits 16-bit indices, and at ~1M vertices.
+//  Press H to render the 1M vertex version.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
 #define SOKOL_SHAPE_IMPL
 #include "sokol_shape.h"
 #define SOKOL_DEBUGTEXT_IMPL
@@ -15,9 +22,34 @@
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
 #include "HandmadeMath.h"
+#include "util/jobs.h"
+#include "util/pshape.h"
 #include "dbgui/dbgui.h"
 #include "shapes-transform-sapp.glsl.h"
 
+// medium tessellation (fits into 16-bit indices) and ~1M vertices
+#define MED_TESS (120)
+#define HIGH_TESS (500)
+#define MAX_HIGH_VERTICES (1100000)
+#define MAX_HIGH_INDICES (6600000)
+
+typedef enum {
+    BENCH_SOKOL_MED,
+    BENCH_PSHAPE_MED_1,
+    BENCH_PSHAPE_MED_N,
+    BENCH_PSHAPE_HIGH_1,
+    BENCH_PSHAPE_HIGH_N,
+    NUM_BENCHES,
+} bench_t;
+
+static const char* bench_names[NUM_BENCHES] = {
+    "sshape med",
+    "pshape med x1",
+    "pshape med xN",
+    "pshape 1M x1",
+    "pshape 1M xN",
+};
+
 struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
@@ -25,9 +57,23 @@ struct {
     sshape_element_range_t elms;
     vs_params_t vs_params;
     float rx, ry;
+    struct {
+        bool enabled;
+        sg_pipeline pip;
+        sg_bindings bind;
+        sshape_element_range_t elms;
+    } high;
+    struct {
+        double ms;
+        int num_vertices;
+    } bench[NUM_BENCHES];
 } state;
 
+static void run_benchmark(void);
+
 static void init(void) {
+    stm_setup();
+    jobs_setup(&(jobs_desc_t){ 0 });
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
@@ -122,6 +168,115 @@ static void init(void) {
     const sg_buffer_desc ibuf_desc = sshape_index_buffer_desc(&buf);
     state.bind.vertex_buffers[0] = sg_make_buffer(&vbuf_desc);
     state.bind.index_buffer = sg_make_buffer(&ibuf_desc);
+
+    // the 1M vertex version needs 32-bit indices
+    state.high.pip = sg_make_pipeline(&(sg_pipeline_desc){
+        .shader = sg_make_shader(shapes_shader_desc(sg_query_backend())),
+        .layout = {
+            .buffers[0] = sshape_vertex_buffer_layout_state(),
+            .attrs = {
+                [0] = sshape_position_vertex_attr_state(),
+                [1] = sshape_normal_vertex_attr_state(),
+                [2] = sshape_texcoord_vertex_attr_state(),
+                [3] = sshape_color_vertex_attr_state()
+            }
+        },
+        .index_type = SG_INDEXTYPE_UINT32,
+        .cull_mode = SG_CULLMODE_NONE,
+        .depth = {
+            .compare = SG_COMPAREFUNC_LESS_EQUAL,
+            .write_enabled = true
+        },
+    });
+    run_benchmark();
+}
+
+// build the four shapes with either sokol_shape.h or pshape.h
+static sshape_buffer_t build_shapes(sshape_buffer_t buf, int tess, bool use_pshape, const pshape_options_t* opts) {
+    const hmm_mat4 box_transform = HMM_Translate(HMM_Vec3(-1.0f, 0.0f, +1.0f));
+    const hmm_mat4 sphere_transform = HMM_Translate(HMM_Vec3(+1.0f, 0.0f, +1.0f));
+    const hmm_mat4 cylinder_transform = HMM_Translate(HMM_Vec3(-1.0f, 0.0f, -1.0f));
+    const hmm_mat4 torus_transform = HMM_Translate(HMM_Vec3(+1.0f, 0.0f, -1.0f));
+    const sshape_box_t box = {
+        .width = 1.0f, .height = 1.0f, .depth = 1.0f,
+        .tiles = (uint16_t)(tess * 2 / 5),
+        .random_colors = true,
+        .transform = sshape_mat4((const float*)&box_transform)
+    };
+    const sshape_sphere_t sphere = {
+        .merge = true,
+        .radius = 0.75f,
+        .slices = (uint16_t)tess,
+        .stacks = (uint16_t)tess,
+        .random_colors = true,
+        .transform = sshape_mat4((const float*)&sphere_transform)
+    };
+    const sshape_cylinder_t cylinder = {
+        .merge = true,
+        .radius = 0.5f,
+        .height = 1.0f,
+        .slices = (uint16_t)tess,
+        .stacks = (uint16_t)tess,
+        .random_colors = true,
+        .transform = sshape_mat4((const float*)&cylinder_transform)
+    };
+    const sshape_torus_t torus = {
+        .merge = true,
+        .radius = 0.5f,
+        .ring_radius = 0.3f,
+        .rings = (uint16_t)tess,
+        .sides = (uint16_t)tess,
+        .random_colors = true,
+        .transform = sshape_mat4((const float*)&torus_transform)
+    };
+    if (use_pshape) {
+        buf = pshape_build_box(&buf, &box, opts);
+        buf = pshape_build_sphere(&buf, &sphere, opts);
+        buf = pshape_build_cylinder(&buf, &cylinder, opts);
+        buf = pshape_build_torus(&buf, &torus, opts);
+    } else {
+        buf = sshape_build_box(&buf, &box);
+        buf = sshape_build_sphere(&buf, &sphere);
+        buf = sshape_build_cylinder(&buf, &cylinder);
+        buf = sshape_build_torus(&buf, &torus);
+    }
+    return buf;
+}
+
+// time the generation of the same shapes with the different builders, and
+// keep the last (1M vertices, multithreaded) result for rendering
+static void run_benchmark(void) {
+    const size_t vertices_size = MAX_HIGH_VERTICES * sizeof(sshape_vertex_t);
+    const size_t indices_size = MAX_HIGH_INDICES * sizeof(uint32_t);
+    sshape_vertex_t* vertices = (sshape_vertex_t*) malloc(vertices_size);
+    void* indices = malloc(indices_size);
+    sshape_buffer_t buf = { 0 };
+    for (int i = 0; i < NUM_BENCHES; i++) {
+        const bool high = (i == BENCH_PSHAPE_HIGH_1) || (i == BENCH_PSHAPE_HIGH_N);
+        const pshape_options_t opts = {
+            .index32 = high,
+            .no_jobs = (i == BENCH_PSHAPE_MED_1) || (i == BENCH_PSHAPE_HIGH_1),
+        };
+        buf = (sshape_buffer_t){
+            .vertices.buffer = { .ptr = vertices, .size = vertices_size },
+            .indices.buffer = { .ptr = indices, .size = indices_size },
+        };
+        const uint64_t start = stm_now();
+        buf = build_shapes(buf, high ? HIGH_TESS : MED_TESS, i != BENCH_SOKOL_MED, &opts);
+        state.bench[i].ms = stm_ms(stm_since(start));
+        state.bench[i].num_vertices = buf.valid ? (int)(buf.vertices.data_size / sizeof(sshape_vertex_t)) : 0;
+    }
+    if (buf.valid) {
+        sg_destroy_buffer(state.high.bind.vertex_buffers[0]);
+        sg_destroy_buffer(state.high.bind.index_buffer);
+        const sg_buffer_desc vbuf_desc = sshape_vertex_buffer_desc(&buf);
+        const sg_buffer_desc ibuf_desc = sshape_index_buffer_desc(&buf);
+        state.high.bind.vertex_buffers[0] = sg_make_buffer(&vbuf_desc);
+        state.high.bind.index_buffer = sg_make_buffer(&ibuf_desc);
+        state.high.elms = pshape_element_range(&buf, &(pshape_options_t){ .index32 = true });
+    }
+    free(vertices);
+    free(indices);
 }
 
 static void frame(void) {
@@ -131,7 +286,14 @@ static void frame(void) {
     sdtx_puts("press key to switch draw mode:\n\n"
               "  1: vertex normals\n"
               "  2: texture coords\n"
-              "  3: vertex color");
+              "  3: vertex color\n\n");
+    sdtx_printf("  H: 1M vertices (%s)\n", state.high.enabled ? "on" : "off");
+    sdtx_puts("  R: rerun benchmark\n\n");
+    sdtx_printf("N = %d threads, %s\n", jobs_num_threads() + 1, PSHAPE_SSE2 ? "SSE2" : "scalar");
+    for (int i = 0; i < NUM_BENCHES; i++) {
+        const double mverts = (state.bench[i].ms > 0.0) ? (state.bench[i].num_vertices / (state.bench[i].ms * 1000.0)) : 0.0;
+        sdtx_printf("%-13s %7d %7.2fms %5.1fMv/s\n", bench_names[i], state.bench[i].num_vertices, state.bench[i].ms, mverts);
+    }
 
     // build model-view-projection matrix
     const float t = (float)(sapp_frame_duration() * 60.0);
@@ -147,10 +309,17 @@ static void frame(void) {
 
     // render the single shape
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
-    sg_apply_pipeline(state.pip);
-    sg_apply_bindings(&state.bind);
-    sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
-    sg_draw(state.elms.base_element, state.elms.num_elements, 1);
+    if (state.high.enabled && (state.high.elms.num_elements > 0)) {
+        sg_apply_pipeline(state.high.pip);
+        sg_apply_bindings(&state.high.bind);
+        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+        sg_draw(state.high.elms.base_element, state.high.elms.num_elements, 1);
+    } else {
+        sg_apply_pipeline(state.pip);
+        sg_apply_bindings(&state.bind);
+        sg_apply_uniforms(UB_vs_params, &SG_RANGE(state.vs_params));
+        sg_draw(state.elms.base_element, state.elms.num_elements, 1);
+    }
 
     // render help text and finish frame
     sdtx_draw();
@@ -165,6 +334,8 @@ static void input(const sapp_event* ev) {
             case SAPP_KEYCODE_1: state.vs_params.draw_mode = 0.0f; break;
             case SAPP_KEYCODE_2: state.vs_params.draw_mode = 1.0f; break;
             case SAPP_KEYCODE_3: state.vs_params.draw_mode = 2.0f; break;
+            case SAPP_KEYCODE_H: state.high.enabled = !state.high.enabled; break;
+            case SAPP_KEYCODE_R: run_benchmark(); break;
             default: break;
         }
     }
@@ -174,6 +345,7 @@ static void input(const sapp_event* ev) {
 static void cleanup(void) {
     __dbgui_shutdown();
     sg_shutdown();
+    jobs_shutdown();
 }
 
 sapp_desc sokol_main(int argc, char* argv[]) {
@@ -2,6 +2,7 @@
 //  spine-contexts-sapp.c
 //  Test/demonstrate Spine rendering into sokol-gfx offscreen passes
 //  via sokol_spine.h contexts.
+//  The instances are updated on worker threads via util/spinejobs.h.
 //------------------------------------------------------------------------------
 #define SOKOL_SPINE_IMPL
 #define SOKOL_GL_IMPL
@@ -15,6 +16,8 @@
 #include "sokol_glue.h"
 #include "stb/stb_image.h"
 #include "util/fileutil.h"
+#include "util/jobs.h"
+#include "util/spinejobs.h"
 #include "dbgui/dbgui.h"
 
 typedef struct {
@@ -74,6 +77,7 @@ static void init(void) {
     sspine_setup(&(sspine_desc){
         .logger.func = slog_func
     });
+    jobs_setup(&(jobs_desc_t){ 0 });
     sfetch_setup(&(sfetch_desc_t){
         .max_requests = 3,
         .num_channels = 2,
@@ -118,14 +122,14 @@ static void frame(void) {
     const float delta_time = (float)sapp_frame_duration();
     sfetch_dowork();
 
+    // update both instances in parallel
+    spinejobs_update_instances(state.instances, 2, delta_time, 0);
+
     // render spine objects in separate contexts, first one by setting the current context,
     // second one by calling function with ctx arg
-    sspine_update_instance(state.instances[0], delta_time);
     sspine_set_context(state.offscreen[0].ctx);
-    sspine_draw_instance_in_layer(state.instances[0], 0);
-
-    sspine_update_instance(state.instances[1], delta_time);
-    sspine_context_draw_instance_in_layer(state.offscreen[1].ctx, state.instances[1], 0);
+    spinejobs_draw_instances_in_layers(&state.instances[0], 0, 1);
+    spinejobs_context_draw_instances_in_layers(state.offscreen[1].ctx, &state.instances[1], 0, 1);
 
     // draw two quads via sokol-gl which use the offscreen-rendered spine scenes as textures
     const float dw = sapp_widthf();
@@ -183,6 +187,7 @@ static void frame(void) {
 static void cleanup(void) {
     __dbgui_shutdown();
     sfetch_shutdown();
+    jobs_shutdown();
     sspine_shutdown();
     sgl_shutdown();
     sg_shutdown();
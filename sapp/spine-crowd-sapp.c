@@ -0,0 +1,385 @@
+//------------------------------------------------------------------------------
+//  spine-crowd-sapp.c
+//
+//  Animates a crowd of 1000 Spine instances and measures the instance
+//  update time depending on how many threads the update is split over
+//  (via util/spinejobs.h). At startup the sample sweeps through 1, 2, 4, ...
+//  jobs up to one job per thread and shows the average update time for
+//  each, drawing always happens on the main thread in instance order.
+//
+//  Press SPACE to restart the sweep, press 1..9 to select a job count.
+//------------------------------------------------------------------------------
+#define SOKOL_SPINE_IMPL
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_log.h"
+#include "sokol_fetch.h"
+#include "sokol_debugtext.h"
+#include "sokol_time.h"
+#include "sokol_glue.h"
+#include "spine/spine.h"
+#include "sokol_spine.h"
+#include "stb/stb_image.h"
+#include "util/fileutil.h"
+#include "util/jobs.h"
+#include "util/spinejobs.h"
+
+#define NUM_INSTANCES_X (40)
+#define NUM_INSTANCES_Y (25)
+#define NUM_INSTANCES (NUM_INSTANCES_X * NUM_INSTANCES_Y)
+#define PRESCALE (0.1f)
+#define GRID_DX (32.0f)
+#define GRID_DY (44.0f)
+#define NUM_AVG_FRAMES (60)
+#define MAX_JOB_COUNTS (8)
+
+typedef struct {
+    bool loaded;
+    sspine_range data;
+} load_status_t;
+
+typedef struct {
+    int num_jobs;
+    double update_ms;       // averaged over NUM_AVG_FRAMES, 0 if not measured yet
+} result_t;
+
+static struct {
+    sspine_atlas atlas;
+    sspine_skeleton skeleton;
+    sspine_instance instances[NUM_INSTANCES];
+    bool instances_valid;
+    sg_pass_action pass_action;
+    int num_results;
+    result_t results[MAX_JOB_COUNTS];   // 1, 2, 4, ... jobs
+    int cur_result;
+    bool sweep;
+    struct {
+        double update_ms;
+        double draw_ms;
+        int num_frames;
+    } accum;
+    double draw_ms;
+    struct {
+        load_status_t atlas;
+        load_status_t skeleton;
+        bool failed;
+    } load_status;
+    struct {
+        uint8_t atlas[16 * 1024];
+        uint8_t skeleton[512 * 1024];
+        uint8_t image[512 * 1024];
+    } buffers;
+} state;
+
+static void atlas_data_loaded(const sfetch_response_t* response);
+static void skeleton_data_loaded(const sfetch_response_t* response);
+static void image_data_loaded(const sfetch_response_t* response);
+static void create_spine_objects(void);
+
+static void start_sweep(void) {
+    for (int i = 0; i < state.num_results; i++) {
+        state.results[i].update_ms = 0.0;
+    }
+    state.cur_result = 0;
+    state.sweep = true;
+    state.accum.update_ms = 0.0;
+    state.accum.draw_ms = 0.0;
+    state.accum.num_frames = 0;
+}
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    sspine_setup(&(sspine_desc){
+        .instance_pool_size = NUM_INSTANCES,
+        .max_vertices = 1024 * 1024,
+        .max_commands = 16 * 1024,
+        .logger.func = slog_func,
+    });
+    sfetch_setup(&(sfetch_desc_t){
+        .max_requests = 3,
+        .num_channels = 2,
+        .num_lanes = 1,
+        .logger.func = slog_func,
+    });
+    jobs_setup(&(jobs_desc_t){ 0 });
+
+    // job counts to measure: 1, 2, 4, ... up to one job per thread
+    const int max_jobs = jobs_num_threads() + 1;
+    for (int num_jobs = 1; state.num_results < MAX_JOB_COUNTS; num_jobs *= 2) {
+        const bool last = num_jobs >= max_jobs;
+        state.results[state.num_results++].num_jobs = last ? max_jobs : num_jobs;
+        if (last) {
+            break;
+        }
+    }
+    start_sweep();
+
+    state.pass_action = (sg_pass_action){
+        .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.25f, 0.45f, 0.25f, 1.0f } }
+    };
+
+    char path_buf[512];
+    sfetch_send(&(sfetch_request_t){
+        .path = fileutil_get_path("speedy-pma.atlas", path_buf, sizeof(path_buf)),
+        .channel = 0,
+        .buffer = SFETCH_RANGE(state.buffers.atlas),
+        .callback = atlas_data_loaded,
+    });
+    sfetch_send(&(sfetch_request_t){
+        .path = fileutil_get_path("speedy-ess.skel", path_buf, sizeof(path_buf)),
+        .channel = 1,
+        .buffer = SFETCH_RANGE(state.buffers.skeleton),
+        .callback = skeleton_data_loaded,
+    });
+}
+
+static void frame(void) {
+    const float delta_time = (float)sapp_frame_duration();
+    const float aspect = sapp_widthf() / sapp_heightf();
+    sfetch_dowork();
+
+    const sspine_vec2 virt_size = { 1600.0f * aspect, 1200.0f };
+    const sspine_layer_transform layer_transform = {
+        .size = virt_size,
+        .origin = { .x = virt_size.x * 0.5f, .y = virt_size.y * 0.5f }
+    };
+
+    // parallel update, followed by recording the draw commands on this thread
+    result_t* res = &state.results[state.cur_result];
+    uint64_t start = stm_now();
+    if (state.instances_valid) {
+        spinejobs_update_instances(state.instances, NUM_INSTANCES, delta_time, res->num_jobs);
+    }
+    const double update_ms = stm_ms(stm_laptime(&start));
+    if (state.instances_valid) {
+        spinejobs_draw_instances_in_layers(state.instances, 0, NUM_INSTANCES);
+    }
+    const double draw_ms = stm_ms(stm_since(start));
+
+    if (state.instances_valid) {
+        state.accum.update_ms += update_ms;
+        state.accum.draw_ms += draw_ms;
+        if (++state.accum.num_frames == NUM_AVG_FRAMES) {
+            res->update_ms = state.accum.update_ms / NUM_AVG_FRAMES;
+            state.draw_ms = state.accum.draw_ms / NUM_AVG_FRAMES;
+            state.accum.update_ms = 0.0;
+            state.accum.draw_ms = 0.0;
+            state.accum.num_frames = 0;
+            if (state.sweep) {
+                if (state.cur_result < (state.num_results - 1)) {
+                    state.cur_result++;
+                } else {
+                    state.sweep = false;
+                }
+            }
+        }
+    }
+
+    sspine_context_info ctx_info = sspine_get_context_info(sspine_default_context());
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("%d instances, %d threads\n", NUM_INSTANCES, jobs_num_threads() + 1);
+    sdtx_printf("vertices:%d draws:%d\n", ctx_info.num_vertices, ctx_info.num_commands);
+    sdtx_printf("draw: %.3f ms\n\n", state.draw_ms);
+    sdtx_puts("jobs  update      speedup\n");
+    const double base_ms = state.results[0].update_ms;
+    for (int i = 0; i < state.num_results; i++) {
+        const result_t* r = &state.results[i];
+        if (i == state.cur_result) {
+            sdtx_color3b(0xFF, 0xCC, 0x00);
+        } else {
+            sdtx_color3b(0xFF, 0xFF, 0xFF);
+        }
+        if (r->update_ms > 0.0) {
+            sdtx_printf("%4d  %7.3f ms  %5.2fx\n", r->num_jobs, r->update_ms, (base_ms > 0.0) ? (base_ms / r->update_ms) : 0.0);
+        } else {
+            sdtx_printf("%4d        -\n", r->num_jobs);
+        }
+    }
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    sdtx_printf("\n%s\n", state.sweep ? "measuring..." : "SPACE: measure again");
+    sdtx_printf("1..%d: select job count", state.num_results);
+
+    sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
+    sspine_draw_layer(0, &layer_transform);
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        if (ev->key_code == SAPP_KEYCODE_SPACE) {
+            start_sweep();
+        } else if ((ev->key_code >= SAPP_KEYCODE_1) && (ev->key_code <= SAPP_KEYCODE_9)) {
+            const int index = (int)(ev->key_code - SAPP_KEYCODE_1);
+            if (index < state.num_results) {
+                state.cur_result = index;
+                state.sweep = false;
+                state.accum.update_ms = 0.0;
+                state.accum.draw_ms = 0.0;
+                state.accum.num_frames = 0;
+            }
+        }
+    }
+}
+
+static void cleanup(void) {
+    sfetch_shutdown();
+    jobs_shutdown();
+    sspine_shutdown();
+    sdtx_shutdown();
+    sg_shutdown();
+}
+
+// fetch callback for atlas data
+static void atlas_data_loaded(const sfetch_response_t* response) {
+    if (response->fetched) {
+        state.load_status.atlas = (load_status_t){
+            .loaded = true,
+            .data = (sspine_range){ .ptr = response->data.ptr, .size = response->data.size }
+        };
+        if (state.load_status.atlas.loaded && state.load_status.skeleton.loaded) {
+            create_spine_objects();
+        }
+    } else if (response->failed) {
+        state.load_status.failed = true;
+    }
+}
+
+// fetch callback for skeleton data
+static void skeleton_data_loaded(const sfetch_response_t* response) {
+    if (response->fetched) {
+        state.load_status.skeleton = (load_status_t){
+            .loaded = true,
+            .data = (sspine_range){ .ptr = response->data.ptr, .size = response->data.size }
+        };
+        if (state.load_status.atlas.loaded && state.load_status.skeleton.loaded) {
+            create_spine_objects();
+        }
+    } else if (response->failed) {
+        state.load_status.failed = true;
+    }
+}
+
+// creates the atlas, skeleton and the crowd of instances, and starts
+// loading the atlas image(s)
+static void create_spine_objects(void) {
+    state.atlas = sspine_make_atlas(&(sspine_atlas_desc){
+        .data = state.load_status.atlas.data
+    });
+    assert(sspine_atlas_valid(state.atlas));
+
+    state.skeleton = sspine_make_skeleton(&(sspine_skeleton_desc){
+        .atlas = state.atlas,
+        .prescale = PRESCALE,
+        .anim_default_mix = 0.2f,
+        .binary_data = state.load_status.skeleton.data,
+    });
+    assert(sspine_skeleton_valid(state.skeleton));
+
+    // instances on a grid, with different animations and start times so
+    // that the crowd isn't running in lockstep
+    const sspine_anim anim_run = sspine_anim_by_name(state.skeleton, "run");
+    const sspine_anim anim_run_linear = sspine_anim_by_name(state.skeleton, "run-linear");
+    for (int iy = 0; iy < NUM_INSTANCES_Y; iy++) {
+        for (int ix = 0; ix < NUM_INSTANCES_X; ix++) {
+            const int i = iy * NUM_INSTANCES_X + ix;
+            state.instances[i] = sspine_make_instance(&(sspine_instance_desc){
+                .skeleton = state.skeleton
+            });
+            assert(sspine_instance_valid(state.instances[i]));
+            sspine_set_position(state.instances[i], (sspine_vec2){
+                .x = ((float)ix - (NUM_INSTANCES_X - 1) * 0.5f) * GRID_DX,
+                .y = ((float)iy - (NUM_INSTANCES_Y - 1) * 0.5f) * GRID_DY + GRID_DY * 0.5f,
+            });
+            sspine_set_animation(state.instances[i], (i & 1) ? anim_run_linear : anim_run, 0, true);
+            sspine_update_instance(state.instances[i], (float)(i % 17) * 0.05f);
+        }
+    }
+    state.instances_valid = true;
+
+    const int num_images = sspine_num_images(state.atlas);
+    for (int img_index = 0; img_index < num_images; img_index++) {
+        const sspine_image img = sspine_image_by_index(state.atlas, img_index);
+        const sspine_image_info img_info = sspine_get_image_info(img);
+        assert(img_info.valid);
+        char path_buf[512];
+        sfetch_send(&(sfetch_request_t){
+            .channel = 0,
+            .path = fileutil_get_path(img_info.filename.cstr, path_buf, sizeof(path_buf)),
+            .buffer = SFETCH_RANGE(state.buffers.image),
+            .callback = image_data_loaded,
+            .user_data = SFETCH_RANGE(img),
+        });
+    }
+}
+
+// load spine atlas image data and create a sokol-gfx image object
+static void image_data_loaded(const sfetch_response_t* response) {
+    const sspine_image img = *(sspine_image*)response->user_data;
+    const sspine_image_info img_info = sspine_get_image_info(img);
+    assert(img_info.valid);
+    if (response->fetched) {
+        const int desired_channels = 4;
+        int img_width, img_height, num_channels;
+        stbi_uc* pixels = stbi_load_from_memory(
+            response->data.ptr,
+            (int)response->data.size,
+            &img_width,
+            &img_height,
+            &num_channels, desired_channels);
+        if (pixels) {
+            sg_init_image(img_info.sgimage, &(sg_image_desc){
+                .width = img_width,
+                .height = img_height,
+                .pixel_format = SG_PIXELFORMAT_RGBA8,
+                .label = img_info.filename.cstr,
+                .data.subimage[0][0] = {
+                    .ptr = pixels,
+                    .size = (size_t)(img_width * img_height * 4)
+                }
+            });
+            sg_init_sampler(img_info.sgsampler, &(sg_sampler_desc){
+                .min_filter = img_info.min_filter,
+                .mag_filter = img_info.mag_filter,
+                .mipmap_filter = img_info.mipmap_filter,
+                .wrap_u = img_info.wrap_u,
+                .wrap_v = img_info.wrap_v,
+                .label = img_info.filename.cstr,
+            });
+            stbi_image_free(pixels);
+        } else {
+            state.load_status.failed = true;
+            sg_fail_image(img_info.sgimage);
+        }
+    } else if (response->failed) {
+        state.load_status.failed = true;
+        sg_fail_image(img_info.sgimage);
+    }
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 1024,
+        .height = 768,
+        .window_title = "spine-crowd-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
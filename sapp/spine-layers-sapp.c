@@ -1,6 +1,7 @@
 //------------------------------------------------------------------------------
 //  spine-layers-sapp.c
 //  Use layered rendering to mix sokol-spine and sokol-gl rendering.
+//  The instances are updated on worker threads via util/spinejobs.h.
 //------------------------------------------------------------------------------
 #define SOKOL_SPINE_IMPL
 #define SOKOL_GL_IMPL
@@ -14,6 +15,8 @@
 #include "sokol_glue.h"
 #include "stb/stb_image.h"
 #include "util/fileutil.h"
+#include "util/jobs.h"
+#include "util/spinejobs.h"
 #include "dbgui/dbgui.h"
 
 typedef struct {
@@ -27,6 +30,7 @@ static struct {
     sspine_atlas atlas;
     sspine_skeleton skeleton;
     sspine_instance instances[NUM_INSTANCES];
+    int layers[NUM_INSTANCES];
     sg_pass_action pass_action;
     struct {
         load_status_t atlas;
@@ -56,6 +60,7 @@ static void init(void) {
     sgl_setup(&(sgl_desc_t){
         .logger.func = slog_func
     });
+    jobs_setup(&(jobs_desc_t){ 0 });
     sfetch_setup(&(sfetch_desc_t){
         .max_requests = 3,
         .num_channels = 2,
@@ -120,18 +125,10 @@ static void frame(void) {
         sgl_end();
     }
 
-    // draw spine instances into different layers
-    sspine_set_position(state.instances[0], (sspine_vec2){ -225.0f, 128.0f });
-    sspine_update_instance(state.instances[0], delta_time);
-    sspine_draw_instance_in_layer(state.instances[0], 0);
-
-    sspine_set_position(state.instances[1], (sspine_vec2){ 0.0f, 128.0f });
-    sspine_update_instance(state.instances[1], delta_time);
-    sspine_draw_instance_in_layer(state.instances[1], 1);
-
-    sspine_set_position(state.instances[2], (sspine_vec2){ +225.0f, 128.0f });
-    sspine_update_instance(state.instances[2], delta_time);
-    sspine_draw_instance_in_layer(state.instances[2], 2);
+    // update the spine instances in parallel, and draw them into different
+    // layers (drawing happens on this thread in instance order)
+    spinejobs_update_instances(state.instances, NUM_INSTANCES, delta_time, 0);
+    spinejobs_draw_instances_in_layers(state.instances, state.layers, NUM_INSTANCES);
 
     // sokol-gfx render pass, draw the sokol-gl and sokol-spine layers interleaved
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
@@ -147,6 +144,7 @@ static void frame(void) {
 static void cleanup(void) {
     __dbgui_shutdown();
     sfetch_shutdown();
+    jobs_shutdown();
     sgl_shutdown();
     sspine_shutdown();
     sg_shutdown();
@@ -202,12 +200,14 @@ static void create_spine_objects(void) {
     });
     assert(sspine_skeleton_valid(state.skeleton));
 
-    // create two instance objects
+    // create instance objects, each in its own layer
     for (int i = 0; i < NUM_INSTANCES; i++) {
         state.instances[i] = sspine_make_instance(&(sspine_instance_desc){
             .skeleton = state.skeleton
         });
         assert(sspine_instance_valid(state.instances[i]));
+        sspine_set_position(state.instances[i], (sspine_vec2){ (float)(i - 1) * 225.0f, 128.0f });
+        state.layers[i] = i;
         sspine_set_animation(state.instances[i], sspine_anim_by_name(state.skeleton, "run-linear"), 0, true);
     }
 
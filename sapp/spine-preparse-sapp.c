@@ -0,0 +1,341 @@
+//------------------------------------------------------------------------------
+//  spine-preparse-sapp.c
+//
+//  Compares the time to create the spine-c atlas and skeleton data of all
+//  Spine samples' assets by parsing the .atlas and .skel/.json files (what
+//  sspine_make_atlas() and sspine_make_skeleton() do at startup) with loading
+//  a preparsed binary blob via pointer fixup (util/spineblob.h).
+//
+//  The blobs are kept in memory here, an application would write them to a
+//  cache file. Loaded data is checked by comparing an animated pose with the
+//  pose computed from the parsed data.
+//
+//  Press SPACE to run the benchmark again.
+//------------------------------------------------------------------------------
+#define SOKOL_DEBUGTEXT_IMPL
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_fetch.h"
+#include "sokol_debugtext.h"
+#include "sokol_time.h"
+#include "sokol_log.h"
+#include "sokol_glue.h"
+#include "spine/spine.h"
+#include "spine/extension.h"
+#include "util/fileutil.h"
+#include "util/spineblob.h"
+
+#define NUM_ASSETS (5)
+#define NUM_REPEAT (24)
+#define MAX_BONES (256)
+
+typedef struct {
+    const char* atlas_file;
+    const char* skel_file;
+    bool json;
+    struct {
+        bool atlas;
+        bool skel;
+        bool failed;
+    } loaded;
+    size_t atlas_size;
+    size_t skel_size;
+    uint8_t atlas_buf[16 * 1024];
+    uint8_t skel_buf[512 * 1024];
+    void* blob;
+    size_t blob_size;
+    double parse_ms;        // average over NUM_REPEAT
+    double load_ms;
+    bool pose_ok;
+} asset_t;
+
+static struct {
+    asset_t assets[NUM_ASSETS];
+    int num_loaded;
+    bool done;
+    double total_parse_ms;
+    double total_load_ms;
+} state = {
+    .assets = {
+        { .atlas_file = "spineboy.atlas", .skel_file = "spineboy-pro.json", .json = true },
+        { .atlas_file = "raptor-pma.atlas", .skel_file = "raptor-pro.skel" },
+        { .atlas_file = "alien-pma.atlas", .skel_file = "alien-pro.skel" },
+        { .atlas_file = "speedy-pma.atlas", .skel_file = "speedy-ess.skel" },
+        { .atlas_file = "mix-and-match-pma.atlas", .skel_file = "mix-and-match-pro.skel" },
+    },
+};
+
+// only the atlas and skeleton data is needed, so the spine-c callbacks
+// which sokol_spine.h would implement don't do anything here
+void _spAtlasPage_createTexture(spAtlasPage* self, const char* path) {
+    (void)path;
+    self->rendererObject = 0;
+}
+
+void _spAtlasPage_disposeTexture(spAtlasPage* self) {
+    (void)self;
+}
+
+char* _spUtil_readFile(const char* path, int* length) {
+    (void)path;
+    *length = 0;
+    return 0;
+}
+
+static void file_loaded(const sfetch_response_t* response);
+
+static void init(void) {
+    stm_setup();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+    });
+    sdtx_setup(&(sdtx_desc_t){
+        .fonts[0] = sdtx_font_oric(),
+        .logger.func = slog_func,
+    });
+    sfetch_setup(&(sfetch_desc_t){
+        .max_requests = 2 * NUM_ASSETS,
+        .num_channels = 1,
+        .num_lanes = 2 * NUM_ASSETS,
+        .logger.func = slog_func,
+    });
+    char path[512];
+    for (int i = 0; i < NUM_ASSETS; i++) {
+        asset_t* asset = &state.assets[i];
+        const int atlas_id = i * 2;
+        const int skel_id = i * 2 + 1;
+        sfetch_send(&(sfetch_request_t){
+            .path = fileutil_get_path(asset->atlas_file, path, sizeof(path)),
+            .buffer = SFETCH_RANGE(asset->atlas_buf),
+            .callback = file_loaded,
+            .user_data = SFETCH_RANGE(atlas_id),
+        });
+        sfetch_send(&(sfetch_request_t){
+            .path = fileutil_get_path(asset->skel_file, path, sizeof(path)),
+            .buffer = SFETCH_RANGE(asset->skel_buf),
+            .callback = file_loaded,
+            .user_data = SFETCH_RANGE(skel_id),
+        });
+    }
+}
+
+// the current parse path: atlas text and skeleton data into spine-c objects
+static void parse(const asset_t* asset, spAtlas** out_atlas, spSkeletonData** out_skel_data) {
+    *out_atlas = spAtlas_create((const char*)asset->atlas_buf, (int)asset->atlas_size, "", 0);
+    *out_skel_data = 0;
+    if (*out_atlas) {
+        if (asset->json) {
+            spSkeletonJson* json = spSkeletonJson_create(*out_atlas);
+            *out_skel_data = spSkeletonJson_readSkeletonData(json, (const char*)asset->skel_buf);
+            spSkeletonJson_dispose(json);
+        } else {
+            spSkeletonBinary* bin = spSkeletonBinary_create(*out_atlas);
+            *out_skel_data = spSkeletonBinary_readSkeletonData(bin, asset->skel_buf, (int)asset->skel_size);
+            spSkeletonBinary_dispose(bin);
+        }
+    }
+}
+
+// bone world transforms of the first animation at some point in time
+static int compute_pose(spSkeletonData* skel_data, float* out) {
+    spSkeleton* skel = spSkeleton_create(skel_data);
+    spAnimationStateData* anim_data = spAnimationStateData_create(skel_data);
+    spAnimationState* anim_state = spAnimationState_create(anim_data);
+    if (skel_data->animationsCount > 0) {
+        spAnimationState_setAnimation(anim_state, 0, skel_data->animations[0], 1);
+    }
+    spAnimationState_update(anim_state, 0.37f);
+    spAnimationState_apply(anim_state, skel);
+    spSkeleton_updateWorldTransform(skel);
+    int n = 0;
+    for (int i = 0; (i < skel->bonesCount) && (i < MAX_BONES); i++) {
+        const spBone* bone = skel->bones[i];
+        out[n++] = bone->a; out[n++] = bone->b; out[n++] = bone->worldX;
+        out[n++] = bone->c; out[n++] = bone->d; out[n++] = bone->worldY;
+    }
+    spAnimationState_dispose(anim_state);
+    spAnimationStateData_dispose(anim_data);
+    spSkeleton_dispose(skel);
+    return n;
+}
+
+static void run_benchmark(void) {
+    state.total_parse_ms = 0.0;
+    state.total_load_ms = 0.0;
+    for (int i = 0; i < NUM_ASSETS; i++) {
+        asset_t* asset = &state.assets[i];
+        if (asset->loaded.failed) {
+            continue;
+        }
+        // create the blob once (this would be the cache file)
+        if (!asset->blob) {
+            spineblob_data_t data;
+            if (spineblob_parse(&(spineblob_parse_desc_t){
+                .atlas_data = asset->atlas_buf,
+                .atlas_size = asset->atlas_size,
+                .skeleton_data = asset->skel_buf,
+                .skeleton_size = asset->skel_size,
+                .json = asset->json,
+            }, &data)) {
+                asset->blob_size = spineblob_save(&data, &asset->blob);
+                spineblob_free(&data);
+            }
+        }
+
+        uint64_t start = stm_now();
+        for (int r = 0; r < NUM_REPEAT; r++) {
+            spAtlas* atlas;
+            spSkeletonData* skel_data;
+            parse(asset, &atlas, &skel_data);
+            if (skel_data) {
+                spSkeletonData_dispose(skel_data);
+            }
+            if (atlas) {
+                spAtlas_dispose(atlas);
+            }
+        }
+        asset->parse_ms = stm_ms(stm_since(start)) / NUM_REPEAT;
+
+        start = stm_now();
+        for (int r = 0; asset->blob && (r < NUM_REPEAT); r++) {
+            spineblob_data_t data;
+            if (spineblob_load(asset->blob, asset->blob_size, &data)) {
+                spineblob_free(&data);
+            }
+        }
+        asset->load_ms = asset->blob ? (stm_ms(stm_since(start)) / NUM_REPEAT) : 0.0;
+        state.total_parse_ms += asset->parse_ms;
+        state.total_load_ms += asset->load_ms;
+
+        // check that the loaded data animates like the parsed data
+        asset->pose_ok = false;
+        spineblob_data_t data;
+        if (asset->blob && spineblob_load(asset->blob, asset->blob_size, &data)) {
+            static float pose0[MAX_BONES * 6];
+            static float pose1[MAX_BONES * 6];
+            spAtlas* atlas;
+            spSkeletonData* skel_data;
+            parse(asset, &atlas, &skel_data);
+            if (skel_data) {
+                const int n0 = compute_pose(skel_data, pose0);
+                const int n1 = compute_pose(data.skeleton_data, pose1);
+                asset->pose_ok = (n0 == n1) && (0 == memcmp(pose0, pose1, (size_t)n0 * sizeof(float)));
+                spSkeletonData_dispose(skel_data);
+            }
+            if (atlas) {
+                spAtlas_dispose(atlas);
+            }
+            spineblob_free(&data);
+        }
+    }
+    state.done = true;
+}
+
+static void frame(void) {
+    sfetch_dowork();
+    if (!state.done && (state.num_loaded == NUM_ASSETS)) {
+        run_benchmark();
+    }
+
+    sdtx_canvas(sapp_widthf() * 0.5f, sapp_heightf() * 0.5f);
+    sdtx_origin(1.0f, 1.0f);
+    sdtx_color3b(0xFF, 0xCC, 0x00);
+    sdtx_puts("spine-c atlas+skeleton creation\n");
+    sdtx_printf("parse vs preparsed blob, avg of %d\n\n", NUM_REPEAT);
+    sdtx_color3b(0xFF, 0xFF, 0xFF);
+    if (!state.done) {
+        sdtx_printf("loading files (%d/%d)...", state.num_loaded, NUM_ASSETS);
+    } else {
+        sdtx_puts("skeleton              parse    blob   blob size\n");
+        for (int i = 0; i < NUM_ASSETS; i++) {
+            const asset_t* asset = &state.assets[i];
+            if (asset->loaded.failed) {
+                sdtx_printf("%-22s failed to load\n", asset->skel_file);
+                continue;
+            }
+            sdtx_printf("%-22s %6.3f  %6.3f  %5d KB %s\n",
+                asset->skel_file,
+                asset->parse_ms,
+                asset->load_ms,
+                (int)(asset->blob_size / 1024),
+                !asset->blob ? "not saved" : (asset->pose_ok ? "ok" : "MISMATCH"));
+        }
+        sdtx_printf("\ntotal (ms)             %6.3f  %6.3f\n", state.total_parse_ms, state.total_load_ms);
+        if (state.total_load_ms > 0.0) {
+            sdtx_printf("speedup: %.1fx\n", state.total_parse_ms / state.total_load_ms);
+        }
+        sdtx_puts("\nSPACE: run again");
+    }
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.2f, 0.3f, 1.0f } },
+        },
+        .swapchain = sglue_swapchain()
+    });
+    sdtx_draw();
+    sg_end_pass();
+    sg_commit();
+}
+
+static void input(const sapp_event* ev) {
+    if ((ev->type == SAPP_EVENTTYPE_KEY_DOWN) && (ev->key_code == SAPP_KEYCODE_SPACE) && (state.num_loaded == NUM_ASSETS)) {
+        state.done = false;
+    }
+}
+
+static void cleanup(void) {
+    for (int i = 0; i < NUM_ASSETS; i++) {
+        free(state.assets[i].blob);
+    }
+    sfetch_shutdown();
+    sdtx_shutdown();
+    sg_shutdown();
+}
+
+static void file_loaded(const sfetch_response_t* response) {
+    const int id = *(const int*)response->user_data;
+    asset_t* asset = &state.assets[id / 2];
+    const bool is_atlas = (id & 1) == 0;
+    if (response->fetched) {
+        // zero-terminate, the JSON parser expects a string
+        uint8_t* buf = is_atlas ? asset->atlas_buf : asset->skel_buf;
+        const size_t buf_size = is_atlas ? sizeof(asset->atlas_buf) : sizeof(asset->skel_buf);
+        if (response->data.size < buf_size) {
+            buf[response->data.size] = 0;
+        } else {
+            asset->loaded.failed = true;
+        }
+        if (is_atlas) {
+            asset->atlas_size = response->data.size;
+            asset->loaded.atlas = true;
+        } else {
+            asset->skel_size = response->data.size;
+            asset->loaded.skel = true;
+        }
+        if (asset->loaded.atlas && asset->loaded.skel) {
+            state.num_loaded++;
+        }
+    } else if (response->failed) {
+        if (!asset->loaded.failed) {
+            asset->loaded.failed = true;
+            state.num_loaded++;
+        }
+    }
+}
+
+sapp_desc sokol_main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+    return (sapp_desc){
+        .init_cb = init,
+        .frame_cb = frame,
+        .event_cb = input,
+        .cleanup_cb = cleanup,
+        .width = 1024,
+        .height = 768,
+        .window_title = "spine-preparse-sapp.c",
+        .icon.sokol_default = true,
+        .logger.func = slog_func,
+    };
+}
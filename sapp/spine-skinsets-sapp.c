@@ -1,6 +1,14 @@
 //------------------------------------------------------------------------------
 //  spine-skinsets-sapp.c
 //  Test/demonstrate skinset usage and draw call merging.
+//
+//  Vertices are reused via the pose-hash cache in util/spinecache.h,
+//  press P to pause the animations, and C to toggle the cache.
+//
+//  Each instance has a random skin set, so instances only share poses
+//  while paused. Press S to switch to a second set of instances which all
+//  have the same skin set and play the same animation in lockstep, so
+//  nearly all instances reuse the vertices of the first one.
 //------------------------------------------------------------------------------
 #define SOKOL_SPINE_IMPL
 #define SOKOL_DEBUGTEXT_IMPL
@@ -15,6 +23,7 @@
 #include "sokol_spine.h"
 #include "stb/stb_image.h"
 #include "util/fileutil.h"
+#include "util/spinecache.h"
 #include "dbgui/dbgui.h"
 
 #define NUM_INSTANCES_X (16)
@@ -41,10 +50,15 @@ static struct {
     sspine_atlas atlas;
     sspine_skeleton skeleton;
     sspine_instance instances[NUM_INSTANCES];
+    sspine_instance shared_instances[NUM_INSTANCES];    // all with the same pose
+    bool shared;
     sg_pass_action pass_action;
     float t;       // time interval 0..1
     uint32_t t_count;   // bumped each time t goes over 1
     grid_cell_t grid[NUM_INSTANCES];
+    spinecache_t cache;
+    bool cache_enabled;
+    bool paused;
     struct {
         load_status_t atlas;
         load_status_t skeleton;
@@ -149,8 +163,8 @@ static void init(void) {
     });
     // setup sokol-spine
     sspine_setup(&(sspine_desc){
-        .skinset_pool_size = NUM_INSTANCES,
-        .instance_pool_size = NUM_INSTANCES,
+        .skinset_pool_size = NUM_INSTANCES + 1,
+        .instance_pool_size = 2 * NUM_INSTANCES,
         .max_vertices = 256 * 1024,
         .logger = {
             .func = slog_func,
@@ -165,6 +179,10 @@ static void init(void) {
     });
     __dbgui_setup(sapp_sample_count());
 
+    // vertex cache for the default context, room for 2 poses per instance
+    spinecache_init(&state.cache, sspine_default_context(), 2 * NUM_INSTANCES);
+    state.cache_enabled = true;
+
     // pass action to clear to blue-ish
     state.pass_action = (sg_pass_action){
         .colors[0] = { .load_action = SG_LOADACTION_CLEAR, .clear_value = { 0.0f, 0.5f, 0.7f, 1.0f } }
@@ -229,7 +247,9 @@ static void frame(void) {
     };
 
     // update and draw Spine objects
+    const sspine_instance* instances = state.shared ? state.shared_instances : state.instances;
     uint64_t start_time = stm_now();
+    spinecache_begin_frame(&state.cache);
     for (uint32_t i = 0; i < NUM_INSTANCES; i++) {
         const uint32_t grid_index = (i + state.t_count) % NUM_INSTANCES;
         const vec2 pos = state.grid[grid_index].pos;
@@ -238,9 +258,13 @@ static void frame(void) {
             .x = pos.x + vec.x * GRID_DX * state.t,
             .y = pos.y + vec.y * GRID_DY * state.t,
         };
-        sspine_set_position(state.instances[i], p);
-        sspine_update_instance(state.instances[i], (float)delta_time);
-        sspine_draw_instance_in_layer(state.instances[i], 0);
+        sspine_set_position(instances[i], p);
+        sspine_update_instance(instances[i], state.paused ? 0.0f : (float)delta_time);
+        if (state.cache_enabled) {
+            spinecache_draw_instance_in_layer(&state.cache, instances[i], 0);
+        } else {
+            sspine_draw_instance_in_layer(instances[i], 0);
+        }
     }
     double eval_time = stm_ms(stm_since(start_time));
 
@@ -251,7 +275,18 @@ static void frame(void) {
     sdtx_home();
     sdtx_color3b(0, 0, 0);
     sdtx_printf("spine eval time:%.3fms\n", eval_time); sdtx_move_y(0.5f);
-    sdtx_printf("vertices:%d indices:%d draws:%d", ctx_info.num_vertices, ctx_info.num_indices, ctx_info.num_commands);
+    sdtx_printf("vertices:%d indices:%d draws:%d\n", ctx_info.num_vertices, ctx_info.num_indices, ctx_info.num_commands); sdtx_move_y(0.5f);
+    if (state.cache_enabled) {
+        const uint64_t total = state.cache.total_reused + state.cache.total_generated;
+        sdtx_printf("reuse:%.1f%% total:%.1f%%\n",
+            spinecache_reuse_rate(&state.cache) * 100.0f,
+            (total > 0) ? ((double)state.cache.total_reused * 100.0 / (double)total) : 0.0);
+    } else {
+        sdtx_puts("reuse:off\n");
+    }
+    sdtx_move_y(0.5f);
+    sdtx_printf("P: %s  C: %s cache  S: %s", state.paused ? "resume" : "pause",
+        state.cache_enabled ? "disable" : "enable", state.shared ? "random skins" : "shared pose");
 
     // actual sokol-gfx render pass
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
@@ -262,7 +297,20 @@ static void frame(void) {
     sg_commit();
 }
 
+static void input(const sapp_event* ev) {
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN) {
+        switch (ev->key_code) {
+            case SAPP_KEYCODE_P: state.paused = !state.paused; break;
+            case SAPP_KEYCODE_C: state.cache_enabled = !state.cache_enabled; break;
+            case SAPP_KEYCODE_S: state.shared = !state.shared; break;
+            default: break;
+        }
+    }
+    __dbgui_event(ev);
+}
+
 static void cleanup(void) {
+    spinecache_discard(&state.cache);
     sfetch_shutdown();
     sspine_shutdown();
     __dbgui_shutdown();
@@ -422,6 +470,33 @@ static void create_spine_objects(void) {
         sspine_update_instance(state.instances[i], initial_time);
         initial_time += 0.1f;
     }
+
+    // instances which all have the same skin set, animation and animation
+    // time, and which are always updated with the same time step, so they
+    // always show exactly the same pose
+    sspine_skinset shared_skinset = sspine_make_skinset(&(sspine_skinset_desc){
+        .skeleton = state.skeleton,
+        .skins = {
+            sspine_skin_by_name(state.skeleton, "skin-base"),
+            sspine_skin_by_name(state.skeleton, accessories[0]),
+            sspine_skin_by_name(state.skeleton, clothes[0]),
+            sspine_skin_by_name(state.skeleton, eyelids[0]),
+            sspine_skin_by_name(state.skeleton, eyes[0]),
+            sspine_skin_by_name(state.skeleton, hair[0]),
+            sspine_skin_by_name(state.skeleton, legs[0]),
+            sspine_skin_by_name(state.skeleton, nose[0])
+        }
+    });
+    assert(sspine_skinset_valid(shared_skinset));
+    for (int i = 0; i < NUM_INSTANCES; i++) {
+        state.shared_instances[i] = sspine_make_instance(&(sspine_instance_desc){
+            .skeleton = state.skeleton,
+        });
+        assert(sspine_instance_valid(state.shared_instances[i]));
+        sspine_set_animation(state.shared_instances[i], sspine_anim_by_name(state.skeleton, "dance"), 0, true);
+        sspine_set_skinset(state.shared_instances[i], shared_skinset);
+        sspine_update_instance(state.shared_instances[i], 0.0f);
+    }
 }
 
 sapp_desc sokol_main(int argc, char* argv[]) {
@@ -430,7 +505,7 @@ sapp_desc sokol_main(int argc, char* argv[]) {
         .init_cb = init,
         .frame_cb = frame,
         .cleanup_cb = cleanup,
-        .event_cb = __dbgui_event,
+        .event_cb = input,
         .width = 1024,
         .height = 768,
         .high_dpi = true,
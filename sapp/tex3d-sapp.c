@@ -1,6 +1,9 @@
 //------------------------------------------------------------------------------
 //  tex3d-sapp.c
 //  Test 3D texture rendering.
+//
+//  Each frame a small brick of the 3D texture is filled with new random
+//  values, and the texture is updated from its CPU-side copy.
 //------------------------------------------------------------------------------
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -13,12 +16,14 @@
 #include "tex3d-sapp.glsl.h"
 
 #define TEX3D_DIM (32)
+#define BRICK_DIM (4)
 
 static struct {
     sg_pass_action pass_action;
     sg_pipeline pip;
     sg_bindings bind;
     float rx, ry, t;
+    uint32_t pixels[TEX3D_DIM][TEX3D_DIM][TEX3D_DIM];
 } state;
 
 static uint32_t xorshift32(void) {
@@ -85,24 +90,23 @@ static void init(void) {
         .label = "cube-pipeline"
     });
 
-    // create a 3d texture with random content
-    static uint32_t pixels[TEX3D_DIM][TEX3D_DIM][TEX3D_DIM];
+    // create a dynamic 3d texture, the random content is uploaded in the first frame
     for (int x = 0; x < TEX3D_DIM; x++) {
         for (int y = 0; y < TEX3D_DIM; y++) {
             for (int z = 0; z < TEX3D_DIM; z++) {
-                pixels[x][y][z] = xorshift32();
+                state.pixels[x][y][z] = xorshift32();
             }
         }
     }
     state.bind.images[IMG_tex] = sg_make_image(&(sg_image_desc){
         .type = SG_IMAGETYPE_3D,
+        .usage = SG_USAGE_DYNAMIC,
         .width = TEX3D_DIM,
         .height = TEX3D_DIM,
         .num_slices = TEX3D_DIM,
         .num_mipmaps = 1,
         .pixel_format = SG_PIXELFORMAT_RGBA8,
         .label = "3d texture",
-        .data.subimage[0][0] = SG_RANGE(pixels)
     });
 
     // ...and a sampler object
@@ -129,6 +133,22 @@ static void frame(void) {
         .scale = (HMM_SinF(state.t) + 1.0f) * 0.5f
     };
 
+    // put new random values into a random brick, sg_update_image() replaces
+    // the complete image and may only be called once per frame
+    const int bx = (int)(xorshift32() % (TEX3D_DIM - BRICK_DIM + 1));
+    const int by = (int)(xorshift32() % (TEX3D_DIM - BRICK_DIM + 1));
+    const int bz = (int)(xorshift32() % (TEX3D_DIM - BRICK_DIM + 1));
+    for (int z = bz; z < (bz + BRICK_DIM); z++) {
+        for (int y = by; y < (by + BRICK_DIM); y++) {
+            for (int x = bx; x < (bx + BRICK_DIM); x++) {
+                state.pixels[z][y][x] = xorshift32();
+            }
+        }
+    }
+    sg_update_image(state.bind.images[IMG_tex], &(sg_image_data){
+        .subimage[0][0] = SG_RANGE(state.pixels)
+    });
+
     // render the scene
     sg_begin_pass(&(sg_pass){ .action = state.pass_action, .swapchain = sglue_swapchain() });
     sg_apply_pipeline(state.pip);